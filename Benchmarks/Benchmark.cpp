@@ -0,0 +1,184 @@
+#include "Benchmark.h"
+
+#include <chrono>
+#include <cerrno>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace noid::benchmarks {
+
+/**
+ * The width of every column printed by @c PrintRow.
+ */
+static const int COLUMN_WIDTH = 14;
+
+/**
+ * @return The registered benchmarks, ordered by name.
+ */
+static std::map<std::string, Benchmark>& Benchmarks() {
+  static std::map<std::string, Benchmark> benchmarks;
+  return benchmarks;
+}
+
+bool RegisterBenchmark(const std::string &name, Benchmark benchmark) {
+  Benchmarks().emplace(name, std::move(benchmark));
+  return true;
+}
+
+double MeasureSeconds(const std::function<void()> &function) {
+  auto start = std::chrono::steady_clock::now();
+  function();
+
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+IoCounters ReadIoCounters() {
+  std::ifstream in("/proc/self/io");
+  IoCounters counters{0, 0};
+  bool read_found = false;
+  bool write_found = false;
+
+  std::string name;
+  uint64_t value;
+  while (in >> name >> value) {
+    if (name == "read_bytes:") {
+      counters.read_bytes = value;
+      read_found = true;
+    } else if (name == "write_bytes:") {
+      counters.write_bytes = value;
+      write_found = true;
+    }
+  }
+
+  if (!read_found || !write_found) {
+    throw std::runtime_error("Cannot read the I/O counters of this process from /proc/self/io.");
+  }
+
+  return counters;
+}
+
+void DropFromPageCache(const std::filesystem::path &path) {
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot open " + path.string());
+  }
+
+  // Only clean pages can be dropped, so write the dirty ones first.
+  auto result = ::fdatasync(fd);
+  auto error = errno;
+  if (result == 0) {
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  }
+  ::close(fd);
+
+  if (result != 0) {
+    throw std::system_error(error, std::generic_category(), "Cannot synchronize " + path.string());
+  }
+}
+
+uint64_t PageCacheBytes(const std::filesystem::path &path) {
+  auto size = std::filesystem::file_size(path);
+  if (size == 0) {
+    return 0;
+  }
+
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot open " + path.string());
+  }
+
+  auto mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  auto error = errno;
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    throw std::system_error(error, std::generic_category(), "Cannot map " + path.string());
+  }
+
+  auto page_size = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+  std::vector<unsigned char> resident((size + page_size - 1) / page_size);
+  auto result = ::mincore(mapping, size, resident.data());
+  error = errno;
+  ::munmap(mapping, size);
+  if (result != 0) {
+    throw std::system_error(error, std::generic_category(), "Cannot determine the cached pages of " + path.string());
+  }
+
+  uint64_t cached = 0;
+  for (auto page : resident) {
+    cached += (page & 1) * page_size;
+  }
+
+  return cached;
+}
+
+void PrintRow(const std::vector<std::string> &columns) {
+  for (auto& column : columns) {
+    std::cout << std::setw(COLUMN_WIDTH) << column;
+  }
+  std::cout << std::endl;
+}
+
+std::string Format(double value, int decimals) {
+  std::stringstream out;
+  out << std::fixed << std::setprecision(decimals) << value;
+
+  return out.str();
+}
+
+}
+
+/**
+ * Runs the benchmarks whose names contain any of the given arguments, or all benchmarks if no names are given. Each
+ * benchmark stores its files in an empty directory within the temporary directory, or within the directory given
+ * using --directory=<path>, which is removed afterwards.
+ */
+int main(int argc, char** argv) {
+  auto parent = std::filesystem::temp_directory_path();
+  std::vector<std::string> filters;
+  for (auto i = 1; i < argc; i++) {
+    std::string argument(argv[i]);
+    if (argument.rfind("--directory=", 0) == 0) {
+      parent = argument.substr(std::string("--directory=").size());
+    } else {
+      filters.push_back(argument);
+    }
+  }
+
+  auto failed = false;
+  for (auto& [name, benchmark] : noid::benchmarks::Benchmarks()) {
+    auto selected = filters.empty();
+    for (auto& filter : filters) {
+      selected = selected || name.find(filter) != std::string::npos;
+    }
+
+    if (!selected) {
+      continue;
+    }
+
+    auto directory = parent / ("noid-benchmark-" + name);
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    std::cout << name << std::endl;
+    try {
+      benchmark(directory);
+    } catch (std::exception& e) {
+      std::cout << "Failed: " << e.what() << std::endl;
+      failed = true;
+    }
+    std::cout << std::endl;
+
+    std::filesystem::remove_all(directory);
+  }
+
+  return failed ? 1 : 0;
+}
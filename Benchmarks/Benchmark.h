@@ -0,0 +1,102 @@
+#ifndef NOID_BENCHMARKS_BENCHMARK_H_
+#define NOID_BENCHMARKS_BENCHMARK_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace noid::benchmarks {
+
+/**
+ * @brief A benchmark, which stores its files in the given empty directory and prints its results as a table.
+ */
+using Benchmark = std::function<void(const std::filesystem::path&)>;
+
+/**
+ * @brief The amount of bytes a process transferred from and to storage devices. Reads served from the operating
+ * system page cache are not included.
+ */
+struct IoCounters {
+
+    /**
+     * @brief The amount of bytes read from storage devices.
+     */
+    uint64_t read_bytes;
+
+    /**
+     * @brief The amount of bytes written to storage devices.
+     */
+    uint64_t write_bytes;
+};
+
+/**
+ * @brief Registers a benchmark, so it is run by the benchmark executable.
+ *
+ * @param name The name of the benchmark, by which it can be selected.
+ * @param benchmark The benchmark.
+ * @return @c true, so the registration can initialize a static variable.
+ */
+bool RegisterBenchmark(const std::string& name, Benchmark benchmark);
+
+/**
+ * @brief Invokes @p function and measures how long it takes.
+ *
+ * @param function The function to measure.
+ * @return The elapsed wall-clock time in seconds.
+ */
+double MeasureSeconds(const std::function<void()>& function);
+
+/**
+ * @return The storage device transfers of this process so far, as reported by @c /proc/self/io.
+ * @throws std::runtime_error If the counters are not available.
+ */
+IoCounters ReadIoCounters();
+
+/**
+ * @brief Writes the cached pages of the given file to its device, and drops them from the operating system page
+ * cache, so subsequent reads are served by the device.
+ *
+ * @param path The file.
+ * @throws std::system_error If the file cannot be synchronized.
+ */
+void DropFromPageCache(const std::filesystem::path& path);
+
+/**
+ * @brief Determines how much of the given file is cached in the operating system page cache.
+ *
+ * @param path The file.
+ * @return The amount of cached bytes, in whole pages.
+ * @throws std::system_error If the file cannot be mapped.
+ */
+uint64_t PageCacheBytes(const std::filesystem::path& path);
+
+/**
+ * @brief Prints a row of a result table. Every column is right-aligned in a column of fixed width.
+ *
+ * @param columns The column values.
+ */
+void PrintRow(const std::vector<std::string>& columns);
+
+/**
+ * @brief Formats the given @p value using a fixed amount of decimals.
+ *
+ * @param value The value.
+ * @param decimals The amount of decimals.
+ * @return The formatted value.
+ */
+std::string Format(double value, int decimals = 1);
+
+}
+
+/**
+ * @brief Defines and registers a benchmark. The body receives the empty directory to store its files in as
+ * @c directory.
+ */
+#define NOID_BENCHMARK(name) \
+    static void name(const std::filesystem::path& directory); \
+    static const bool name##_registered = noid::benchmarks::RegisterBenchmark(#name, name); \
+    static void name(const std::filesystem::path& directory)
+
+#endif //NOID_BENCHMARKS_BENCHMARK_H_
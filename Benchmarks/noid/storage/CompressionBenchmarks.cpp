@@ -0,0 +1,129 @@
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "Benchmark.h"
+#include "storage/Codec.h"
+#include "storage/CowBPlusTree.h"
+
+using namespace noid::benchmarks;
+using namespace noid::storage;
+
+/**
+ * @return A JSON document of about 200 bytes, which is as compressible as the payloads stored by the application.
+ */
+static V Document(uint64_t number) {
+  std::mt19937_64 random(number);
+  auto text = R"({"id":)" + std::to_string(number) + R"(,"type":"order","status":")"
+      + (random() % 2 == 0 ? "shipped" : "pending") + R"(","customer":{"id":)" + std::to_string(random() % 100000)
+      + R"(,"country":"NL"},"items":[{"sku":"A-)" + std::to_string(random() % 1000) + R"(","quantity":)"
+      + std::to_string(1 + random() % 5) + R"(,"price":)" + std::to_string(random() % 10000) + "}]}";
+
+  return {text.begin(), text.end()};
+}
+
+/**
+ * @return The key of the given document number, so documents are stored in insertion order.
+ */
+static K Key(uint64_t number) {
+  K key{};
+  for (size_t i = 0; i < sizeof(uint64_t); i++) {
+    key[BTREE_KEY_SIZE - 1 - i] = static_cast<byte>(number >> (8 * i));
+  }
+
+  return key;
+}
+
+/**
+ * Compares uncompressed and compressed leaves by file size, and by the device bytes read per logical byte of keys and
+ * values in a cold full scan using direct I/O.
+ */
+NOID_BENCHMARK(CompressionLeafPages) {
+  const uint64_t record_count = 200000;
+  const size_t commit_interval = 1000;
+
+  PrintRow({"codec", "file MiB", "ratio", "read MiB", "read amp", "scan MiB/s"});
+  double uncompressed_size = 0;
+  for (auto codec : {CodecType::None, CodecType::Lz}) {
+    auto path = directory / (codec == CodecType::None ? "none" : "lz");
+
+    CowBPlusTreeOptions options;
+    options.direct_io = true;
+    options.leaf_codec = codec;
+    uint64_t logical_bytes = 0;
+    {
+      auto tree = CowBPlusTree::Open(path, options);
+      for (uint64_t i = 0; i < record_count; i++) {
+        auto value = Document(i);
+        logical_bytes += BTREE_KEY_SIZE + value.size();
+        tree->Insert(Key(i), value);
+        if ((i + 1) % commit_interval == 0) {
+          tree->Commit();
+        }
+      }
+      tree->Commit();
+    }
+
+    auto file_size = static_cast<double>(std::filesystem::file_size(path));
+    if (codec == CodecType::None) {
+      uncompressed_size = file_size;
+    }
+
+    auto tree = CowBPlusTree::Open(path, options);
+    auto before = ReadIoCounters();
+    uint64_t scanned = 0;
+    auto seconds = MeasureSeconds([&]() {
+      tree->Snapshot().Scan(K{}, [&](const K&, const V&) {
+        scanned++;
+        return true;
+      });
+    });
+    auto read_bytes = static_cast<double>(ReadIoCounters().read_bytes - before.read_bytes);
+    if (scanned != record_count) {
+      throw std::runtime_error("The scan returned " + std::to_string(scanned) + " records.");
+    }
+
+    auto mib = [](double bytes) { return Format(bytes / (1024 * 1024)); };
+    PrintRow({codec == CodecType::None ? "none" : "lz", mib(file_size), Format(uncompressed_size / file_size, 2),
+              mib(read_bytes), Format(read_bytes / logical_bytes, 2), mib(logical_bytes / seconds)});
+  }
+}
+
+/**
+ * Measures how fast @c LzCodec compresses and decompresses pages filled with documents.
+ */
+NOID_BENCHMARK(CompressionLzThroughput) {
+  const uint64_t total_bytes = 1ULL << 30;
+  auto& codec = GetCodec(CodecType::Lz);
+
+  byte page[PAGE_SIZE];
+  size_t filled = 0;
+  for (uint64_t i = 0; filled < PAGE_SIZE; i++) {
+    auto document = Document(i);
+    auto size = std::min(document.size(), PAGE_SIZE - filled);
+    std::memcpy(page + filled, document.data(), size);
+    filled += size;
+  }
+
+  byte compressed[2 * PAGE_SIZE];
+  auto compressed_size = codec.Compress(page, PAGE_SIZE, compressed, sizeof(compressed));
+  byte decompressed[PAGE_SIZE];
+  auto decompress_seconds = MeasureSeconds([&]() {
+    for (uint64_t done = 0; done < total_bytes; done += PAGE_SIZE) {
+      codec.Decompress(compressed, compressed_size, decompressed, PAGE_SIZE);
+    }
+  });
+  if (std::memcmp(page, decompressed, PAGE_SIZE) != 0) {
+    throw std::runtime_error("The page did not survive a round trip.");
+  }
+
+  auto compress_seconds = MeasureSeconds([&]() {
+    for (uint64_t done = 0; done < total_bytes / 8; done += PAGE_SIZE) {
+      codec.Compress(page, PAGE_SIZE, compressed, sizeof(compressed));
+    }
+  });
+
+  PrintRow({"page ratio", "comp MB/s", "decomp MB/s"});
+  PrintRow({Format(static_cast<double>(PAGE_SIZE) / compressed_size, 2),
+            Format(total_bytes / 8 / compress_seconds / 1e6, 0), Format(total_bytes / decompress_seconds / 1e6, 0)});
+}
@@ -0,0 +1,151 @@
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "storage/AlignedBuffer.h"
+#include "storage/CowBPlusTree.h"
+#include "storage/PageFile.h"
+
+using namespace noid::benchmarks;
+using namespace noid::storage;
+
+/**
+ * @return A key derived from the given @p number, which spreads consecutive numbers over the key space.
+ */
+static K Key(uint64_t number) {
+  std::mt19937_64 random(number);
+  K key{};
+  for (size_t i = 0; i < BTREE_KEY_SIZE; i += sizeof(uint64_t)) {
+    auto bits = random();
+    std::memcpy(key.data() + i, &bits, sizeof(uint64_t));
+  }
+
+  return key;
+}
+
+/**
+ * Compares buffered and direct I/O by the throughput of inserts and random lookups, and by the memory used: the pool,
+ * plus the part of the file kept in the operating system page cache.
+ */
+NOID_BENCHMARK(CowBPlusTreeDirectIo) {
+  const uint64_t record_count = 400000;
+  const uint64_t lookup_count = 200000;
+  const size_t commit_interval = 1000;
+
+  PrintRow({"io", "inserts/s", "lookups/s", "pool MiB", "cache MiB", "file MiB"});
+  for (auto direct_io : {false, true}) {
+    auto path = directory / (direct_io ? "direct" : "buffered");
+
+    CowBPlusTreeOptions options;
+    options.pool_capacity = 4096;
+    options.direct_io = direct_io;
+    auto tree = CowBPlusTree::Open(path, options);
+
+    V value(100, 42);
+    auto insert_seconds = MeasureSeconds([&]() {
+      for (uint64_t i = 0; i < record_count; i++) {
+        tree->Insert(Key(i), value);
+        if ((i + 1) % commit_interval == 0) {
+          tree->Commit();
+        }
+      }
+      tree->Commit();
+    });
+
+    std::mt19937_64 random(42);
+    auto lookup_seconds = MeasureSeconds([&]() {
+      for (uint64_t i = 0; i < lookup_count; i++) {
+        tree->Find(Key(random() % record_count));
+      }
+    });
+
+    auto mib = [](double bytes) { return Format(bytes / (1024 * 1024)); };
+    PrintRow({direct_io ? "direct" : "buffered", Format(record_count / insert_seconds, 0),
+              Format(lookup_count / lookup_seconds, 0), mib(static_cast<double>(options.pool_capacity) * PAGE_SIZE),
+              mib(static_cast<double>(PageCacheBytes(path))),
+              mib(static_cast<double>(std::filesystem::file_size(path)))});
+  }
+}
+
+/**
+ * Compares a cold full scan using direct I/O with the two bounds of the device: sequential bandwidth, read in large
+ * batches, and IOPS times the page size, read one random page at a time. The records are inserted in random order, so
+ * the leaves are scattered over the file.
+ */
+NOID_BENCHMARK(CowBPlusTreeScan) {
+  const uint64_t record_count = 400000;
+  const size_t commit_interval = 1000;
+  const size_t batch_size = 128;
+  const size_t random_read_count = 8192;
+
+  auto path = directory / "tree";
+  CowBPlusTreeOptions options;
+  options.direct_io = true;
+  {
+    auto tree = CowBPlusTree::Open(path, options);
+    V value(100, 42);
+    for (uint64_t i = 0; i < record_count; i++) {
+      tree->Insert(Key(i), value);
+      if ((i + 1) % commit_interval == 0) {
+        tree->Commit();
+      }
+    }
+    tree->Commit();
+  }
+
+  auto mb_per_second = [](double bytes, double seconds) { return Format(bytes / seconds / 1e6); };
+  PrintRow({"backend", "read", "MB/s", "read MiB"});
+  for (auto type : {IoBackendType::Synchronous, IoBackendType::IoUring}) {
+    options.io_backend = type;
+    auto backend = type == IoBackendType::IoUring ? "io_uring" : "pread";
+
+    {
+      auto tree = CowBPlusTree::Open(path, options);
+      auto before = ReadIoCounters();
+      uint64_t scanned = 0;
+      auto seconds = MeasureSeconds([&]() {
+        tree->Snapshot().Scan(K{}, [&scanned](const K&, const V&) {
+          scanned++;
+          return true;
+        });
+      });
+      if (scanned != record_count) {
+        throw std::runtime_error("The scan returned " + std::to_string(scanned) + " records.");
+      }
+
+      auto read_bytes = static_cast<double>(ReadIoCounters().read_bytes - before.read_bytes);
+      PrintRow({backend, "scan", mb_per_second(read_bytes, seconds), Format(read_bytes / (1024 * 1024))});
+    }
+
+    auto file = PageFile::Open(path, type, true);
+    auto page_count = file->PageCount();
+    auto buffer = AllocateAligned(batch_size * PAGE_SIZE);
+
+    auto sequential_seconds = MeasureSeconds([&]() {
+      std::vector<PageIo> batch;
+      for (PageId page_id = 0; page_id < page_count; page_id++) {
+        batch.push_back({page_id, buffer.get() + batch.size() * PAGE_SIZE});
+        if (batch.size() == batch_size || page_id + 1 == page_count) {
+          file->ReadBatch(batch);
+          batch.clear();
+        }
+      }
+    });
+    auto file_bytes = static_cast<double>(page_count) * PAGE_SIZE;
+    PrintRow({backend, "sequential", mb_per_second(file_bytes, sequential_seconds),
+              Format(file_bytes / (1024 * 1024))});
+
+    std::mt19937_64 random(42);
+    auto random_seconds = MeasureSeconds([&]() {
+      for (size_t i = 0; i < random_read_count; i++) {
+        file->Read(static_cast<PageId>(random() % page_count), buffer.get());
+      }
+    });
+    auto random_bytes = static_cast<double>(random_read_count) * PAGE_SIZE;
+    PrintRow({backend, "random page", mb_per_second(random_bytes, random_seconds),
+              Format(random_bytes / (1024 * 1024))});
+  }
+}
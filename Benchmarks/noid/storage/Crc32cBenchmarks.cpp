@@ -0,0 +1,47 @@
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "storage/Crc32c.h"
+
+using namespace noid::benchmarks;
+using namespace noid::storage;
+
+/**
+ * Receives the computed checksums.
+ */
+static volatile uint32_t checksum_sink;
+
+/**
+ * Compares the checksum throughput of the software implementation with the one @c Crc32c selects on this processor,
+ * for buffer sizes ranging from a small record to a large batch of pages.
+ */
+NOID_BENCHMARK(Crc32cThroughput) {
+  const uint64_t total_bytes = 1ULL << 30;
+  std::vector<uint8_t> buffer(1 << 20);
+  for (size_t i = 0; i < buffer.size(); i++) {
+    buffer[i] = static_cast<uint8_t>(i * 131);
+  }
+
+  std::vector<std::pair<std::string, std::function<uint32_t(const void*, size_t, uint32_t)>>> implementations{
+      {"software", Crc32cSoftware},
+      {Crc32cHardwareSupported() ? "hardware" : "selected", Crc32c}};
+
+  PrintRow({"size", "variant", "GB/s"});
+  for (size_t size : {64, 4096, 1 << 20}) {
+    for (auto& [name, checksum] : implementations) {
+      uint32_t crc = 0;
+      auto seconds = MeasureSeconds([&]() {
+        for (uint64_t done = 0; done < total_bytes; done += size) {
+          crc = checksum(buffer.data(), size, crc);
+        }
+      });
+
+      // Storing the checksum keeps the computation from being optimized away.
+      checksum_sink = crc;
+      PrintRow({std::to_string(size), name, Format(total_bytes / seconds / 1e9, 2)});
+    }
+  }
+}
@@ -0,0 +1,179 @@
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "Benchmark.h"
+#include "storage/CowBPlusTree.h"
+#include "storage/LsmTree.h"
+
+using namespace noid::benchmarks;
+using namespace noid::storage;
+
+/**
+ * @return A key derived from the given @p number, which spreads consecutive numbers over the key space.
+ */
+static K Key(uint64_t number) {
+  std::mt19937_64 random(number);
+  K key{};
+  for (size_t i = 0; i < BTREE_KEY_SIZE; i += sizeof(uint64_t)) {
+    auto bits = random();
+    std::memcpy(key.data() + i, &bits, sizeof(uint64_t));
+  }
+
+  return key;
+}
+
+/**
+ * Measures how fast a log tail is replayed when the tree is opened, depending on the amount of recovery threads.
+ */
+NOID_BENCHMARK(LsmTreeReplay) {
+  const uint64_t record_count = 1000000;
+  const size_t value_size = 100;
+
+  // Keep every record in the memtable, so the whole log is replayed by every open.
+  LsmTreeOptions options;
+  options.memtable_size = 1024 * 1024 * 1024;
+  options.sync_writes = false;
+  options.log_flush_interval = std::chrono::milliseconds(0);
+  options.compaction_threads = 0;
+  {
+    auto tree = LsmTree::Open(directory, options);
+    V value(value_size, 42);
+    for (uint64_t i = 0; i < record_count; i++) {
+      tree->Insert(Key(i % (record_count / 2)), value);
+    }
+    tree->Sync();
+  }
+
+  PrintRow({"threads", "seconds", "records/s", "MB/s"});
+  for (size_t threads : {1, 2, 4, 8}) {
+    options.recovery_threads = threads;
+
+    std::unique_ptr<LsmTree> tree;
+    auto seconds = MeasureSeconds([&]() { tree = LsmTree::Open(directory, options); });
+    tree.reset();
+
+    auto bytes = static_cast<double>(record_count * (BTREE_KEY_SIZE + value_size));
+    PrintRow({std::to_string(threads), Format(seconds, 2), Format(record_count / seconds, 0),
+              Format(bytes / seconds / 1e6)});
+  }
+}
+
+/**
+ * Compares the LSM tree with the in-place copy-on-write tree on the same random blind inserts, by throughput and by
+ * write amplification: the bytes written to storage devices per byte of keys and values inserted. The LSM tree is
+ * given time to finish its compactions before its writes are counted.
+ */
+NOID_BENCHMARK(LsmTreeWriteAmplification) {
+  const uint64_t record_count = 500000;
+  const size_t value_size = 100;
+  const size_t commit_interval = 1000;
+
+  V value(value_size, 42);
+  auto user_bytes = static_cast<double>(record_count * (BTREE_KEY_SIZE + value_size));
+  PrintRow({"tree", "inserts/s", "write MiB", "write amp", "compact MiB"});
+
+  {
+    auto before = ReadIoCounters();
+    double seconds;
+    {
+      CowBPlusTreeOptions options;
+      auto tree = CowBPlusTree::Open(directory / "cow", options);
+      seconds = MeasureSeconds([&]() {
+        for (uint64_t i = 0; i < record_count; i++) {
+          tree->Insert(Key(i), value);
+          if ((i + 1) % commit_interval == 0) {
+            tree->Commit();
+          }
+        }
+        tree->Commit();
+      });
+    }
+    DropFromPageCache(directory / "cow");
+
+    auto written = static_cast<double>(ReadIoCounters().write_bytes - before.write_bytes);
+    PrintRow({"in-place", Format(record_count / seconds, 0), Format(written / (1024 * 1024)),
+              Format(written / user_bytes, 2), "-"});
+  }
+
+  {
+    auto before = ReadIoCounters();
+    double seconds;
+    uint64_t compaction_bytes;
+    {
+      LsmTreeOptions options;
+      options.sync_writes = false;
+      auto tree = LsmTree::Open(directory / "lsm", options);
+      seconds = MeasureSeconds([&]() {
+        for (uint64_t i = 0; i < record_count; i++) {
+          tree->Insert(Key(i), value);
+        }
+        tree->Flush();
+      });
+
+      while (tree->Metrics().pending_compaction_bytes > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+      tree->Sync();
+      compaction_bytes = tree->Metrics().compaction_bytes_written;
+    }
+
+    auto written = static_cast<double>(ReadIoCounters().write_bytes - before.write_bytes);
+    PrintRow({"lsm", Format(record_count / seconds, 0), Format(written / (1024 * 1024)),
+              Format(written / user_bytes, 2), Format(compaction_bytes / (1024. * 1024))});
+  }
+}
+
+/**
+ * Measures inserts and random lookups for value sizes from 64 bytes to 64 KiB, with values stored in the sorted runs
+ * and with values of at least 1 KiB separated into the value log. Every size inserts the same amount of data.
+ */
+NOID_BENCHMARK(LsmTreeValueSeparation) {
+  const uint64_t total_bytes = 64 * 1024 * 1024;
+  const size_t separation_threshold = 1024;
+  const size_t lookup_count = 20000;
+
+  PrintRow({"value size", "separation", "inserts/s", "MB/s", "write amp", "lookups/s"});
+  for (size_t value_size = 64; value_size <= 64 * 1024; value_size *= 4) {
+    for (auto threshold : {size_t{0}, separation_threshold}) {
+      auto path = directory / (std::to_string(value_size) + "-" + std::to_string(threshold));
+      auto record_count = total_bytes / value_size;
+      V value(value_size, 42);
+
+      LsmTreeOptions options;
+      options.sync_writes = false;
+      options.value_separation_threshold = threshold;
+      auto tree = LsmTree::Open(path, options);
+
+      auto before = ReadIoCounters();
+      auto insert_seconds = MeasureSeconds([&]() {
+        for (uint64_t i = 0; i < record_count; i++) {
+          tree->Insert(Key(i), value);
+        }
+        tree->Flush();
+      });
+      while (tree->Metrics().pending_compaction_bytes > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+      tree->Sync();
+      auto written = static_cast<double>(ReadIoCounters().write_bytes - before.write_bytes);
+
+      std::mt19937_64 random(value_size);
+      auto lookup_seconds = MeasureSeconds([&]() {
+        for (size_t i = 0; i < lookup_count; i++) {
+          if (!tree->Find(Key(random() % record_count))) {
+            throw std::runtime_error("A key is missing.");
+          }
+        }
+      });
+
+      auto user_bytes = static_cast<double>(record_count * (BTREE_KEY_SIZE + value_size));
+      PrintRow({std::to_string(value_size), threshold > 0 ? "on" : "off", Format(record_count / insert_seconds, 0),
+                Format(user_bytes / insert_seconds / 1e6), Format(written / user_bytes, 2),
+                Format(lookup_count / lookup_seconds, 0)});
+    }
+  }
+}
@@ -0,0 +1,69 @@
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Benchmark.h"
+#include "storage/AlignedBuffer.h"
+#include "storage/PageFile.h"
+
+using namespace noid::benchmarks;
+using namespace noid::storage;
+
+/**
+ * @return A readable name of the given backend type.
+ */
+static std::string BackendName(IoBackendType type) {
+  return type == IoBackendType::IoUring ? "io_uring" : "pread";
+}
+
+/**
+ * Measures random page reads of both backends, depending on the amount of pages submitted per batch. The file is
+ * read using direct I/O, so every read is served by the device.
+ */
+NOID_BENCHMARK(PageFileQueueDepth) {
+  const PageId page_count = 64 * 1024;
+  const size_t read_count = 16 * 1024;
+  const size_t max_depth = 64;
+
+  auto path = directory / "pages";
+  auto buffer = AllocateAligned(max_depth * PAGE_SIZE);
+  {
+    auto file = PageFile::Open(path);
+    std::vector<PageIo> batch;
+    for (PageId page_id = 0; page_id < page_count; page_id++) {
+      batch.push_back({page_id, buffer.get() + (page_id % max_depth) * PAGE_SIZE});
+      if (batch.size() == max_depth) {
+        file->WriteBatch(batch);
+        batch.clear();
+      }
+    }
+  }
+  DropFromPageCache(path);
+
+  PrintRow({"backend", "depth", "IOPS", "MB/s"});
+  for (auto type : {IoBackendType::Synchronous, IoBackendType::IoUring}) {
+    auto file = PageFile::Open(path, type, true);
+    if (file->BackendType() != type || !file->DirectIo()) {
+      PrintRow({BackendName(type), "unavailable"});
+      continue;
+    }
+
+    for (size_t depth = 1; depth <= max_depth; depth *= 2) {
+      std::mt19937_64 random(depth);
+      auto seconds = MeasureSeconds([&]() {
+        std::vector<PageIo> batch;
+        for (size_t i = 0; i < read_count; i++) {
+          batch.push_back({static_cast<PageId>(random() % page_count), buffer.get() + batch.size() * PAGE_SIZE});
+          if (batch.size() == depth) {
+            file->ReadBatch(batch);
+            batch.clear();
+          }
+        }
+      });
+
+      PrintRow({BackendName(type), std::to_string(depth), Format(read_count / seconds, 0),
+                Format(read_count * PAGE_SIZE / seconds / 1e6)});
+    }
+  }
+}
@@ -1,8 +1,16 @@
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
 
+#include <algorithm>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
 #include <sstream>
 #include <iostream>
+#include <map>
+#include <system_error>
+
+#include <sys/resource.h>
 
 #include "storage/BPlusTree.h"
 #include "storage/BPlusTreeInternalNode.h"
@@ -165,4 +173,356 @@ TEST_F(BPlusTreeFixture, ShrinkTree) {
   tree->Write(buf);
   auto expect_after_shrink = "[2* 5* 13* 15*]\n";
   EXPECT_STREQ(buf.str().c_str(), expect_after_shrink) << "Expect shrunk tree with only a root node";
+}
+
+TEST_F(BPlusTreeFixture, SnapshotBuildsTreeBottomUp) {
+  K key_base = {57, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  // Insert in reverse order to ensure the snapshot is sorted regardless of the insertion order.
+  for (auto i = 9; i >= 0; i--) {
+    K key = key_base;
+    key[BTREE_KEY_SIZE - 1] = i;
+    V value(i, static_cast<byte>(i));
+
+    tree->Insert(key, value);
+  }
+
+  auto path = std::filesystem::temp_directory_path() / "noid-snapshot-bottom-up";
+  tree->SaveSnapshot(path);
+
+  BPlusTree loaded(BTREE_MIN_ORDER);
+  loaded.LoadSnapshot(path);
+
+  std::stringstream buf;
+  loaded.Write(buf);
+
+  // Ten records are spread evenly over as few leaves as possible, and the leaves share a single parent.
+  EXPECT_STREQ(buf.str().c_str(), "[4 7]\n[0* 1* 2* 3*] [4* 5* 6*] [7* 8* 9*]\n");
+
+  auto remove_key = key_base;
+  remove_key[BTREE_KEY_SIZE - 1] = 9;
+  auto removed = loaded.Remove(remove_key);
+
+  EXPECT_TRUE(removed.has_value()) << "Expect a removed value";
+  EXPECT_THAT(removed.value(), ContainerEq(V(9, 9)));
+
+  std::filesystem::remove(path);
+}
+
+TEST_F(BPlusTreeFixture, SnapshotRoundTrip) {
+  K key_base = {57, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  for (auto i = 0; i < 1000; i++) {
+    K key = key_base;
+    key[BTREE_KEY_SIZE - 2] = static_cast<byte>(i * 7 / 256);
+    key[BTREE_KEY_SIZE - 1] = static_cast<byte>(i * 7);
+    V value(i % 50, static_cast<byte>(i));
+
+    tree->Insert(key, value);
+  }
+
+  auto first = std::filesystem::temp_directory_path() / "noid-snapshot-first";
+  auto second = std::filesystem::temp_directory_path() / "noid-snapshot-second";
+  tree->SaveSnapshot(first);
+
+  // Load into a tree of another order, which must not change the contents of the tree.
+  BPlusTree loaded(5);
+  loaded.LoadSnapshot(first);
+  loaded.SaveSnapshot(second);
+
+  std::ifstream lhs(first, std::ios::binary);
+  std::ifstream rhs(second, std::ios::binary);
+  std::vector<char> lhs_bytes((std::istreambuf_iterator<char>(lhs)), std::istreambuf_iterator<char>());
+  std::vector<char> rhs_bytes((std::istreambuf_iterator<char>(rhs)), std::istreambuf_iterator<char>());
+
+  EXPECT_FALSE(lhs_bytes.empty());
+  EXPECT_EQ(lhs_bytes, rhs_bytes) << "Expect a loaded snapshot to contain exactly the saved records";
+
+  std::filesystem::remove(first);
+  std::filesystem::remove(second);
+}
+
+TEST_F(BPlusTreeFixture, CorruptSnapshot) {
+  K key = {57, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  V value = {1, 3, 3, 7};
+  tree->Insert(key, value);
+
+  auto path = std::filesystem::temp_directory_path() / "noid-snapshot-corrupt";
+  tree->SaveSnapshot(path);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+  BPlusTree loaded(BTREE_MIN_ORDER);
+  EXPECT_THROW(loaded.LoadSnapshot(path), std::runtime_error) << "Expect a truncated snapshot to be rejected";
+  EXPECT_EQ(loaded.Root(), nullptr) << "Expect a failed load to leave the tree unchanged";
+
+  std::filesystem::remove(path);
+}
+
+TEST_F(BPlusTreeFixture, FailedSnapshotIsRemoved) {
+  K key_base = {57, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  for (auto i = 0; i < 32; i++) {
+    K key = key_base;
+    key[BTREE_KEY_SIZE - 1] = i;
+    V value(64 * 1024, static_cast<byte>(i));
+
+    tree->Insert(key, value);
+  }
+
+  auto path = std::filesystem::temp_directory_path() / "noid-snapshot-failed";
+  auto temporary_path = path;
+  temporary_path += ".tmp";
+
+  // Limiting the file size makes the write fail with EFBIG instead of raising SIGXFSZ.
+  struct rlimit original{};
+  ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &original), 0);
+  auto handler = std::signal(SIGXFSZ, SIG_IGN);
+  struct rlimit limited = original;
+  limited.rlim_cur = 1024;
+  ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limited), 0);
+
+  EXPECT_THROW(tree->SaveSnapshot(path), std::system_error);
+  ::setrlimit(RLIMIT_FSIZE, &original);
+  std::signal(SIGXFSZ, handler);
+
+  EXPECT_FALSE(std::filesystem::exists(temporary_path)) << "Expect the temporary file of a failed snapshot to be gone";
+  EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST_F(BPlusTreeFixture, LoadBuildsTreeBottomUp) {
+  K key_base = {57, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+  std::vector<std::pair<K, V>> records;
+  for (auto i = 0; i < 10; i++) {
+    K key = key_base;
+    key[BTREE_KEY_SIZE - 1] = i;
+    records.emplace_back(key, V(i, static_cast<byte>(i)));
+  }
+
+  auto unsorted = records;
+  std::swap(unsorted[3], unsorted[4]);
+  EXPECT_THROW(tree->Load(unsorted), std::invalid_argument) << "Expect unsorted records to be rejected";
+  EXPECT_EQ(tree->Root(), nullptr) << "Expect a failed load to leave the tree unchanged";
+
+  tree->Load(records);
+
+  std::stringstream buf;
+  tree->Write(buf);
+  EXPECT_STREQ(buf.str().c_str(), "[4 7]\n[0* 1* 2* 3*] [4* 5* 6*] [7* 8* 9*]\n");
+
+  K key = key_base;
+  key[BTREE_KEY_SIZE - 1] = 6;
+  EXPECT_THAT(tree->Find(key).value(), ContainerEq(V(6, 6)));
+
+  V value(1, 10);
+  key[BTREE_KEY_SIZE - 1] = 10;
+  tree->Insert(key, value);
+  EXPECT_TRUE(tree->Find(key).has_value()) << "Expect a loaded tree to accept inserts";
+
+  tree->Load({});
+  EXPECT_EQ(tree->Root(), nullptr) << "Expect loading no records to empty the tree";
+}
+
+TEST_F(BPlusTreeFixture, ReleasesNodes) {
+  K key_base = {57, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  V value = {1, 3, 3, 7};
+
+  // Collects the root and all leaves, which link to their parents and siblings.
+  auto collect = [this]() {
+    std::vector<std::weak_ptr<BPlusTreeNode>> nodes;
+    auto root = dynamic_cast<BPlusTreeInternalNode*>(tree->Root());
+    nodes.emplace_back(root->shared_from_this());
+
+    std::shared_ptr<BPlusTreeNode> node = root->Keys()[0]->left_child;
+    while (auto internal = std::dynamic_pointer_cast<BPlusTreeInternalNode>(node)) {
+      node = internal->Keys()[0]->left_child;
+    }
+    for (auto leaf = std::dynamic_pointer_cast<BPlusTreeLeafNode>(node); leaf; leaf = leaf->Next()) {
+      nodes.emplace_back(leaf);
+    }
+
+    return nodes;
+  };
+  auto expired = [](const std::vector<std::weak_ptr<BPlusTreeNode>>& nodes) {
+    return std::all_of(nodes.begin(), nodes.end(), [](const auto& node) { return node.expired(); });
+  };
+
+  for (auto i = 0; i < 100; i++) {
+    K key = key_base;
+    key[BTREE_KEY_SIZE - 1] = i;
+    tree->Insert(key, value);
+  }
+
+  auto inserted = collect();
+  EXPECT_GT(inserted.size(), 10);
+  EXPECT_FALSE(expired(inserted));
+
+  std::vector<std::pair<K, V>> records;
+  for (auto i = 0; i < 100; i++) {
+    K key = key_base;
+    key[BTREE_KEY_SIZE - 1] = i;
+    records.emplace_back(key, value);
+  }
+  tree->Load(records);
+  EXPECT_TRUE(expired(inserted)) << "Expect the replaced nodes to be freed";
+
+  auto loaded = collect();
+  delete tree;
+  tree = nullptr;
+  EXPECT_TRUE(expired(loaded)) << "Expect the nodes of a destroyed tree to be freed";
+}
+
+TEST_F(BPlusTreeFixture, ExportsChangesSinceSequence) {
+  K key_base = {57, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  auto key = [&key_base](int i) {
+    K k = key_base;
+    k[BTREE_KEY_SIZE - 1] = static_cast<byte>(i);
+    return k;
+  };
+  auto export_since = [this](uint64_t since) {
+    std::vector<std::pair<K, std::optional<V>>> changes;
+    tree->ExportSince(since, [&changes](const K& k, const V* v) {
+      changes.emplace_back(k, v ? std::optional<V>(*v) : std::nullopt);
+      return true;
+    });
+    return changes;
+  };
+
+  for (auto i = 0; i < 100; i++) {
+    V value(1, static_cast<byte>(i));
+    tree->Insert(key(i), value);
+  }
+  EXPECT_EQ(tree->Sequence(), 100);
+  EXPECT_EQ(export_since(0).size(), 100) << "Expect every key to be changed since the first sequence number";
+
+  auto since = tree->Sequence();
+  V replacement(1, 200);
+  tree->Insert(key(70), replacement);
+  replacement = V(1, 200);
+  tree->Remove(key(5));
+  tree->Remove(key(90));
+  tree->Remove(key(40));
+  V reinserted(1, 201);
+  tree->Insert(key(40), reinserted);
+  reinserted = V(1, 201);
+  EXPECT_FALSE(tree->Remove(key(150)).has_value());
+  EXPECT_EQ(tree->Sequence(), since + 5) << "Expect only actual modifications to be stamped";
+
+  auto changes = export_since(since);
+  ASSERT_EQ(changes.size(), 4);
+  EXPECT_EQ(changes[0], std::make_pair(key(5), std::optional<V>())) << "Expect removals to be exported in key order";
+  EXPECT_EQ(changes[1], std::make_pair(key(40), std::optional<V>(reinserted)));
+  EXPECT_EQ(changes[2], std::make_pair(key(70), std::optional<V>(replacement)));
+  EXPECT_EQ(changes[3], std::make_pair(key(90), std::optional<V>()));
+  EXPECT_TRUE(export_since(tree->Sequence()).empty()) << "Expect no changes since the latest sequence number";
+
+  size_t consumed = 0;
+  tree->ExportSince(since, [&consumed](const K&, const V*) { return ++consumed < 2; });
+  EXPECT_EQ(consumed, 2) << "Expect the export to stop when the consumer returns false";
+
+  tree->ForgetRemovals(since + 2);
+  EXPECT_THROW(export_since(since), std::invalid_argument) << "Expect forgotten removals not to be exported";
+  EXPECT_EQ(export_since(since + 2).size(), 2);
+
+  std::vector<std::pair<K, V>> records = {{key(1), V(1, 1)}, {key(2), V(1, 2)}};
+  tree->Load(records);
+  EXPECT_THROW(export_since(since + 5), std::invalid_argument) << "Expect a load to hide the removed keys";
+  EXPECT_TRUE(export_since(tree->Sequence()).empty()) << "Expect loaded records to be stamped by the load";
+
+  V value(1, 3);
+  tree->Insert(key(3), value);
+  EXPECT_EQ(export_since(tree->Sequence() - 1).size(), 1);
+}
+
+TEST_F(BPlusTreeFixture, DiffsTreesByHash) {
+  K key_base = {57, 5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+  auto key = [&key_base](int i) {
+    K k = key_base;
+    k[BTREE_KEY_SIZE - 2] = static_cast<byte>(i >> 8);
+    k[BTREE_KEY_SIZE - 1] = static_cast<byte>(i);
+    return k;
+  };
+  auto insert = [&key](BPlusTree& t, int i, byte b) {
+    V value(1 + i % 13, b);
+    t.Insert(key(i), value);
+  };
+  auto records = [](BPlusTree& t) {
+    std::map<K, V> scanned;
+    t.Scan([&scanned](const K& k, const V& v) {
+      scanned.emplace(k, v);
+      return true;
+    });
+    return scanned;
+  };
+  auto diff = [](BPlusTree& t, BPlusTree& other) {
+    std::vector<K> keys;
+    t.Diff(other, [&keys](const K& k, const V*, const V*) {
+      keys.push_back(k);
+      return true;
+    });
+    return keys;
+  };
+
+  // The replica has a different order, and receives the same records in the opposite order.
+  BPlusTree replica(BTREE_MIN_ORDER + 1);
+  for (auto i = 0; i < 500; i++) {
+    insert(*tree, i, 1);
+    insert(replica, 499 - i, 1);
+  }
+  EXPECT_EQ(tree->Root()->Hash(), replica.Root()->Hash()) << "Expect the hash not to depend on the tree shape";
+  EXPECT_TRUE(diff(*tree, replica).empty());
+
+  insert(*tree, 17, 2);
+  insert(replica, 600, 1);
+  insert(*tree, 610, 1);
+  insert(replica, 250, 3);
+  insert(*tree, 420, 4);
+  insert(replica, 420, 4);
+
+  // Compute the expected differences from the actual contents of both trees.
+  auto mine = records(*tree);
+  auto theirs = records(replica);
+  std::vector<K> expected;
+  for (auto i = 0; i <= 700; i++) {
+    auto a = mine.find(key(i));
+    auto b = theirs.find(key(i));
+    if ((a == mine.end()) != (b == theirs.end()) || (a != mine.end() && a->second != b->second)) {
+      expected.push_back(key(i));
+    }
+  }
+  ASSERT_FALSE(expected.empty());
+  EXPECT_THAT(diff(*tree, replica), ContainerEq(expected)) << "Expect every differing key to be found in key order";
+
+  std::vector<K> reversed;
+  replica.Diff(*tree, [&reversed, &mine, &theirs](const K& k, const V* value, const V* other_value) {
+    EXPECT_EQ(value != nullptr, theirs.count(k) > 0);
+    EXPECT_EQ(other_value != nullptr, mine.count(k) > 0);
+    reversed.push_back(k);
+    return true;
+  });
+  EXPECT_THAT(reversed, ContainerEq(expected));
+
+  // A tree built bottom-up from the same records has the same hash as one maintained incrementally.
+  BPlusTree loaded(BTREE_MIN_ORDER);
+  loaded.Load(std::vector<std::pair<K, V>>(mine.begin(), mine.end()));
+  EXPECT_EQ(loaded.Root()->Hash(), tree->Root()->Hash()) << "Expect hashes to be maintained on every modification";
+
+  // Removals rearrange the records of the leaves, which must keep their hashes up to date as well.
+  BPlusTree small(BTREE_MIN_ORDER);
+  BPlusTree small_replica(BTREE_MIN_ORDER);
+  for (auto i : {2, 5, 12, 13, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 29}) {
+    insert(small, i, 1);
+    insert(small_replica, i, 1);
+  }
+  // Hashes are computed on demand, so computing them first checks that the removal invalidates them.
+  auto before_removal = small.Root()->Hash();
+  small.Remove(key(20));
+  EXPECT_NE(small.Root()->Hash(), before_removal);
+  BPlusTree small_loaded(BTREE_MIN_ORDER);
+  auto remaining = records(small);
+  small_loaded.Load(std::vector<std::pair<K, V>>(remaining.begin(), remaining.end()));
+  EXPECT_EQ(small.Root()->Hash(), small_loaded.Root()->Hash()) << "Expect the hash to be maintained on a merge";
+  EXPECT_THAT(diff(small, small_replica), ContainerEq(std::vector<K>{key(20)}));
+
+  BPlusTree empty(BTREE_MIN_ORDER);
+  EXPECT_EQ(diff(empty, *tree).size(), mine.size()) << "Expect every key to differ from an empty tree";
 }
\ No newline at end of file
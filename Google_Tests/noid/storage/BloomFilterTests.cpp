@@ -0,0 +1,81 @@
+#include "gtest/gtest.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "storage/BloomFilter.h"
+
+using namespace noid::storage;
+
+static K Key(uint32_t i) {
+  K key{};
+  key[12] = static_cast<byte>(i >> 24);
+  key[13] = static_cast<byte>(i >> 16);
+  key[14] = static_cast<byte>(i >> 8);
+  key[15] = static_cast<byte>(i);
+
+  return key;
+}
+
+static BloomFilter Build(uint32_t count, uint8_t bits_per_key) {
+  std::vector<uint64_t> hashes;
+  for (uint32_t i = 0; i < count; i++) {
+    hashes.push_back(BloomFilter::Hash(Key(2 * i)));
+  }
+
+  return BloomFilter::Build(hashes, bits_per_key);
+}
+
+/**
+ * @return The fraction of absent keys reported as possibly contained.
+ */
+static double FalsePositiveRate(const BloomFilter& filter, uint32_t count) {
+  uint32_t false_positives = 0;
+  for (uint32_t i = 0; i < count; i++) {
+    false_positives += filter.MayContain(Key(2 * i + 1)) ? 1 : 0;
+  }
+
+  return static_cast<double>(false_positives) / count;
+}
+
+TEST(BloomFilter, NoFalseNegatives) {
+  auto filter = Build(10000, 10);
+
+  for (uint32_t i = 0; i < 10000; i++) {
+    ASSERT_TRUE(filter.MayContain(Key(2 * i))) << "Expect every added key to be reported as possibly contained";
+  }
+}
+
+TEST(BloomFilter, FalsePositiveRate) {
+  auto small = Build(10000, 6);
+  auto large = Build(10000, 16);
+
+  EXPECT_LT(FalsePositiveRate(Build(10000, 10), 10000), 0.02)
+      << "Expect about one percent false positives using ten bits per key";
+  EXPECT_LT(FalsePositiveRate(large, 10000), FalsePositiveRate(small, 10000))
+      << "Expect more bits per key to yield fewer false positives";
+  EXPECT_GT(large.Size(), small.Size());
+}
+
+TEST(BloomFilter, EncodeAndDecode) {
+  auto filter = Build(1000, 10);
+  std::vector<byte> encoded;
+  filter.Encode(encoded);
+
+  auto decoded = BloomFilter::Decode(encoded.data(), encoded.size());
+  EXPECT_EQ(decoded.Size(), filter.Size());
+  for (uint32_t i = 0; i < 2000; i++) {
+    EXPECT_EQ(decoded.MayContain(Key(i)), filter.MayContain(Key(i)));
+  }
+
+  EXPECT_THROW(BloomFilter::Decode(encoded.data(), encoded.size() - 1), std::runtime_error)
+      << "Expect a truncated filter to be rejected";
+}
+
+TEST(BloomFilter, EmptyFilterMayContainAnyKey) {
+  auto filter = Build(1000, 0);
+
+  EXPECT_EQ(filter.Size(), 0);
+  EXPECT_TRUE(filter.MayContain(Key(1)));
+  EXPECT_TRUE(BloomFilter().MayContain(Key(1)));
+}
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "storage/BufferPool.h"
+#include "storage/PageFile.h"
+#include "storage/WriteAheadLog.h"
+
+using namespace noid::storage;
+
+class BufferPoolFixture : public ::testing::Test {
+ protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-pool-") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+      std::filesystem::remove_all(directory);
+      std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(directory);
+    }
+};
+
+TEST_F(BufferPoolFixture, EvictionWritesDirtyPages) {
+  std::shared_ptr<PageFile> file = PageFile::Open(directory / "pages");
+  std::shared_ptr<WriteAheadLog> log = WriteAheadLog::Open(directory / "wal");
+  BufferPool pool(file, 2, log);
+
+  for (PageId id = 0; id < 4; id++) {
+    auto page = pool.Fetch(id);
+    std::unique_lock<std::shared_mutex> latch(page.Latch());
+
+    page.MutableData()[PAGE_HEADER_SIZE] = static_cast<byte>(id + 1);
+    byte record[] = {static_cast<byte>(id)};
+    EXPECT_EQ(page.Log(record, sizeof(record)), id + 1);
+  }
+
+  EXPECT_GE(log->FlushedLsn(), 2) << "Expect evictions to flush the log before writing pages";
+
+  for (PageId id = 0; id < 4; id++) {
+    auto page = pool.Fetch(id);
+
+    Lsn lsn;
+    std::memcpy(&lsn, page.Data(), sizeof(Lsn));
+    EXPECT_EQ(page.Data()[PAGE_HEADER_SIZE], id + 1) << "Expect page " << id << " to survive eviction";
+    EXPECT_EQ(lsn, id + 1) << "Expect the page LSN to be stored in the page header";
+  }
+}
+
+TEST_F(BufferPoolFixture, AllFramesPinned) {
+  std::shared_ptr<PageFile> file = PageFile::Open(directory / "pages");
+  BufferPool pool(file, 1);
+
+  auto page = pool.Fetch(0);
+  EXPECT_THROW(pool.Fetch(1), std::runtime_error) << "Expect fetching to fail if no frame can be evicted";
+}
+
+TEST_F(BufferPoolFixture, CheckpointBoundaries) {
+  std::shared_ptr<PageFile> file = PageFile::Open(directory / "pages");
+  std::shared_ptr<WriteAheadLog> log = WriteAheadLog::Open(directory / "wal");
+  BufferPool pool(file, 4, log);
+  byte record[] = {0};
+
+  {
+    auto page = pool.Fetch(0);
+    std::unique_lock<std::shared_mutex> latch(page.Latch());
+    page.Log(record, sizeof(record));
+    page.Log(record, sizeof(record));
+  }
+
+  const auto [begin_lsn, dirty_pages] = pool.BeginCheckpoint();
+  EXPECT_EQ(begin_lsn, 3);
+  EXPECT_EQ(dirty_pages, std::vector<PageId>({0}));
+  EXPECT_EQ(pool.OldestRecoveryLsn(), 1) << "Expect the recovery LSN to be the first modification";
+
+  EXPECT_TRUE(pool.FlushPage(0));
+  EXPECT_FALSE(pool.FlushPage(0)) << "Expect a clean page not to be written";
+  EXPECT_EQ(pool.OldestRecoveryLsn(), INVALID_LSN);
+}
+
+TEST_F(BufferPoolFixture, FetchVerifiesChecksums) {
+  std::shared_ptr<PageFile> file = PageFile::Open(directory / "pages");
+  {
+    BufferPool pool(file, 2);
+    for (PageId id = 0; id < 2; id++) {
+      auto page = pool.Fetch(id);
+      std::unique_lock<std::shared_mutex> latch(page.Latch());
+      page.MutableData()[PAGE_HEADER_SIZE] = 42;
+      page.MarkDirty();
+    }
+    pool.FlushAll();
+  }
+
+  auto data = std::make_unique<byte[]>(PAGE_SIZE);
+  file->Read(1, data.get());
+  EXPECT_TRUE(VerifyPage(data.get())) << "Expect written pages to contain their checksum";
+
+  data[PAGE_SIZE - 1] ^= 1;
+  file->Write(1, data.get());
+
+  BufferPool pool(file, 2);
+  EXPECT_EQ(pool.Fetch(0).Data()[PAGE_HEADER_SIZE], 42);
+  EXPECT_EQ(pool.Fetch(2).Data()[PAGE_HEADER_SIZE], 0) << "Expect a page that was never written to be valid";
+  EXPECT_THROW(pool.Fetch(1), std::runtime_error) << "Expect a corrupt page to be rejected";
+  EXPECT_EQ(pool.CachedPageCount(), 1) << "Expect the frame of a rejected page to be released";
+  EXPECT_THROW(pool.Fetch(1), std::runtime_error) << "Expect a rejected page to be read again";
+}
+
+TEST_F(BufferPoolFixture, ConcurrentFetchesEvictDirtyPages) {
+  std::shared_ptr<PageFile> file = PageFile::Open(directory / "pages");
+  std::shared_ptr<WriteAheadLog> log = WriteAheadLog::Open(directory / "wal");
+  const PageId page_count = 64;
+  const int increments = 2000;
+
+  {
+    // Every thread pins at most one page, and every eviction at most one while writing it back.
+    BufferPool pool(file, 16, log);
+    std::vector<std::thread> threads;
+    for (auto t = 0; t < 4; t++) {
+      threads.emplace_back([&pool, t]() {
+        std::mt19937 random(t);
+        for (auto i = 0; i < increments; i++) {
+          auto page = pool.Fetch(random() % page_count);
+          std::unique_lock<std::shared_mutex> latch(page.Latch());
+
+          uint32_t counter;
+          std::memcpy(&counter, page.Data() + PAGE_HEADER_SIZE, sizeof(uint32_t));
+          counter++;
+          std::memcpy(page.MutableData() + PAGE_HEADER_SIZE, &counter, sizeof(uint32_t));
+
+          byte record[] = {static_cast<byte>(t)};
+          page.Log(record, sizeof(record));
+        }
+      });
+    }
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    pool.FlushAll();
+  }
+
+  BufferPool pool(file, 4);
+  uint64_t total = 0;
+  for (PageId id = 0; id < page_count; id++) {
+    uint32_t counter;
+    std::memcpy(&counter, pool.Fetch(id).Data() + PAGE_HEADER_SIZE, sizeof(uint32_t));
+    total += counter;
+  }
+  EXPECT_EQ(total, 4 * increments) << "Expect no modification to be lost by concurrent evictions";
+}
+
+TEST_F(BufferPoolFixture, Prefetch) {
+  std::shared_ptr<PageFile> file = PageFile::Open(directory / "pages");
+  {
+    BufferPool pool(file, 8);
+    for (PageId id = 0; id < 8; id++) {
+      auto page = pool.Fetch(id);
+      std::unique_lock<std::shared_mutex> latch(page.Latch());
+      page.MutableData()[PAGE_HEADER_SIZE] = static_cast<byte>(id + 1);
+      page.MarkDirty();
+    }
+    pool.FlushAll();
+  }
+
+  auto data = std::make_unique<byte[]>(PAGE_SIZE);
+  file->Read(3, data.get());
+  data[PAGE_SIZE - 1] ^= 1;
+  file->Write(3, data.get());
+
+  BufferPool pool(file, 16);
+  EXPECT_EQ(pool.Prefetch({0, 1, 2, 3}), 3) << "Expect the corrupt page to be dropped";
+  EXPECT_EQ(pool.Prefetch({0, 1, 2}), 0) << "Expect cached pages to be skipped";
+  EXPECT_EQ(pool.Prefetch({4, 5, 6, 7, 8, 9}), 4) << "Expect at most a quarter of the pool to be prefetched at once";
+
+  for (PageId id = 0; id < 8; id++) {
+    if (id != 3) {
+      EXPECT_EQ(pool.Fetch(id).Data()[PAGE_HEADER_SIZE], id + 1);
+    }
+  }
+  EXPECT_THROW(pool.Fetch(3), std::runtime_error) << "Expect a corrupt page to be rejected when it is fetched";
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+#include "storage/BufferPool.h"
+#include "storage/Checkpointer.h"
+#include "storage/PageFile.h"
+#include "storage/WriteAheadLog.h"
+
+using namespace noid::storage;
+
+class CheckpointerFixture : public ::testing::Test {
+ protected:
+    std::filesystem::path directory;
+    std::shared_ptr<PageFile> file;
+    std::shared_ptr<WriteAheadLog> log;
+    std::shared_ptr<BufferPool> pool;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-checkpointer-") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+      std::filesystem::remove_all(directory);
+      std::filesystem::create_directories(directory);
+
+      file = PageFile::Open(directory / "pages");
+      log = WriteAheadLog::Open(directory / "wal", 1);
+      pool = std::make_shared<BufferPool>(file, 16, log);
+    }
+
+    void TearDown() override {
+      pool.reset();
+      log.reset();
+      file.reset();
+      std::filesystem::remove_all(directory);
+    }
+
+    void Modify(PageId page_id, byte value) {
+      auto page = pool->Fetch(page_id);
+      std::unique_lock<std::shared_mutex> latch(page.Latch());
+
+      page.MutableData()[PAGE_HEADER_SIZE] = value;
+      byte record[] = {static_cast<byte>(page_id), value};
+      log->Flush(page.Log(record, sizeof(record)));
+    }
+};
+
+TEST_F(CheckpointerFixture, CheckpointWritesDirtyPages) {
+  Checkpointer checkpointer(pool, log);
+
+  for (PageId id = 0; id < 8; id++) {
+    Modify(id, 42);
+  }
+
+  auto lsn = checkpointer.Checkpoint();
+  EXPECT_EQ(lsn, 9) << "Expect the checkpoint LSN to follow the last record if no page is dirty";
+  EXPECT_EQ(log->CheckpointLsn(), 9);
+  EXPECT_EQ(log->SegmentCount(), 1) << "Expect all segments preceding the checkpoint to be recycled";
+
+  auto metrics = checkpointer.Metrics();
+  EXPECT_EQ(metrics.checkpoints, 1);
+  EXPECT_EQ(metrics.pages_written, 8);
+  EXPECT_EQ(metrics.bytes_written, 8 * PAGE_SIZE);
+  EXPECT_EQ(metrics.checkpoint_lsn, 9);
+
+  byte buffer[PAGE_SIZE];
+  file->Read(7, buffer);
+  EXPECT_EQ(buffer[PAGE_HEADER_SIZE], 42) << "Expect the dirty page to be written to the page file";
+}
+
+TEST_F(CheckpointerFixture, BackgroundCheckpointsWhileWriting) {
+  Checkpointer checkpointer(pool, log, {std::chrono::milliseconds(1), 64 * PAGE_SIZE});
+  checkpointer.Start();
+
+  std::thread writer([&] {
+    for (auto i = 0; i < 500; i++) {
+      Modify(i % 8, static_cast<byte>(i));
+    }
+  });
+
+  writer.join();
+  checkpointer.Stop();
+  checkpointer.Checkpoint();
+
+  auto metrics = checkpointer.Metrics();
+  EXPECT_GT(metrics.checkpoints, 1) << "Expect background checkpoints to run while writing";
+  EXPECT_EQ(metrics.failed_checkpoints, 0);
+  EXPECT_EQ(log->CheckpointLsn(), log->LastLsn() + 1) << "Expect a final checkpoint to cover all records";
+
+  byte buffer[PAGE_SIZE];
+  file->Read(3, buffer);
+  EXPECT_EQ(buffer[PAGE_HEADER_SIZE], static_cast<byte>(499)) << "Expect the latest page image to be written";
+}
\ No newline at end of file
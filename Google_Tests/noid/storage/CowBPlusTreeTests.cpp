@@ -0,0 +1,527 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "storage/CowBPlusTree.h"
+
+using namespace noid::storage;
+
+class CowBPlusTreeFixture : public ::testing::Test {
+ protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-cow-") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+      std::filesystem::remove_all(directory);
+      std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(directory);
+    }
+
+    static K Key(uint32_t i) {
+      K key{};
+      key[12] = static_cast<byte>(i >> 24);
+      key[13] = static_cast<byte>(i >> 16);
+      key[14] = static_cast<byte>(i >> 8);
+      key[15] = static_cast<byte>(i);
+
+      return key;
+    }
+
+    static V Value(uint32_t i, size_t size = 100) {
+      return V(size, static_cast<byte>(i));
+    }
+};
+
+TEST_F(CowBPlusTreeFixture, CommitAndReopen) {
+  {
+    auto tree = CowBPlusTree::Open(directory / "tree");
+    for (uint32_t i = 0; i < 2000; i++) {
+      EXPECT_EQ(tree->Insert(Key(i * 7 % 2000), Value(i * 7 % 2000)), InsertType::Insert);
+    }
+    EXPECT_EQ(tree->Insert(Key(5), Value(6)), InsertType::Upsert);
+    EXPECT_EQ(tree->Commit(), 1);
+
+    tree->Insert(Key(5000), Value(1));
+    EXPECT_TRUE(tree->Find(Key(5000))) << "Expect the writer to see its uncommitted modifications";
+  }
+
+  auto tree = CowBPlusTree::Open(directory / "tree");
+  EXPECT_EQ(tree->Committed().number, 1);
+  EXPECT_EQ(tree->Committed().record_count, 2000);
+  EXPECT_FALSE(tree->Find(Key(5000))) << "Expect uncommitted modifications to be lost";
+  EXPECT_EQ(tree->Find(Key(5)), Value(6));
+
+  auto snapshot = tree->Snapshot();
+  uint32_t expected = 0;
+  snapshot.Scan(Key(0), [&expected](const K& key, const V& value) {
+    EXPECT_EQ(key, Key(expected)) << "Expect records in key order";
+    EXPECT_EQ(value.size(), 100);
+    expected++;
+    return true;
+  });
+  EXPECT_EQ(expected, 2000);
+}
+
+TEST_F(CowBPlusTreeFixture, SnapshotIsolation) {
+  auto tree = CowBPlusTree::Open(directory / "tree");
+  for (uint32_t i = 0; i < 500; i++) {
+    tree->Insert(Key(i), Value(i));
+  }
+  tree->Commit();
+
+  auto snapshot = tree->Snapshot();
+  for (uint32_t i = 0; i < 500; i += 2) {
+    tree->Remove(Key(i));
+  }
+  tree->Insert(Key(1), Value(42));
+  tree->Commit();
+
+  EXPECT_EQ(snapshot.Version().number, 1);
+  EXPECT_EQ(snapshot.Find(Key(0)), Value(0)) << "Expect a snapshot not to observe later commits";
+  EXPECT_EQ(snapshot.Find(Key(1)), Value(1)) << "Expect a snapshot not to observe later commits";
+  EXPECT_GT(tree->PendingPageCount(), 0) << "Expect pages of the pinned version not to be reclaimed";
+
+  auto latest = tree->Snapshot();
+  EXPECT_FALSE(latest.Find(Key(0)));
+  EXPECT_EQ(latest.Find(Key(1)), Value(42));
+  EXPECT_EQ(latest.Version().record_count, 250);
+}
+
+TEST_F(CowBPlusTreeFixture, ReclaimPages) {
+  auto tree = CowBPlusTree::Open(directory / "tree");
+  for (uint32_t i = 0; i < 1000; i++) {
+    tree->Insert(Key(i), Value(i));
+  }
+  tree->Commit();
+
+  {
+    auto snapshot = tree->Snapshot();
+    for (uint32_t i = 0; i < 1000; i++) {
+      tree->Insert(Key(i), Value(i + 1));
+    }
+    tree->Commit();
+    EXPECT_GT(tree->PendingPageCount(), 0);
+  }
+
+  tree->Insert(Key(0), Value(0));
+  tree->Commit();
+  EXPECT_EQ(tree->PendingPageCount(), 0) << "Expect pages to be reclaimed once no snapshot refers to them";
+
+  // Rewriting all records repeatedly must reuse the reclaimed pages instead of growing the file.
+  auto page_count = tree->PageCount();
+  for (auto round = 0; round < 5; round++) {
+    for (uint32_t i = 0; i < 1000; i++) {
+      tree->Insert(Key(i), Value(i + round));
+    }
+    tree->Commit();
+  }
+  EXPECT_LE(tree->PageCount(), page_count + PAGE_ALLOCATOR_EXTENT_SIZE) << "Expect reclaimed pages to be reused";
+}
+
+TEST_F(CowBPlusTreeFixture, Rollback) {
+  auto tree = CowBPlusTree::Open(directory / "tree");
+  tree->Insert(Key(1), Value(1));
+  tree->Commit();
+
+  tree->Insert(Key(2), Value(2));
+  tree->Remove(Key(1));
+  tree->Rollback();
+
+  EXPECT_EQ(tree->Find(Key(1)), Value(1));
+  EXPECT_FALSE(tree->Find(Key(2)));
+  EXPECT_EQ(tree->Commit(), 1) << "Expect nothing to commit after a rollback";
+}
+
+TEST_F(CowBPlusTreeFixture, RandomWorkload) {
+  auto tree = CowBPlusTree::Open(directory / "tree", {64});
+  std::map<K, V> expected;
+  std::mt19937 random(7);
+
+  for (auto round = 0; round < 20; round++) {
+    for (auto i = 0; i < 500; i++) {
+      auto id = static_cast<uint32_t>(random() % 3000);
+      if (random() % 3 == 0) {
+        EXPECT_EQ(tree->Remove(Key(id)).has_value(), expected.erase(Key(id)) > 0);
+      } else {
+        auto value = Value(id, random() % (2 * COW_MAX_INLINE_VALUE_SIZE));
+        tree->Insert(Key(id), value);
+        expected[Key(id)] = value;
+      }
+    }
+    tree->Commit();
+  }
+
+  auto snapshot = tree->Snapshot();
+  EXPECT_EQ(snapshot.Version().record_count, expected.size());
+
+  auto entry = expected.begin();
+  snapshot.Scan(Key(0), [&](const K& key, const V& value) {
+    EXPECT_EQ(key, entry->first);
+    EXPECT_EQ(value, entry->second);
+    entry++;
+    return true;
+  });
+  EXPECT_EQ(entry, expected.end());
+
+  for (auto& [key, value] : expected) {
+    tree->Remove(key);
+  }
+  tree->Commit();
+  EXPECT_EQ(tree->Committed().root, INVALID_PAGE_ID) << "Expect removing all records to leave an empty tree";
+}
+
+TEST_F(CowBPlusTreeFixture, ScanReadsAhead) {
+  {
+    auto tree = CowBPlusTree::Open(directory / "tree");
+    for (uint32_t i = 0; i < 20000; i++) {
+      tree->Insert(Key(i), Value(i));
+    }
+    tree->Commit();
+  }
+
+  // A small pool forces most leaves to be read during the scan, concurrently with the readahead.
+  auto tree = CowBPlusTree::Open(directory / "tree", {16});
+  auto snapshot = tree->Snapshot();
+  uint32_t i = 100;
+  snapshot.Scan(Key(100), [&](const K& key, const V& value) {
+    EXPECT_EQ(key, Key(i));
+    EXPECT_EQ(value, Value(i));
+    i++;
+    return true;
+  });
+  EXPECT_EQ(i, 20000);
+
+  i = 0;
+  snapshot.ScanKeys(Key(0), [&](const K&) {
+    return ++i < 5000;
+  });
+  EXPECT_EQ(i, 5000) << "Expect a scan to stop when the consumer returns false";
+}
+
+TEST_F(CowBPlusTreeFixture, OverflowValues) {
+  V large(1024 * 1024 + 7);
+  for (size_t i = 0; i < large.size(); i++) {
+    large[i] = static_cast<byte>(i * 31 + i / 4096);
+  }
+
+  {
+    auto tree = CowBPlusTree::Open(directory / "tree", {64});
+    for (uint32_t i = 0; i < 100; i++) {
+      tree->Insert(Key(i), Value(i));
+    }
+    tree->Insert(Key(50), large);
+    tree->Insert(Key(51), Value(51, 600));
+    tree->Commit();
+  }
+
+  auto tree = CowBPlusTree::Open(directory / "tree", {64});
+  EXPECT_EQ(tree->Find(Key(50)), large);
+  EXPECT_EQ(tree->Find(Key(51)), Value(51, 600));
+
+  {
+    auto snapshot = tree->Snapshot();
+    size_t offset = 0;
+    size_t chunks = 0;
+    EXPECT_TRUE(snapshot.Read(Key(50), [&](const byte* data, size_t size) {
+      EXPECT_TRUE(std::equal(data, data + size, large.begin() + static_cast<int64_t>(offset)));
+      offset += size;
+      chunks++;
+    }));
+    EXPECT_EQ(offset, large.size());
+    EXPECT_GT(chunks, 1) << "Expect large values to be streamed in chunks";
+    EXPECT_FALSE(snapshot.Read(Key(1000), [](const byte*, size_t) { FAIL(); }));
+
+    uint32_t keys = 0;
+    snapshot.ScanKeys(Key(0), [&](const K& key) {
+      EXPECT_EQ(key, Key(keys++));
+      return true;
+    });
+    EXPECT_EQ(keys, 100);
+  }
+
+  // Replacing the value retires its overflow pages, which are then reused for the next large value.
+  auto page_count = tree->PageCount();
+  tree->Insert(Key(50), Value(50));
+  tree->Commit();
+  EXPECT_EQ(tree->Find(Key(50)), Value(50));
+
+  tree->Insert(Key(60), large);
+  EXPECT_EQ(tree->Remove(Key(60)), large);
+  tree->Insert(Key(70), large);
+  tree->Commit();
+  EXPECT_EQ(tree->Find(Key(70)), large);
+  EXPECT_LE(tree->PageCount(), page_count + 8) << "Expect the overflow pages to be reused";
+}
+
+TEST_F(CowBPlusTreeFixture, CompressedLeaves) {
+  auto value = [](uint32_t i) {
+    auto json = R"({"id":)" + std::to_string(i) + R"(,"name":"record","tags":["alpha","beta"],"active":true})";
+    return V(json.begin(), json.end());
+  };
+
+  CowBPlusTreeOptions plain;
+  CowBPlusTreeOptions compressed;
+  compressed.leaf_codec = CodecType::Lz;
+
+  std::map<std::string, PageId> page_counts;
+  for (auto& [name, options] : {std::make_pair("plain", plain), std::make_pair("compressed", compressed)}) {
+    {
+      auto tree = CowBPlusTree::Open(directory / name, options);
+      for (uint32_t i = 0; i < 3000; i++) {
+        tree->Insert(Key(i), value(i));
+      }
+      for (uint32_t i = 0; i < 3000; i += 3) {
+        tree->Remove(Key(i));
+      }
+      tree->Commit();
+      page_counts[name] = tree->PageCount();
+    }
+
+    auto tree = CowBPlusTree::Open(directory / name, options);
+    auto snapshot = tree->Snapshot();
+    uint32_t i = 1;
+    snapshot.Scan(Key(0), [&](const K& key, const V& v) {
+      EXPECT_EQ(key, Key(i));
+      EXPECT_EQ(v, value(i));
+      i += i % 3 == 1 ? 1 : 2;
+      return true;
+    });
+    EXPECT_EQ(i, 3001);
+    EXPECT_EQ(snapshot.Find(Key(1000)), value(1000));
+    EXPECT_FALSE(snapshot.Find(Key(999)));
+  }
+
+  EXPECT_LT(page_counts["compressed"] * 2, page_counts["plain"]) << "Expect compressed leaves to use fewer pages";
+}
+TEST_F(CowBPlusTreeFixture, Transactions) {
+  auto tree = CowBPlusTree::Open(directory / "tree");
+  for (uint32_t i = 0; i < 100; i++) {
+    tree->Insert(Key(i), Value(i));
+  }
+  tree->Commit();
+
+  auto first = tree->Begin();
+  auto second = tree->Begin();
+  auto third = tree->Begin();
+  EXPECT_EQ(first.ReadVersion(), 1);
+
+  first.Insert(Key(10), Value(11));
+  first.Remove(Key(20));
+  first.Insert(Key(500), Value(5));
+  EXPECT_EQ(first.Find(Key(10)), Value(11)) << "Expect a transaction to see its own modifications";
+  EXPECT_FALSE(first.Find(Key(20)));
+  EXPECT_EQ(tree->Find(Key(10)), Value(10)) << "Expect modifications to be invisible before commit";
+
+  std::vector<uint32_t> keys;
+  first.Scan(Key(18), [&](const K& key, const V& value) {
+    keys.push_back(key[15] + (key[14] << 8));
+    EXPECT_EQ(value, first.Find(key));
+    return keys.size() < 83;
+  });
+  EXPECT_EQ(keys.front(), 18);
+  EXPECT_EQ(keys[2], 21) << "Expect the scan to skip removed records";
+  EXPECT_EQ(keys.back(), 500) << "Expect the scan to include inserted records";
+
+  second.Insert(Key(10), Value(12));
+  third.Insert(Key(30), Value(31));
+  EXPECT_EQ(first.Commit(), 2);
+  EXPECT_FALSE(second.Commit()) << "Expect the second writer of a key to fail";
+  EXPECT_EQ(third.Commit(), 3) << "Expect transactions writing disjoint keys to commit";
+
+  auto snapshot = tree->Snapshot();
+  EXPECT_EQ(snapshot.Find(Key(10)), Value(11));
+  EXPECT_FALSE(snapshot.Find(Key(20)));
+  EXPECT_EQ(snapshot.Find(Key(30)), Value(31));
+  EXPECT_EQ(snapshot.Find(Key(500)), Value(5));
+
+  auto fourth = tree->Begin();
+  tree->Insert(Key(40), Value(41));
+  EXPECT_EQ(fourth.Find(Key(40)), Value(40)) << "Expect a transaction to read its own snapshot";
+  fourth.Insert(Key(40), Value(42));
+  EXPECT_THROW(fourth.Commit(), std::logic_error) << "Expect uncommitted direct modifications to be rejected";
+  tree->Commit();
+  EXPECT_FALSE(fourth.Commit()) << "Expect the transaction to conflict with the direct commit";
+
+  EXPECT_THROW(fourth.Find(Key(40)), std::logic_error) << "Expect an ended transaction to be unusable";
+  EXPECT_THROW(first.Insert(Key(1), Value(1)), std::logic_error);
+}
+
+TEST_F(CowBPlusTreeFixture, BackgroundReclaim) {
+  auto tree = CowBPlusTree::Open(directory / "tree");
+  for (uint32_t i = 0; i < 1000; i++) {
+    tree->Insert(Key(i), Value(i));
+  }
+  tree->Commit();
+
+  {
+    auto transaction = tree->Begin();
+    for (uint32_t i = 0; i < 1000; i++) {
+      tree->Insert(Key(i), Value(i + 1));
+    }
+    tree->Commit();
+    EXPECT_GT(tree->PendingPageCount(), 0);
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (tree->PendingPageCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(tree->PendingPageCount(), 0) << "Expect pages to be reclaimed once the last snapshot is released";
+}
+TEST_F(CowBPlusTreeFixture, WarmUp) {
+  {
+    auto tree = CowBPlusTree::Open(directory / "tree");
+    for (uint32_t i = 0; i < 20000; i++) {
+      tree->Insert(Key(i), Value(i));
+    }
+    tree->Commit();
+  }
+
+  CowBPlusTreeOptions options;
+  options.pool_capacity = 4096;
+
+  auto tree = CowBPlusTree::Open(directory / "tree", options);
+  EXPECT_EQ(tree->WarmUp(1), 0) << "Expect the root to be read when opening";
+
+  auto internal_nodes = tree->WarmUp(2);
+  EXPECT_GT(internal_nodes, 1) << "Expect the children of the root to be read";
+  EXPECT_EQ(tree->WarmUp(2), 0) << "Expect cached pages not to be read again";
+  EXPECT_GT(tree->WarmUp(3), internal_nodes) << "Expect the leaves to be read";
+  EXPECT_EQ(tree->WarmUp(10), 0) << "Expect warming up to stop at the leaves";
+
+  options.warm_up_levels = 2;
+  tree = CowBPlusTree::Open(directory / "tree", options);
+  EXPECT_EQ(tree->Find(Key(12345)), Value(12345));
+}
+TEST_F(CowBPlusTreeFixture, BackupAndRestore) {
+  auto tree = CowBPlusTree::Open(directory / "tree");
+  for (uint32_t i = 0; i < 5000; i++) {
+    tree->Insert(Key(i), Value(i, i % 100 == 0 ? 3000 : 100));
+  }
+  tree->Insert(Key(100000), Value(7, 1100000));
+  tree->Commit();
+
+  // A writer keeps modifying the tree while the backup is written. Every round stores its number in the values.
+  std::atomic<bool> done(false);
+  std::thread writer([&] {
+    for (uint32_t round = 1; !done; round++) {
+      auto key = Key(round);
+      for (uint32_t i = 0; i < 5000; i += 7) {
+        tree->Insert(Key(i), V(key.begin(), key.end()));
+      }
+      tree->Commit();
+    }
+  });
+
+  while (tree->Committed().number < 3) {
+    std::this_thread::yield();
+  }
+  auto version = tree->Backup(directory / "backup");
+  done = true;
+  writer.join();
+  EXPECT_FALSE(std::filesystem::exists(directory / "backup.tmp")) << "Expect the temporary file to be moved";
+
+  auto backup = CowBPlusTree::Open(directory / "backup");
+  EXPECT_EQ(backup->Committed().number, version.number);
+  EXPECT_EQ(backup->Committed().record_count, version.record_count);
+
+  auto snapshot = backup->Snapshot();
+  auto round = snapshot.Find(Key(0));
+  ASSERT_TRUE(round);
+  EXPECT_EQ(snapshot.Find(Key(100000)), Value(7, 1100000)) << "Expect values spanning several extents to be copied";
+
+  uint32_t i = 0;
+  snapshot.Scan(Key(0), [&](const K& key, const V& value) {
+    if (key == Key(100000)) {
+      return true;
+    }
+
+    EXPECT_EQ(key, Key(i));
+    if (i % 7 == 0) {
+      EXPECT_EQ(value, *round) << "Expect all records to belong to the same version";
+    } else {
+      EXPECT_EQ(value, Value(i, i % 100 == 0 ? 3000 : 100));
+    }
+    i++;
+    return true;
+  });
+  EXPECT_EQ(i, 5000);
+
+  // The copy is a tree of its own, which can be modified without reusing the pages of the copied version.
+  for (uint32_t j = 0; j < 5000; j++) {
+    backup->Insert(Key(j), Value(j));
+  }
+  backup->Commit();
+  EXPECT_EQ(backup->Find(Key(4999)), Value(4999));
+  EXPECT_EQ(snapshot.Find(Key(4999)), Value(4999, 100));
+}
+TEST_F(CowBPlusTreeFixture, ReadsRetainedVersionsAsOf) {
+  CowBPlusTreeOptions options;
+  options.version_retention = std::chrono::seconds(2);
+
+  auto tree = CowBPlusTree::Open(directory / "tree", options);
+  auto start = std::chrono::system_clock::now();
+  std::vector<std::chrono::system_clock::time_point> times;
+  for (uint32_t round = 0; round < 3; round++) {
+    for (uint32_t i = 0; i < 1000; i++) {
+      tree->Insert(Key(i), Value(i + round));
+    }
+    tree->Remove(Key(round));
+    tree->Commit();
+
+    times.push_back(std::chrono::system_clock::now());
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  EXPECT_EQ(tree->RetainedVersionCount(), 3);
+  EXPECT_GT(tree->PendingPageCount(), 0) << "Expect the pages of retained versions to be kept";
+
+  for (uint32_t round = 0; round < 3; round++) {
+    auto snapshot = tree->SnapshotAsOf(times[round]);
+    EXPECT_EQ(snapshot.Version().number, round + 1);
+    EXPECT_FALSE(snapshot.Find(Key(round))) << "Expect the remove of round " << round << " to be visible";
+    EXPECT_EQ(tree->Find(Key(500), times[round]), Value(500 + round)) << "Expect round " << round << " to be read";
+
+    uint32_t count = 0;
+    snapshot.Scan(Key(0), [&count](const K&, const V&) {
+      count++;
+      return true;
+    });
+    EXPECT_EQ(count, 999);
+  }
+  EXPECT_FALSE(tree->Find(Key(500), start)) << "Expect the empty version to be read";
+  EXPECT_EQ(tree->Find(Key(500)), Value(502));
+
+  {
+    // A snapshot keeps its version beyond the retention window.
+    auto snapshot = tree->SnapshotAsOf(times[0]);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (tree->RetainedVersionCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(tree->RetainedVersionCount(), 0) << "Expect expired versions to be purged in the background";
+    EXPECT_EQ(snapshot.Find(Key(500)), Value(500));
+    EXPECT_THROW(tree->Find(Key(500), times[0]), std::invalid_argument);
+  }
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (tree->PendingPageCount() > 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(tree->PendingPageCount(), 0) << "Expect the pages of expired versions to be reclaimed";
+  EXPECT_EQ(tree->Find(Key(500), std::chrono::system_clock::now()), Value(502));
+}
\ No newline at end of file
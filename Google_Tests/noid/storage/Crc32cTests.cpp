@@ -0,0 +1,46 @@
+#include "gtest/gtest.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "storage/Crc32c.h"
+
+using namespace noid::storage;
+
+TEST(Crc32c, KnownValues) {
+  const char* check = "123456789";
+
+  EXPECT_EQ(Crc32c(check, std::strlen(check)), 0xe3069283) << "Expect the standard CRC32C check value";
+  EXPECT_EQ(Crc32cSoftware(check, std::strlen(check)), 0xe3069283) << "Expect the standard CRC32C check value";
+  EXPECT_EQ(Crc32c(check, 0), 0) << "Expect the checksum of no data to be zero";
+
+  std::vector<uint8_t> zeroes(32, 0);
+  EXPECT_EQ(Crc32c(zeroes.data(), zeroes.size()), 0x8a9136aa) << "Expect the RFC 3720 value for 32 zero bytes";
+}
+
+TEST(Crc32c, ImplementationsAgree) {
+  std::mt19937 random(42);
+  std::vector<uint8_t> data(4096 + 64);
+  for (auto& b : data) {
+    b = static_cast<uint8_t>(random());
+  }
+
+  // Vary the offset and size, so all unaligned heads and tails are covered.
+  for (size_t offset = 0; offset < 16; offset++) {
+    for (size_t size : {0, 1, 7, 8, 9, 63, 64, 65, 1000, 4096}) {
+      EXPECT_EQ(Crc32c(data.data() + offset, size), Crc32cSoftware(data.data() + offset, size))
+                << "Expect both implementations to agree at offset " << offset << " and size " << size;
+    }
+  }
+}
+
+TEST(Crc32c, Chaining) {
+  const char* check = "123456789";
+
+  auto crc = Crc32c(check, 4);
+  EXPECT_EQ(Crc32c(check + 4, 5, crc), 0xe3069283) << "Expect a chained checksum to equal the checksum of all data";
+
+  crc = Crc32cSoftware(check, 3);
+  EXPECT_EQ(Crc32cSoftware(check + 3, 6, crc), 0xe3069283) << "Expect a chained checksum to equal the checksum of all data";
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "storage/LsmStore.h"
+
+using namespace noid::storage;
+
+class LsmStoreFixture : public ::testing::Test {
+ protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-lsm-store-") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+      std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(directory);
+    }
+
+    static K Key(uint32_t i) {
+      K key{};
+      key[12] = static_cast<byte>(i >> 24);
+      key[13] = static_cast<byte>(i >> 16);
+      key[14] = static_cast<byte>(i >> 8);
+      key[15] = static_cast<byte>(i);
+
+      return key;
+    }
+
+    static V Value(uint32_t i, size_t size = 100) {
+      return V(size, static_cast<byte>(i));
+    }
+
+    static std::map<std::string, LsmTreeOptions> Trees() {
+      LsmTreeOptions users;
+      users.memtable_order = 16;
+      users.compaction_threads = 0;
+
+      LsmTreeOptions orders;
+      orders.memtable_order = 128;
+      orders.compaction_threads = 0;
+      orders.value_separation_threshold = 64;
+
+      return {{"users", users}, {"orders", orders}};
+    }
+
+    size_t LogSegmentCount() {
+      size_t count = 0;
+      for ([[maybe_unused]] auto& file : std::filesystem::directory_iterator(directory / "wal")) {
+        count++;
+      }
+
+      return count;
+    }
+};
+
+TEST_F(LsmStoreFixture, TreesAreSeparate) {
+  auto store = LsmStore::Open(directory, Trees());
+  for (uint32_t i = 0; i < 100; i++) {
+    store->Tree("users").Insert(Key(i), Value(i));
+    store->Tree("orders").Insert(Key(i), Value(i + 1, 200));
+  }
+  store->Tree("users").Remove(Key(7));
+  store->Tree("orders").Flush();
+
+  EXPECT_FALSE(store->Tree("users").Find(Key(7))) << "Expect the tombstone to be written to its own tree only";
+  EXPECT_EQ(store->Tree("orders").Find(Key(7)), Value(8, 200));
+  EXPECT_EQ(store->Tree("users").Find(Key(8)), Value(8));
+  EXPECT_EQ(store->Tree("users").RunCount(), 0) << "Expect a flush to be limited to its own tree";
+  EXPECT_EQ(store->Tree("orders").RunCount(), 1);
+  EXPECT_THROW(store->Tree("invoices"), std::invalid_argument);
+  store.reset();
+
+  store = LsmStore::Open(directory, Trees());
+  for (uint32_t i = 0; i < 100; i++) {
+    if (i == 7) {
+      EXPECT_FALSE(store->Tree("users").Find(Key(i))) << "Expect the tombstone to be recovered";
+    } else {
+      EXPECT_EQ(store->Tree("users").Find(Key(i)), Value(i)) << "Expect the log records of users to be replayed";
+    }
+    EXPECT_EQ(store->Tree("orders").Find(Key(i)), Value(i + 1, 200)) << "Expect the run of orders to be reopened";
+  }
+}
+
+TEST_F(LsmStoreFixture, WritesSpanningTreesAreAtomic) {
+  {
+    auto store = LsmStore::Open(directory, Trees());
+
+    WriteBatch users;
+    users.Insert(Key(1), Value(1));
+    users.Remove(Key(2));
+    WriteBatch orders;
+    orders.Insert(Key(1), Value(10, 300));
+    orders.Insert(Key(3), Value(30));
+
+    store->Tree("users").Insert(Key(2), Value(2));
+    store->Write({{"users", users}, {"orders", orders}});
+    EXPECT_EQ(store->Tree("users").Find(Key(1)), Value(1));
+    EXPECT_FALSE(store->Tree("users").Find(Key(2)));
+    EXPECT_EQ(store->Tree("orders").Find(Key(1)), Value(10, 300));
+    EXPECT_EQ(store->Tree("orders").Find(Key(3)), Value(30));
+
+    EXPECT_THROW(store->Write({{"users", users}, {"invoices", orders}}), std::invalid_argument);
+  }
+
+  auto store = LsmStore::Open(directory, Trees());
+  EXPECT_EQ(store->Tree("users").Find(Key(1)), Value(1)) << "Expect the batch of users to be recovered";
+  EXPECT_FALSE(store->Tree("users").Find(Key(2)));
+  EXPECT_EQ(store->Tree("orders").Find(Key(1)), Value(10, 300)) << "Expect the batch of orders to be recovered";
+  EXPECT_EQ(store->Tree("orders").Find(Key(3)), Value(30));
+}
+
+TEST_F(LsmStoreFixture, LogIsCheckpointedUpToTheOldestRequiredRecord) {
+  auto trees = Trees();
+  trees["users"].memtable_size = 16 * 1024;
+
+  LsmStoreOptions options;
+  options.log_segment_size = 4 * 1024;
+
+  {
+    auto store = LsmStore::Open(directory, trees, options);
+    store->Tree("orders").Insert(Key(0), Value(0));
+
+    // The record of orders keeps the log from being checkpointed while users flushes its memtables.
+    for (uint32_t i = 0; i < 1000; i++) {
+      store->Tree("users").Insert(Key(i), Value(i), Durability::Buffered);
+      if (i % 50 == 49) {
+        store->Sync();
+      }
+    }
+    EXPECT_GT(store->Tree("users").RunCount(), 0);
+    EXPECT_GT(LogSegmentCount(), 3) << "Expect the log to retain the segments following the record of orders";
+  }
+
+  {
+    auto store = LsmStore::Open(directory, trees, options);
+    EXPECT_EQ(store->Tree("orders").Find(Key(0)), Value(0)) << "Expect the oldest record to be retained";
+    for (uint32_t i = 0; i < 1000; i++) {
+      ASSERT_EQ(store->Tree("users").Find(Key(i)), Value(i)) << "Expect key " << i << " to be recovered";
+    }
+
+    store->Tree("orders").Flush();
+    store->Tree("users").Flush();
+    store->Tree("users").Insert(Key(0), Value(1));
+  }
+
+  EXPECT_LE(LogSegmentCount(), 3) << "Expect the log to be checkpointed once no tree requires its records";
+
+  auto store = LsmStore::Open(directory, trees, options);
+  EXPECT_EQ(store->Tree("orders").Find(Key(0)), Value(0));
+  EXPECT_EQ(store->Tree("users").Find(Key(0)), Value(1));
+  EXPECT_EQ(store->Tree("users").Find(Key(999)), Value(999));
+}
+
+TEST_F(LsmStoreFixture, OpensWithAllTrees) {
+  EXPECT_THROW(LsmStore::Open(directory, {}), std::invalid_argument);
+  LsmStore::Open(directory, Trees())->Tree("users").Insert(Key(1), Value(1));
+
+  EXPECT_THROW(LsmStore::Open(directory, {{"users", {}}}), std::invalid_argument)
+            << "Expect a store not to open without all of its trees";
+
+  auto trees = Trees();
+  trees["invoices"] = {};
+  auto store = LsmStore::Open(directory, trees);
+  EXPECT_FALSE(store->Tree("invoices").Find(Key(1))) << "Expect a new tree not to replay the records of others";
+  EXPECT_EQ(store->Tree("users").Find(Key(1)), Value(1));
+}
\ No newline at end of file
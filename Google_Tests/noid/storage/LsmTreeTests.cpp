@@ -0,0 +1,668 @@
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <thread>
+
+#include "storage/LsmTree.h"
+
+using namespace noid::storage;
+
+class LsmTreeFixture : public ::testing::Test {
+ protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-lsm-") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+      std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(directory);
+    }
+
+    static K Key(uint32_t i) {
+      K key{};
+      key[12] = static_cast<byte>(i >> 24);
+      key[13] = static_cast<byte>(i >> 16);
+      key[14] = static_cast<byte>(i >> 8);
+      key[15] = static_cast<byte>(i);
+
+      return key;
+    }
+
+    static V Value(uint32_t i, size_t size = 100) {
+      return V(size, static_cast<byte>(i));
+    }
+
+    static void ExpectContents(LsmTree& tree, const std::map<K, V>& expected, uint32_t key_count) {
+      for (uint32_t id = 0; id < key_count; id++) {
+        auto entry = expected.find(Key(id));
+        auto value = tree.Find(Key(id));
+        if (entry == expected.end()) {
+          EXPECT_FALSE(value) << "Expect key " << id << " to be absent";
+        } else {
+          EXPECT_EQ(value, entry->second) << "Expect key " << id << " to have its latest value";
+        }
+      }
+    }
+
+    size_t RunFileCount() {
+      size_t count = 0;
+      for ([[maybe_unused]] auto& file : std::filesystem::directory_iterator(directory / "runs")) {
+        count++;
+      }
+
+      return count;
+    }
+};
+
+TEST_F(LsmTreeFixture, TombstonesShadowOlderRuns) {
+  auto tree = LsmTree::Open(directory);
+  for (uint32_t i = 0; i < 100; i++) {
+    tree->Insert(Key(i), Value(i));
+  }
+  tree->Flush();
+  EXPECT_EQ(tree->RunCount(), 1);
+
+  tree->Remove(Key(5));
+  tree->Insert(Key(6), Value(60));
+  EXPECT_FALSE(tree->Find(Key(5))) << "Expect a tombstone in the memtable to shadow the run";
+  EXPECT_EQ(tree->Find(Key(6)), Value(60)) << "Expect the memtable to shadow the run";
+
+  tree->Flush();
+  EXPECT_EQ(tree->RunCount(), 2);
+  EXPECT_FALSE(tree->Find(Key(5))) << "Expect a tombstone in a newer run to shadow an older run";
+  EXPECT_EQ(tree->Find(Key(6)), Value(60));
+  EXPECT_EQ(tree->Find(Key(7)), Value(7));
+  EXPECT_FALSE(tree->Find(Key(100)));
+
+  tree->Flush();
+  EXPECT_EQ(tree->RunCount(), 2) << "Expect flushing an empty memtable to be a no-op";
+}
+
+TEST_F(LsmTreeFixture, RecoversFromLog) {
+  {
+    auto tree = LsmTree::Open(directory);
+    for (uint32_t i = 0; i < 50; i++) {
+      tree->Insert(Key(i), Value(i));
+    }
+    tree->Flush();
+
+    tree->Remove(Key(1));
+    tree->Insert(Key(2), Value(20));
+  }
+
+  auto tree = LsmTree::Open(directory);
+  EXPECT_EQ(tree->RunCount(), 1);
+  EXPECT_FALSE(tree->Find(Key(1))) << "Expect the tombstone to be replayed from the log";
+  EXPECT_EQ(tree->Find(Key(2)), Value(20)) << "Expect the insert to be replayed from the log";
+  EXPECT_EQ(tree->Find(Key(3)), Value(3));
+}
+
+TEST_F(LsmTreeFixture, RandomWorkload) {
+  LsmTreeOptions options;
+  options.memtable_size = 16 * 1024;
+  options.memtable_order = 16;
+  options.sync_writes = false;
+  options.level1_size = 64 * 1024;
+  options.run_size = 16 * 1024;
+
+  std::map<K, V> expected;
+  std::mt19937 random(7);
+
+  for (auto round = 0; round < 3; round++) {
+    auto tree = LsmTree::Open(directory, options);
+    for (auto i = 0; i < 3000; i++) {
+      auto id = static_cast<uint32_t>(random() % 2000);
+      if (random() % 3 == 0) {
+        tree->Remove(Key(id));
+        expected.erase(Key(id));
+      } else {
+        auto value = Value(id, random() % 300);
+        tree->Insert(Key(id), value);
+        expected[Key(id)] = value;
+      }
+    }
+    tree->Sync();
+  }
+
+  auto tree = LsmTree::Open(directory, options);
+  EXPECT_GT(tree->RunCount(), 1) << "Expect full memtables to be flushed";
+  ExpectContents(*tree, expected, 2000);
+
+  tree->Compact();
+  EXPECT_LT(tree->RunCount(0), options.level0_compaction_trigger);
+  ExpectContents(*tree, expected, 2000);
+}
+
+TEST_F(LsmTreeFixture, CompactionDropsShadowedVersions) {
+  LsmTreeOptions options;
+  options.sync_writes = false;
+  options.compaction_threads = 0;
+  options.level0_compaction_trigger = 2;
+
+  std::map<K, V> expected;
+  {
+    auto tree = LsmTree::Open(directory, options);
+    for (uint32_t round = 0; round < 4; round++) {
+      for (uint32_t id = 0; id < 500; id++) {
+        if (round == 3 && id % 2 == 0) {
+          tree->Remove(Key(id));
+          expected.erase(Key(id));
+        } else {
+          tree->Insert(Key(id), Value(round));
+          expected[Key(id)] = Value(round);
+        }
+      }
+      tree->Flush();
+    }
+    EXPECT_EQ(tree->RunCount(0), 4) << "Expect no compactions without compaction threads";
+
+    tree->Compact();
+    EXPECT_EQ(tree->RunCount(0), 0) << "Expect level 0 to be compacted";
+    EXPECT_EQ(tree->RunCount(), 1);
+    EXPECT_EQ(RunFileCount(), 1) << "Expect compacted runs to be removed";
+    ExpectContents(*tree, expected, 600);
+
+    auto metrics = tree->Metrics();
+    EXPECT_EQ(metrics.compactions, 1);
+    EXPECT_EQ(metrics.pending_compaction_bytes, 0);
+    // Every record consists of its key, a tombstone flag, the value length and the value.
+    auto value_size = BTREE_KEY_SIZE + 1 + sizeof(uint32_t) + 100;
+    auto tombstone_size = BTREE_KEY_SIZE + 1 + sizeof(uint32_t);
+    EXPECT_EQ(metrics.compaction_bytes_read, 1750 * value_size + 250 * tombstone_size);
+    EXPECT_EQ(metrics.compaction_bytes_written, 250 * value_size)
+        << "Expect only the newest version of the odd keys to be written";
+  }
+
+  auto tree = LsmTree::Open(directory, options);
+  EXPECT_EQ(tree->RunCount(1), 1) << "Expect the levels to be recovered from the manifest";
+  ExpectContents(*tree, expected, 600);
+}
+
+TEST_F(LsmTreeFixture, BackgroundCompaction) {
+  LsmTreeOptions options;
+  options.memtable_size = 8 * 1024;
+  options.sync_writes = false;
+  options.level0_slowdown_trigger = 2;
+  options.level0_stop_trigger = 3;
+  options.level1_size = 32 * 1024;
+  options.run_size = 8 * 1024;
+
+  std::map<K, V> expected;
+  auto tree = LsmTree::Open(directory, options);
+  std::mt19937 random(3);
+  for (auto i = 0; i < 5000; i++) {
+    auto id = static_cast<uint32_t>(random() % 1000);
+    tree->Insert(Key(id), Value(i));
+    expected[Key(id)] = Value(i);
+  }
+
+  // Let the compaction threads catch up.
+  for (auto i = 0; i < 500 && tree->Metrics().pending_compaction_bytes > 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  auto metrics = tree->Metrics();
+  EXPECT_GT(metrics.compactions, 0);
+  EXPECT_EQ(metrics.failed_compactions, 0);
+  EXPECT_EQ(metrics.pending_compaction_bytes, 0);
+  EXPECT_GT(metrics.stalled_writes, 0) << "Expect writes to be throttled while level 0 is full";
+  EXPECT_GT(metrics.stall_time.count(), 0);
+  EXPECT_LT(tree->RunCount(0), options.level0_stop_trigger);
+  EXPECT_GT(tree->RunCount(2), 0) << "Expect runs to be compacted into deeper levels";
+  ExpectContents(*tree, expected, 1000);
+}
+
+TEST_F(LsmTreeFixture, Level0BelowTriggerIsLeftAlone) {
+  LsmTreeOptions options;
+  options.sync_writes = false;
+  options.level0_compaction_trigger = 4;
+
+  auto tree = LsmTree::Open(directory, options);
+  for (uint32_t round = 0; round < 3; round++) {
+    for (uint32_t id = 0; id < 100; id++) {
+      tree->Insert(Key(id), Value(round));
+    }
+    tree->Flush();
+  }
+
+  tree->Compact();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(tree->RunCount(0), 3) << "Expect level 0 not to be compacted below its trigger";
+  EXPECT_EQ(tree->RunCount(1), 0);
+  EXPECT_EQ(tree->Metrics().compactions, 0);
+}
+
+TEST_F(LsmTreeFixture, ConcurrentCompactionsMatchModel) {
+  LsmTreeOptions options;
+  options.memtable_size = 4 * 1024;
+  options.memtable_order = 16;
+  options.sync_writes = false;
+  options.compaction_threads = 2;
+  options.level0_compaction_trigger = 2;
+  options.level1_size = 8 * 1024;
+  options.level_size_multiplier = 2;
+  options.run_size = 4 * 1024;
+
+  const uint32_t key_count = 500;
+  for (uint32_t seed = 0; seed < 5; seed++) {
+    std::filesystem::remove_all(directory);
+    std::map<K, V> expected;
+    std::mt19937 random(seed);
+
+    for (auto round = 0; round < 3; round++) {
+      auto tree = LsmTree::Open(directory, options);
+      for (auto i = 0; i < 2000; i++) {
+        auto id = static_cast<uint32_t>(random() % key_count);
+        auto operation = random() % 100;
+        if (operation < 20) {
+          tree->Remove(Key(id));
+          expected.erase(Key(id));
+        } else if (operation < 25) {
+          WriteBatch batch;
+          for (auto j = 0; j < 8; j++) {
+            auto batch_id = static_cast<uint32_t>(random() % key_count);
+            auto value = Value(i + j, random() % 200);
+            batch.Insert(Key(batch_id), value);
+            expected[Key(batch_id)] = value;
+          }
+          tree->Write(batch);
+        } else if (operation < 27) {
+          tree->Flush();
+        } else if (operation < 28) {
+          tree->Compact();
+        } else {
+          auto value = Value(i, random() % 200);
+          tree->Insert(Key(id), value);
+          expected[Key(id)] = value;
+        }
+      }
+      ExpectContents(*tree, expected, key_count);
+      EXPECT_EQ(tree->Metrics().failed_compactions, 0);
+    }
+
+    auto tree = LsmTree::Open(directory, options);
+    ExpectContents(*tree, expected, key_count);
+    ASSERT_FALSE(HasFailure()) << "Seed " << seed;
+  }
+}
+
+TEST_F(LsmTreeFixture, WriteBatch) {
+  {
+    auto tree = LsmTree::Open(directory);
+    tree->Insert(Key(1), Value(1));
+
+    WriteBatch batch;
+    batch.Insert(Key(3), Value(3));
+    batch.Remove(Key(1));
+    batch.Insert(Key(2), Value(2));
+    batch.Insert(Key(3), Value(30));
+    batch.Remove(Key(2));
+    batch.Insert(Key(4), Value(4));
+    EXPECT_EQ(batch.Count(), 6);
+
+    tree->Write(batch);
+    tree->Write(WriteBatch());
+    EXPECT_FALSE(tree->Find(Key(1)));
+    EXPECT_FALSE(tree->Find(Key(2))) << "Expect the last operation on a key to win";
+    EXPECT_EQ(tree->Find(Key(3)), Value(30)) << "Expect the last operation on a key to win";
+    EXPECT_EQ(tree->Find(Key(4)), Value(4));
+  }
+
+  auto tree = LsmTree::Open(directory);
+  EXPECT_FALSE(tree->Find(Key(1))) << "Expect the batch to be replayed from the log";
+  EXPECT_FALSE(tree->Find(Key(2)));
+  EXPECT_EQ(tree->Find(Key(3)), Value(30));
+  EXPECT_EQ(tree->Find(Key(4)), Value(4));
+}
+
+TEST_F(LsmTreeFixture, WriteBatchIsAtomicForReaders) {
+  LsmTreeOptions options;
+  options.memtable_size = 32 * 1024;
+  options.sync_writes = false;
+  auto tree = LsmTree::Open(directory, options);
+
+  std::atomic<bool> done(false);
+  std::thread reader([&]() {
+    while (!done) {
+      // Both keys are written by every batch, so the key read last can only be newer.
+      auto first = tree->Find(Key(0));
+      auto second = tree->Find(Key(1));
+      if (first && second && *first > *second) {
+        ADD_FAILURE() << "Expect readers not to observe a partial batch";
+        return;
+      }
+    }
+  });
+
+  // The values are big-endian counters, so they compare like their numbers.
+  for (uint32_t i = 1; i < 1000; i++) {
+    auto counter = Key(i);
+    WriteBatch batch;
+    batch.Insert(Key(1), V(counter.begin(), counter.end()));
+    batch.Insert(Key(0), V(counter.begin(), counter.end()));
+    tree->Write(batch);
+  }
+  done = true;
+  reader.join();
+
+  EXPECT_EQ(tree->Find(Key(1)), tree->Find(Key(0)));
+}
+
+TEST_F(LsmTreeFixture, SeparatesLargeValues) {
+  LsmTreeOptions options;
+  options.memtable_size = 4 * 1024;
+  options.compaction_threads = 0;
+  options.level0_compaction_trigger = 2;
+  options.value_separation_threshold = 1024;
+  options.value_log_segment_size = 256 * 1024;
+
+  // Value sizes range from 64 bytes up to 64 KiB, so both inline and separated values are stored.
+  auto size = [](uint32_t i) { return static_cast<size_t>(64) << (i % 11); };
+  std::map<K, V> expected;
+  {
+    auto tree = LsmTree::Open(directory, options);
+    for (uint32_t i = 0; i < 200; i++) {
+      tree->Insert(Key(i), Value(i, size(i)));
+      expected[Key(i)] = Value(i, size(i));
+    }
+    EXPECT_GT(tree->RunCount(), 0) << "Expect pointers to be flushed into runs";
+    ExpectContents(*tree, expected, 200);
+
+    WriteBatch batch;
+    batch.Insert(Key(3), Value(33, 8192));
+    batch.Insert(Key(4), Value(44, 16));
+    batch.Remove(Key(5));
+    tree->Write(batch);
+    tree->Insert(Key(6), Value(66, 4096));
+    expected[Key(3)] = Value(33, 8192);
+    expected[Key(4)] = Value(44, 16);
+    expected.erase(Key(5));
+    expected[Key(6)] = Value(66, 4096);
+    ExpectContents(*tree, expected, 200);
+  }
+  EXPECT_GT(std::filesystem::file_size(*std::filesystem::directory_iterator(directory / "values")), 0);
+
+  auto tree = LsmTree::Open(directory, options);
+  ExpectContents(*tree, expected, 200);
+
+  tree->Flush();
+  tree->Compact();
+  EXPECT_EQ(tree->RunCount(0), 0) << "Expect compactions to carry the pointers into level 1";
+  ExpectContents(*tree, expected, 200);
+}
+
+TEST_F(LsmTreeFixture, CollectsValueLogGarbage) {
+  LsmTreeOptions options;
+  options.memtable_size = 4 * 1024;
+  options.compaction_threads = 0;
+  options.value_separation_threshold = 256;
+  options.value_log_segment_size = 16 * 1024;
+  options.value_log_gc_interval = std::chrono::milliseconds(0);
+
+  std::map<K, V> expected;
+  {
+    auto tree = LsmTree::Open(directory, options);
+    for (uint32_t round = 0; round < 4; round++) {
+      for (uint32_t id = 0; id < 100; id++) {
+        if (round == 3 && id % 4 == 0) {
+          tree->Remove(Key(id));
+          expected.erase(Key(id));
+        } else if (round < 3 || id % 2 == 0) {
+          tree->Insert(Key(id), Value(id + round, 1024));
+          expected[Key(id)] = Value(id + round, 1024);
+        }
+      }
+    }
+
+    auto before = tree->Metrics();
+    EXPECT_DOUBLE_EQ(before.value_log_space_amplification, 1.0) << "Expect no estimate before the first scan";
+
+    EXPECT_GT(tree->CollectGarbage(), 0) << "Expect the segments of overwritten values to be removed";
+    ExpectContents(*tree, expected, 100);
+
+    auto after = tree->Metrics();
+    EXPECT_LT(after.value_log_bytes, before.value_log_bytes);
+    EXPECT_GT(after.value_log_gc_segments, 0);
+    EXPECT_GT(after.value_log_gc_bytes_scanned, after.value_log_gc_bytes_relocated);
+    EXPECT_GT(after.value_log_gc_bytes_relocated, 0) << "Expect the keys that were not overwritten to be relocated";
+    EXPECT_GT(after.value_log_space_amplification, 1.0);
+    EXPECT_GT(after.value_log_gc_time.count(), 0);
+
+    EXPECT_EQ(tree->CollectGarbage(), 0) << "Expect segments of live values not to be rewritten";
+  }
+
+  auto tree = LsmTree::Open(directory, options);
+  ExpectContents(*tree, expected, 100);
+  tree->Flush();
+  tree->Compact();
+  ExpectContents(*tree, expected, 100);
+}
+
+TEST_F(LsmTreeFixture, CollectsValueLogGarbageConcurrently) {
+  LsmTreeOptions options;
+  options.memtable_size = 8 * 1024;
+  options.sync_writes = false;
+  options.value_separation_threshold = 128;
+  options.value_log_segment_size = 32 * 1024;
+  options.value_log_gc_interval = std::chrono::milliseconds(1);
+  options.value_log_gc_garbage_ratio = 0.25;
+
+  const uint32_t key_count = 200;
+  auto tree = LsmTree::Open(directory, options);
+  for (uint32_t id = 0; id < key_count; id++) {
+    tree->Insert(Key(id), Value(id, 512));
+  }
+
+  std::atomic<bool> done(false);
+  std::thread reader([&tree, &done] {
+    std::mt19937 random(42);
+    while (!done) {
+      auto id = static_cast<uint32_t>(random() % key_count);
+      auto value = tree->Find(Key(id));
+      ASSERT_TRUE(value) << "Expect key " << id << " to remain readable while its value is relocated";
+      EXPECT_EQ(value->size(), 512);
+      EXPECT_EQ((*value)[0], id);
+    }
+  });
+
+  // Every value starts with its key, so readers can verify them regardless of the round that wrote them.
+  for (uint32_t round = 1; round < 20; round++) {
+    for (uint32_t id = 0; id < key_count; id += 1 + round % 3) {
+      auto value = Value(id, 512);
+      value[1] = static_cast<byte>(round);
+      tree->Insert(Key(id), value);
+    }
+  }
+  done = true;
+  reader.join();
+
+  auto metrics = tree->Metrics();
+  EXPECT_GT(metrics.value_log_gc_segments, 0) << "Expect the background collector to remove segments";
+  EXPECT_EQ(metrics.value_log_gc_failures, 0);
+}
+
+TEST_F(LsmTreeFixture, CollectsValueLogGarbageDuringCompactions) {
+  LsmTreeOptions options;
+  options.memtable_size = 4 * 1024;
+  options.memtable_order = 16;
+  options.sync_writes = false;
+  options.compaction_threads = 1;
+  options.level0_compaction_trigger = 2;
+  options.level1_size = 8 * 1024;
+  options.level_size_multiplier = 2;
+  options.run_size = 4 * 1024;
+  options.value_separation_threshold = 128;
+  options.value_log_segment_size = 16 * 1024;
+  options.value_log_gc_interval = std::chrono::milliseconds(1);
+  options.value_log_gc_garbage_ratio = 0.25;
+
+  const uint32_t key_count = 300;
+  for (uint32_t seed = 0; seed < 5; seed++) {
+    std::filesystem::remove_all(directory);
+    std::map<K, V> expected;
+    std::mt19937 random(seed);
+    uint64_t collected_segments = 0;
+
+    for (auto round = 0; round < 3; round++) {
+      auto tree = LsmTree::Open(directory, options);
+      for (auto i = 0; i < 2000; i++) {
+        auto id = static_cast<uint32_t>(random() % key_count);
+        auto operation = random() % 100;
+        if (operation < 20) {
+          tree->Remove(Key(id));
+          expected.erase(Key(id));
+        } else if (operation < 22) {
+          tree->Flush();
+        } else if (operation < 23) {
+          tree->Compact();
+        } else {
+          auto value = Value(i, 64 + random() % 512);
+          tree->Insert(Key(id), value);
+          expected[Key(id)] = value;
+        }
+      }
+      ExpectContents(*tree, expected, key_count);
+
+      auto metrics = tree->Metrics();
+      EXPECT_EQ(metrics.failed_compactions, 0);
+      EXPECT_EQ(metrics.value_log_gc_failures, 0);
+      collected_segments += metrics.value_log_gc_segments;
+    }
+    EXPECT_GT(collected_segments, 0) << "Expect the background collector to remove segments";
+
+    auto tree = LsmTree::Open(directory, options);
+    ExpectContents(*tree, expected, key_count);
+    ASSERT_FALSE(HasFailure()) << "Seed " << seed;
+  }
+}
+
+TEST_F(LsmTreeFixture, ReplaysLogInParallel) {
+  LsmTreeOptions options;
+  options.memtable_size = 64 * 1024 * 1024;
+  options.sync_writes = false;
+  options.value_separation_threshold = 200;
+  options.value_log_gc_interval = std::chrono::milliseconds(0);
+
+  std::map<K, V> expected;
+  std::mt19937 random(11);
+  {
+    auto tree = LsmTree::Open(directory, options);
+    for (auto i = 0; i < 20000; i++) {
+      auto id = static_cast<uint32_t>(random() % 5000);
+      if (random() % 10 == 0) {
+        WriteBatch batch;
+        for (uint32_t j = 0; j < 5; j++) {
+          batch.Insert(Key(id + j * 1000), Value(i, 50));
+          expected[Key(id + j * 1000)] = Value(i, 50);
+        }
+        tree->Write(batch);
+      } else if (random() % 4 == 0) {
+        tree->Remove(Key(id));
+        expected.erase(Key(id));
+      } else {
+        auto value = Value(i, random() % 400);
+        tree->Insert(Key(id), value);
+        expected[Key(id)] = value;
+      }
+    }
+    EXPECT_EQ(tree->RunCount(), 0) << "Expect all modifications to remain in the log";
+  }
+
+  for (size_t threads : {1, 3, 8}) {
+    options.recovery_threads = threads;
+    auto tree = LsmTree::Open(directory, options);
+    ExpectContents(*tree, expected, 9000);
+  }
+
+  // Replayed modifications are flushed like any others.
+  options.memtable_size = 16 * 1024;
+  auto tree = LsmTree::Open(directory, options);
+  EXPECT_GT(tree->RunCount(), 0);
+  ExpectContents(*tree, expected, 9000);
+}
+
+TEST_F(LsmTreeFixture, DurabilityLevels) {
+  LsmTreeOptions options;
+  options.log_flush_interval = std::chrono::milliseconds(0);
+  {
+    auto tree = LsmTree::Open(directory, options);
+    tree->Insert(Key(1), Value(1), Durability::Memory);
+    tree->Flush();
+
+    tree->Insert(Key(2), Value(2), Durability::Memory);
+    tree->Remove(Key(1), Durability::Memory);
+    tree->Insert(Key(3), Value(3), Durability::Buffered);
+    tree->Insert(Key(4), Value(4), Durability::Sync);
+
+    WriteBatch batch;
+    batch.Insert(Key(5), Value(5));
+    batch.Insert(Key(6), Value(6));
+    tree->Write(batch, Durability::Memory);
+    EXPECT_EQ(tree->Find(Key(2)), Value(2)) << "Expect unlogged modifications to be visible";
+    EXPECT_FALSE(tree->Find(Key(1)));
+    EXPECT_EQ(tree->Find(Key(5)), Value(5));
+
+    auto metrics = tree->Metrics();
+    EXPECT_EQ(metrics.synchronous_writes, 1);
+    EXPECT_EQ(metrics.log_flushes, 1) << "Expect only the synchronous modification to flush the log";
+  }
+
+  auto tree = LsmTree::Open(directory, options);
+  EXPECT_EQ(tree->Find(Key(1)), Value(1)) << "Expect a flushed unlogged modification to survive";
+  EXPECT_FALSE(tree->Find(Key(2))) << "Expect unlogged modifications in the memtable to be lost";
+  EXPECT_FALSE(tree->Find(Key(5)));
+  EXPECT_FALSE(tree->Find(Key(6)));
+  EXPECT_EQ(tree->Find(Key(3)), Value(3));
+  EXPECT_EQ(tree->Find(Key(4)), Value(4));
+}
+
+TEST_F(LsmTreeFixture, FlushesBufferedWritesPeriodically) {
+  LsmTreeOptions options;
+  options.sync_writes = false;
+  options.log_flush_interval = std::chrono::milliseconds(1);
+
+  auto tree = LsmTree::Open(directory, options);
+  tree->Insert(Key(1), Value(1));
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (tree->Metrics().log_flushes == 0 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(tree->Metrics().log_flushes, 1) << "Expect the background thread to flush buffered modifications";
+  EXPECT_EQ(tree->Metrics().synchronous_writes, 0);
+}
+
+TEST_F(LsmTreeFixture, GroupCommitsSynchronousWrites) {
+  LsmTreeOptions options;
+  options.log_flush_interval = std::chrono::milliseconds(0);
+
+  const uint32_t thread_count = 8;
+  const uint32_t writes_per_thread = 200;
+  auto tree = LsmTree::Open(directory, options);
+
+  std::vector<std::thread> writers;
+  for (uint32_t t = 0; t < thread_count; t++) {
+    writers.emplace_back([&tree, t] {
+      for (uint32_t i = 0; i < writes_per_thread; i++) {
+        auto id = t * writes_per_thread + i;
+        tree->Insert(Key(id), Value(id), i % 2 == 0 ? Durability::Sync : Durability::Buffered);
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+
+  auto metrics = tree->Metrics();
+  EXPECT_EQ(metrics.synchronous_writes, thread_count * writes_per_thread / 2);
+  EXPECT_GT(metrics.log_flushes, 0);
+  EXPECT_LE(metrics.log_flushes, metrics.synchronous_writes)
+      << "Expect buffered modifications to ride along with synchronous ones";
+}
\ No newline at end of file
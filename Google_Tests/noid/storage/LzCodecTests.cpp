@@ -0,0 +1,80 @@
+#include "gtest/gtest.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "storage/LzCodec.h"
+
+using namespace noid::storage;
+
+static std::vector<byte> RoundTrip(const Codec& codec, const std::vector<byte>& data) {
+  std::vector<byte> compressed(data.size() * 2 + 16);
+  auto size = codec.Compress(data.data(), data.size(), compressed.data(), compressed.size());
+
+  std::vector<byte> decompressed(data.size());
+  codec.Decompress(compressed.data(), size, decompressed.data(), decompressed.size());
+
+  return decompressed;
+}
+
+TEST(LzCodec, RoundTrip) {
+  auto& codec = GetCodec(CodecType::Lz);
+  EXPECT_EQ(codec.Type(), CodecType::Lz);
+
+  std::mt19937 random(3);
+  std::vector<byte> noise(10000);
+  for (auto& b : noise) {
+    b = static_cast<byte>(random());
+  }
+
+  std::string json;
+  for (auto i = 0; i < 200; i++) {
+    json += R"({"id":)" + std::to_string(i) + R"(,"name":"record","tags":["a","b"],"active":true})";
+  }
+  std::vector<byte> text(json.begin(), json.end());
+
+  for (auto& data : {std::vector<byte>(), std::vector<byte>(1, 7), std::vector<byte>(70000, 0), noise, text}) {
+    EXPECT_EQ(RoundTrip(codec, data), data) << "Expect " << data.size() << " bytes to survive a round trip";
+  }
+}
+
+TEST(LzCodec, Compresses) {
+  auto& codec = GetCodec(CodecType::Lz);
+
+  std::string json;
+  for (auto i = 0; i < 100; i++) {
+    json += R"({"id":)" + std::to_string(i) + R"(,"name":"record","tags":["a","b"],"active":true})";
+  }
+
+  std::vector<byte> compressed(json.size());
+  auto size = codec.Compress(reinterpret_cast<const byte*>(json.data()), json.size(), compressed.data(),
+                             compressed.size());
+  EXPECT_GT(size, 0);
+  EXPECT_LT(size * 4, json.size()) << "Expect repetitive data to compress at least four times";
+
+  std::vector<byte> noise(1000);
+  std::mt19937 random(5);
+  for (auto& b : noise) {
+    b = static_cast<byte>(random());
+  }
+  EXPECT_EQ(codec.Compress(noise.data(), noise.size(), compressed.data(), noise.size()), 0)
+            << "Expect incompressible data not to fit in its own size";
+}
+
+TEST(LzCodec, RejectsCorruptData) {
+  auto& codec = GetCodec(CodecType::Lz);
+  std::vector<byte> data(1000, 'x');
+  std::vector<byte> compressed(1000);
+  auto size = codec.Compress(data.data(), data.size(), compressed.data(), compressed.size());
+
+  EXPECT_THROW(codec.Decompress(compressed.data(), size, data.data(), data.size() - 1), std::runtime_error)
+            << "Expect a size mismatch to be detected";
+  EXPECT_THROW(codec.Decompress(compressed.data(), size / 2, data.data(), data.size()), std::runtime_error)
+            << "Expect truncated data to be detected";
+
+  const byte bad_offset[] = {0x10, 'a', 0x05, 0x00};
+  EXPECT_THROW(codec.Decompress(bad_offset, sizeof(bad_offset), data.data(), 5), std::runtime_error)
+            << "Expect a match before the start of the output to be detected";
+  EXPECT_THROW(GetCodec(CodecType::None), std::invalid_argument);
+}
\ No newline at end of file
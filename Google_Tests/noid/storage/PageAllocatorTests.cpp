@@ -0,0 +1,172 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <memory>
+#include <set>
+
+#include "storage/BufferPool.h"
+#include "storage/PageAllocator.h"
+#include "storage/PageFile.h"
+
+using namespace noid::storage;
+
+class PageAllocatorFixture : public ::testing::Test {
+ protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-allocator-") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+      std::filesystem::remove_all(directory);
+      std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(directory);
+    }
+
+    std::shared_ptr<BufferPool> OpenPool() {
+      std::shared_ptr<PageFile> file = PageFile::Open(directory / "pages");
+      return std::make_shared<BufferPool>(file, 16);
+    }
+};
+
+TEST_F(PageAllocatorFixture, AllocateReusesFreedPages) {
+  auto allocator = PageAllocator::Open(OpenPool(), 2);
+
+  auto first = allocator->Allocate();
+  EXPECT_EQ(first, 3) << "Expect page 0 and the reserved pages never to be allocated";
+  EXPECT_EQ(allocator->PageCount(), 3 + PAGE_ALLOCATOR_EXTENT_SIZE) << "Expect the file to grow by an extent";
+
+  auto second = allocator->Allocate();
+  allocator->Free(first);
+  EXPECT_EQ(allocator->Allocate(), first) << "Expect a freed page to be reused";
+  EXPECT_NE(allocator->Allocate(), second);
+
+  EXPECT_THROW(allocator->Free(0), std::logic_error) << "Expect the bitmap page not to be freed";
+  EXPECT_THROW(allocator->Free(1), std::logic_error) << "Expect a reserved page not to be freed";
+  allocator->Free(second);
+  EXPECT_THROW(allocator->Free(second), std::logic_error) << "Expect a double free to be detected";
+}
+
+TEST_F(PageAllocatorFixture, AllocateNearHint) {
+  auto allocator = PageAllocator::Open(OpenPool());
+
+  for (auto i = 0; i < 20; i++) {
+    allocator->Allocate();
+  }
+  allocator->Free(3);
+  allocator->Free(15);
+  allocator->Free(16);
+
+  EXPECT_EQ(allocator->Allocate(14), 15) << "Expect the free page closest to the hint";
+  EXPECT_EQ(allocator->Allocate(4), 3) << "Expect the free page closest to the hint";
+}
+
+TEST_F(PageAllocatorFixture, AllocateExtent) {
+  auto allocator = PageAllocator::Open(OpenPool());
+
+  for (auto i = 0; i < 10; i++) {
+    allocator->Allocate();
+  }
+  allocator->Free(4);
+  allocator->Free(6);
+  allocator->Free(7);
+  allocator->Free(8);
+
+  EXPECT_EQ(allocator->AllocateExtent(3), 6) << "Expect the first run of enough free pages";
+  EXPECT_EQ(allocator->AllocateExtent(2, 5), 11) << "Expect a run after the hint";
+
+  auto first = allocator->AllocateExtent(100);
+  EXPECT_GE(allocator->PageCount(), first + 100) << "Expect the file to grow to contain the extent";
+}
+
+TEST_F(PageAllocatorFixture, Reopen) {
+  std::set<PageId> allocated;
+  {
+    auto pool = OpenPool();
+    auto allocator = PageAllocator::Open(pool);
+    for (auto i = 0; i < 40; i++) {
+      allocated.insert(allocator->Allocate());
+    }
+
+    for (PageId id = 5; id < 15; id++) {
+      allocator->Free(id);
+      allocated.erase(id);
+    }
+    pool->FlushAll();
+  }
+
+  auto allocator = PageAllocator::Open(OpenPool());
+  EXPECT_EQ(allocator->PageCount(), 1 + 2 * PAGE_ALLOCATOR_EXTENT_SIZE);
+  EXPECT_EQ(allocator->FreePageCount(), allocator->PageCount() - 1 - allocated.size())
+            << "Expect the free pages to be read from the bitmap";
+
+  for (auto i = 0; i < 10; i++) {
+    auto page_id = allocator->Allocate();
+    EXPECT_TRUE(page_id >= 5 && page_id < 15) << "Expect freed pages to survive reopening, got " << page_id;
+  }
+}
+
+TEST_F(PageAllocatorFixture, Truncate) {
+  auto pool = OpenPool();
+  auto allocator = PageAllocator::Open(pool);
+
+  PageId last = INVALID_PAGE_ID;
+  for (auto i = 0; i < 50; i++) {
+    last = allocator->Allocate();
+  }
+  pool->FlushAll();
+
+  for (auto id = last; id > 20; id--) {
+    allocator->Free(id);
+  }
+
+  EXPECT_EQ(allocator->Truncate(), 21) << "Expect all trailing free pages to be released";
+  EXPECT_EQ(allocator->PageCount(), 21);
+  EXPECT_EQ(std::filesystem::file_size(directory / "pages"), 21 * PAGE_SIZE) << "Expect the file to shrink";
+  EXPECT_EQ(allocator->Truncate(), 21) << "Expect nothing to be released if the last page is allocated";
+
+  EXPECT_EQ(allocator->Allocate(), 21) << "Expect the file to grow again after truncation";
+}
+
+TEST_F(PageAllocatorFixture, LoadBitmapsOnDemand) {
+  PageId free_page_count;
+  PageId middle;
+  {
+    auto pool = OpenPool();
+    auto allocator = PageAllocator::Open(pool);
+    for (auto i = 0; i < 100; i++) {
+      auto first = allocator->AllocateExtent(1000);
+      if (i == 50) {
+        middle = first + 500;
+      }
+    }
+
+    free_page_count = allocator->FreePageCount();
+    pool->FlushAll();
+  }
+
+  auto pool = OpenPool();
+  auto allocator = PageAllocator::Open(pool);
+  EXPECT_EQ(pool->CachedPageCount(), 1) << "Expect opening to read page 0 only";
+
+  allocator->Free(middle);
+  EXPECT_EQ(pool->CachedPageCount(), 2) << "Expect freeing a page to read the bitmap of its group only";
+  EXPECT_EQ(allocator->Allocate(middle), middle) << "Expect the freed page to be reused";
+  EXPECT_EQ(pool->CachedPageCount(), 2);
+
+  EXPECT_EQ(allocator->FreePageCount(), free_page_count) << "Expect the free pages of all groups to be read";
+}
+TEST_F(PageAllocatorFixture, Reserve) {
+  auto allocator = PageAllocator::Open(OpenPool(), 2);
+
+  allocator->Reserve(100);
+  EXPECT_EQ(allocator->PageCount(), 101) << "Expect the file to grow up to the reserved page";
+  EXPECT_EQ(allocator->FreePageCount(), 97);
+  EXPECT_THROW(allocator->Reserve(100), std::logic_error) << "Expect an allocated page not to be reserved";
+  EXPECT_THROW(allocator->Reserve(2), std::logic_error) << "Expect a reserved page not to be reserved";
+
+  allocator->Reserve(50);
+  EXPECT_NE(allocator->Allocate(50), 50) << "Expect reserved pages not to be allocated";
+}
\ No newline at end of file
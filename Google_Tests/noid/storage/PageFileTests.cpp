@@ -0,0 +1,110 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "storage/AlignedBuffer.h"
+#include "storage/PageFile.h"
+
+using namespace noid::storage;
+
+class PageFileFixture : public ::testing::TestWithParam<IoBackendType> {
+ protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-pagefile-") + std::to_string(static_cast<int>(GetParam())));
+      std::filesystem::remove_all(directory);
+      std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(directory);
+    }
+};
+
+TEST_P(PageFileFixture, BatchRoundTrip) {
+  auto file = PageFile::Open(directory / "pages", GetParam());
+  const PageId page_count = 200;
+
+  std::vector<std::unique_ptr<byte[]>> pages;
+  std::vector<PageIo> batch;
+  for (PageId id = 0; id < page_count; id++) {
+    pages.push_back(std::make_unique<byte[]>(PAGE_SIZE));
+    std::fill_n(pages.back().get(), PAGE_SIZE, static_cast<byte>(id));
+    batch.push_back({id, pages.back().get()});
+  }
+
+  // Write the pages in reverse, so the batch is not sequential.
+  std::vector<PageIo> reversed(batch.rbegin(), batch.rend());
+  file->WriteBatch(reversed);
+  EXPECT_EQ(file->PageCount(), page_count);
+
+  for (auto& page : pages) {
+    std::fill_n(page.get(), PAGE_SIZE, 0xff);
+  }
+  file->ReadBatch(batch);
+
+  for (PageId id = 0; id < page_count; id++) {
+    EXPECT_EQ(pages[id][0], static_cast<byte>(id)) << "Expect page " << id << " to be read back";
+    EXPECT_EQ(pages[id][PAGE_SIZE - 1], static_cast<byte>(id)) << "Expect page " << id << " to be read completely";
+  }
+}
+
+TEST_P(PageFileFixture, ReadBeyondEndOfFile) {
+  auto file = PageFile::Open(directory / "pages", GetParam());
+
+  auto written = std::make_unique<byte[]>(PAGE_SIZE);
+  std::fill_n(written.get(), PAGE_SIZE, 7);
+  file->Write(0, written.get());
+
+  auto first = std::make_unique<byte[]>(PAGE_SIZE);
+  auto second = std::make_unique<byte[]>(PAGE_SIZE);
+  std::fill_n(second.get(), PAGE_SIZE, 0xff);
+  file->ReadBatch({{0, first.get()}, {5, second.get()}});
+
+  EXPECT_EQ(first[PAGE_SIZE - 1], 7);
+  EXPECT_EQ(second[0], 0) << "Expect pages beyond the end of the file to be zero-filled";
+  EXPECT_EQ(second[PAGE_SIZE - 1], 0) << "Expect pages beyond the end of the file to be zero-filled";
+}
+
+TEST_P(PageFileFixture, Reopen) {
+  auto page = std::make_unique<byte[]>(PAGE_SIZE);
+  {
+    auto file = PageFile::Open(directory / "pages", GetParam());
+    std::fill_n(page.get(), PAGE_SIZE, 42);
+    file->WriteBatch({{3, page.get()}});
+    file->Sync();
+  }
+
+  auto file = PageFile::Open(directory / "pages");
+  EXPECT_EQ(file->BackendType(), IoBackendType::Synchronous);
+
+  std::fill_n(page.get(), PAGE_SIZE, 0);
+  file->Read(3, page.get());
+  EXPECT_EQ(page[0], 42) << "Expect pages written by any backend to be readable by another";
+}
+
+TEST_P(PageFileFixture, DirectIo) {
+  auto file = PageFile::Open(directory / "pages", GetParam(), true);
+
+  // Unaligned buffers are transferred through aligned ones.
+  auto unaligned = std::make_unique<byte[]>(PAGE_SIZE + 1);
+  auto aligned = AllocateAligned(PAGE_SIZE);
+  std::fill_n(unaligned.get() + 1, PAGE_SIZE, 1);
+  std::fill_n(aligned.get(), PAGE_SIZE, 2);
+  file->WriteBatch({{0, unaligned.get() + 1}, {1, aligned.get()}});
+  file->Sync();
+
+  std::fill_n(unaligned.get() + 1, PAGE_SIZE, 0);
+  std::fill_n(aligned.get(), PAGE_SIZE, 0);
+  file->ReadBatch({{1, unaligned.get() + 1}, {0, aligned.get()}});
+
+  EXPECT_EQ(unaligned[PAGE_SIZE], 2) << "Expect an unaligned buffer to be read";
+  EXPECT_EQ(aligned[PAGE_SIZE - 1], 1) << "Expect an aligned buffer to be read";
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, PageFileFixture,
+                         ::testing::Values(IoBackendType::Synchronous, IoBackendType::IoUring));
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "storage/SortedRun.h"
+
+using namespace noid::storage;
+
+class SortedRunFixture : public ::testing::Test {
+ protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-run-") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+      std::filesystem::remove_all(directory);
+      std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(directory);
+    }
+
+    static K Key(uint32_t i) {
+      K key{};
+      key[12] = static_cast<byte>(i >> 24);
+      key[13] = static_cast<byte>(i >> 16);
+      key[14] = static_cast<byte>(i >> 8);
+      key[15] = static_cast<byte>(i);
+
+      return key;
+    }
+
+    /**
+     * Writes a run containing the even keys below 2 * count, where every fifth key is a tombstone.
+     */
+    void Build(const std::filesystem::path& path, uint32_t count,
+               uint8_t bits_per_key = SORTED_RUN_DEFAULT_BLOOM_BITS_PER_KEY) {
+      auto builder = SortedRunBuilder::Create(path, bits_per_key);
+      for (uint32_t i = 0; i < count; i++) {
+        auto key = 2 * i;
+        builder->Add(Key(key), {key % 5 == 0, key % 5 == 0 ? V() : V(key % 200, static_cast<byte>(key))});
+      }
+      builder->Finish();
+    }
+};
+
+TEST_F(SortedRunFixture, FindAndScan) {
+  Build(directory / "1.run", 2000);
+
+  auto run = SortedRun::Open(directory / "1.run");
+  EXPECT_EQ(run->RecordCount(), 2000);
+  EXPECT_EQ(run->SmallestKey(), Key(0));
+  EXPECT_EQ(run->LargestKey(), Key(3998));
+  EXPECT_EQ(run->FileSize(), std::filesystem::file_size(directory / "1.run"));
+
+  for (uint32_t key = 0; key < 4000; key++) {
+    auto entry = run->Find(Key(key));
+    if (key % 2 == 1) {
+      EXPECT_FALSE(entry) << "Expect odd keys to be absent";
+    } else {
+      ASSERT_TRUE(entry);
+      EXPECT_EQ(entry->tombstone, key % 5 == 0);
+      EXPECT_EQ(entry->value, key % 5 == 0 ? V() : V(key % 200, static_cast<byte>(key)));
+    }
+  }
+  EXPECT_FALSE(run->Find(Key(5000))) << "Expect keys beyond the largest key to be absent";
+  EXPECT_GT(run->FilterSize(), 0) << "Expect the run to have a Bloom filter";
+
+  uint32_t expected = 1000;
+  run->Scan(Key(999), [&expected](const K& key, const LsmEntry&) {
+    EXPECT_EQ(key, Key(expected)) << "Expect the scan to start at the first key of at least the given key";
+    expected += 2;
+    return expected < 1100;
+  });
+  EXPECT_EQ(expected, 1100) << "Expect the scan to stop when the consumer returns false";
+}
+
+TEST_F(SortedRunFixture, UnfinishedRunIsDiscarded) {
+  {
+    auto builder = SortedRunBuilder::Create(directory / "1.run");
+    builder->Add(Key(1), {false, V(10, 1)});
+    EXPECT_THROW(builder->Add(Key(1), {false, V(10, 1)}), std::logic_error)
+        << "Expect keys which are not ascending to be rejected";
+  }
+
+  EXPECT_TRUE(std::filesystem::is_empty(directory)) << "Expect an unfinished run to leave no files behind";
+}
+
+TEST_F(SortedRunFixture, DetectsCorruption) {
+  Build(directory / "1.run", 2000);
+
+  {
+    std::fstream file(directory / "1.run", std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(100);
+    file.put(static_cast<char>(0x5a));
+  }
+
+  auto run = SortedRun::Open(directory / "1.run");
+  EXPECT_THROW(run->Find(Key(2)), std::runtime_error) << "Expect a corrupt block to be detected";
+  EXPECT_TRUE(run->Find(Key(3000))) << "Expect intact blocks to remain readable";
+
+  std::filesystem::resize_file(directory / "1.run", 1000);
+  EXPECT_THROW(SortedRun::Open(directory / "1.run"), std::runtime_error) << "Expect a truncated run to be rejected";
+}
+
+TEST_F(SortedRunFixture, WithoutFilter) {
+  Build(directory / "1.run", 100, 0);
+
+  auto run = SortedRun::Open(directory / "1.run");
+  EXPECT_EQ(run->FilterSize(), 0);
+  EXPECT_TRUE(run->Find(Key(2)));
+  EXPECT_FALSE(run->Find(Key(3))) << "Expect a run without filter to find absent keys in its blocks";
+}
\ No newline at end of file
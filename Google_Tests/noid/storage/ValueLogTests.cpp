@@ -0,0 +1,178 @@
+#include "gtest/gtest.h"
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "storage/ValueLog.h"
+
+using namespace noid::storage;
+
+class ValueLogFixture : public ::testing::Test {
+ protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-vlog-") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+      std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(directory);
+    }
+
+    static K Key(uint32_t i) {
+      K key{};
+      key[12] = static_cast<byte>(i >> 24);
+      key[13] = static_cast<byte>(i >> 16);
+      key[14] = static_cast<byte>(i >> 8);
+      key[15] = static_cast<byte>(i);
+
+      return key;
+    }
+
+    static V Value(uint32_t i, size_t size = 100) {
+      return V(size, static_cast<byte>(i));
+    }
+};
+
+TEST_F(ValueLogFixture, PointerRoundTrip) {
+  ValuePointer pointer{7, 123456789012, 4096};
+  auto encoded = pointer.Encode();
+  EXPECT_EQ(encoded.size(), VALUE_POINTER_SIZE);
+
+  auto decoded = ValuePointer::Decode(encoded);
+  EXPECT_EQ(decoded.segment, 7);
+  EXPECT_EQ(decoded.offset, 123456789012);
+  EXPECT_EQ(decoded.length, 4096);
+
+  EXPECT_THROW(ValuePointer::Decode(V(VALUE_POINTER_SIZE - 1)), std::runtime_error)
+            << "Expect a truncated pointer to be rejected";
+}
+
+TEST_F(ValueLogFixture, AppendAndRead) {
+  EXPECT_THROW(ValueLog::Open(directory, 0), std::invalid_argument);
+
+  auto log = ValueLog::Open(directory);
+  EXPECT_EQ(log->SegmentCount(), 0) << "Expect the first segment to be created on the first append";
+
+  std::vector<ValuePointer> pointers;
+  for (uint32_t i = 0; i < 100; i++) {
+    pointers.push_back(log->Append(Key(i), Value(i, 64 + i * 100)));
+  }
+  pointers.push_back(log->Append(Key(100), V()));
+  EXPECT_EQ(log->SegmentCount(), 1);
+
+  for (uint32_t i = 0; i < 100; i++) {
+    EXPECT_EQ(log->Read(Key(i), pointers[i]), Value(i, 64 + i * 100));
+  }
+  EXPECT_EQ(log->Read(Key(100), pointers[100]), V()) << "Expect empty values to be supported";
+
+  EXPECT_THROW(log->Read(Key(1), pointers[0]), std::runtime_error)
+            << "Expect reading a value for another key to fail";
+  EXPECT_THROW(log->Read(Key(0), ValuePointer{42, 0, 64}), std::runtime_error)
+            << "Expect reading from a missing segment to fail";
+}
+
+TEST_F(ValueLogFixture, RotatesAndReopensSegments) {
+  std::vector<ValuePointer> pointers;
+  {
+    auto log = ValueLog::Open(directory, 4096);
+    for (uint32_t i = 0; i < 100; i++) {
+      pointers.push_back(log->Append(Key(i), Value(i, 1000)));
+    }
+    EXPECT_EQ(log->SegmentCount(), 25) << "Expect a new segment after every 4 KiB";
+    log->Sync();
+  }
+
+  auto log = ValueLog::Open(directory, 4096);
+  EXPECT_EQ(log->SegmentCount(), 25);
+  for (uint32_t i = 0; i < 100; i++) {
+    EXPECT_EQ(log->Read(Key(i), pointers[i]), Value(i, 1000)) << "Expect value " << i << " to survive a reopen";
+  }
+
+  auto pointer = log->Append(Key(100), Value(100));
+  EXPECT_GT(pointer.segment, pointers.back().segment) << "Expect a reopened log to start a new segment";
+  EXPECT_EQ(pointer.offset, 0);
+  EXPECT_EQ(log->Read(Key(100), pointer), Value(100));
+}
+
+TEST_F(ValueLogFixture, DetectsCorruption) {
+  ValuePointer pointer{};
+  {
+    auto log = ValueLog::Open(directory);
+    log->Append(Key(0), Value(0));
+    pointer = log->Append(Key(1), Value(1));
+  }
+
+  auto segment = std::filesystem::directory_iterator(directory)->path();
+  {
+    std::fstream file(segment, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(static_cast<std::streamoff>(pointer.offset + pointer.length));
+    file.put(0x42);
+  }
+
+  auto log = ValueLog::Open(directory);
+  EXPECT_THROW(log->Read(Key(1), pointer), std::runtime_error) << "Expect a checksum mismatch to be detected";
+
+  pointer.offset += pointer.length;
+  EXPECT_THROW(log->Read(Key(1), pointer), std::runtime_error) << "Expect reading past the segment end to fail";
+}
+
+TEST_F(ValueLogFixture, ScanAndRemoveSealedSegments) {
+  auto log = ValueLog::Open(directory, 4096);
+  EXPECT_FALSE(log->OldestSealedSegment());
+
+  std::vector<ValuePointer> pointers;
+  for (uint32_t i = 0; i < 10; i++) {
+    pointers.push_back(log->Append(Key(i), Value(i, 1000)));
+  }
+  EXPECT_EQ(log->SegmentCount(), 3);
+  EXPECT_EQ(log->OldestSealedSegment(), pointers[0].segment);
+  EXPECT_THROW(log->Remove(pointers[9].segment), std::logic_error) << "Expect the head segment not to be removable";
+
+  uint32_t scanned = 0;
+  log->Scan(pointers[0].segment, [&scanned, &pointers](const K& key, const ValuePointer& pointer, const V& value) {
+    EXPECT_EQ(key, Key(scanned));
+    EXPECT_EQ(pointer.offset, pointers[scanned].offset);
+    EXPECT_EQ(pointer.length, 1000);
+    EXPECT_EQ(value, Value(scanned, 1000));
+    scanned++;
+
+    return true;
+  });
+  EXPECT_EQ(scanned, 4) << "Expect a segment to be scanned until its end";
+
+  auto size = log->Size();
+  log->Remove(pointers[0].segment);
+  EXPECT_EQ(log->SegmentCount(), 2);
+  EXPECT_LT(log->Size(), size);
+  EXPECT_EQ(log->OldestSealedSegment(), pointers[4].segment);
+  EXPECT_THROW(log->Read(Key(0), pointers[0]), std::runtime_error) << "Expect removed values to be unreadable";
+  EXPECT_THROW(log->Remove(pointers[0].segment), std::logic_error);
+  EXPECT_EQ(log->Read(Key(4), pointers[4]), Value(4, 1000));
+}
+
+TEST_F(ValueLogFixture, ScanStopsAtTruncatedEntry) {
+  {
+    auto log = ValueLog::Open(directory);
+    log->Append(Key(0), Value(0));
+    log->Append(Key(1), Value(1));
+  }
+
+  auto segment = std::filesystem::directory_iterator(directory)->path();
+  std::filesystem::resize_file(segment, std::filesystem::file_size(segment) - 10);
+
+  auto log = ValueLog::Open(directory);
+  auto number = log->OldestSealedSegment();
+  ASSERT_TRUE(number) << "Expect the segments of a reopened log to be sealed";
+
+  uint32_t scanned = 0;
+  log->Scan(*number, [&scanned](const K&, const ValuePointer&, const V&) {
+    scanned++;
+    return true;
+  });
+  EXPECT_EQ(scanned, 1) << "Expect an entry torn by a crash to end the scan";
+}
\ No newline at end of file
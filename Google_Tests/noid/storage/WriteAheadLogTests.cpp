@@ -0,0 +1,245 @@
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <system_error>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "storage/WriteAheadLog.h"
+
+using namespace noid::storage;
+
+/**
+ * The amount of upcoming calls to fdatasync that fail with EIO.
+ */
+static std::atomic<int> failing_syncs(0);
+
+/**
+ * Replaces fdatasync of the C library for the whole test binary, so tests can make synchronization fail.
+ */
+extern "C" int fdatasync(int fd) {
+  if (failing_syncs.load() > 0 && failing_syncs.fetch_sub(1) > 0) {
+    errno = EIO;
+    return -1;
+  }
+
+  return static_cast<int>(::syscall(SYS_fdatasync, fd));
+}
+
+class WriteAheadLogFixture : public ::testing::Test {
+ protected:
+    std::filesystem::path directory;
+
+    void SetUp() override {
+      directory = std::filesystem::temp_directory_path() /
+          (std::string("noid-wal-") + ::testing::UnitTest::GetInstance()->current_test_info()->name());
+      std::filesystem::remove_all(directory);
+    }
+
+    void TearDown() override {
+      std::filesystem::remove_all(directory);
+    }
+};
+
+TEST_F(WriteAheadLogFixture, AppendAssignsIncreasingLsns) {
+  auto log = WriteAheadLog::Open(directory);
+  byte record[] = {1, 3, 3, 7};
+
+  EXPECT_EQ(log->LastLsn(), INVALID_LSN) << "Expect an empty log to have no last LSN";
+  EXPECT_EQ(log->Append(record, sizeof(record)), 1);
+  EXPECT_EQ(log->Append(record, sizeof(record)), 2);
+  EXPECT_EQ(log->LastLsn(), 2);
+  EXPECT_EQ(log->FlushedLsn(), 0) << "Expect appended records to be buffered until flushed";
+
+  log->Flush(1);
+  EXPECT_EQ(log->FlushedLsn(), 2) << "Expect a flush to write all buffered records";
+}
+
+TEST_F(WriteAheadLogFixture, AppendRejectsOversizedRecords) {
+  auto log = WriteAheadLog::Open(directory);
+  byte record[] = {1, 3, 3, 7};
+
+  // The size is rejected before the record is read.
+  EXPECT_THROW(log->Append(record, static_cast<size_t>(std::numeric_limits<uint32_t>::max()) + 1),
+               std::invalid_argument);
+  EXPECT_EQ(log->LastLsn(), INVALID_LSN) << "Expect a rejected record not to be assigned an LSN";
+}
+
+TEST_F(WriteAheadLogFixture, ReplayAfterReopen) {
+  {
+    auto log = WriteAheadLog::Open(directory);
+    for (byte i = 0; i < 10; i++) {
+      byte record[] = {i, i, i};
+      log->Append(record, sizeof(record));
+    }
+    log->Flush(log->LastLsn());
+  }
+
+  auto log = WriteAheadLog::Open(directory);
+  EXPECT_EQ(log->LastLsn(), 10) << "Expect reopening the log to continue after the last durable record";
+
+  std::vector<Lsn> replayed;
+  log->Replay(4, [&replayed](Lsn lsn, const byte* data, size_t size) {
+    EXPECT_EQ(size, 3);
+    EXPECT_EQ(data[0], lsn - 1);
+    replayed.push_back(lsn);
+  });
+
+  EXPECT_EQ(replayed, std::vector<Lsn>({4, 5, 6, 7, 8, 9, 10}));
+}
+
+TEST_F(WriteAheadLogFixture, CheckpointRecyclesSegments) {
+  // Use tiny segments so that every flush starts a new one.
+  auto log = WriteAheadLog::Open(directory, 1);
+  byte record[] = {1, 3, 3, 7};
+
+  for (auto i = 0; i < 5; i++) {
+    log->Flush(log->Append(record, sizeof(record)));
+  }
+  EXPECT_EQ(log->SegmentCount(), 5);
+
+  log->Checkpoint(4);
+  EXPECT_EQ(log->CheckpointLsn(), 4);
+  EXPECT_EQ(log->SegmentCount(), 2) << "Expect all segments preceding the checkpoint LSN to be recycled";
+
+  log->Checkpoint(2);
+  EXPECT_EQ(log->CheckpointLsn(), 4) << "Expect a checkpoint never to move backwards";
+
+  log.reset();
+  log = WriteAheadLog::Open(directory, 1);
+  EXPECT_EQ(log->CheckpointLsn(), 4) << "Expect the checkpoint LSN to be durable";
+
+  std::vector<Lsn> replayed;
+  log->Replay(log->CheckpointLsn(), [&replayed](Lsn lsn, const byte*, size_t) { replayed.push_back(lsn); });
+  EXPECT_EQ(replayed, std::vector<Lsn>({4, 5}));
+}
+
+TEST_F(WriteAheadLogFixture, DirectIoFlushesPartialBlocks) {
+  // Records are smaller than a block, so consecutive flushes rewrite the partially written last block.
+  {
+    auto log = WriteAheadLog::Open(directory, WAL_DEFAULT_SEGMENT_SIZE, true);
+    for (byte i = 0; i < 100; i++) {
+      std::vector<byte> record(i + 1, i);
+      log->Flush(log->Append(record.data(), record.size()));
+    }
+  }
+
+  auto log = WriteAheadLog::Open(directory, WAL_DEFAULT_SEGMENT_SIZE, true);
+  EXPECT_EQ(log->LastLsn(), 100) << "Expect block padding to be discarded when reopening the log";
+
+  std::vector<byte> record(101, 100);
+  log->Flush(log->Append(record.data(), record.size()));
+
+  Lsn expected = 1;
+  log->Replay(1, [&expected](Lsn lsn, const byte* data, size_t size) {
+    EXPECT_EQ(lsn, expected);
+    EXPECT_EQ(size, lsn) << "Expect record " << lsn << " to survive rewriting its block";
+    EXPECT_EQ(data[size - 1], lsn - 1);
+    expected++;
+  });
+
+  EXPECT_EQ(expected, 102) << "Expect records appended after reopening to follow the existing ones";
+}
+
+TEST_F(WriteAheadLogFixture, ReplayVerifiesChecksums) {
+  {
+    // Use tiny segments so that every flush starts a new one.
+    auto log = WriteAheadLog::Open(directory, 1);
+    byte record[] = {1, 3, 3, 7};
+
+    for (auto i = 0; i < 3; i++) {
+      log->Flush(log->Append(record, sizeof(record)));
+    }
+  }
+
+  // Flip a bit in the contents of the first record. Its header is 16 bytes.
+  std::vector<std::filesystem::path> segments;
+  for (auto& entry : std::filesystem::directory_iterator(directory)) {
+    if (entry.path().extension() == ".wal") {
+      segments.push_back(entry.path());
+    }
+  }
+  std::sort(segments.begin(), segments.end());
+  ASSERT_EQ(segments.size(), 3);
+  {
+    std::fstream segment(segments[0], std::ios::in | std::ios::out | std::ios::binary);
+    segment.seekp(17);
+    segment.put(4);
+  }
+
+  auto log = WriteAheadLog::Open(directory, 1);
+  EXPECT_THROW(log->Replay(1, [](Lsn, const byte*, size_t) {}), std::runtime_error)
+            << "Expect a corrupt record preceding the last segment to be reported";
+
+  std::vector<Lsn> replayed;
+  log->Replay(2, [&replayed](Lsn lsn, const byte*, size_t) { replayed.push_back(lsn); });
+  EXPECT_EQ(replayed, std::vector<Lsn>({2, 3})) << "Expect intact segments to be replayed";
+}
+
+TEST_F(WriteAheadLogFixture, FailedFlushKeepsRecords) {
+  byte small[] = {1, 3, 3, 7};
+  std::vector<byte> large(64 * 1024, 42);
+  {
+    auto log = WriteAheadLog::Open(directory);
+    log->Flush(log->Append(small, sizeof(small)));
+    log->Append(large.data(), large.size());
+
+    // Limiting the file size makes the write fail with EFBIG instead of raising SIGXFSZ.
+    struct rlimit original{};
+    ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &original), 0);
+    auto handler = std::signal(SIGXFSZ, SIG_IGN);
+    struct rlimit limited = original;
+    limited.rlim_cur = 1024;
+    ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limited), 0);
+
+    EXPECT_THROW(log->Flush(log->LastLsn()), std::system_error);
+    ::setrlimit(RLIMIT_FSIZE, &original);
+    std::signal(SIGXFSZ, handler);
+    EXPECT_EQ(log->FlushedLsn(), 1);
+
+    log->Flush(log->Append(small, sizeof(small)));
+    EXPECT_EQ(log->FlushedLsn(), 3) << "Expect the records of the failed flush to be written by the next one";
+  }
+
+  auto log = WriteAheadLog::Open(directory);
+  std::vector<size_t> sizes;
+  log->Replay(1, [&sizes](Lsn, const byte*, size_t size) { sizes.push_back(size); });
+  EXPECT_EQ(sizes, std::vector<size_t>({4, large.size(), 4})) << "Expect no gap in the replayed records";
+}
+
+TEST_F(WriteAheadLogFixture, FailedDirectIoSyncKeepsRecords) {
+  byte record[] = {1, 3, 3, 7};
+  {
+    auto log = WriteAheadLog::Open(directory, WAL_DEFAULT_SEGMENT_SIZE, true);
+    log->Flush(log->Append(record, sizeof(record)));
+    log->Append(record, sizeof(record));
+
+    // The partial block has been rewritten by the time the synchronization fails.
+    failing_syncs = 1;
+    EXPECT_THROW(log->Flush(log->LastLsn()), std::system_error);
+    EXPECT_EQ(failing_syncs.load(), 0);
+    EXPECT_EQ(log->FlushedLsn(), 1);
+
+    log->Flush(log->Append(record, sizeof(record)));
+    EXPECT_EQ(log->FlushedLsn(), 3) << "Expect the records of the failed flush to be written by the next one";
+  }
+
+  auto log = WriteAheadLog::Open(directory, WAL_DEFAULT_SEGMENT_SIZE, true);
+  EXPECT_EQ(log->LastLsn(), 3) << "Expect all records to be recovered";
+
+  std::vector<Lsn> replayed;
+  log->Replay(1, [&replayed](Lsn lsn, const byte* data, size_t size) {
+    EXPECT_EQ(size, 4);
+    EXPECT_EQ(data[3], 7);
+    replayed.push_back(lsn);
+  });
+  EXPECT_EQ(replayed, std::vector<Lsn>({1, 2, 3})) << "Expect no duplicated or shifted records";
+}
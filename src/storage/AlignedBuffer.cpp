@@ -0,0 +1,32 @@
+#include "AlignedBuffer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace noid::storage {
+
+void AlignedDeleter::operator()(byte *data) const {
+  std::free(data);
+}
+
+AlignedBuffer AllocateAligned(size_t size, size_t alignment) {
+  // aligned_alloc requires the size to be a multiple of the alignment.
+  auto rounded_size = (std::max<size_t>(size, 1) + alignment - 1) & ~(alignment - 1);
+
+  auto data = static_cast<byte*>(std::aligned_alloc(alignment, rounded_size));
+  if (data == nullptr) {
+    throw std::bad_alloc();
+  }
+
+  std::memset(data, 0, rounded_size);
+  return AlignedBuffer(data);
+}
+
+bool IsAligned(const void *data, size_t alignment) {
+  return (reinterpret_cast<uintptr_t>(data) & (alignment - 1)) == 0;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef NOID_SRC_STORAGE_ALIGNEDBUFFER_H_
+#define NOID_SRC_STORAGE_ALIGNEDBUFFER_H_
+
+#include <cstddef>
+#include <memory>
+
+#include "Page.h"
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief Releases memory allocated by @c AllocateAligned.
+ */
+struct AlignedDeleter {
+
+    /**
+     * @brief Releases the given memory.
+     *
+     * @param data The memory to release.
+     */
+    void operator()(byte* data) const;
+};
+
+/**
+ * @brief Alias for an owned, aligned byte array.
+ */
+using AlignedBuffer = std::unique_ptr<byte[], AlignedDeleter>;
+
+/**
+ * @brief Allocates a zero-filled byte array starting at a multiple of @p alignment.
+ * @details Direct I/O requires the memory, the file offset and the transfer size to be aligned to the logical block
+ * size of the device. Aligning to @c PAGE_SIZE satisfies this for all common devices.
+ *
+ * @param size The size in bytes.
+ * @param alignment The alignment in bytes, which must be a power of two.
+ * @return The allocated memory.
+ * @throws std::bad_alloc If the memory cannot be allocated.
+ */
+[[nodiscard]] AlignedBuffer AllocateAligned(size_t size, size_t alignment = PAGE_SIZE);
+
+/**
+ * @param data The memory to inspect.
+ * @param alignment The alignment in bytes, which must be a power of two.
+ * @return Whether @p data starts at a multiple of @p alignment.
+ */
+[[nodiscard]] bool IsAligned(const void* data, size_t alignment = PAGE_SIZE);
+
+}
+
+#endif //NOID_SRC_STORAGE_ALIGNEDBUFFER_H_
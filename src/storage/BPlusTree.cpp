@@ -1,14 +1,34 @@
 #include "BPlusTree.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <sstream>
 #include <stdexcept>
+#include <string>
+#include <system_error>
 #include <tuple>
 
 #include "BPlusTreeInternalNode.h"
+#include "SequentialFile.h"
 
 namespace noid::storage {
 
+/**
+ * Identifies a snapshot file. It is stored at the very end of the file, so a truncated snapshot is detected as well.
+ */
+static const byte SNAPSHOT_MAGIC[8] = {'n', 'o', 'i', 'd', 's', 'n', 'a', 'p'};
+
+static const uint32_t SNAPSHOT_VERSION = 1;
+
+/**
+ * The snapshot footer consists of the record count, the size of the record data, the format version and the magic.
+ */
+static const uint64_t SNAPSHOT_FOOTER_SIZE = sizeof(uint64_t) + sizeof(uint64_t) + sizeof(uint32_t)
+    + sizeof(SNAPSHOT_MAGIC);
+
 static inline bool IsInternalNode(const std::shared_ptr<BPlusTreeNode>& node) {
   if (std::dynamic_pointer_cast<BPlusTreeInternalNode>(node)) {
     return true;
@@ -17,6 +37,14 @@ static inline bool IsInternalNode(const std::shared_ptr<BPlusTreeNode>& node) {
   return false;
 }
 
+/**
+ * @return Whether @p key is in the range from @p lower (inclusive) up to @p upper (exclusive), where an empty
+ * optional is unbounded.
+ */
+static inline bool InRange(const K& key, const std::optional<K>& lower, const std::optional<K>& upper) {
+  return (!lower.has_value() || !(key < lower.value())) && (!upper.has_value() || key < upper.value());
+}
+
 static inline uint8_t EnsureMinOrder(uint8_t value) {
   if (value >= BTREE_MIN_ORDER) {
     return value;
@@ -27,7 +55,12 @@ static inline uint8_t EnsureMinOrder(uint8_t value) {
   throw std::invalid_argument(buf.str());
 }
 
-BPlusTree::BPlusTree(uint8_t order) : order(EnsureMinOrder(order)), root(nullptr) {}
+BPlusTree::BPlusTree(uint8_t order)
+  : order(EnsureMinOrder(order)), root(nullptr), sequence(0), removals_horizon(0) {}
+
+BPlusTree::~BPlusTree() {
+  Release(this->root);
+}
 
 std::shared_ptr<BPlusTreeLeafNode> BPlusTree::FindLeafRangeMatch(const std::shared_ptr<BPlusTreeNode>& node, const K &key) {
   if (IsInternalNode(node)) {
@@ -58,19 +91,175 @@ std::pair<std::shared_ptr<BPlusTreeInternalNode>, std::shared_ptr<BPlusTreeLeafN
   return {nullptr, std::reinterpret_pointer_cast<BPlusTreeLeafNode>(node) };
 }
 
+std::shared_ptr<BPlusTreeLeafNode> BPlusTree::LeftmostLeaf() {
+  auto node = this->root;
+  while (IsInternalNode(node)) {
+    node = std::reinterpret_pointer_cast<BPlusTreeInternalNode>(node)->Smallest()->left_child;
+  }
+
+  return std::reinterpret_pointer_cast<BPlusTreeLeafNode>(node);
+}
+
+std::vector<std::pair<K, std::shared_ptr<BPlusTreeNode>>> BPlusTree::BuildLeaves(uint64_t record_count,
+    const std::function<std::unique_ptr<BPlusTreeRecord>()>& next_record) {
+  const uint64_t max_records = this->order * 2;
+  auto leaf_count = (record_count + max_records - 1) / max_records;
+
+  std::vector<std::pair<K, std::shared_ptr<BPlusTreeNode>>> leaves;
+  leaves.reserve(leaf_count);
+
+  std::shared_ptr<BPlusTreeLeafNode> previous;
+  for (uint64_t i = 0; i < leaf_count; i++) {
+    auto size = record_count / leaf_count + (i < record_count % leaf_count ? 1 : 0);
+
+    std::vector<std::unique_ptr<BPlusTreeRecord>> records;
+    records.reserve(size);
+    for (uint64_t j = 0; j < size; j++) {
+      records.push_back(next_record());
+    }
+
+    previous = BPlusTreeLeafNode::Create(this->order, std::move(records), previous);
+    leaves.emplace_back(previous->SmallestKey(), previous);
+  }
+
+  return leaves;
+}
+
+std::shared_ptr<BPlusTreeNode> BPlusTree::BuildLevels(std::vector<std::pair<K, std::shared_ptr<BPlusTreeNode>>> level) {
+  const size_t max_children = this->order * 2 + 1;
+
+  while (level.size() > 1) {
+    auto node_count = (level.size() + max_children - 1) / max_children;
+    std::vector<std::pair<K, std::shared_ptr<BPlusTreeNode>>> parents;
+    parents.reserve(node_count);
+
+    size_t begin = 0;
+    for (size_t i = 0; i < node_count; i++) {
+      auto child_count = level.size() / node_count + (i < level.size() % node_count ? 1 : 0);
+
+      // Every key separates two adjacent children, and equals the smallest key in the subtree of its right child.
+      std::vector<std::unique_ptr<BPlusTreeKey>> keys;
+      keys.reserve(child_count - 1);
+      for (auto j = begin + 1; j < begin + child_count; j++) {
+        auto key = std::make_unique<BPlusTreeKey>(level[j].first);
+        key->left_child = level[j - 1].second;
+        key->right_child = level[j].second;
+
+        keys.push_back(std::move(key));
+      }
+
+      parents.emplace_back(level[begin].first, BPlusTreeInternalNode::Create(nullptr, this->order, std::move(keys)));
+      begin += child_count;
+    }
+
+    level = std::move(parents);
+  }
+
+  return level.empty() ? nullptr : level[0].second;
+}
+
+void BPlusTree::Replace(std::shared_ptr<BPlusTreeNode> replacement, uint64_t replacement_sequence) {
+  // Replacing a tree that was never modified does not remove any key.
+  if (this->sequence > 0) {
+    this->removals.clear();
+    this->removals_horizon = replacement_sequence;
+  }
+
+  Release(this->root);
+  this->root = std::move(replacement);
+  this->sequence = replacement_sequence;
+}
+
+void BPlusTree::Release(const std::shared_ptr<BPlusTreeNode>& node) {
+  std::vector<std::shared_ptr<BPlusTreeNode>> pending;
+  if (node) {
+    pending.push_back(node);
+  }
+
+  // The links to the children are kept, so the subtree is freed top-down afterwards. Adjacent keys share a child,
+  // which is unlinked twice.
+  while (!pending.empty()) {
+    auto next = std::move(pending.back());
+    pending.pop_back();
+    if (next == nullptr) {
+      continue;
+    }
+
+    if (IsInternalNode(next)) {
+      for (auto& key : std::reinterpret_pointer_cast<BPlusTreeInternalNode>(next)->Keys()) {
+        if (key) {
+          pending.push_back(key->left_child);
+          pending.push_back(key->right_child);
+        }
+      }
+    }
+
+    next->Unlink();
+  }
+}
+
+bool BPlusTree::ExportNode(const std::shared_ptr<BPlusTreeNode>& node, uint64_t since,
+                           std::map<K, uint64_t>::const_iterator& removal,
+                           const std::function<bool(const K&, const V*)>& consumer) {
+  if (node == nullptr || node->MaxSequence() <= since) {
+    return true;
+  }
+
+  if (IsInternalNode(node)) {
+    auto& keys = std::reinterpret_pointer_cast<BPlusTreeInternalNode>(node)->Keys();
+    if (keys.empty()) {
+      return true;
+    }
+
+    if (!this->ExportNode(keys[0]->left_child, since, removal, consumer)) {
+      return false;
+    }
+    for (auto& key : keys) {
+      if (!this->ExportNode(key->right_child, since, removal, consumer)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  for (auto& record : std::reinterpret_pointer_cast<BPlusTreeLeafNode>(node)->Records()) {
+    if (record->Sequence() <= since) {
+      continue;
+    }
+
+    // A removed key is not in the tree, so the removals preceding this record are exported first.
+    for (; removal != this->removals.end() && removal->first < record->Key(); removal++) {
+      if (removal->second > since && !consumer(removal->first, nullptr)) {
+        return false;
+      }
+    }
+
+    if (!consumer(record->Key(), &record->Value())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 BPlusTreeNode *BPlusTree::Root() {
   return this->root.get();
 }
 
 InsertType BPlusTree::Insert(const K &key, V &value) {
   auto type = InsertType::Insert;
+  auto insert_sequence = ++this->sequence;
+  this->removals.erase(key);
+
   if (this->root == nullptr) {
-    this->root = BPlusTreeLeafNode::Create(nullptr, order, std::make_unique<BPlusTreeRecord>(key, value));
+    this->root = BPlusTreeLeafNode::Create(
+        nullptr, order, std::make_unique<BPlusTreeRecord>(key, value, insert_sequence));
     return type;
   }
 
   auto leaf = this->FindLeafRangeMatch(this->root, key);
-  type = leaf->Insert(key, value) ? InsertType::Insert : InsertType::Upsert;
+  type = leaf->Insert(key, value, insert_sequence) ? InsertType::Insert : InsertType::Upsert;
 
   BPlusTreeNode* node = leaf.get();
   while (node && node->IsFull()) {
@@ -84,6 +273,12 @@ InsertType BPlusTree::Insert(const K &key, V &value) {
     node = parent.get();
   }
 
+  // Nodes created by splits derive their bound from their contents, but the ancestors of the leaf do not.
+  for (auto parent = leaf->Parent(); parent; parent = parent->Parent()) {
+    parent->RaiseMaxSequence(insert_sequence);
+    parent->InvalidateHash();
+  }
+
   return type;
 }
 
@@ -92,10 +287,14 @@ std::optional<V> BPlusTree::Remove(const K &key) {
 
   if (leaf->Contains(key)) {
     auto removed = leaf->Remove(key);
+    this->removals[key] = ++this->sequence;
 
     BPlusTreeNode* node = leaf.get();
     while (node) {
 
+      // The children of this node were rearranged in the previous iteration, which invalidated their hashes.
+      node->InvalidateHash();
+
       // Replace the root node if it is empty after rearrangement of entries.
       if (node->IsPoor()) {
         auto rearrangement = node->Rearrange();
@@ -139,6 +338,295 @@ std::optional<V> BPlusTree::Remove(const K &key) {
   return std::nullopt;
 }
 
+std::optional<V> BPlusTree::Find(const K &key) {
+  if (this->root == nullptr) {
+    return std::nullopt;
+  }
+
+  auto& records = this->FindLeafRangeMatch(this->root, key)->Records();
+  auto record = std::lower_bound(records.begin(), records.end(), key, [](const auto& r, const K& k) {
+    return r->Key() < k;
+  });
+
+  if (record != records.end() && (*record)->Key() == key) {
+    return (*record)->Value();
+  }
+
+  return std::nullopt;
+}
+
+void BPlusTree::Scan(const std::function<bool(const K &, const V &)> &consumer) {
+  if (this->root == nullptr) {
+    return;
+  }
+
+  for (auto leaf = this->LeftmostLeaf(); leaf; leaf = leaf->Next()) {
+    for (auto& record : leaf->Records()) {
+      if (!consumer(record->Key(), record->Value())) {
+        return;
+      }
+    }
+  }
+}
+
+void BPlusTree::SaveSnapshot(const std::filesystem::path &path) {
+  auto temporary_path = path;
+  temporary_path += ".tmp";
+
+  try {
+    auto writer = SequentialWriter::Create(temporary_path);
+    uint64_t record_count = 0;
+
+    for (auto leaf = this->LeftmostLeaf(); leaf; leaf = leaf->Next()) {
+      for (auto& record : leaf->Records()) {
+        auto& value = record->Value();
+        if (value.size() > std::numeric_limits<uint32_t>::max()) {
+          throw std::invalid_argument("Cannot write a value exceeding 4 GiB to a snapshot.");
+        }
+
+        writer->Append(record->Key().data(), BTREE_KEY_SIZE);
+        writer->AppendValue(static_cast<uint32_t>(value.size()));
+        writer->Append(value.data(), value.size());
+
+        record_count++;
+      }
+    }
+
+    auto data_size = writer->Offset();
+    writer->AppendValue(record_count);
+    writer->AppendValue(data_size);
+    writer->AppendValue(SNAPSHOT_VERSION);
+    writer->Append(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    writer->Close();
+  } catch (...) {
+    std::error_code error;
+    std::filesystem::remove(temporary_path, error);
+    throw;
+  }
+
+  std::filesystem::rename(temporary_path, path);
+  SyncDirectory(path.parent_path());
+}
+
+void BPlusTree::LoadSnapshot(const std::filesystem::path &path) {
+  auto reader = SequentialReader::Open(path);
+  if (reader->Size() < SNAPSHOT_FOOTER_SIZE) {
+    throw std::runtime_error("Snapshot " + path.string() + " is too small to contain a footer.");
+  }
+
+  uint64_t record_count;
+  uint64_t data_size;
+  uint32_t version;
+  byte magic[sizeof(SNAPSHOT_MAGIC)];
+
+  reader->Seek(reader->Size() - SNAPSHOT_FOOTER_SIZE);
+  reader->ReadValue(record_count);
+  reader->ReadValue(data_size);
+  reader->ReadValue(version);
+  reader->Read(magic, sizeof(magic));
+
+  if (std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+    throw std::runtime_error("File " + path.string() + " is not a snapshot.");
+  } else if (version != SNAPSHOT_VERSION) {
+    throw std::runtime_error("Snapshot " + path.string() + " has unsupported version " + std::to_string(version) + ".");
+  } else if (data_size != reader->Size() - SNAPSHOT_FOOTER_SIZE
+      || record_count > data_size / (BTREE_KEY_SIZE + sizeof(uint32_t))) {
+    throw std::runtime_error("Snapshot " + path.string() + " is corrupt.");
+  }
+
+  std::optional<K> previous_key;
+  auto load_sequence = this->sequence + 1;
+  reader->Seek(0);
+
+  auto leaves = this->BuildLeaves(record_count, [&]() {
+    K key;
+    uint32_t value_size;
+    if (!reader->Read(key.data(), BTREE_KEY_SIZE) || !reader->ReadValue(value_size)
+        || reader->Offset() + value_size > data_size) {
+      throw std::runtime_error("Snapshot " + path.string() + " is corrupt.");
+    }
+
+    if (previous_key.has_value() && !(previous_key.value() < key)) {
+      throw std::runtime_error("Snapshot " + path.string() + " contains unsorted keys.");
+    }
+    previous_key = key;
+
+    V value(value_size);
+    reader->Read(value.data(), value_size);
+    return std::make_unique<BPlusTreeRecord>(key, std::move(value), load_sequence);
+  });
+
+  if (reader->Offset() != data_size) {
+    throw std::runtime_error("Snapshot " + path.string() + " is corrupt.");
+  }
+
+  this->Replace(this->BuildLevels(std::move(leaves)), load_sequence);
+}
+
+void BPlusTree::Load(std::vector<std::pair<K, V>> records) {
+  for (size_t i = 1; i < records.size(); i++) {
+    if (!(records[i - 1].first < records[i].first)) {
+      throw std::invalid_argument("Cannot load records into a tree: their keys are not strictly increasing.");
+    }
+  }
+
+  auto load_sequence = this->sequence + 1;
+  auto record = records.begin();
+  auto leaves = this->BuildLeaves(records.size(), [&]() {
+    auto leaf_record = std::make_unique<BPlusTreeRecord>(record->first, std::move(record->second), load_sequence);
+    record++;
+    return leaf_record;
+  });
+
+  this->Replace(this->BuildLevels(std::move(leaves)), load_sequence);
+}
+
+uint64_t BPlusTree::RangeHash(const std::shared_ptr<BPlusTreeNode>& node, const std::optional<K>& node_lower,
+                              const std::optional<K>& node_upper, const std::optional<K>& lower,
+                              const std::optional<K>& upper) {
+  if (node == nullptr
+      || (upper.has_value() && node_lower.has_value() && !(node_lower.value() < upper.value()))
+      || (lower.has_value() && node_upper.has_value() && !(lower.value() < node_upper.value()))) {
+    return 0;
+  }
+
+  if ((!lower.has_value() || (node_lower.has_value() && !(node_lower.value() < lower.value())))
+      && (!upper.has_value() || (node_upper.has_value() && !(upper.value() < node_upper.value())))) {
+    return node->Hash();
+  }
+
+  uint64_t sum = 0;
+  if (IsInternalNode(node)) {
+    auto& keys = std::reinterpret_pointer_cast<BPlusTreeInternalNode>(node)->Keys();
+    for (size_t i = 0; i <= keys.size() && !keys.empty(); i++) {
+      sum += this->RangeHash(i == 0 ? keys[0]->left_child : keys[i - 1]->right_child,
+                             i == 0 ? node_lower : keys[i - 1]->Key(),
+                             i == keys.size() ? node_upper : keys[i]->Key(), lower, upper);
+    }
+
+    return sum;
+  }
+
+  for (auto& record : std::reinterpret_pointer_cast<BPlusTreeLeafNode>(node)->Records()) {
+    if (InRange(record->Key(), lower, upper)) {
+      sum += record->Hash();
+    }
+  }
+
+  return sum;
+}
+
+bool BPlusTree::DiffNode(const std::shared_ptr<BPlusTreeNode>& node, const std::optional<K>& node_lower,
+                         const std::optional<K>& node_upper, BPlusTree& other,
+                         const std::function<bool(const K&, const V*, const V*)>& consumer) {
+  if (node->Hash() == other.RangeHash(other.root, std::nullopt, std::nullopt, node_lower, node_upper)) {
+    return true;
+  }
+
+  if (IsInternalNode(node)) {
+    auto& keys = std::reinterpret_pointer_cast<BPlusTreeInternalNode>(node)->Keys();
+    for (size_t i = 0; i <= keys.size() && !keys.empty(); i++) {
+      if (!this->DiffNode(i == 0 ? keys[0]->left_child : keys[i - 1]->right_child,
+                          i == 0 ? node_lower : keys[i - 1]->Key(),
+                          i == keys.size() ? node_upper : keys[i]->Key(), other, consumer)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  return this->DiffRecords(std::reinterpret_pointer_cast<BPlusTreeLeafNode>(node)->Records(), node_lower,
+                           node_upper, other, consumer);
+}
+
+bool BPlusTree::DiffRecords(const std::vector<std::unique_ptr<BPlusTreeRecord>>& records,
+                            const std::optional<K>& lower, const std::optional<K>& upper, BPlusTree& other,
+                            const std::function<bool(const K&, const V*, const V*)>& consumer) {
+  std::vector<const BPlusTreeRecord*> others;
+  if (other.root != nullptr) {
+    auto leaf = lower.has_value() ? other.FindLeafRangeMatch(other.root, lower.value()) : other.LeftmostLeaf();
+    for (; leaf; leaf = leaf->Next()) {
+      auto& leaf_records = leaf->Records();
+      if (!leaf_records.empty() && upper.has_value() && !(leaf_records[0]->Key() < upper.value())) {
+        break;
+      }
+
+      for (auto& record : leaf_records) {
+        if (InRange(record->Key(), lower, upper)) {
+          others.push_back(record.get());
+        }
+      }
+    }
+  }
+
+  // Both sequences are ordered by key, so they are merged like sorted runs.
+  auto record = records.begin();
+  auto other_record = others.begin();
+  while (record != records.end() || other_record != others.end()) {
+    if (other_record == others.end() || (record != records.end() && (*record)->Key() < (*other_record)->Key())) {
+      if (!consumer((*record)->Key(), &(*record)->Value(), nullptr)) {
+        return false;
+      }
+      record++;
+    } else if (record == records.end() || (*other_record)->Key() < (*record)->Key()) {
+      if (!consumer((*other_record)->Key(), nullptr, &(*other_record)->Value())) {
+        return false;
+      }
+      other_record++;
+    } else {
+      if ((*record)->Value() != (*other_record)->Value()
+          && !consumer((*record)->Key(), &(*record)->Value(), &(*other_record)->Value())) {
+        return false;
+      }
+      record++;
+      other_record++;
+    }
+  }
+
+  return true;
+}
+
+uint64_t BPlusTree::Sequence() const {
+  return this->sequence;
+}
+
+void BPlusTree::ExportSince(uint64_t since, const std::function<bool(const K &, const V *)> &consumer) {
+  if (since < this->removals_horizon) {
+    throw std::invalid_argument("Cannot export the changes since sequence number " + std::to_string(since)
+                                    + ": the removals up to " + std::to_string(this->removals_horizon)
+                                    + " are no longer known.");
+  }
+
+  std::map<K, uint64_t>::const_iterator removal = this->removals.begin();
+  if (!this->ExportNode(this->root, since, removal, consumer)) {
+    return;
+  }
+
+  for (; removal != this->removals.end(); removal++) {
+    if (removal->second > since && !consumer(removal->first, nullptr)) {
+      return;
+    }
+  }
+}
+
+void BPlusTree::ForgetRemovals(uint64_t until) {
+  for (auto removal = this->removals.begin(); removal != this->removals.end();) {
+    removal = removal->second <= until ? this->removals.erase(removal) : std::next(removal);
+  }
+
+  this->removals_horizon = std::max(this->removals_horizon, std::min(until, this->sequence));
+}
+
+void BPlusTree::Diff(BPlusTree& other, const std::function<bool(const K&, const V*, const V*)>& consumer) {
+  if (this->root == nullptr) {
+    this->DiffRecords({}, std::nullopt, std::nullopt, other, consumer);
+    return;
+  }
+
+  this->DiffNode(this->root, std::nullopt, std::nullopt, other, consumer);
+}
+
 void BPlusTree::Write(std::stringstream &out) {
   if (this->root) {
     auto node = this->root;
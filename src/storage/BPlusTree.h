@@ -2,9 +2,13 @@
 #define NOID_SRC_STORAGE_BPLUSTREE_H_
 
 #include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
 #include <memory>
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "Shared.h"
 #include "BPlusTreeNode.h"
@@ -34,6 +38,22 @@ class BPlusTree {
      */
     std::shared_ptr<BPlusTreeNode> root;
 
+    /**
+     * The sequence number of the latest modification. Every insert and removal is stamped with the next one.
+     */
+    uint64_t sequence;
+
+    /**
+     * The sequence numbers of the removals of keys that were not inserted again since, by key.
+     */
+    std::map<K, uint64_t> removals;
+
+    /**
+     * The sequence number up to which removals are no longer known, because they were forgotten or the tree was
+     * replaced. Changes since an older sequence number cannot be exported.
+     */
+    uint64_t removals_horizon;
+
     /**
      * @brief Recursively finds the leaf having a key range containing the given @p key, starting with @p node.
      * @details The returned leaf is the only leaf that can contain the given @p key if it exists in this tree. However,
@@ -59,6 +79,101 @@ class BPlusTree {
      */
     std::pair<std::shared_ptr<BPlusTreeInternalNode>, std::shared_ptr<BPlusTreeLeafNode>> FindNodes(const std::shared_ptr<BPlusTreeNode>& node, const K& key);
 
+    /**
+     * @return The leaf containing the smallest keys, or @c nullptr if this tree is empty.
+     */
+    std::shared_ptr<BPlusTreeLeafNode> LeftmostLeaf();
+
+    /**
+     * @brief Builds the leaf level of a tree from @p record_count records in ascending key order.
+     * @details Since the record count is known up front, the records are spread evenly over as few leaves as
+     * possible. This guarantees that every leaf contains at least @c order records.
+     *
+     * @param record_count The number of records.
+     * @param next_record Produces the next record, and is called exactly @p record_count times.
+     * @return The leaves, ordered by key and paired with their smallest key.
+     */
+    std::vector<std::pair<K, std::shared_ptr<BPlusTreeNode>>> BuildLeaves(uint64_t record_count,
+        const std::function<std::unique_ptr<BPlusTreeRecord>()>& next_record);
+
+    /**
+     * @brief Builds the internal levels of a tree on top of the given nodes, which form a complete level.
+     * @details Each level is divided into as few nodes as possible, while spreading the children evenly over them.
+     * This guarantees that every node contains at least @c order keys.
+     *
+     * @param level The nodes of the lowest level, ordered by key and paired with the smallest key in their subtree.
+     * @return The root node.
+     */
+    std::shared_ptr<BPlusTreeNode> BuildLevels(std::vector<std::pair<K, std::shared_ptr<BPlusTreeNode>>> level);
+
+    /**
+     * @brief Replaces the contents of this tree by the given @p replacement, whose records were all stamped with
+     * the given @p replacement_sequence.
+     * @details Since the keys that are not in @p replacement are not known, changes can only be exported since
+     * the replacement.
+     *
+     * @param replacement The new root node, or @c nullptr.
+     * @param replacement_sequence The sequence number of the replacement.
+     */
+    void Replace(std::shared_ptr<BPlusTreeNode> replacement, uint64_t replacement_sequence);
+
+    /**
+     * @brief Unlinks the nodes in the subtree of @p node, so they are freed once the last reference to @p node is
+     * dropped.
+     *
+     * @param node The root of the discarded subtree, which may be @c nullptr.
+     */
+    static void Release(const std::shared_ptr<BPlusTreeNode>& node);
+
+    /**
+     * @brief Recursively invokes @p consumer for the records in the subtree of @p node that changed after
+     * @p since, preceded by the removals in @p removal that are less than them.
+     * @details Subtrees that were not modified after @p since are skipped.
+     *
+     * @return Whether @p consumer requested to continue.
+     */
+    bool ExportNode(const std::shared_ptr<BPlusTreeNode>& node, uint64_t since,
+                    std::map<K, uint64_t>::const_iterator& removal,
+                    const std::function<bool(const K&, const V*)>& consumer);
+
+    /**
+     * @brief Recursively sums the hashes of the records in the subtree of @p node whose keys are in the range
+     * from @p lower (inclusive) up to @p upper (exclusive).
+     * @details Only the nodes whose key range partially overlaps the requested range are descended into, so this
+     * visits at most two nodes per level.
+     *
+     * @param node The subtree.
+     * @param node_lower The smallest key the subtree can contain, or an empty optional if it is unbounded.
+     * @param node_upper The key that the subtree contains only lesser keys than, or an empty optional if it is
+     * unbounded.
+     * @param lower The smallest key of the range, or an empty optional if it is unbounded.
+     * @param upper The key that the range contains only lesser keys than, or an empty optional if it is unbounded.
+     * @return The sum of the record hashes.
+     */
+    uint64_t RangeHash(const std::shared_ptr<BPlusTreeNode>& node, const std::optional<K>& node_lower,
+                       const std::optional<K>& node_upper, const std::optional<K>& lower,
+                       const std::optional<K>& upper);
+
+    /**
+     * @brief Recursively compares the subtree of @p node with the same key range of @p other, descending only into
+     * the children whose hashes differ from that of their range in @p other.
+     *
+     * @return Whether @p consumer requested to continue.
+     */
+    bool DiffNode(const std::shared_ptr<BPlusTreeNode>& node, const std::optional<K>& node_lower,
+                  const std::optional<K>& node_upper, BPlusTree& other,
+                  const std::function<bool(const K&, const V*, const V*)>& consumer);
+
+    /**
+     * @brief Compares the given @p records with the records of @p other in the given key range, and invokes
+     * @p consumer for every key whose value differs.
+     *
+     * @return Whether @p consumer requested to continue.
+     */
+    bool DiffRecords(const std::vector<std::unique_ptr<BPlusTreeRecord>>& records, const std::optional<K>& lower,
+                     const std::optional<K>& upper, BPlusTree& other,
+                     const std::function<bool(const K&, const V*, const V*)>& consumer);
+
  public:
 
     /**
@@ -68,7 +183,7 @@ class BPlusTree {
      * @throws std::invalid_argument If order is less than @c BTREE_MIN_ORDER.
      */
     explicit BPlusTree(uint8_t order);
-    ~BPlusTree()= default;
+    ~BPlusTree();
 
     /**
      * @return An unmanaged pointer to the root node.
@@ -93,6 +208,98 @@ class BPlusTree {
      */
     std::optional<V> Remove(const K& key);
 
+    /**
+     * @brief Looks up the value associated with the given @p key.
+     *
+     * @param key The search key.
+     * @return The value, or an empty optional if no such record exists.
+     */
+    std::optional<V> Find(const K& key);
+
+    /**
+     * @brief Invokes @p consumer for every record in key order, until it returns @c false.
+     *
+     * @param consumer The function to invoke with every key and value.
+     */
+    void Scan(const std::function<bool(const K&, const V&)>& consumer);
+
+    /**
+     * @brief Writes all records in this tree to a snapshot file at the given @p path.
+     * @details The snapshot consists of the records in key order, each stored as its key, the length of its value
+     * and the value itself, followed by a footer. The file is written to a temporary location first, and then
+     * renamed to @p path, so a pre-existing snapshot is only replaced by a complete one. The temporary file is
+     * removed if the snapshot cannot be written.
+     *
+     * @param path The location of the snapshot file.
+     * @throws std::invalid_argument If a value exceeds 4 GiB.
+     * @throws std::system_error If the snapshot cannot be written.
+     */
+    void SaveSnapshot(const std::filesystem::path& path);
+
+    /**
+     * @brief Replaces the contents of this tree with the records in the snapshot file at the given @p path.
+     * @details Instead of inserting the records one by one, the tree is built bottom-up in a single pass
+     * over the sorted records. The snapshot does not need to have been written by a tree with the same order.
+     * If the snapshot cannot be loaded, this tree is left unchanged.
+     *
+     * @param path The location of the snapshot file.
+     * @throws std::system_error If the snapshot cannot be read.
+     * @throws std::runtime_error If the snapshot is corrupt.
+     */
+    void LoadSnapshot(const std::filesystem::path& path);
+
+    /**
+     * @brief Replaces the contents of this tree with the given @p records, building it bottom-up like
+     * @c LoadSnapshot.
+     *
+     * @param records The records, ordered by strictly increasing key.
+     * @throws std::invalid_argument If the keys are not strictly increasing. This tree is left unchanged then.
+     */
+    void Load(std::vector<std::pair<K, V>> records);
+
+    /**
+     * @return The sequence number of the latest insert or removal, or zero if this tree was never modified.
+     */
+    [[nodiscard]] uint64_t Sequence() const;
+
+    /**
+     * @brief Invokes @p consumer for every key that was inserted, replaced or removed after the given sequence
+     * number in key order, until it returns @c false.
+     * @details Only the latest change of each key is exported. The consumer receives the current value of a key, or
+     * @c nullptr if it was removed. Every node tracks the highest sequence number in its subtree, so subtrees that
+     * were not modified are skipped entirely. Removed keys are tracked separately until they are forgotten using
+     * @c ForgetRemovals.
+     *
+     * Passing the @c Sequence of a previous export results in the changes made since that export.
+     *
+     * @param since The sequence number after which the changes are exported.
+     * @param consumer The function to invoke with every changed key and its value.
+     * @throws std::invalid_argument If the removals since @p since were forgotten, or this tree was loaded since.
+     */
+    void ExportSince(uint64_t since, const std::function<bool(const K&, const V*)>& consumer);
+
+    /**
+     * @brief Forgets the removals up to and including the given sequence number, so they no longer take up memory.
+     * @details Changes can only be exported since @p until or later afterwards.
+     *
+     * @param until The sequence number of the latest removal to forget.
+     */
+    void ForgetRemovals(uint64_t until);
+
+    /**
+     * @brief Invokes @p consumer for every key whose value in this tree differs from its value in @p other in key
+     * order, until it returns @c false.
+     * @details The consumer receives the value in this tree and the value in @p other, either of which is
+     * @c nullptr if the key does not exist in that tree. Subtrees of this tree whose hash equals the hash of the
+     * same key range in @p other are skipped, so the cost is proportional to the amount of differences rather than
+     * the size of the trees. The trees do not need to have the same order or shape. The hashes are computed by the
+     * first comparison, and only those of modified subtrees are recomputed by later ones.
+     *
+     * @param other The tree to compare with.
+     * @param consumer The function to invoke with every differing key and both of its values.
+     */
+    void Diff(BPlusTree& other, const std::function<bool(const K&, const V*, const V*)>& consumer);
+
     /**
      * @brief Writes a textual representation of this tree to the given stream.
      *
@@ -68,9 +68,12 @@ bool BPlusTreeInternalNode::Redistribute() {
 
     // Take the largest from the left sibling
     auto largest = sibling->TakeLargest();
+    this->RaiseMaxSequence(sibling->MaxSequence());
 
     // Replace the parent key with the largest key we took from our sibling.
     parent_key->Replace(largest->Key());
+    this->InvalidateHash();
+    sibling->InvalidateHash();
 
     return true;
   }
@@ -79,6 +82,7 @@ bool BPlusTreeInternalNode::Redistribute() {
   if (sibling && sibling->IsRich()) {
     // Take the smallest from the right sibling.
     auto smallest = sibling->TakeSmallest();
+    this->RaiseMaxSequence(sibling->MaxSequence());
 
     // Retrieve GreatestNotExceeding(siblings smallest) from parent
     auto parent_key = this->parent->GreatestNotExceeding(smallest->Key());
@@ -88,6 +92,8 @@ bool BPlusTreeInternalNode::Redistribute() {
 
     // Replace the parent key value with the smallest key we took from our sibling.
     parent_key->Replace(smallest->Key());
+    this->InvalidateHash();
+    sibling->InvalidateHash();
 
     return true;
   }
@@ -141,6 +147,8 @@ Rearrangement BPlusTreeInternalNode::Merge() {
   for (auto& key : largest->keys) {
     smallest->keys.push_back(std::move(key));
   }
+  smallest->RaiseMaxSequence(largest->MaxSequence());
+  smallest->InvalidateHash();
 
   return {RearrangementType::Merge, smallest};
 }
@@ -154,9 +162,11 @@ void BPlusTreeInternalNode::InsertInternal(std::unique_ptr<BPlusTreeKey> contain
   // Update the parent of the children
   if (ptr->left_child) {
     ptr->left_child->SetParent(shared_from_this());
+    this->RaiseMaxSequence(ptr->left_child->MaxSequence());
   }
   if (ptr->right_child) {
     ptr->right_child->SetParent(shared_from_this());
+    this->RaiseMaxSequence(ptr->right_child->MaxSequence());
   }
 
   // Adjacent keys inherit children from the inserted one
@@ -220,7 +230,7 @@ std::unique_ptr<BPlusTreeKey> BPlusTreeInternalNode::TakeMiddle(BPlusTreeInterna
 BPlusTreeInternalNode::BPlusTreeInternalNode(std::shared_ptr<BPlusTreeInternalNode> parent, uint8_t order)
     : parent(std::move(parent)), order(order) {}
 
-// private
+// public
 std::shared_ptr<BPlusTreeInternalNode> BPlusTreeInternalNode::Create(
     std::shared_ptr<BPlusTreeInternalNode> parent,
     uint8_t order,
@@ -232,9 +242,11 @@ std::shared_ptr<BPlusTreeInternalNode> BPlusTreeInternalNode::Create(
   for (auto &key : keys) {
     if (key->left_child) {
       key->left_child->SetParent(instance);
+      instance->RaiseMaxSequence(key->left_child->MaxSequence());
     }
     if (key->right_child) {
       key->right_child->SetParent(instance);
+      instance->RaiseMaxSequence(key->right_child->MaxSequence());
     }
   }
 
@@ -258,8 +270,14 @@ std::shared_ptr<BPlusTreeInternalNode> BPlusTreeInternalNode::Create(
     container->left_child = std::move(left_child);
     container->right_child = std::move(right_child);
 
-    if (container->left_child) { container->left_child->SetParent(instance); }
-    if (container->right_child) { container->right_child->SetParent(instance); }
+    if (container->left_child) {
+      container->left_child->SetParent(instance);
+      instance->RaiseMaxSequence(container->left_child->MaxSequence());
+    }
+    if (container->right_child) {
+      container->right_child->SetParent(instance);
+      instance->RaiseMaxSequence(container->right_child->MaxSequence());
+    }
   }
 
   instance->keys.push_back(std::move(container));
@@ -301,6 +319,10 @@ BPlusTreeKey* BPlusTreeInternalNode::Smallest() {
   return this->keys[0].get();
 }
 
+const std::vector<std::unique_ptr<BPlusTreeKey>>& BPlusTreeInternalNode::Keys() {
+  return this->keys;
+}
+
 BPlusTreeKey* BPlusTreeInternalNode::GreatestNotExceeding(const K &key) {
   auto index = noid::storage::GreatestNotExceeding(
       this->keys, 0, static_cast<int64_t>(this->keys.size() - 1), key, GetKeyReference);
@@ -328,6 +350,10 @@ void BPlusTreeInternalNode::SetParent(std::shared_ptr<BPlusTreeInternalNode> p)
   }
 }
 
+void BPlusTreeInternalNode::Unlink() {
+  this->parent.reset();
+}
+
 bool BPlusTreeInternalNode::Insert(const K& key, std::shared_ptr<BPlusTreeNode> left_child, std::shared_ptr<BPlusTreeNode> right_child) {
   auto index = BinarySearch(
       this->keys, 0, static_cast<int64_t>(this->keys.size() - 1), key, GetKeyReference);
@@ -364,6 +390,7 @@ TreeStructureChange BPlusTreeInternalNode::Split() {
 
   // Remove the slots of the records that were moved to the new node.
   this->keys.resize(middle_index);
+  this->InvalidateHash();
 
   // Create a new sibling.
   auto split = BPlusTreeInternalNode::Create(this->parent, this->order, std::move(split_keys));
@@ -404,6 +431,22 @@ Rearrangement BPlusTreeInternalNode::Rearrange() {
   return this->Merge();
 }
 
+uint64_t BPlusTreeInternalNode::ComputeHash() {
+  uint64_t sum = 0;
+  if (!this->keys.empty() && this->keys[0]->left_child) {
+    sum += this->keys[0]->left_child->Hash();
+  }
+
+  // Adjacent keys share a child, so only the right child of every key is added.
+  for (auto& key : this->keys) {
+    if (key->right_child) {
+      sum += key->right_child->Hash();
+    }
+  }
+
+  return sum;
+}
+
 void BPlusTreeInternalNode::Write(std::stringstream &out) {
   out << '[';
   for (auto i = 0; i < this->keys.size(); i++) {
@@ -109,6 +109,11 @@ namespace noid::storage {
      */
     std::unique_ptr<BPlusTreeKey> TakeMiddle(BPlusTreeInternalNode& left, BPlusTreeInternalNode& right);
 
+    /**
+     * @return The sum of the hashes of the children of this node.
+     */
+    uint64_t ComputeHash() override;
+
     /**
      * Internal constructor to support the Create factory methods.
      *
@@ -117,10 +122,13 @@ namespace noid::storage {
      */
     BPlusTreeInternalNode(std::shared_ptr<BPlusTreeInternalNode> parent, uint8_t order);
 
+ public:
+
     /**
      * @brief Creates a new @c BPlusTreeInternalNode whose pointer is managed by the wrapping @c std::shared_ptr.
      * @details Additionally adopts the given @p keys by iterating over them and setting the parent of its children
-     * to the new @c BPlusTreeInternalNode.
+     * to the new @c BPlusTreeInternalNode. The keys must be sorted, and adjacent keys must share their
+     * right- and left child respectively.
      *
      * @param parent The parent of this node, or @c nullptr if this is the root node.
      * @param order The tree order.
@@ -129,8 +137,6 @@ namespace noid::storage {
      */
     static std::shared_ptr<BPlusTreeInternalNode> Create(std::shared_ptr<BPlusTreeInternalNode> parent, uint8_t order, std::vector<std::unique_ptr<BPlusTreeKey>> keys);
 
- public:
-
     /**
      * @brief Creates a new @c BPlusTreeInternalNode whose pointer is managed by the wrapping @c std::shared_ptr.
      * @details Inserts the given @p key, @p left_child and @p right_child as a new @c BPlusTreeKey. Since a
@@ -190,6 +196,11 @@ namespace noid::storage {
      */
     BPlusTreeKey* Smallest();
 
+    /**
+     * @return The keys in this node, ordered by key.
+     */
+    const std::vector<std::unique_ptr<BPlusTreeKey>>& Keys();
+
     /**
      * @brief Returns the largest @c BPlusTreeKey which is less than or equal to the given @p key.
      *
@@ -214,6 +225,11 @@ namespace noid::storage {
      */
     void SetParent(std::shared_ptr<BPlusTreeInternalNode> parent) override;
 
+    /**
+     * @brief Drops the link of this node to its parent.
+     */
+    void Unlink() override;
+
     /**
      * @brief Creates and inserts a new @c BPlusTreeKey based on the given key and children.
      * @details If a key with the given @p key already exists in this node,
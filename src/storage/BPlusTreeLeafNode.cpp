@@ -35,9 +35,13 @@ bool BPlusTreeLeafNode::CopyUp(const K &key) {
 bool BPlusTreeLeafNode::Redistribute() {
   if (this->next && this->Parent() == this->next->Parent() && this->next->IsRich()) {
     // Take the smallest record from our right sibling and append it to our records.
+    this->RaiseMaxSequence(this->next->MaxSequence());
     auto taken_from_sibling = this->next->TakeSmallest();
     this->records.push_back(std::move(this->next->TakeSmallest()));
 
+    this->InvalidateHash();
+    this->next->InvalidateHash();
+
     // Replace key that points to us and sibling in parent entry.
     auto& next_smallest_from_sibling = this->next->SmallestKey();
     this->Parent()->GreatestNotExceeding(next_smallest_from_sibling)->Replace(next_smallest_from_sibling);
@@ -45,8 +49,11 @@ bool BPlusTreeLeafNode::Redistribute() {
     return true;
   } else if (this->previous && this->Parent() == this->Previous()->Parent() && this->previous->IsRich()) {
     // Take the largest record from our left sibling and prepend it to our records.
+    this->RaiseMaxSequence(this->previous->MaxSequence());
     auto taken_from_sibling = this->Previous()->TakeLargest();
     this->records.insert(this->records.begin(), std::move(taken_from_sibling));
+    this->InvalidateHash();
+    this->previous->InvalidateHash();
 
     // Replace key that points to us and sibling in parent entry.
     auto& smallest_key = this->SmallestKey();
@@ -83,6 +90,8 @@ Rearrangement BPlusTreeLeafNode::Merge() {
   for (auto& record : largest->records) {
     smallest->records.push_back(std::move(record));
   }
+  smallest->RaiseMaxSequence(largest->MaxSequence());
+  smallest->InvalidateHash();
 
   // Remove the greatest parent key which does not exceed the largest from the smallest node. This is the key
   // that points to both the smallest and largest node, whose records were just merged.
@@ -131,6 +140,9 @@ std::unique_ptr<BPlusTreeRecord> BPlusTreeLeafNode::TakeLargest() {
 
 BPlusTreeLeafNode::BPlusTreeLeafNode(std::shared_ptr<BPlusTreeInternalNode> parent, uint8_t order, std::unique_ptr<BPlusTreeRecord> record)
 : order(order), parent(std::move(parent)), previous(nullptr), next(nullptr) {
+  if (record) {
+    this->RaiseMaxSequence(record->Sequence());
+  }
   this->records.push_back(std::move(record));
 }
 
@@ -139,6 +151,28 @@ std::shared_ptr<BPlusTreeLeafNode> BPlusTreeLeafNode::Create(
   return std::shared_ptr<BPlusTreeLeafNode>(new BPlusTreeLeafNode(std::move(parent), order, std::move(record)));
 }
 
+std::shared_ptr<BPlusTreeLeafNode> BPlusTreeLeafNode::Create(
+    uint8_t order, std::vector<std::unique_ptr<BPlusTreeRecord>> records,
+    const std::shared_ptr<BPlusTreeLeafNode>& previous) {
+  auto instance = std::shared_ptr<BPlusTreeLeafNode>(new BPlusTreeLeafNode(nullptr, order, nullptr));
+  for (auto& record : records) {
+    instance->RaiseMaxSequence(record->Sequence());
+  }
+  instance->records = std::move(records);
+
+  if (previous) {
+    instance->next = previous->next;
+    if (instance->next) {
+      instance->next->previous = instance;
+    }
+
+    instance->previous = previous;
+    previous->next = instance;
+  }
+
+  return instance;
+}
+
 bool BPlusTreeLeafNode::IsRoot() {
   return this->parent == nullptr;
 }
@@ -172,6 +206,10 @@ std::shared_ptr<BPlusTreeLeafNode> BPlusTreeLeafNode::Next() {
   return this->next;
 }
 
+const std::vector<std::unique_ptr<BPlusTreeRecord>>& BPlusTreeLeafNode::Records() {
+  return this->records;
+}
+
 const K& BPlusTreeLeafNode::SmallestKey() {
   return this->records[0]->Key();
 }
@@ -186,17 +224,26 @@ void BPlusTreeLeafNode::SetParent(std::shared_ptr<BPlusTreeInternalNode> p) {
   }
 }
 
-bool BPlusTreeLeafNode::Insert(const K &key, V &value) {
+void BPlusTreeLeafNode::Unlink() {
+  this->parent.reset();
+  this->previous.reset();
+  this->next.reset();
+}
+
+bool BPlusTreeLeafNode::Insert(const K &key, V &value, uint64_t sequence) {
   auto index = noid::storage::BinarySearch(
       this->records, 0, static_cast<int64_t>(this->records.size() - 1), key,GetKeyReference);
+  this->RaiseMaxSequence(sequence);
 
   if (index == -1) {
-    this->records.push_back(std::make_unique<BPlusTreeRecord>(key, value));
+    this->records.push_back(std::make_unique<BPlusTreeRecord>(key, value, sequence));
     std::sort(this->records.begin(), this->records.end(), LeftKeyIsLess);
+    this->InvalidateHash();
 
     return true;
   } else {
-    this->records[index]->Replace(value);
+    this->records[index]->Replace(value, sequence);
+    this->InvalidateHash();
     return false;
   }
 }
@@ -213,11 +260,14 @@ TreeStructureChange BPlusTreeLeafNode::Split() {
 
   // Add the largest half of the records to the new node
   for (auto i = middle_index + 1; i < this->records.size(); i++) {
+    split->RaiseMaxSequence(this->records[i]->Sequence());
     split->records.push_back(std::move(this->records[i]));
   }
 
   // Remove the slots of the records that were moved to the new node.
   this->records.resize(middle_index);
+  this->InvalidateHash();
+  split->InvalidateHash();
 
   // Put the leaf in position
   if (this->next) {
@@ -246,6 +296,7 @@ std::optional<V> BPlusTreeLeafNode::Remove(const K &key) {
   if (index >= 0) {
     auto record = std::move(this->records[index]);
     this->records.erase(this->records.begin() + index);
+    this->InvalidateHash();
 
     return std::move(record)->Value();
   }
@@ -261,6 +312,15 @@ Rearrangement BPlusTreeLeafNode::Rearrange() {
   return this->Merge();
 }
 
+uint64_t BPlusTreeLeafNode::ComputeHash() {
+  uint64_t sum = 0;
+  for (auto& record : this->records) {
+    sum += record->Hash();
+  }
+
+  return sum;
+}
+
 void BPlusTreeLeafNode::Write(std::stringstream &out) {
   out << '[';
   for (auto i = 0; i < this->records.size(); i++) {
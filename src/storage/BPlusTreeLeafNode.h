@@ -95,6 +95,11 @@ namespace noid::storage {
      */
     std::unique_ptr<BPlusTreeRecord> TakeLargest();
 
+    /**
+     * @return The sum of the hashes of the records in this node.
+     */
+    uint64_t ComputeHash() override;
+
      /**
       * @brief Creates a new BPlusTreeLeafNode.
       * @details A record must be added in order to ensure the node is never empty, except just prior to
@@ -119,6 +124,20 @@ namespace noid::storage {
       */
     [[nodiscard]] static std::shared_ptr<BPlusTreeLeafNode> Create(std::shared_ptr<BPlusTreeInternalNode> parent, uint8_t order, std::unique_ptr<BPlusTreeRecord> record);
 
+    /**
+     * @brief Creates a new BPlusTreeLeafNode containing the given @p records, and links it as the right sibling of
+     * @p previous.
+     * @details This supports building a tree bottom-up from sorted records. The records must be sorted, must all be
+     * greater than the records in @p previous and may not be empty. The parent is set once the node is adopted
+     * by a @c BPlusTreeInternalNode.
+     *
+     * @param order The tree order.
+     * @param records The sorted records.
+     * @param previous The left sibling, which may be @c nullptr.
+     * @return The new leaf node.
+     */
+    [[nodiscard]] static std::shared_ptr<BPlusTreeLeafNode> Create(uint8_t order, std::vector<std::unique_ptr<BPlusTreeRecord>> records, const std::shared_ptr<BPlusTreeLeafNode>& previous);
+
     ~BPlusTreeLeafNode() override = default;
 
     /**
@@ -162,6 +181,11 @@ namespace noid::storage {
      */
     std::shared_ptr<BPlusTreeLeafNode> Next();
 
+    /**
+     * @return The records in this node, ordered by their key.
+     */
+    const std::vector<std::unique_ptr<BPlusTreeRecord>>& Records();
+
     /**
      * @return The smallest key.
      */
@@ -179,15 +203,21 @@ namespace noid::storage {
      */
     void SetParent(std::shared_ptr<BPlusTreeInternalNode> p) override;
 
+    /**
+     * @brief Drops the links of this node to its parent and siblings.
+     */
+    void Unlink() override;
+
     /**
      * @brief Copies @p key and @p value and inserts them into this node.
      * @details If the key already exists, the pre-existing value is overwritten.
      *
      * @param key The key to insert.
      * @param value The related data.
+     * @param sequence The sequence number of this modification.
      * @return @c true if inserting the key/value increased the size of this node.
      */
-    bool Insert(const K& key, V& value);
+    bool Insert(const K& key, V& value, uint64_t sequence = 0);
 
     /**
      * @brief Redistributes the node keys evenly between this node and a newly created sibling, copying up
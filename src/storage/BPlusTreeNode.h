@@ -1,6 +1,8 @@
 #ifndef NOID_SRC_STORAGE_BPLUSTREENODE_H_
 #define NOID_SRC_STORAGE_BPLUSTREENODE_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <sstream>
 
@@ -15,6 +17,33 @@ class BPlusTreeInternalNode;
  * @brief Defines shared behaviour between internal- and leaf nodes.
  */
 class BPlusTreeNode {
+ private:
+
+    /**
+     * An upper bound of the sequence numbers of the records in the subtree of this node.
+     * @see BPlusTree::ExportSince
+     */
+    uint64_t max_sequence = 0;
+
+    /**
+     * The sum of the hashes of the records in the subtree of this node.
+     * @see BPlusTreeNode::Hash
+     */
+    uint64_t hash = 0;
+
+    /**
+     * Whether @c hash reflects the current records in the subtree of this node.
+     */
+    bool hash_valid = false;
+
+ protected:
+
+    /**
+     * @brief Computes the hash of this node from its records or the hashes of its children.
+     *
+     * @return The sum of the hashes of the records in the subtree of this node.
+     */
+    virtual uint64_t ComputeHash()= 0;
 
  public:
     BPlusTreeNode()= default;
@@ -59,6 +88,13 @@ class BPlusTreeNode {
      */
     virtual void SetParent(std::shared_ptr<BPlusTreeInternalNode> parent)= 0;
 
+    /**
+     * @brief Drops the links of this node to its parent and siblings.
+     * @details These links and the links to the children form reference cycles, so a tree must unlink the nodes it
+     * discards for them to be freed.
+     */
+    virtual void Unlink()= 0;
+
     /**
      * @brief Redistributes the keys or records evenly between itself and a new sibling.
      * @details If the node contains less than @c BTREE_MIN_ORDER elements, this method does nothing but
@@ -81,6 +117,49 @@ class BPlusTreeNode {
      * @param out The stream to Write the output to.
      */
     virtual void Write(std::stringstream& out)= 0;
+
+    /**
+     * @return An upper bound of the sequence numbers of the records in the subtree of this node. The subtree does
+     * not contain any record modified after this sequence number.
+     */
+    [[nodiscard]] uint64_t MaxSequence() const {
+      return this->max_sequence;
+    }
+
+    /**
+     * @brief Raises the upper bound of the sequence numbers in the subtree of this node to at least @p sequence.
+     *
+     * @param sequence The sequence number of a record that is or was moved into the subtree of this node.
+     */
+    void RaiseMaxSequence(uint64_t sequence) {
+      this->max_sequence = std::max(this->max_sequence, sequence);
+    }
+
+    /**
+     * @brief Returns the hash summarizing the records in the subtree of this node.
+     * @details The hash is the sum of the hashes of the records, wrapping around on overflow. Unlike a hash over
+     * the hashes of the children, it does not depend on the shape of the tree, so the hashes of a key range are
+     * comparable between trees having different orders or insertion histories.
+     * The hash is computed on demand and kept until @c InvalidateHash is called, so modifications of a tree that is
+     * never compared do not compute any hash.
+     *
+     * @return The hash of the subtree of this node.
+     */
+    [[nodiscard]] uint64_t Hash() {
+      if (!this->hash_valid) {
+        this->hash = this->ComputeHash();
+        this->hash_valid = true;
+      }
+
+      return this->hash;
+    }
+
+    /**
+     * @brief Marks the hash of this node as outdated, after its records or the subtrees of its children changed.
+     */
+    void InvalidateHash() {
+      this->hash_valid = false;
+    }
 };
 
 }
@@ -1,8 +1,48 @@
 #include "BPlusTreeRecord.h"
 
+#include <cstring>
 
 namespace noid::storage {
 
+/**
+ * @brief The finalizer of MurmurHash3, which mixes all input bits into all output bits.
+ */
+static uint64_t Mix(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+
+  return value;
+}
+
+/**
+ * @return The hash of the given key and value.
+ */
+static uint64_t HashRecord(const K& key, const V& value) {
+  uint64_t low;
+  uint64_t high;
+  std::memcpy(&low, key.data(), sizeof(uint64_t));
+  std::memcpy(&high, key.data() + sizeof(uint64_t), sizeof(uint64_t));
+
+  auto hash = Mix(low ^ Mix(high ^ value.size()));
+  size_t offset = 0;
+  for (; offset + sizeof(uint64_t) <= value.size(); offset += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, value.data() + offset, sizeof(uint64_t));
+    hash = Mix(hash ^ word);
+  }
+
+  if (offset < value.size()) {
+    uint64_t word = 0;
+    std::memcpy(&word, value.data() + offset, value.size() - offset);
+    hash = Mix(hash ^ word);
+  }
+
+  return hash;
+}
+
 bool operator==(BPlusTreeRecord &lhs, BPlusTreeRecord &rhs) {
   return lhs.Key() ==rhs.Key();
 }
@@ -11,7 +51,8 @@ bool operator<(BPlusTreeRecord &lhs, BPlusTreeRecord &rhs) {
   return lhs.Key() < rhs.Key();
 }
 
-BPlusTreeRecord::BPlusTreeRecord(K key, V value) : key(key), value(std::move(value)) {}
+BPlusTreeRecord::BPlusTreeRecord(K key, V value, uint64_t sequence)
+  : key(key), value(std::move(value)), sequence(sequence), hash(0), hash_valid(false) {}
 
 const K &BPlusTreeRecord::Key() const {
   return this->key;
@@ -25,8 +66,23 @@ V BPlusTreeRecord::Value() && {
   return std::move(this->value);
 }
 
-void BPlusTreeRecord::Replace(V &replacement) {
+uint64_t BPlusTreeRecord::Sequence() const {
+  return this->sequence;
+}
+
+uint64_t BPlusTreeRecord::Hash() {
+  if (!this->hash_valid) {
+    this->hash = HashRecord(this->key, this->value);
+    this->hash_valid = true;
+  }
+
+  return this->hash;
+}
+
+void BPlusTreeRecord::Replace(V &replacement, uint64_t replacement_sequence) {
   this->value = std::move(replacement);
+  this->sequence = replacement_sequence;
+  this->hash_valid = false;
 }
 
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef NOID_SRC_STORAGE_BPLUSTREERECORD_H_
 #define NOID_SRC_STORAGE_BPLUSTREERECORD_H_
 
+#include <cstdint>
+
 #include "Shared.h"
 #include "KeyBearer.h"
 
@@ -14,6 +16,21 @@ class BPlusTreeRecord : public KeyBearer {
     K key;
     V value;
 
+    /**
+     * The sequence number of the modification that inserted or last replaced this record.
+     */
+    uint64_t sequence;
+
+    /**
+     * The hash of the key and value. It is computed on demand, so trees that are never compared do not pay for it.
+     */
+    uint64_t hash;
+
+    /**
+     * Whether @c hash reflects the current value.
+     */
+    bool hash_valid;
+
  public:
 
     /**
@@ -22,8 +39,9 @@ class BPlusTreeRecord : public KeyBearer {
      *
      * @param key The search key.
      * @param value The related data.
+     * @param sequence The sequence number of the modification inserting this record.
      */
-    BPlusTreeRecord(K key, V value);
+    BPlusTreeRecord(K key, V value, uint64_t sequence = 0);
     BPlusTreeRecord()= delete;
     BPlusTreeRecord(BPlusTreeRecord const&)= delete;
     BPlusTreeRecord(BPlusTreeRecord &&)= default;
@@ -47,14 +65,25 @@ class BPlusTreeRecord : public KeyBearer {
      */
     V Value() &&;
 
+    /**
+     * @return The sequence number of the modification that inserted or last replaced this record.
+     */
+    [[nodiscard]] uint64_t Sequence() const;
+
+    /**
+     * @return A 64-bit hash of the key and value of this record.
+     */
+    [[nodiscard]] uint64_t Hash();
+
     /**
      * @brief Replaces the current value with the given one.
      * @details To avoid copying the data, the values' contents are moved instead of copied. This leaves
      * the given @p value in a valid, but hopefully useless state.
      *
      * @param replacement The replacement value.
+     * @param replacement_sequence The sequence number of the modification replacing the value.
      */
-    void Replace(V& replacement);
+    void Replace(V& replacement, uint64_t replacement_sequence = 0);
 };
 
   /**
@@ -0,0 +1,127 @@
+#include "BloomFilter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace noid::storage {
+
+static const uint32_t BITS_PER_BLOCK = BLOOM_BLOCK_SIZE * 8;
+
+static const uint32_t MAX_PROBES = 16;
+
+/**
+ * The encoded header consists of the probe count and the block count.
+ */
+static const size_t HEADER_SIZE = 2 * sizeof(uint32_t);
+
+/**
+ * @brief The finalizer of MurmurHash3, which mixes all input bits into all output bits.
+ */
+static uint64_t Mix(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdULL;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ULL;
+  value ^= value >> 33;
+
+  return value;
+}
+
+BloomFilter::BloomFilter() : probes(0) {}
+
+uint64_t BloomFilter::Hash(const K &key) {
+  uint64_t low;
+  uint64_t high;
+  std::memcpy(&low, key.data(), sizeof(uint64_t));
+  std::memcpy(&high, key.data() + sizeof(uint64_t), sizeof(uint64_t));
+
+  return Mix(low ^ Mix(high));
+}
+
+BloomFilter BloomFilter::Build(const std::vector<uint64_t> &hashes, uint8_t bits_per_key) {
+  BloomFilter filter;
+  if (bits_per_key == 0 || hashes.empty()) {
+    return filter;
+  }
+
+  // The optimal amount of probes is ln(2) times the amount of bits per key.
+  filter.probes = std::clamp<uint32_t>(static_cast<uint32_t>(std::lround(bits_per_key * 0.69)), 1, MAX_PROBES);
+  filter.blocks.resize((hashes.size() * bits_per_key + BITS_PER_BLOCK - 1) / BITS_PER_BLOCK, Block{});
+
+  for (auto hash : hashes) {
+    auto& block = filter.blocks[static_cast<uint32_t>(hash) % filter.blocks.size()];
+
+    // Derive the bit positions within the block from the upper half of the hash by double hashing.
+    auto bits = static_cast<uint32_t>(hash >> 32);
+    auto delta = (bits >> 17) | (bits << 15);
+    for (uint32_t i = 0; i < filter.probes; i++) {
+      auto bit = bits % BITS_PER_BLOCK;
+      block.words[bit / 64] |= uint64_t(1) << (bit % 64);
+      bits += delta;
+    }
+  }
+
+  return filter;
+}
+
+BloomFilter BloomFilter::Decode(const byte *data, size_t size) {
+  BloomFilter filter;
+  if (size < HEADER_SIZE) {
+    throw std::runtime_error("Cannot decode Bloom filter: it is truncated.");
+  }
+
+  uint32_t block_count;
+  std::memcpy(&filter.probes, data, sizeof(uint32_t));
+  std::memcpy(&block_count, data + sizeof(uint32_t), sizeof(uint32_t));
+  if (filter.probes > MAX_PROBES || (block_count > 0 && filter.probes == 0)
+      || size != HEADER_SIZE + static_cast<size_t>(block_count) * BLOOM_BLOCK_SIZE) {
+    throw std::runtime_error("Cannot decode Bloom filter: its header is corrupt.");
+  }
+
+  filter.blocks.resize(block_count);
+  std::copy(data + HEADER_SIZE, data + size, reinterpret_cast<byte*>(filter.blocks.data()));
+
+  return filter;
+}
+
+void BloomFilter::Encode(std::vector<byte> &buffer) const {
+  auto block_count = static_cast<uint32_t>(this->blocks.size());
+  auto probes_data = reinterpret_cast<const byte*>(&this->probes);
+  auto count_data = reinterpret_cast<const byte*>(&block_count);
+  auto blocks_data = reinterpret_cast<const byte*>(this->blocks.data());
+
+  buffer.insert(buffer.end(), probes_data, probes_data + sizeof(uint32_t));
+  buffer.insert(buffer.end(), count_data, count_data + sizeof(uint32_t));
+  buffer.insert(buffer.end(), blocks_data, blocks_data + this->Size());
+}
+
+bool BloomFilter::MayContain(uint64_t hash) const {
+  if (this->blocks.empty()) {
+    return true;
+  }
+
+  auto& block = this->blocks[static_cast<uint32_t>(hash) % this->blocks.size()];
+  auto bits = static_cast<uint32_t>(hash >> 32);
+  auto delta = (bits >> 17) | (bits << 15);
+  for (uint32_t i = 0; i < this->probes; i++) {
+    auto bit = bits % BITS_PER_BLOCK;
+    if ((block.words[bit / 64] & (uint64_t(1) << (bit % 64))) == 0) {
+      return false;
+    }
+    bits += delta;
+  }
+
+  return true;
+}
+
+bool BloomFilter::MayContain(const K &key) const {
+  return this->MayContain(Hash(key));
+}
+
+size_t BloomFilter::Size() const {
+  return this->blocks.size() * BLOOM_BLOCK_SIZE;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#ifndef NOID_SRC_STORAGE_BLOOMFILTER_H_
+#define NOID_SRC_STORAGE_BLOOMFILTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief The size in bytes of a block of a @c BloomFilter, which equals the size of a cache line.
+ */
+const size_t BLOOM_BLOCK_SIZE = 64;
+
+/**
+ * @brief A blocked Bloom filter over keys, which answers whether a set may contain a key.
+ * @details The filter consists of cache-line-sized blocks. All bits of a key are set within a single block, which is
+ * selected by its hash, so a lookup touches one cache line. This costs a slightly higher false positive rate than a
+ * classic Bloom filter of the same size.
+ *
+ * A filter without blocks may contain any key.
+ */
+class BloomFilter {
+ private:
+
+    /**
+     * @brief A block of the filter.
+     */
+    struct alignas(BLOOM_BLOCK_SIZE) Block {
+        uint64_t words[BLOOM_BLOCK_SIZE / sizeof(uint64_t)];
+    };
+
+    /**
+     * The amount of bits set per key.
+     */
+    uint32_t probes;
+
+    /**
+     * The blocks.
+     */
+    std::vector<Block> blocks;
+
+ public:
+
+    /**
+     * @brief Creates an empty filter, which may contain any key.
+     */
+    BloomFilter();
+
+    /**
+     * @brief Hashes the given @p key for use with @c Build and @c MayContain.
+     *
+     * @param key The key.
+     * @return The hash.
+     */
+    static uint64_t Hash(const K& key);
+
+    /**
+     * @brief Builds a filter containing the keys having the given @p hashes.
+     *
+     * @param hashes The key hashes.
+     * @param bits_per_key The amount of filter bits per key. Ten bits per key yield a false positive rate of
+     * about one percent. If zero, an empty filter is returned.
+     * @return The filter.
+     */
+    static BloomFilter Build(const std::vector<uint64_t>& hashes, uint8_t bits_per_key);
+
+    /**
+     * @brief Decodes a filter encoded by @c Encode.
+     *
+     * @param data The encoded filter.
+     * @param size The size of the encoded filter in bytes.
+     * @return The filter.
+     * @throws std::runtime_error If the data does not contain a filter.
+     */
+    static BloomFilter Decode(const byte* data, size_t size);
+
+    /**
+     * @brief Appends the encoded form of this filter to the given @p buffer.
+     *
+     * @param buffer The buffer.
+     */
+    void Encode(std::vector<byte>& buffer) const;
+
+    /**
+     * @param hash The key hash, obtained using @c Hash.
+     * @return Whether the key may be contained in the filter. If not, it certainly is not.
+     */
+    [[nodiscard]] bool MayContain(uint64_t hash) const;
+
+    /**
+     * @param key The key.
+     * @return Whether the key may be contained in the filter. If not, it certainly is not.
+     */
+    [[nodiscard]] bool MayContain(const K& key) const;
+
+    /**
+     * @return The size of the filter bits in bytes.
+     */
+    [[nodiscard]] size_t Size() const;
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_BLOOMFILTER_H_
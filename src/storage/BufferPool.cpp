@@ -0,0 +1,481 @@
+#include "BufferPool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace noid::storage {
+
+PageHandle::PageHandle(BufferPool *pool, size_t frame) : pool(pool), frame(frame) {}
+
+PageHandle::PageHandle(PageHandle &&other) noexcept : pool(other.pool), frame(other.frame) {
+  other.pool = nullptr;
+}
+
+PageHandle::~PageHandle() {
+  if (this->pool) {
+    this->pool->Unpin(this->frame);
+  }
+}
+
+PageHandle &PageHandle::operator=(PageHandle &&other) noexcept {
+  if (this != &other) {
+    if (this->pool) {
+      this->pool->Unpin(this->frame);
+    }
+
+    this->pool = other.pool;
+    this->frame = other.frame;
+    other.pool = nullptr;
+  }
+
+  return *this;
+}
+
+PageId PageHandle::Id() const {
+  return this->pool->frames[this->frame]->page_id;
+}
+
+const byte *PageHandle::Data() const {
+  return this->pool->frames[this->frame]->data;
+}
+
+byte *PageHandle::MutableData() {
+  return this->pool->frames[this->frame]->data;
+}
+
+std::shared_mutex &PageHandle::Latch() {
+  return this->pool->frames[this->frame]->latch;
+}
+
+Lsn PageHandle::Log(const byte *record, size_t size) {
+  if (!this->pool->log) {
+    throw std::logic_error("Cannot log a page modification without a write-ahead log");
+  }
+
+  auto& f = *this->pool->frames[this->frame];
+
+  // Appending to the log and marking the page dirty happen atomically with respect to BeginCheckpoint, so that every
+  // record preceding the checkpoint start either belongs to a page in its dirty page list, or to a page that was
+  // written already.
+  std::lock_guard<std::mutex> lock(this->pool->mutex);
+  auto lsn = this->pool->log->Append(record, size);
+
+  std::memcpy(f.data + offsetof(PageHeader, lsn), &lsn, sizeof(Lsn));
+  f.page_lsn = lsn;
+  if (!f.dirty) {
+    f.dirty = true;
+    f.recovery_lsn = lsn;
+  }
+
+  return lsn;
+}
+
+void PageHandle::MarkDirty() {
+  auto& f = *this->pool->frames[this->frame];
+
+  std::lock_guard<std::mutex> lock(this->pool->mutex);
+  f.dirty = true;
+}
+
+size_t BufferPool::Evict(std::unique_lock<std::mutex> &lock) {
+  // Two full rotations suffice to clear all reference bits and find an unpinned frame, if one exists.
+  for (size_t i = 0; i < this->frames.size() * 2; i++) {
+    auto index = this->clock_hand;
+    this->clock_hand = (this->clock_hand + 1) % this->frames.size();
+
+    auto& f = *this->frames[index];
+    if (f.pin_count > 0) {
+      continue;
+    }
+
+    if (f.referenced) {
+      f.referenced = false;
+      continue;
+    }
+
+    if (f.page_id != INVALID_PAGE_ID) {
+      if (f.dirty) {
+        // The page is written back like a flushed one, which pins it meanwhile. Since it might have been fetched or
+        // modified while the lock was released, the frame is only used if it is still unreferenced and clean.
+        auto page_id = f.page_id;
+        lock.unlock();
+        try {
+          this->FlushPage(page_id);
+        } catch (...) {
+          lock.lock();
+          throw;
+        }
+        lock.lock();
+
+        if (f.page_id != page_id || f.pin_count > 0 || f.referenced || f.dirty) {
+          continue;
+        }
+      }
+
+      this->page_table.erase(f.page_id);
+      f.page_id = INVALID_PAGE_ID;
+    }
+
+    return index;
+  }
+
+  throw std::runtime_error("Cannot evict a page from the buffer pool: all frames are pinned.");
+}
+
+std::pair<size_t, bool> BufferPool::Lookup(std::unique_lock<std::mutex> &lock, PageId page_id) {
+  while (true) {
+    auto entry = this->page_table.find(page_id);
+    if (entry != this->page_table.end()) {
+      if (this->frames[entry->second]->loading) {
+        // Look the page up again once it is loaded, since reading it might have failed.
+        this->loaded.wait(lock);
+        continue;
+      }
+
+      return {entry->second, true};
+    }
+
+    // Writing back a dirty page releases the lock, during which the page might have been fetched by someone else.
+    auto index = this->Evict(lock);
+    if (this->page_table.count(page_id) == 0) {
+      return {index, false};
+    }
+  }
+}
+
+void BufferPool::Unpin(size_t frame) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->frames[frame]->pin_count--;
+}
+
+BufferPool::BufferPool(std::shared_ptr<PageFile> file, size_t capacity, std::shared_ptr<WriteAheadLog> log)
+  : file(std::move(file)), log(std::move(log)), clock_hand(0) {
+  if (capacity == 0) {
+    throw std::invalid_argument("Expect a buffer pool capacity of at least one frame.");
+  }
+
+  this->arena = AllocateAligned(capacity * PAGE_SIZE);
+  this->frames.reserve(capacity);
+  for (size_t i = 0; i < capacity; i++) {
+    auto f = std::make_unique<Frame>();
+    f->data = this->arena.get() + i * PAGE_SIZE;
+
+    this->frames.push_back(std::move(f));
+  }
+}
+
+PageHandle BufferPool::Fetch(PageId page_id) {
+  std::unique_lock<std::mutex> lock(this->mutex);
+
+  // Reading a page that is being prefetched would read it twice, so wait until the prefetched copy is installed.
+  this->loaded.wait(lock, [this, page_id]() { return this->prefetching.count(page_id) == 0; });
+  auto [index, cached] = this->Lookup(lock, page_id);
+  auto& f = *this->frames[index];
+  f.pin_count++;
+  f.referenced = true;
+  if (cached) {
+    return {this, index};
+  }
+
+  // Publish the pinned frame before reading the page into it, so other fetches of the page wait for this one. A
+  // prefetch of the page that started while evicting is dropped.
+  this->prefetching.erase(page_id);
+  f.page_id = page_id;
+  f.loading = true;
+  this->page_table[page_id] = index;
+  lock.unlock();
+
+  try {
+    this->file->Read(page_id, f.data);
+    if (!VerifyPage(f.data)) {
+      throw std::runtime_error("Page " + std::to_string(page_id) + " is corrupt: its checksum does not match.");
+    }
+  } catch (...) {
+    lock.lock();
+    this->page_table.erase(page_id);
+    f.page_id = INVALID_PAGE_ID;
+    f.pin_count = 0;
+    f.referenced = false;
+    f.loading = false;
+    this->loaded.notify_all();
+
+    throw;
+  }
+
+  std::memcpy(&f.page_lsn, f.data + offsetof(PageHeader, lsn), sizeof(Lsn));
+
+  lock.lock();
+  f.loading = false;
+  this->loaded.notify_all();
+
+  return {this, index};
+}
+
+PageHandle BufferPool::FetchNew(PageId page_id) {
+  std::unique_lock<std::mutex> lock(this->mutex);
+
+  auto index = this->Lookup(lock, page_id).first;
+  auto& f = *this->frames[index];
+
+  this->prefetching.erase(page_id);
+  std::memset(f.data, 0, PAGE_SIZE);
+  f.page_id = page_id;
+  f.page_lsn = INVALID_LSN;
+  f.pin_count++;
+  f.referenced = true;
+  this->page_table[page_id] = index;
+
+  return {this, index};
+}
+
+size_t BufferPool::Prefetch(const std::vector<PageId> &page_ids) {
+  // Reserve a pinned frame per page, which is not in the page table yet so no one else can use it.
+  std::vector<std::pair<PageId, size_t>> reserved;
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    auto limit = std::max<size_t>(1, this->frames.size() / 4);
+    std::vector<std::pair<PageId, size_t>> candidates;
+    for (auto page_id : page_ids) {
+      if (candidates.size() == limit) {
+        break;
+      }
+
+      if (this->page_table.count(page_id) > 0 || this->prefetching.count(page_id) > 0) {
+        continue;
+      }
+
+      size_t index;
+      try {
+        index = this->Evict(lock);
+      } catch (std::runtime_error&) {
+        break;
+      }
+
+      this->frames[index]->pin_count = 1;
+      candidates.emplace_back(page_id, index);
+    }
+
+    // Fetches wait for pages being prefetched, so pages are only marked once no more dirty pages are written back,
+    // which needs page latches that the waiting fetches may hold. Since writing back a page releases the lock, a page
+    // might have been fetched by someone else meanwhile.
+    for (auto [page_id, index] : candidates) {
+      if (this->page_table.count(page_id) > 0 || !this->prefetching.insert(page_id).second) {
+        this->frames[index]->pin_count = 0;
+        continue;
+      }
+
+      reserved.emplace_back(page_id, index);
+    }
+  }
+
+  if (reserved.empty()) {
+    return 0;
+  }
+
+  std::vector<PageIo> batch;
+  for (auto [page_id, index] : reserved) {
+    batch.push_back({page_id, this->frames[index]->data});
+  }
+
+  auto loaded = true;
+  try {
+    this->file->ReadBatch(batch);
+  } catch (std::system_error&) {
+    loaded = false;
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  size_t installed = 0;
+  for (auto [page_id, index] : reserved) {
+    auto& f = *this->frames[index];
+    f.pin_count = 0;
+
+    if (this->prefetching.erase(page_id) > 0 && loaded && VerifyPage(f.data)) {
+      std::memcpy(&f.page_lsn, f.data + offsetof(PageHeader, lsn), sizeof(Lsn));
+      f.page_id = page_id;
+      f.referenced = true;
+      this->page_table[page_id] = index;
+      installed++;
+    }
+  }
+  this->loaded.notify_all();
+
+  return installed;
+}
+
+bool BufferPool::FlushPage(PageId page_id) {
+  return this->FlushPages({page_id}) == 1;
+}
+
+size_t BufferPool::FlushPages(const std::vector<PageId> &page_ids) {
+  // Pin the dirty pages, so they cannot be evicted while they are being written. The handles unpin them when
+  // leaving this scope.
+  std::vector<PageHandle> handles;
+  std::vector<size_t> pinned;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto page_id : page_ids) {
+      auto entry = this->page_table.find(page_id);
+      if (entry != this->page_table.end() && this->frames[entry->second]->dirty) {
+        this->frames[entry->second]->pin_count++;
+        handles.emplace_back(this, entry->second);
+        pinned.push_back(entry->second);
+      }
+    }
+  }
+
+  if (handles.empty()) {
+    return 0;
+  }
+
+  auto copies = AllocateAligned(handles.size() * PAGE_SIZE);
+  std::vector<Lsn> recovery_lsns(handles.size());
+  std::vector<PageIo> batch;
+  batch.reserve(handles.size());
+  auto max_page_lsn = INVALID_LSN;
+
+  for (size_t i = 0; i < handles.size(); i++) {
+    auto& f = *this->frames[pinned[i]];
+    auto copy = copies.get() + i * PAGE_SIZE;
+
+    std::shared_lock<std::shared_mutex> latch(f.latch);
+    std::lock_guard<std::mutex> lock(this->mutex);
+
+    max_page_lsn = std::max(max_page_lsn, f.page_lsn);
+    recovery_lsns[i] = f.recovery_lsn;
+    f.dirty = false;
+    f.recovery_lsn = INVALID_LSN;
+
+    std::memcpy(copy, f.data, PAGE_SIZE);
+    batch.push_back({f.page_id, copy});
+  }
+
+  for (auto& io : batch) {
+    SealPage(io.buffer);
+  }
+
+  try {
+    if (this->log && max_page_lsn != INVALID_LSN) {
+      this->log->Flush(max_page_lsn);
+    }
+
+    this->file->WriteBatch(batch);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (size_t i = 0; i < handles.size(); i++) {
+      auto& f = *this->frames[pinned[i]];
+      if (!f.dirty) {
+        f.dirty = true;
+        f.recovery_lsn = recovery_lsns[i];
+      }
+    }
+
+    throw;
+  }
+
+  return batch.size();
+}
+
+void BufferPool::DiscardFrame(size_t frame) {
+  auto& f = *this->frames[frame];
+  if (f.pin_count > 0) {
+    throw std::logic_error("Cannot discard page " + std::to_string(f.page_id) + ": it is pinned.");
+  }
+
+  this->page_table.erase(f.page_id);
+  f.page_id = INVALID_PAGE_ID;
+  f.referenced = false;
+  f.dirty = false;
+  f.recovery_lsn = INVALID_LSN;
+  f.page_lsn = INVALID_LSN;
+}
+
+void BufferPool::Discard(PageId page_id) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  this->prefetching.erase(page_id);
+  auto entry = this->page_table.find(page_id);
+  if (entry != this->page_table.end()) {
+    this->DiscardFrame(entry->second);
+  }
+}
+
+void BufferPool::Truncate(PageId page_count) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  for (size_t i = 0; i < this->frames.size(); i++) {
+    auto page_id = this->frames[i]->page_id;
+    if (page_id != INVALID_PAGE_ID && page_id >= page_count) {
+      this->DiscardFrame(i);
+    }
+  }
+
+  for (auto entry = this->prefetching.begin(); entry != this->prefetching.end();) {
+    entry = *entry >= page_count ? this->prefetching.erase(entry) : std::next(entry);
+  }
+
+  this->file->Truncate(page_count);
+}
+
+void BufferPool::FlushAll() {
+  std::vector<PageId> dirty;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto& f : this->frames) {
+      if (f->dirty) {
+        dirty.push_back(f->page_id);
+      }
+    }
+  }
+
+  this->FlushPages(dirty);
+  this->Sync();
+}
+
+void BufferPool::Sync() {
+  this->file->Sync();
+}
+
+std::pair<Lsn, std::vector<PageId>> BufferPool::BeginCheckpoint() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  std::vector<PageId> dirty;
+  for (auto& f : this->frames) {
+    if (f->dirty) {
+      dirty.push_back(f->page_id);
+    }
+  }
+
+  auto begin_lsn = this->log ? this->log->LastLsn() + 1 : INVALID_LSN;
+  return {begin_lsn, dirty};
+}
+
+Lsn BufferPool::OldestRecoveryLsn() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  auto oldest = INVALID_LSN;
+  for (auto& f : this->frames) {
+    if (f->dirty && f->recovery_lsn != INVALID_LSN && (oldest == INVALID_LSN || f->recovery_lsn < oldest)) {
+      oldest = f->recovery_lsn;
+    }
+  }
+
+  return oldest;
+}
+
+size_t BufferPool::Capacity() const {
+  return this->frames.size();
+}
+
+size_t BufferPool::CachedPageCount() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->page_table.size();
+}
+
+}
\ No newline at end of file
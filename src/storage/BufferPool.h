@@ -0,0 +1,377 @@
+#ifndef NOID_SRC_STORAGE_BUFFERPOOL_H_
+#define NOID_SRC_STORAGE_BUFFERPOOL_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "AlignedBuffer.h"
+#include "Page.h"
+#include "PageFile.h"
+#include "Shared.h"
+#include "WriteAheadLog.h"
+
+namespace noid::storage {
+
+class BufferPool;
+
+/**
+ * @brief A pinned page in a @c BufferPool. The page cannot be evicted while a handle to it exists.
+ * @details Reading the page contents requires holding the shared page latch, while modifying them requires holding
+ * it exclusively. Modifications must be described by a log record using @c Log before the latch is released.
+ */
+class PageHandle {
+ private:
+
+    /**
+     * The pool containing the page, or @c nullptr if this handle has been moved from.
+     */
+    BufferPool* pool;
+
+    /**
+     * The index of the frame containing the page.
+     */
+    size_t frame;
+
+ public:
+
+    /**
+     * @brief Creates a new @c PageHandle for an already pinned frame.
+     *
+     * @param pool The pool containing the frame.
+     * @param frame The index of the frame.
+     */
+    PageHandle(BufferPool* pool, size_t frame);
+    PageHandle()= delete;
+    PageHandle(PageHandle const&)= delete;
+    PageHandle(PageHandle &&other) noexcept;
+    ~PageHandle();
+
+    PageHandle& operator=(PageHandle const&)= delete;
+    PageHandle& operator=(PageHandle &&other) noexcept;
+
+    /**
+     * @return The id of the page.
+     */
+    [[nodiscard]] PageId Id() const;
+
+    /**
+     * @return The page contents, including the @c PageHeader.
+     */
+    [[nodiscard]] const byte* Data() const;
+
+    /**
+     * @return The modifiable page contents, including the @c PageHeader.
+     */
+    byte* MutableData();
+
+    /**
+     * @return The latch protecting the page contents.
+     */
+    std::shared_mutex& Latch();
+
+    /**
+     * @brief Appends a record describing the latest modification of this page to the write-ahead log, and marks the
+     * page dirty.
+     * @details The caller must hold the page latch exclusively.
+     *
+     * @param record The log record.
+     * @param size The size of the log record.
+     * @return The LSN of the log record, which is also stored in the @c PageHeader.
+     * @throws std::logic_error If the pool has no write-ahead log.
+     */
+    Lsn Log(const byte* record, size_t size);
+
+    /**
+     * @brief Marks the page dirty without logging the modification. Use this for pages that are not recovered from
+     * the write-ahead log.
+     * @details The caller must hold the page latch exclusively.
+     */
+    void MarkDirty();
+};
+
+/**
+ * @brief Caches the pages of a @c PageFile in a fixed amount of frames, and keeps track of modified (dirty) pages.
+ * @details Unpinned pages are evicted using the clock algorithm when a frame is required to load another page.
+ * Dirty pages are written back on eviction or when flushed explicitly, but never before the write-ahead log is durable
+ * up to the LSN of their latest modification. Their checksum is stored in the @c PageHeader when they are written.
+ */
+class BufferPool {
+ private:
+    friend class PageHandle;
+
+    /**
+     * @brief A slot in the pool which can contain a single page.
+     */
+    struct Frame {
+
+        /**
+         * The page contained in this frame, or @c INVALID_PAGE_ID if the frame is unused.
+         */
+        PageId page_id = INVALID_PAGE_ID;
+
+        /**
+         * The page contents, which are part of the pool arena.
+         */
+        byte* data = nullptr;
+
+        /**
+         * The amount of handles referencing this frame.
+         */
+        uint32_t pin_count = 0;
+
+        /**
+         * Whether the page was used since the clock hand last passed it.
+         */
+        bool referenced = false;
+
+        /**
+         * Whether the page was modified since it was last written to the page file.
+         */
+        bool dirty = false;
+
+        /**
+         * Whether the page is being read by @c Fetch. The frame is pinned by the reading fetch, and other fetches
+         * of the page wait for it.
+         */
+        bool loading = false;
+
+        /**
+         * The LSN of the first modification since the page was last written, or @c INVALID_LSN if that
+         * modification was not logged. This is the first record required to recover the page.
+         */
+        Lsn recovery_lsn = INVALID_LSN;
+
+        /**
+         * The LSN of the latest modification.
+         */
+        Lsn page_lsn = INVALID_LSN;
+
+        /**
+         * Protects the page contents.
+         */
+        std::shared_mutex latch;
+    };
+
+    /**
+     * The file containing the pages.
+     */
+    std::shared_ptr<PageFile> file;
+
+    /**
+     * The log describing page modifications. May be @c nullptr
+     */
+    std::shared_ptr<WriteAheadLog> log;
+
+    /**
+     * The memory containing the contents of all frames. Every frame is aligned to @c PAGE_SIZE, so pages can be
+     * transferred using direct I/O.
+     */
+    AlignedBuffer arena;
+
+    /**
+     * The frames of this pool.
+     */
+    std::vector<std::unique_ptr<Frame>> frames;
+
+    /**
+     * Maps page ids to the index of the frame containing them.
+     */
+    std::unordered_map<PageId, size_t> page_table;
+
+    /**
+     * The pages being read by @c Prefetch. A page is removed when it is loaded or discarded by other means, in which
+     * case the prefetched copy is dropped.
+     */
+    std::unordered_set<PageId> prefetching;
+
+    /**
+     * The frame to inspect first when looking for an eviction victim.
+     */
+    size_t clock_hand;
+
+    /**
+     * Protects the page table and the frame metadata.
+     */
+    std::mutex mutex;
+
+    /**
+     * Signals that a page read by @c Fetch or a batch read by @c Prefetch has been loaded, or that reading failed.
+     */
+    std::condition_variable loaded;
+
+    /**
+     * @brief Finds a frame that can be (re)used to contain another page, writing back its current page if it is dirty.
+     * @details The caller must hold @c mutex using @p lock. A dirty page is written back without holding the lock,
+     * so the pool can be used meanwhile. The lock is held again when this method returns or throws.
+     *
+     * @param lock The lock on @c mutex.
+     * @return The index of the frame.
+     * @throws std::runtime_error If all frames are pinned.
+     * @throws std::system_error If a dirty page cannot be written back.
+     */
+    size_t Evict(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @brief Finds the frame containing the given page, or evicts a frame to contain it.
+     * @details The caller must hold @c mutex using @p lock. If the page is being read by another fetch, this method
+     * waits for it.
+     *
+     * @param lock The lock on @c mutex.
+     * @param page_id The page to look up.
+     * @return The index of the frame, and whether it contains the page already.
+     * @throws std::runtime_error If all frames are pinned.
+     * @throws std::system_error If a dirty page cannot be written back.
+     */
+    std::pair<size_t, bool> Lookup(std::unique_lock<std::mutex>& lock, PageId page_id);
+
+    /**
+     * @brief Removes the page in the given frame from the pool without writing it.
+     * @details The caller must hold @c mutex.
+     *
+     * @param frame The frame index.
+     * @throws std::logic_error If the page is pinned.
+     */
+    void DiscardFrame(size_t frame);
+
+    /**
+     * @brief Decrements the pin count of the given frame.
+     *
+     * @param frame The frame index.
+     */
+    void Unpin(size_t frame);
+
+ public:
+
+    /**
+     * @brief Creates a new @c BufferPool.
+     *
+     * @param file The file containing the pages.
+     * @param capacity The amount of frames.
+     * @param log The log describing page modifications. May be @c nullptr.
+     * @throws std::invalid_argument If @p capacity is zero.
+     */
+    BufferPool(std::shared_ptr<PageFile> file, size_t capacity, std::shared_ptr<WriteAheadLog> log = nullptr);
+    BufferPool()= delete;
+    BufferPool(BufferPool const&)= delete;
+    BufferPool(BufferPool &&)= delete;
+    ~BufferPool()= default;
+
+    BufferPool& operator=(BufferPool const&)= delete;
+    BufferPool& operator=(BufferPool &&)= delete;
+
+    /**
+     * @brief Pins the given page, reading it from the page file if it is not cached yet.
+     *
+     * @details The checksum of every page read from the page file is verified. Like @c Prefetch, the page is read
+     * without holding the pool lock, so a cache miss only delays the fetches of the same page.
+     *
+     * @param page_id The page to fetch.
+     * @return A handle to the pinned page.
+     * @throws std::runtime_error If all frames are pinned, or if the page is corrupt.
+     */
+    PageHandle Fetch(PageId page_id);
+
+    /**
+     * @brief Pins the given page without reading it from the page file, and fills it with zeroes.
+     * @details Use this for newly allocated pages, of which the previous contents are irrelevant. The caller must
+     * make sure no other handles to the page exist.
+     *
+     * @param page_id The page to fetch.
+     * @return A handle to the pinned page.
+     * @throws std::runtime_error If all frames are pinned.
+     */
+    PageHandle FetchNew(PageId page_id);
+
+    /**
+     * @brief Reads the given pages into the pool in a single batch, without pinning them.
+     * @details Prefetching is a hint: pages that are already cached, or that do not fit in a quarter of the pool,
+     * are skipped, and pages that cannot be read or are corrupt are dropped. The batch is read without holding the
+     * pool lock, so prefetching can run in the background while the pool is in use. Fetching a page that is being
+     * prefetched waits for the batch instead of reading the page again.
+     *
+     * @param page_ids The pages to read.
+     * @return The amount of pages added to the pool.
+     */
+    size_t Prefetch(const std::vector<PageId>& page_ids);
+
+    /**
+     * @brief Writes the given page to the page file if it is cached and dirty.
+     * @details The page is copied under its shared latch, so writers only wait for the copy, not for the write.
+     * @see FlushPages
+     *
+     * @param page_id The page to flush.
+     * @return Whether the page was written.
+     */
+    bool FlushPage(PageId page_id);
+
+    /**
+     * @brief Writes the given pages to the page file in a single batch, skipping pages that are not cached or clean.
+     * @details Like @c FlushPage, every page is only latched while it is being copied.
+     *
+     * @param page_ids The pages to flush.
+     * @return The amount of pages written.
+     */
+    size_t FlushPages(const std::vector<PageId>& page_ids);
+
+    /**
+     * @brief Removes the given page from the pool without writing it, for example because it has been freed.
+     *
+     * @param page_id The page to discard.
+     * @throws std::logic_error If the page is pinned.
+     */
+    void Discard(PageId page_id);
+
+    /**
+     * @brief Discards all pages starting at @p page_count, and truncates the page file to the remaining pages.
+     *
+     * @param page_count The amount of pages to keep.
+     * @throws std::logic_error If a discarded page is pinned.
+     * @throws std::system_error If the page file cannot be truncated.
+     */
+    void Truncate(PageId page_count);
+
+    /**
+     * @brief Writes all dirty pages to the page file and synchronizes it.
+     */
+    void FlushAll();
+
+    /**
+     * @brief Synchronizes the page file, making all written pages durable.
+     */
+    void Sync();
+
+    /**
+     * @brief Determines the position from which a checkpoint starts.
+     * @details Every record preceding the returned LSN has either been written to the page file, or belongs to a page
+     * contained in the returned list of dirty pages.
+     *
+     * @return The LSN following the last logged record, and the ids of all pages that were dirty at that point.
+     */
+    std::pair<Lsn, std::vector<PageId>> BeginCheckpoint();
+
+    /**
+     * @return The smallest recovery LSN of all dirty pages, or @c INVALID_LSN if no dirty page requires recovery.
+     */
+    Lsn OldestRecoveryLsn();
+
+    /**
+     * @return The amount of frames in this pool.
+     */
+    [[nodiscard]] size_t Capacity() const;
+
+    /**
+     * @return The amount of pages currently cached in this pool.
+     */
+    size_t CachedPageCount();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_BUFFERPOOL_H_
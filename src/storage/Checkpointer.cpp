@@ -0,0 +1,110 @@
+#include "Checkpointer.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace noid::storage {
+
+void Checkpointer::Run() {
+  std::unique_lock<std::mutex> lock(this->state_mutex);
+
+  while (!this->stopping) {
+    this->state_changed.wait_for(lock, this->interval, [this] { return this->stopping; });
+    if (this->stopping) {
+      break;
+    }
+
+    lock.unlock();
+    try {
+      this->Checkpoint();
+    } catch (...) {
+      // The next checkpoint will write the remaining dirty pages.
+      this->failed_checkpoints++;
+    }
+    lock.lock();
+  }
+}
+
+Checkpointer::Checkpointer(std::shared_ptr<BufferPool> pool, std::shared_ptr<WriteAheadLog> log,
+                           CheckpointerOptions options)
+  : pool(std::move(pool)), log(std::move(log)), interval(options.interval),
+    batch_size(options.batch_size > 0 ? options.batch_size : 1), limiter(options.bytes_per_second),
+    stopping(false), checkpoints(0), failed_checkpoints(0), pages_written(0), bytes_written(0), last_duration_ns(0),
+    total_duration_ns(0), checkpoint_lsn(INVALID_LSN) {}
+
+Checkpointer::~Checkpointer() {
+  this->Stop();
+}
+
+void Checkpointer::Start() {
+  std::lock_guard<std::mutex> lock(this->state_mutex);
+  if (!this->worker.joinable()) {
+    this->stopping = false;
+    this->worker = std::thread(&Checkpointer::Run, this);
+  }
+}
+
+void Checkpointer::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(this->state_mutex);
+    this->stopping = true;
+  }
+  this->state_changed.notify_all();
+
+  if (this->worker.joinable()) {
+    this->worker.join();
+  }
+}
+
+Lsn Checkpointer::Checkpoint() {
+  std::lock_guard<std::mutex> lock(this->checkpoint_mutex);
+  auto start = std::chrono::steady_clock::now();
+
+  const auto [begin_lsn, dirty_pages] = this->pool->BeginCheckpoint();
+  for (size_t first = 0; first < dirty_pages.size(); first += this->batch_size) {
+    auto last = std::min(dirty_pages.size(), first + this->batch_size);
+    std::vector<PageId> batch(dirty_pages.begin() + static_cast<int64_t>(first),
+                              dirty_pages.begin() + static_cast<int64_t>(last));
+
+    this->limiter.Acquire(batch.size() * PAGE_SIZE);
+
+    // Pages that were evicted since the checkpoint began have been written already.
+    auto written = this->pool->FlushPages(batch);
+    this->pages_written += written;
+    this->bytes_written += written * PAGE_SIZE;
+  }
+
+  // Evicted pages were written, but not necessarily synchronized.
+  this->pool->Sync();
+
+  // Pages dirtied again after they were written must still be recovered from the log.
+  auto oldest = this->pool->OldestRecoveryLsn();
+  auto lsn = oldest != INVALID_LSN && oldest < begin_lsn ? oldest : begin_lsn;
+  this->log->Checkpoint(lsn);
+
+  auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  this->last_duration_ns = duration.count();
+  this->total_duration_ns += duration.count();
+  this->checkpoint_lsn = lsn;
+  this->checkpoints++;
+
+  return lsn;
+}
+
+void Checkpointer::SetBytesPerSecond(uint64_t bytes_per_second) {
+  this->limiter.SetBytesPerSecond(bytes_per_second);
+}
+
+CheckpointMetrics Checkpointer::Metrics() {
+  return {
+      this->checkpoints,
+      this->failed_checkpoints,
+      this->pages_written,
+      this->bytes_written,
+      std::chrono::nanoseconds(this->last_duration_ns),
+      std::chrono::nanoseconds(this->total_duration_ns),
+      this->checkpoint_lsn,
+  };
+}
+
+}
\ No newline at end of file
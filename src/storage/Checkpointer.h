@@ -0,0 +1,210 @@
+#ifndef NOID_SRC_STORAGE_CHECKPOINTER_H_
+#define NOID_SRC_STORAGE_CHECKPOINTER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "BufferPool.h"
+#include "Page.h"
+#include "RateLimiter.h"
+#include "WriteAheadLog.h"
+
+namespace noid::storage {
+
+/**
+ * @brief Configures a @c Checkpointer.
+ */
+struct CheckpointerOptions {
+
+    /**
+     * @brief The time between the end of a background checkpoint and the start of the next one.
+     */
+    std::chrono::milliseconds interval = std::chrono::seconds(30);
+
+    /**
+     * @brief The maximum amount of page bytes written per second, or zero for unlimited throughput.
+     */
+    uint64_t bytes_per_second = 0;
+
+    /**
+     * @brief The maximum amount of pages written in a single batch.
+     */
+    size_t batch_size = 64;
+};
+
+/**
+ * @brief A point-in-time copy of the metrics collected by a @c Checkpointer.
+ */
+struct CheckpointMetrics {
+
+    /**
+     * @brief The amount of completed checkpoints.
+     */
+    uint64_t checkpoints;
+
+    /**
+     * @brief The amount of checkpoints that failed with an error.
+     */
+    uint64_t failed_checkpoints;
+
+    /**
+     * @brief The total amount of pages written by all checkpoints.
+     */
+    uint64_t pages_written;
+
+    /**
+     * @brief The total amount of bytes written by all checkpoints.
+     */
+    uint64_t bytes_written;
+
+    /**
+     * @brief The duration of the last completed checkpoint.
+     */
+    std::chrono::nanoseconds last_duration;
+
+    /**
+     * @brief The total duration of all completed checkpoints.
+     */
+    std::chrono::nanoseconds total_duration;
+
+    /**
+     * @brief The LSN recorded by the last completed checkpoint.
+     */
+    Lsn checkpoint_lsn;
+};
+
+/**
+ * @brief Periodically writes the dirty pages of a @c BufferPool in the background, and recycles the part of the
+ * @c WriteAheadLog that is no longer required for recovery.
+ * @details Checkpoints are fuzzy: pages are written in batches while writers continue to modify them. Each page is
+ * only latched while it is being copied. When all pages that were dirty at the start of the checkpoint have been
+ * written, the checkpoint LSN is the smaller of the LSN at the start of the checkpoint and the recovery LSN of all
+ * pages that have been dirtied again since. All records preceding the checkpoint LSN can then be recycled.
+ */
+class Checkpointer {
+ private:
+
+    /**
+     * The pool containing the pages to write.
+     */
+    std::shared_ptr<BufferPool> pool;
+
+    /**
+     * The log to record checkpoints in.
+     */
+    std::shared_ptr<WriteAheadLog> log;
+
+    /**
+     * The time between two background checkpoints.
+     */
+    const std::chrono::milliseconds interval;
+
+    /**
+     * The maximum amount of pages written in a single batch.
+     */
+    const size_t batch_size;
+
+    /**
+     * Limits the throughput of page writes.
+     */
+    RateLimiter limiter;
+
+    /**
+     * Serializes checkpoints.
+     */
+    std::mutex checkpoint_mutex;
+
+    /**
+     * Protects @c stopping and is used to wake up the background thread.
+     */
+    std::mutex state_mutex;
+
+    /**
+     * Signals the background thread to stop.
+     */
+    std::condition_variable state_changed;
+
+    /**
+     * Whether the background thread must stop.
+     */
+    bool stopping;
+
+    /**
+     * The background thread, if it has been started.
+     */
+    std::thread worker;
+
+    /**
+     * The counters backing the @c CheckpointMetrics.
+     */
+    std::atomic<uint64_t> checkpoints;
+    std::atomic<uint64_t> failed_checkpoints;
+    std::atomic<uint64_t> pages_written;
+    std::atomic<uint64_t> bytes_written;
+    std::atomic<int64_t> last_duration_ns;
+    std::atomic<int64_t> total_duration_ns;
+    std::atomic<Lsn> checkpoint_lsn;
+
+    /**
+     * @brief Executes checkpoints every @c interval until stopped.
+     */
+    void Run();
+
+ public:
+
+    /**
+     * @brief Creates a new @c Checkpointer. Background checkpoints do not start before @c Start is called.
+     *
+     * @param pool The pool containing the pages to write.
+     * @param log The log to record checkpoints in. This must be the same log that is used by @p pool.
+     * @param options The checkpointer configuration.
+     */
+    Checkpointer(std::shared_ptr<BufferPool> pool, std::shared_ptr<WriteAheadLog> log,
+                 CheckpointerOptions options = {});
+    Checkpointer()= delete;
+    Checkpointer(Checkpointer const&)= delete;
+    Checkpointer(Checkpointer &&)= delete;
+    ~Checkpointer();
+
+    Checkpointer& operator=(Checkpointer const&)= delete;
+    Checkpointer& operator=(Checkpointer &&)= delete;
+
+    /**
+     * @brief Starts executing checkpoints in the background. Does nothing if already started.
+     */
+    void Start();
+
+    /**
+     * @brief Stops executing checkpoints in the background, waiting for a running checkpoint to complete.
+     */
+    void Stop();
+
+    /**
+     * @brief Executes a single checkpoint on the calling thread.
+     *
+     * @return The checkpoint LSN.
+     * @throws std::system_error If pages cannot be written or the checkpoint cannot be recorded.
+     */
+    Lsn Checkpoint();
+
+    /**
+     * @brief Changes the maximum throughput of page writes.
+     *
+     * @param bytes_per_second The maximum amount of page bytes written per second, or zero for unlimited throughput.
+     */
+    void SetBytesPerSecond(uint64_t bytes_per_second);
+
+    /**
+     * @return A copy of the current metrics.
+     */
+    CheckpointMetrics Metrics();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_CHECKPOINTER_H_
@@ -0,0 +1,21 @@
+#include "Codec.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "LzCodec.h"
+
+namespace noid::storage {
+
+const Codec &GetCodec(CodecType type) {
+  static const LzCodec lz;
+
+  switch (type) {
+    case CodecType::Lz:
+      return lz;
+    default:
+      throw std::invalid_argument("Unknown codec type " + std::to_string(static_cast<int>(type)) + ".");
+  }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef NOID_SRC_STORAGE_CODEC_H_
+#define NOID_SRC_STORAGE_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief Describes the available implementations of @c Codec. The numeric values are stored on disk.
+ */
+enum class CodecType : uint8_t {
+
+    /**
+     * Data is stored uncompressed.
+     */
+    None = 0,
+
+    /**
+     * Data is compressed using @c LzCodec.
+     */
+    Lz = 1,
+};
+
+/**
+ * @brief Interface for classes which compress and decompress blocks of data.
+ */
+class Codec {
+ public:
+    virtual ~Codec()= default;
+
+    /**
+     * @return The type of this codec.
+     */
+    [[nodiscard]] virtual CodecType Type() const = 0;
+
+    /**
+     * @brief Compresses the given data into @p destination.
+     *
+     * @param source The data to compress.
+     * @param size The size of the data in bytes.
+     * @param destination The buffer to write the compressed data to.
+     * @param capacity The size of @p destination in bytes.
+     * @return The size of the compressed data in bytes, or zero if it does not fit in @p capacity bytes.
+     */
+    virtual size_t Compress(const byte* source, size_t size, byte* destination, size_t capacity) const = 0;
+
+    /**
+     * @brief Decompresses the given data into @p destination.
+     *
+     * @param source The compressed data.
+     * @param size The size of the compressed data in bytes.
+     * @param destination The buffer to write the decompressed data to.
+     * @param decompressed_size The size of the decompressed data in bytes.
+     * @throws std::runtime_error If the compressed data is corrupt, or does not decompress to exactly
+     * @p decompressed_size bytes.
+     */
+    virtual void Decompress(const byte* source, size_t size, byte* destination, size_t decompressed_size) const = 0;
+};
+
+/**
+ * @brief Looks up the codec implementing the given type.
+ *
+ * @param type The codec type.
+ * @return The codec, which lives for the duration of the program.
+ * @throws std::invalid_argument If @p type is @c CodecType::None or unknown.
+ */
+const Codec& GetCodec(CodecType type);
+
+}
+
+#endif //NOID_SRC_STORAGE_CODEC_H_
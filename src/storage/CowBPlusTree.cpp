@@ -0,0 +1,1267 @@
+#include "CowBPlusTree.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+
+#include "AlignedBuffer.h"
+#include "RateLimiter.h"
+#include "SequentialFile.h"
+
+namespace noid::storage {
+
+/**
+ * Identifies a meta page of a copy-on-write tree.
+ */
+static const uint64_t META_MAGIC = 0x6e6f6964636f7731;
+
+/**
+ * The amount of pages following page 0 which are reserved for the meta pages.
+ */
+static const PageId META_PAGE_COUNT = 2;
+
+/**
+ * The offsets of the meta page fields.
+ */
+static const size_t META_MAGIC_OFFSET = PAGE_HEADER_SIZE;
+static const size_t META_VERSION_OFFSET = META_MAGIC_OFFSET + sizeof(uint64_t);
+static const size_t META_ROOT_OFFSET = META_VERSION_OFFSET + sizeof(uint64_t);
+static const size_t META_RECORD_COUNT_OFFSET = META_ROOT_OFFSET + sizeof(PageId);
+static const size_t META_TIMESTAMP_OFFSET = META_RECORD_COUNT_OFFSET + sizeof(uint64_t);
+
+/**
+ * The offsets of the overflow page fields. The first page of an extent holds the first page of the next extent and
+ * the amount of pages in its own extent. These fields are unused in the other pages of the extent.
+ */
+static const size_t OVERFLOW_NEXT_OFFSET = PAGE_HEADER_SIZE;
+static const size_t OVERFLOW_EXTENT_PAGES_OFFSET = OVERFLOW_NEXT_OFFSET + sizeof(PageId);
+static const size_t OVERFLOW_DATA_OFFSET = OVERFLOW_EXTENT_PAGES_OFFSET + sizeof(uint64_t);
+
+/**
+ * The amount of value bytes stored in an overflow page.
+ */
+static const size_t OVERFLOW_PAGE_CAPACITY = PAGE_SIZE - OVERFLOW_DATA_OFFSET;
+
+/**
+ * The maximum amount of pages in an overflow extent.
+ */
+static const PageId OVERFLOW_MAX_EXTENT_PAGES = 256;
+
+/**
+ * The initial and maximum amount of leaves read ahead by a scan.
+ */
+static const uint16_t READAHEAD_MIN_PAGES = 4;
+static const uint16_t READAHEAD_MAX_PAGES = 128;
+
+/**
+ * The amount of pages read and written at once by a backup, and the amount of pages cached while writing it.
+ */
+static const size_t BACKUP_BATCH_PAGES = 256;
+static const size_t BACKUP_POOL_CAPACITY = 16;
+
+/**
+ * @return The meta page the given version is written to. Consecutive versions alternate between both meta pages.
+ */
+static PageId MetaPage(uint64_t version) {
+  return 1 + version % META_PAGE_COUNT;
+}
+
+/**
+ * @brief Writes the fields of the given version to a meta page.
+ */
+static void EncodeMeta(const CowVersion& version, byte* page) {
+  std::memcpy(page + META_MAGIC_OFFSET, &META_MAGIC, sizeof(uint64_t));
+  std::memcpy(page + META_VERSION_OFFSET, &version.number, sizeof(uint64_t));
+  std::memcpy(page + META_ROOT_OFFSET, &version.root, sizeof(PageId));
+  std::memcpy(page + META_RECORD_COUNT_OFFSET, &version.record_count, sizeof(uint64_t));
+
+  int64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      version.timestamp.time_since_epoch()).count();
+  std::memcpy(page + META_TIMESTAMP_OFFSET, &timestamp, sizeof(int64_t));
+}
+
+/**
+ * @return Whether the given node should be merged with a sibling.
+ */
+static bool IsUnderfull(const CowNode& node) {
+  return node.EncodedSize() < PAGE_SIZE / 4;
+}
+
+/**
+ * @return The length of the value referred to by the given overflow reference.
+ */
+static uint64_t OverflowLength(const byte* reference) {
+  uint64_t length;
+  std::memcpy(&length, reference + sizeof(PageId), sizeof(uint64_t));
+
+  return length;
+}
+
+CowSnapshot::CowSnapshot(CowBPlusTree *tree, CowVersion version) : tree(tree), version(version) {}
+
+CowSnapshot::CowSnapshot(CowSnapshot &&other) noexcept : tree(other.tree), version(other.version) {
+  other.tree = nullptr;
+}
+
+CowSnapshot::~CowSnapshot() {
+  if (this->tree) {
+    this->tree->Unpin(this->version.number);
+  }
+}
+
+const CowVersion &CowSnapshot::Version() const {
+  return this->version;
+}
+
+std::optional<V> CowSnapshot::Find(const K &key) const {
+  return this->tree->FindIn(this->version.root, key);
+}
+
+bool CowSnapshot::Read(const K &key, const std::function<void(const byte *, size_t)> &consumer) const {
+  return this->tree->ReadIn(this->version.root, key, consumer);
+}
+
+void CowSnapshot::Scan(const K &from, const std::function<bool(const K &, const V &)> &consumer) const {
+  auto tree = this->tree;
+  tree->ScanIn(this->version.root, from, [tree, &consumer](const byte* page, uint16_t index) {
+    const auto [data, size] = CowNode::ValueAt(page, index);
+    auto value = tree->LoadValue({V(data, data + size), CowNode::IsOverflowAt(page, index)});
+
+    return consumer(CowNode::KeyAt(page, index), value);
+  });
+}
+
+void CowSnapshot::ScanKeys(const K &from, const std::function<bool(const K &)> &consumer) const {
+  this->tree->ScanIn(this->version.root, from, [&consumer](const byte* page, uint16_t index) {
+    return consumer(CowNode::KeyAt(page, index));
+  });
+}
+
+CowTransaction::CowTransaction(CowBPlusTree *tree, CowSnapshot &&snapshot)
+  : tree(tree), snapshot(std::move(snapshot)) {}
+
+CowTransaction::CowTransaction(CowTransaction &&other) noexcept
+  : tree(other.tree), snapshot(std::move(other.snapshot)), writes(std::move(other.writes)) {
+  other.snapshot.reset();
+}
+
+const CowSnapshot &CowTransaction::Active() const {
+  if (!this->snapshot) {
+    throw std::logic_error("Expect the transaction to be active.");
+  }
+
+  return *this->snapshot;
+}
+
+uint64_t CowTransaction::ReadVersion() const {
+  return this->Active().Version().number;
+}
+
+std::optional<V> CowTransaction::Find(const K &key) const {
+  auto& snapshot = this->Active();
+
+  auto write = this->writes.find(key);
+  if (write != this->writes.end()) {
+    return write->second;
+  }
+
+  return snapshot.Find(key);
+}
+
+void CowTransaction::Scan(const K &from, const std::function<bool(const K &, const V &)> &consumer) const {
+  auto& snapshot = this->Active();
+
+  // Merge the buffered modifications into the records of the snapshot.
+  auto write = this->writes.lower_bound(from);
+  auto stopped = false;
+  auto emit_writes_before = [&](const K* key) {
+    for (; write != this->writes.end() && (!key || write->first < *key); write++) {
+      if (write->second && !consumer(write->first, *write->second)) {
+        return false;
+      }
+    }
+
+    return true;
+  };
+
+  snapshot.Scan(from, [&](const K& key, const V& value) {
+    if (!emit_writes_before(&key)) {
+      stopped = true;
+      return false;
+    }
+
+    if (write != this->writes.end() && write->first == key) {
+      auto& modified = (write++)->second;
+      stopped = modified && !consumer(key, *modified);
+    } else {
+      stopped = !consumer(key, value);
+    }
+
+    return !stopped;
+  });
+
+  if (!stopped) {
+    emit_writes_before(nullptr);
+  }
+}
+
+void CowTransaction::Insert(const K &key, const V &value) {
+  this->Active();
+  this->writes[key] = value;
+}
+
+void CowTransaction::Remove(const K &key) {
+  this->Active();
+  this->writes[key] = std::nullopt;
+}
+
+std::optional<uint64_t> CowTransaction::Commit() {
+  auto read_version = this->ReadVersion();
+
+  std::optional<uint64_t> version;
+  try {
+    version = this->writes.empty() ? read_version : this->tree->CommitTransaction(read_version, this->writes);
+  } catch (std::logic_error&) {
+    // The transaction is left as is, so it can still be committed once the tree has no uncommitted modifications.
+    throw;
+  } catch (...) {
+    this->Abort();
+    throw;
+  }
+
+  this->Abort();
+  return version;
+}
+
+void CowTransaction::Abort() {
+  this->writes.clear();
+  this->snapshot.reset();
+}
+
+CowBPlusTree::CowBPlusTree(std::shared_ptr<PageFile> file, std::shared_ptr<BufferPool> pool,
+                           std::unique_ptr<PageAllocator> allocator, size_t overflow_threshold,
+                           const Codec* leaf_codec, std::chrono::milliseconds version_retention)
+  : file(std::move(file)), pool(std::move(pool)), allocator(std::move(allocator)),
+    overflow_threshold(std::min(overflow_threshold, COW_MAX_INLINE_VALUE_SIZE)), leaf_codec(leaf_codec),
+    version_retention(version_retention), committed({0, INVALID_PAGE_ID, 0, {}}), root(INVALID_PAGE_ID),
+    record_count(0), modified(false), reclaim_pending(false), stopping(false) {}
+
+void CowBPlusTree::ReadMeta() {
+  for (PageId meta_page = 1; meta_page <= META_PAGE_COUNT; meta_page++) {
+    try {
+      auto page = this->pool->Fetch(meta_page);
+      std::shared_lock<std::shared_mutex> latch(page.Latch());
+
+      uint64_t magic;
+      CowVersion version{};
+      std::memcpy(&magic, page.Data() + META_MAGIC_OFFSET, sizeof(uint64_t));
+      std::memcpy(&version.number, page.Data() + META_VERSION_OFFSET, sizeof(uint64_t));
+      std::memcpy(&version.root, page.Data() + META_ROOT_OFFSET, sizeof(PageId));
+      std::memcpy(&version.record_count, page.Data() + META_RECORD_COUNT_OFFSET, sizeof(uint64_t));
+
+      int64_t timestamp;
+      std::memcpy(&timestamp, page.Data() + META_TIMESTAMP_OFFSET, sizeof(int64_t));
+      version.timestamp = std::chrono::system_clock::time_point(
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(timestamp)));
+
+      if (magic == META_MAGIC && version.number >= this->committed.number) {
+        this->committed = version;
+      }
+    } catch (std::runtime_error&) {
+      // A meta page that was torn while being written is corrupt. The other one is intact.
+    }
+  }
+
+  this->root = this->committed.root;
+  this->record_count = this->committed.record_count;
+}
+
+CowNode CowBPlusTree::Load(PageId page_id) {
+  auto page = this->pool->Fetch(page_id);
+  std::shared_lock<std::shared_mutex> latch(page.Latch());
+
+  return CowNode::Decode(page.Data());
+}
+
+bool CowBPlusTree::Encode(const CowNode &node, byte *image) const {
+  if (node.Fits()) {
+    node.Encode(image);
+    return true;
+  }
+
+  return node.leaf && this->leaf_codec && node.EncodeCompressed(*this->leaf_codec, image);
+}
+
+PageId CowBPlusTree::Place(const byte *image, PageId page_id, PageId hint) {
+  if (page_id == INVALID_PAGE_ID || this->transaction_pages.count(page_id) == 0) {
+    auto new_page_id = this->allocator->Allocate(hint);
+    this->transaction_pages.insert(new_page_id);
+
+    if (page_id != INVALID_PAGE_ID) {
+      this->Retire(page_id);
+    }
+
+    page_id = new_page_id;
+  }
+
+  auto page = this->pool->FetchNew(page_id);
+  std::unique_lock<std::shared_mutex> latch(page.Latch());
+  std::copy(image + PAGE_HEADER_SIZE, image + PAGE_SIZE, page.MutableData() + PAGE_HEADER_SIZE);
+  page.MarkDirty();
+
+  return page_id;
+}
+
+CowBPlusTree::InsertResult CowBPlusTree::Store(CowNode &&node, PageId page_id, PageId hint) {
+  byte image[PAGE_SIZE];
+  if (this->Encode(node, image)) {
+    return {this->Place(image, page_id, hint), {}};
+  }
+
+  // A single split suffices for uncompressed nodes, but the parts of a compressed leaf may compress worse.
+  auto [separator, right] = node.Split();
+  auto result = this->Store(std::move(node), page_id, hint);
+  auto right_result = this->Store(std::move(right), INVALID_PAGE_ID, result.page);
+
+  result.splits.emplace_back(separator, right_result.page);
+  result.splits.insert(result.splits.end(), right_result.splits.begin(), right_result.splits.end());
+
+  return result;
+}
+
+PageId CowBPlusTree::Grow(InsertResult &&result) {
+  while (!result.splits.empty()) {
+    CowNode new_root;
+    new_root.leaf = false;
+    new_root.children.push_back(result.page);
+    for (auto& [separator, page_id] : result.splits) {
+      new_root.keys.push_back(separator);
+      new_root.children.push_back(page_id);
+    }
+
+    auto hint = result.page;
+    result = this->Store(std::move(new_root), INVALID_PAGE_ID, hint);
+  }
+
+  return result.page;
+}
+
+void CowBPlusTree::Retire(PageId page_id) {
+  if (this->transaction_pages.erase(page_id) > 0) {
+    this->allocator->Free(page_id);
+  } else {
+    this->transaction_frees.push_back(page_id);
+  }
+}
+
+CowValue CowBPlusTree::StoreValue(const V &value) {
+  if (value.size() <= this->overflow_threshold) {
+    return {value, false};
+  }
+
+  // Allocate all extents first, so the first page of each extent can refer to the next one.
+  auto remaining_pages = static_cast<PageId>((value.size() + OVERFLOW_PAGE_CAPACITY - 1) / OVERFLOW_PAGE_CAPACITY);
+  std::vector<std::pair<PageId, PageId>> extents;
+  while (remaining_pages > 0) {
+    auto count = std::min(remaining_pages, OVERFLOW_MAX_EXTENT_PAGES);
+    auto hint = extents.empty() ? INVALID_PAGE_ID : extents.back().first + extents.back().second;
+    auto first = this->allocator->AllocateExtent(count, hint);
+    for (auto page_id = first; page_id < first + count; page_id++) {
+      this->transaction_pages.insert(page_id);
+    }
+
+    extents.emplace_back(first, count);
+    remaining_pages -= count;
+  }
+
+  size_t offset = 0;
+  for (size_t e = 0; e < extents.size(); e++) {
+    auto [first, count] = extents[e];
+    auto next = e + 1 < extents.size() ? extents[e + 1].first : INVALID_PAGE_ID;
+    uint64_t extent_pages = count;
+
+    for (auto page_id = first; page_id < first + count; page_id++) {
+      auto page = this->pool->FetchNew(page_id);
+      std::unique_lock<std::shared_mutex> latch(page.Latch());
+
+      if (page_id == first) {
+        std::memcpy(page.MutableData() + OVERFLOW_NEXT_OFFSET, &next, sizeof(PageId));
+        std::memcpy(page.MutableData() + OVERFLOW_EXTENT_PAGES_OFFSET, &extent_pages, sizeof(uint64_t));
+      }
+
+      auto size = std::min(OVERFLOW_PAGE_CAPACITY, value.size() - offset);
+      std::copy(value.begin() + static_cast<int64_t>(offset), value.begin() + static_cast<int64_t>(offset + size),
+                page.MutableData() + OVERFLOW_DATA_OFFSET);
+      page.MarkDirty();
+      offset += size;
+    }
+  }
+
+  uint64_t length = value.size();
+  V reference(COW_OVERFLOW_REFERENCE_SIZE);
+  std::memcpy(reference.data(), &extents.front().first, sizeof(PageId));
+  std::memcpy(reference.data() + sizeof(PageId), &length, sizeof(uint64_t));
+
+  return {std::move(reference), true};
+}
+
+void CowBPlusTree::RetireValue(const CowValue &value) {
+  if (!value.overflow) {
+    return;
+  }
+
+  PageId first;
+  std::memcpy(&first, value.data.data(), sizeof(PageId));
+
+  while (first != INVALID_PAGE_ID) {
+    PageId next;
+    uint64_t extent_pages;
+    {
+      auto page = this->pool->Fetch(first);
+      std::shared_lock<std::shared_mutex> latch(page.Latch());
+      std::memcpy(&next, page.Data() + OVERFLOW_NEXT_OFFSET, sizeof(PageId));
+      std::memcpy(&extent_pages, page.Data() + OVERFLOW_EXTENT_PAGES_OFFSET, sizeof(uint64_t));
+    }
+
+    for (auto page_id = first; page_id < first + extent_pages; page_id++) {
+      this->Retire(page_id);
+    }
+    first = next;
+  }
+}
+
+void CowBPlusTree::ReadOverflow(const byte *reference, const std::function<void(const byte *, size_t)> &consumer) {
+  PageId first;
+  std::memcpy(&first, reference, sizeof(PageId));
+  auto remaining = OverflowLength(reference);
+
+  while (remaining > 0) {
+    PageId next = INVALID_PAGE_ID;
+    uint64_t extent_pages = 1;
+
+    for (PageId i = 0; i < extent_pages && remaining > 0; i++) {
+      auto page = this->pool->Fetch(first + i);
+      std::shared_lock<std::shared_mutex> latch(page.Latch());
+
+      if (i == 0) {
+        std::memcpy(&next, page.Data() + OVERFLOW_NEXT_OFFSET, sizeof(PageId));
+        std::memcpy(&extent_pages, page.Data() + OVERFLOW_EXTENT_PAGES_OFFSET, sizeof(uint64_t));
+      }
+
+      auto size = std::min<uint64_t>(OVERFLOW_PAGE_CAPACITY, remaining);
+      consumer(page.Data() + OVERFLOW_DATA_OFFSET, size);
+      remaining -= size;
+    }
+
+    first = next;
+  }
+}
+
+V CowBPlusTree::LoadValue(const CowValue &value) {
+  if (!value.overflow) {
+    return value.data;
+  }
+
+  V result;
+  result.reserve(OverflowLength(value.data.data()));
+  this->ReadOverflow(value.data.data(), [&result](const byte* data, size_t size) {
+    result.insert(result.end(), data, data + size);
+  });
+
+  return result;
+}
+
+CowBPlusTree::InsertResult CowBPlusTree::InsertInto(PageId page_id, const K &key, const CowValue &value,
+                                                    InsertType &type) {
+  auto node = this->Load(page_id);
+
+  if (node.leaf) {
+    auto position = std::lower_bound(node.keys.begin(), node.keys.end(), key);
+    auto index = position - node.keys.begin();
+
+    if (position != node.keys.end() && *position == key) {
+      this->RetireValue(node.values[index]);
+      node.values[index] = value;
+      type = InsertType::Upsert;
+    } else {
+      node.keys.insert(position, key);
+      node.values.insert(node.values.begin() + index, value);
+      type = InsertType::Insert;
+    }
+  } else {
+    auto index = std::upper_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin();
+    auto result = this->InsertInto(node.children[index], key, value, type);
+
+    node.children[index] = result.page;
+    for (size_t i = 0; i < result.splits.size(); i++) {
+      node.keys.insert(node.keys.begin() + index + static_cast<int64_t>(i), result.splits[i].first);
+      node.children.insert(node.children.begin() + index + static_cast<int64_t>(i) + 1, result.splits[i].second);
+    }
+  }
+
+  return this->Store(std::move(node), page_id, page_id);
+}
+
+CowBPlusTree::RemoveResult CowBPlusTree::RemoveFrom(PageId page_id, const K &key,
+                                                    std::optional<CowValue> &removed) {
+  auto node = this->Load(page_id);
+
+  if (node.leaf) {
+    auto position = std::lower_bound(node.keys.begin(), node.keys.end(), key);
+    if (position == node.keys.end() || *position != key) {
+      return {page_id, {}, false};
+    }
+
+    auto index = position - node.keys.begin();
+    removed = std::move(node.values[index]);
+    node.keys.erase(position);
+    node.values.erase(node.values.begin() + index);
+  } else {
+    auto index = std::upper_bound(node.keys.begin(), node.keys.end(), key) - node.keys.begin();
+    auto result = this->RemoveFrom(node.children[index], key, removed);
+    if (!removed) {
+      return {page_id, {}, false};
+    }
+
+    if (result.page == INVALID_PAGE_ID) {
+      node.children.erase(node.children.begin() + index);
+      if (!node.keys.empty()) {
+        node.keys.erase(node.keys.begin() + (index > 0 ? index - 1 : 0));
+      }
+    } else {
+      node.children[index] = result.page;
+      for (size_t i = 0; i < result.splits.size(); i++) {
+        node.keys.insert(node.keys.begin() + index + static_cast<int64_t>(i), result.splits[i].first);
+        node.children.insert(node.children.begin() + index + static_cast<int64_t>(i) + 1, result.splits[i].second);
+      }
+
+      if (result.underfull && result.splits.empty() && node.children.size() > 1) {
+        // Merge the child with its left sibling, or with its right sibling if it is the leftmost child.
+        auto left = index > 0 ? index - 1 : index;
+        auto merged = this->Load(node.children[left]);
+        merged.Merge(node.keys[left], this->Load(node.children[left + 1]));
+
+        byte image[PAGE_SIZE];
+        if (this->Encode(merged, image)) {
+          this->Retire(node.children[left + 1]);
+          node.children[left] = this->Place(image, node.children[left], node.children[left]);
+          node.children.erase(node.children.begin() + left + 1);
+          node.keys.erase(node.keys.begin() + left);
+        }
+      }
+    }
+  }
+
+  if (node.keys.empty() && (node.leaf || node.children.empty())) {
+    this->Retire(page_id);
+    return {INVALID_PAGE_ID, {}, false};
+  }
+
+  auto underfull = IsUnderfull(node);
+  auto result = this->Store(std::move(node), page_id, page_id);
+
+  return {result.page, std::move(result.splits), underfull};
+}
+
+bool CowBPlusTree::ReadIn(PageId root_page, const K &key, const std::function<void(const byte *, size_t)> &consumer) {
+  auto page_id = root_page;
+  std::vector<byte> buffer;
+
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = this->pool->Fetch(page_id);
+    std::shared_lock<std::shared_mutex> latch(page.Latch());
+
+    if (!CowNode::IsLeaf(page.Data())) {
+      page_id = CowNode::FindChild(page.Data(), key).second;
+      continue;
+    }
+
+    auto leaf = CowNode::Inflate(page.Data(), buffer);
+    auto index = CowNode::LowerBound(leaf, key);
+    if (index >= CowNode::KeyCount(leaf) || CowNode::KeyAt(leaf, index) != key) {
+      return false;
+    }
+
+    const auto [data, size] = CowNode::ValueAt(leaf, index);
+    if (!CowNode::IsOverflowAt(leaf, index)) {
+      consumer(data, size);
+      return true;
+    }
+
+    // Release the leaf before streaming the overflow pages.
+    byte reference[COW_OVERFLOW_REFERENCE_SIZE];
+    std::memcpy(reference, data, COW_OVERFLOW_REFERENCE_SIZE);
+    latch.unlock();
+
+    this->ReadOverflow(reference, consumer);
+    return true;
+  }
+
+  return false;
+}
+
+std::optional<V> CowBPlusTree::FindIn(PageId root_page, const K &key) {
+  V value;
+  auto found = this->ReadIn(root_page, key, [&value](const byte* data, size_t size) {
+    value.insert(value.end(), data, data + size);
+  });
+
+  return found ? std::make_optional(std::move(value)) : std::nullopt;
+}
+
+void CowBPlusTree::ScanIn(PageId root_page, const K &from,
+                          const std::function<bool(const byte *, uint16_t)> &visitor) {
+  if (root_page == INVALID_PAGE_ID) {
+    return;
+  }
+
+  // The path from the root to the current leaf, as pairs of internal pages and the index of the visited child.
+  std::vector<std::pair<PageId, uint16_t>> path;
+  std::vector<byte> buffer;
+  auto page_id = root_page;
+  auto leftmost = false;
+
+  // Once the scan moves past its first leaf, the following leaves are prefetched in the background. The children of
+  // the leaf parent up to readahead_end have been requested. If the previous request is still running when the next
+  // one is due, reading is slower than scanning, so the window grows up to the amount the pool prefetches at once.
+  std::future<size_t> readahead;
+  auto readahead_parent = INVALID_PAGE_ID;
+  uint16_t readahead_end = 0;
+  auto max_window = static_cast<uint16_t>(std::clamp<size_t>(this->pool->Capacity() / 4, 1, READAHEAD_MAX_PAGES));
+  auto window = std::min(READAHEAD_MIN_PAGES, max_window);
+
+  while (true) {
+    auto page = this->pool->Fetch(page_id);
+    std::shared_lock<std::shared_mutex> latch(page.Latch());
+
+    if (!CowNode::IsLeaf(page.Data())) {
+      auto [index, child] = leftmost ? std::pair<uint16_t, PageId>(0, CowNode::ChildAt(page.Data(), 0))
+                                     : CowNode::FindChild(page.Data(), from);
+      path.emplace_back(page_id, index);
+      page_id = child;
+      continue;
+    }
+
+    auto leaf = CowNode::Inflate(page.Data(), buffer);
+    auto count = CowNode::KeyCount(leaf);
+    for (auto i = leftmost ? 0 : CowNode::LowerBound(leaf, from); i < count; i++) {
+      if (!visitor(leaf, i)) {
+        return;
+      }
+    }
+
+    // Continue with the leftmost leaf of the next subtree.
+    page_id = INVALID_PAGE_ID;
+    auto leaf_parent = true;
+    while (!path.empty() && page_id == INVALID_PAGE_ID) {
+      auto& [parent_id, index] = path.back();
+      auto parent = this->pool->Fetch(parent_id);
+      std::shared_lock<std::shared_mutex> parent_latch(parent.Latch());
+
+      auto child_count = static_cast<uint16_t>(CowNode::KeyCount(parent.Data()) + 1);
+      if (index + 1 == child_count) {
+        path.pop_back();
+        leaf_parent = false;
+        continue;
+      }
+
+      index++;
+      page_id = CowNode::ChildAt(parent.Data(), index);
+
+      if (!leaf_parent || (parent_id == readahead_parent && readahead_end > index + window / 2)) {
+        continue;
+      }
+
+      if (readahead.valid() && readahead.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        window = std::min<uint16_t>(window * 2, max_window);
+        continue;
+      }
+
+      auto start = static_cast<uint16_t>(parent_id == readahead_parent ? std::max<uint16_t>(readahead_end, index + 1)
+                                                                        : index + 1);
+      auto end = static_cast<uint16_t>(std::min<size_t>(start + window, child_count));
+      std::vector<PageId> leaves;
+      for (auto i = start; i < end; i++) {
+        leaves.push_back(CowNode::ChildAt(parent.Data(), i));
+      }
+
+      if (!leaves.empty()) {
+        readahead = std::async(std::launch::async, [pool = this->pool, leaves = std::move(leaves)] {
+          return pool->Prefetch(leaves);
+        });
+      }
+      readahead_parent = parent_id;
+      readahead_end = end;
+    }
+
+    if (page_id == INVALID_PAGE_ID) {
+      return;
+    }
+    leftmost = true;
+  }
+}
+
+void CowBPlusTree::Unpin(uint64_t version) {
+  std::lock_guard<std::mutex> lock(this->version_mutex);
+
+  auto entry = this->readers.find(version);
+  if (--entry->second == 0) {
+    // Releasing the oldest pinned version may allow pages and key versions to be reclaimed.
+    auto oldest = entry == this->readers.begin();
+    this->readers.erase(entry);
+
+    if (oldest && this->reclaimer.joinable()) {
+      this->reclaim_pending = true;
+      this->reclaim_needed.notify_one();
+    }
+  }
+}
+
+std::chrono::system_clock::time_point CowBPlusTree::NextExpiry() const {
+  // A version is superseded by the commit of the next one.
+  auto next = std::next(this->retained.begin());
+  auto superseded = next == this->retained.end() ? this->committed.timestamp : next->second.timestamp;
+
+  return superseded + this->version_retention;
+}
+
+void CowBPlusTree::Reclaim() {
+  std::vector<PageId> reclaimable;
+  {
+    std::lock_guard<std::mutex> lock(this->version_mutex);
+
+    auto now = std::chrono::system_clock::now();
+    while (!this->retained.empty() && this->NextExpiry() <= now) {
+      this->retained.erase(this->retained.begin());
+    }
+
+    // Pages retired by version v are only part of versions preceding v.
+    auto oldest = this->readers.empty() ? this->committed.number : this->readers.begin()->first;
+    if (!this->retained.empty()) {
+      oldest = std::min(oldest, this->retained.begin()->first);
+    }
+    auto end = this->pending_frees.upper_bound(oldest);
+    for (auto entry = this->pending_frees.begin(); entry != end; entry++) {
+      reclaimable.insert(reclaimable.end(), entry->second.begin(), entry->second.end());
+    }
+
+    this->pending_frees.erase(this->pending_frees.begin(), end);
+
+    // Transactions reading version v only conflict with modifications made by later versions.
+    for (auto entry = this->key_versions.begin(); entry != this->key_versions.end();) {
+      entry = entry->second <= oldest ? this->key_versions.erase(entry) : std::next(entry);
+    }
+  }
+
+  for (auto page_id : reclaimable) {
+    this->allocator->Free(page_id);
+  }
+}
+
+void CowBPlusTree::RunReclaimer() {
+  std::unique_lock<std::mutex> lock(this->version_mutex);
+
+  while (true) {
+    auto needed = [this] { return this->reclaim_pending || this->stopping; };
+    if (this->retained.empty()) {
+      this->reclaim_needed.wait(lock, needed);
+    } else {
+      this->reclaim_needed.wait_until(lock, this->NextExpiry(), needed);
+    }
+
+    if (this->stopping) {
+      return;
+    }
+    this->reclaim_pending = false;
+
+    lock.unlock();
+    try {
+      std::lock_guard<std::mutex> writer_lock(this->writer_mutex);
+      this->Reclaim();
+    } catch (...) {
+      // The pages are reclaimed by the next commit instead.
+    }
+    lock.lock();
+  }
+}
+
+void CowBPlusTree::RollbackLocked() {
+  for (auto page_id : this->transaction_pages) {
+    this->allocator->Free(page_id);
+  }
+
+  this->transaction_pages.clear();
+  this->transaction_frees.clear();
+  this->transaction_keys.clear();
+
+  std::lock_guard<std::mutex> lock(this->version_mutex);
+  this->root = this->committed.root;
+  this->record_count = this->committed.record_count;
+  this->modified = false;
+}
+
+std::unique_ptr<CowBPlusTree> CowBPlusTree::Open(const std::filesystem::path &path,
+                                                 const CowBPlusTreeOptions &options) {
+  std::shared_ptr<PageFile> file = PageFile::Open(path, options.io_backend, options.direct_io);
+  auto pool = std::make_shared<BufferPool>(file, options.pool_capacity);
+  auto allocator = PageAllocator::Open(pool, META_PAGE_COUNT);
+
+  auto tree = std::unique_ptr<CowBPlusTree>(new CowBPlusTree(std::move(file), std::move(pool),
+                                                             std::move(allocator), options.overflow_threshold,
+                                                             options.leaf_codec == CodecType::None
+                                                             ? nullptr : &GetCodec(options.leaf_codec),
+                                                             options.version_retention));
+  tree->ReadMeta();
+
+  // Other pages are read on their first access, so opening does not depend on the size of the tree.
+  if (tree->root != INVALID_PAGE_ID) {
+    tree->pool->Prefetch({tree->root});
+  }
+
+  if (options.background_reclaim) {
+    tree->reclaimer = std::thread(&CowBPlusTree::RunReclaimer, tree.get());
+  }
+
+  if (options.warm_up_levels > 0) {
+    tree->warmer = std::thread([tree = tree.get(), levels = options.warm_up_levels] {
+      try {
+        tree->WarmUp(levels);
+      } catch (...) {
+        // Warming up is an optimization only. Pages that could not be read are read on their first access.
+      }
+    });
+  }
+
+  return tree;
+}
+
+CowBPlusTree::~CowBPlusTree() {
+  {
+    std::lock_guard<std::mutex> lock(this->version_mutex);
+    this->stopping = true;
+  }
+  this->reclaim_needed.notify_one();
+
+  // The warmer releases its snapshot when it stops, which may notify the reclaimer.
+  if (this->warmer.joinable()) {
+    this->warmer.join();
+  }
+
+  if (this->reclaimer.joinable()) {
+    this->reclaimer.join();
+  }
+
+  // Retained versions do not survive closing the tree.
+  {
+    std::lock_guard<std::mutex> lock(this->version_mutex);
+    this->retained.clear();
+  }
+
+  try {
+    std::lock_guard<std::mutex> lock(this->writer_mutex);
+    this->RollbackLocked();
+    this->Reclaim();
+    this->pool->FlushAll();
+  } catch (...) {
+    // Pages that could not be freed are leaked, just like they would be after a crash.
+  }
+}
+
+InsertType CowBPlusTree::Insert(const K &key, const V &value) {
+  std::lock_guard<std::mutex> lock(this->writer_mutex);
+  return this->InsertLocked(key, value);
+}
+
+InsertType CowBPlusTree::InsertLocked(const K &key, const V &value) {
+  auto type = InsertType::Insert;
+  auto stored = this->StoreValue(value);
+
+  if (this->root == INVALID_PAGE_ID) {
+    CowNode leaf;
+    leaf.keys.push_back(key);
+    leaf.values.push_back(std::move(stored));
+    this->root = this->Store(std::move(leaf), INVALID_PAGE_ID, INVALID_PAGE_ID).page;
+  } else {
+    this->root = this->Grow(this->InsertInto(this->root, key, stored, type));
+  }
+
+  if (type == InsertType::Insert) {
+    this->record_count++;
+  }
+  this->transaction_keys.insert(key);
+  this->modified = true;
+
+  return type;
+}
+
+std::optional<V> CowBPlusTree::Remove(const K &key) {
+  std::lock_guard<std::mutex> lock(this->writer_mutex);
+  return this->RemoveLocked(key);
+}
+
+std::optional<V> CowBPlusTree::RemoveLocked(const K &key) {
+  if (this->root == INVALID_PAGE_ID) {
+    return std::nullopt;
+  }
+
+  std::optional<CowValue> removed;
+  auto result = this->RemoveFrom(this->root, key, removed);
+  if (!removed) {
+    return std::nullopt;
+  }
+  this->root = this->Grow({result.page, std::move(result.splits)});
+
+  // Read the value before its overflow pages are retired, since pages of the current transaction are freed at once.
+  auto value = this->LoadValue(*removed);
+  this->RetireValue(*removed);
+
+  // Collapse internal roots having a single child.
+  while (this->root != INVALID_PAGE_ID) {
+    auto node = this->Load(this->root);
+    if (node.leaf || !node.keys.empty()) {
+      break;
+    }
+
+    this->Retire(this->root);
+    this->root = node.children.front();
+  }
+
+  this->record_count--;
+  this->transaction_keys.insert(key);
+  this->modified = true;
+
+  return value;
+}
+
+std::optional<V> CowBPlusTree::Find(const K &key) {
+  std::lock_guard<std::mutex> lock(this->writer_mutex);
+  return this->FindIn(this->root, key);
+}
+
+uint64_t CowBPlusTree::Commit() {
+  std::lock_guard<std::mutex> lock(this->writer_mutex);
+  return this->CommitLocked();
+}
+
+uint64_t CowBPlusTree::CommitLocked() {
+  if (!this->modified) {
+    return this->Committed().number;
+  }
+
+  auto previous = this->Committed();
+  auto version = CowVersion{previous.number + 1, this->root, this->record_count,
+                            std::max(std::chrono::system_clock::now(), previous.timestamp)};
+
+  // All pages of the new version, and the allocator state, must be durable before the meta page refers to them.
+  this->pool->FlushAll();
+  {
+    auto page = this->pool->Fetch(MetaPage(version.number));
+    std::unique_lock<std::shared_mutex> latch(page.Latch());
+    EncodeMeta(version, page.MutableData());
+    page.MarkDirty();
+  }
+  this->pool->FlushPage(MetaPage(version.number));
+  this->pool->Sync();
+
+  {
+    std::lock_guard<std::mutex> version_lock(this->version_mutex);
+    if (this->version_retention.count() > 0) {
+      this->retained.emplace(previous.number, previous);
+
+      // The reclaimer waits for the oldest retained version to expire.
+      if (this->retained.size() == 1 && this->reclaimer.joinable()) {
+        this->reclaim_pending = true;
+        this->reclaim_needed.notify_one();
+      }
+    }
+    this->committed = version;
+    if (!this->transaction_frees.empty()) {
+      auto& pending = this->pending_frees[version.number];
+      pending.insert(pending.end(), this->transaction_frees.begin(), this->transaction_frees.end());
+    }
+
+    // Transactions can only read versions which are pinned, or which begin after this one.
+    if (!this->readers.empty()) {
+      for (auto& key : this->transaction_keys) {
+        this->key_versions[key] = version.number;
+      }
+    }
+  }
+
+  this->transaction_pages.clear();
+  this->transaction_frees.clear();
+  this->transaction_keys.clear();
+  this->modified = false;
+  this->Reclaim();
+
+  return version.number;
+}
+
+void CowBPlusTree::Rollback() {
+  std::lock_guard<std::mutex> lock(this->writer_mutex);
+  this->RollbackLocked();
+}
+
+CowSnapshot CowBPlusTree::Snapshot() {
+  std::lock_guard<std::mutex> lock(this->version_mutex);
+  this->readers[this->committed.number]++;
+
+  return {this, this->committed};
+}
+
+CowSnapshot CowBPlusTree::SnapshotAsOf(std::chrono::system_clock::time_point as_of) {
+  std::lock_guard<std::mutex> lock(this->version_mutex);
+
+  auto version = this->committed;
+  if (as_of < version.timestamp) {
+    auto entry = std::find_if(this->retained.rbegin(), this->retained.rend(), [&as_of](const auto& r) {
+      return r.second.timestamp <= as_of;
+    });
+    if (entry == this->retained.rend()) {
+      throw std::invalid_argument("Cannot read a version as of a time preceding the oldest retained version.");
+    }
+
+    version = entry->second;
+  }
+
+  this->readers[version.number]++;
+  return {this, version};
+}
+
+std::optional<V> CowBPlusTree::Find(const K &key, std::chrono::system_clock::time_point as_of) {
+  return this->SnapshotAsOf(as_of).Find(key);
+}
+
+CowTransaction CowBPlusTree::Begin() {
+  return {this, this->Snapshot()};
+}
+
+std::optional<uint64_t> CowBPlusTree::CommitTransaction(uint64_t read_version,
+                                                        const std::map<K, std::optional<V>> &writes) {
+  std::lock_guard<std::mutex> lock(this->writer_mutex);
+  if (this->modified) {
+    throw std::logic_error("Expect no uncommitted modifications when committing a transaction.");
+  }
+
+  for (auto& [key, value] : writes) {
+    auto version = this->key_versions.find(key);
+    if (version != this->key_versions.end() && version->second > read_version) {
+      return std::nullopt;
+    }
+  }
+
+  try {
+    // The modifications are applied in key order, so those of the same leaf follow each other.
+    for (auto& [key, value] : writes) {
+      if (value) {
+        this->InsertLocked(key, *value);
+      } else {
+        this->RemoveLocked(key);
+      }
+    }
+
+    return this->CommitLocked();
+  } catch (...) {
+    this->RollbackLocked();
+    throw;
+  }
+}
+
+CowVersion CowBPlusTree::Committed() {
+  std::lock_guard<std::mutex> lock(this->version_mutex);
+  return this->committed;
+}
+
+size_t CowBPlusTree::RetainedVersionCount() {
+  std::lock_guard<std::mutex> lock(this->version_mutex);
+  return this->retained.size();
+}
+
+size_t CowBPlusTree::PendingPageCount() {
+  std::lock_guard<std::mutex> lock(this->version_mutex);
+
+  size_t count = 0;
+  for (auto& entry : this->pending_frees) {
+    count += entry.second.size();
+  }
+
+  return count;
+}
+
+PageId CowBPlusTree::PageCount() {
+  return this->allocator->PageCount();
+}
+
+size_t CowBPlusTree::WarmUp(size_t levels) {
+  auto snapshot = this->Snapshot();
+  auto budget = this->pool->Capacity() / 2;
+  auto batch_size = std::max<size_t>(this->pool->Capacity() / 4, 1);
+
+  std::vector<PageId> level;
+  if (snapshot.Version().root != INVALID_PAGE_ID) {
+    level.push_back(snapshot.Version().root);
+  }
+
+  size_t prefetched = 0;
+  size_t visited = 0;
+  for (size_t depth = 0; depth < levels && !level.empty() && visited + level.size() <= budget; depth++) {
+    std::vector<std::future<size_t>> batches;
+    for (size_t i = 0; i < level.size(); i += batch_size) {
+      std::vector<PageId> batch(level.begin() + i, level.begin() + std::min(i + batch_size, level.size()));
+      batches.push_back(std::async(std::launch::async, [pool = this->pool, batch = std::move(batch)] {
+        return pool->Prefetch(batch);
+      }));
+    }
+
+    for (auto& batch : batches) {
+      prefetched += batch.get();
+    }
+    visited += level.size();
+
+    {
+      std::lock_guard<std::mutex> lock(this->version_mutex);
+      if (this->stopping || depth + 1 == levels) {
+        break;
+      }
+    }
+
+    // All leaves are at the same depth, so the children of a level are either all internal nodes or all leaves.
+    std::vector<PageId> children;
+    for (auto page_id : level) {
+      auto page = this->pool->Fetch(page_id);
+      std::shared_lock<std::shared_mutex> latch(page.Latch());
+      if (CowNode::IsLeaf(page.Data())) {
+        break;
+      }
+
+      for (uint16_t i = 0; i <= CowNode::KeyCount(page.Data()); i++) {
+        children.push_back(CowNode::ChildAt(page.Data(), i));
+      }
+    }
+    level = std::move(children);
+  }
+
+  return prefetched;
+}
+
+CowVersion CowBPlusTree::Backup(const std::filesystem::path &path, uint64_t bytes_per_second) {
+  auto snapshot = this->Snapshot();
+  auto version = snapshot.Version();
+
+  auto temporary = path;
+  temporary += ".tmp";
+  std::filesystem::remove(temporary);
+
+  try {
+    std::shared_ptr<PageFile> file = PageFile::Open(temporary);
+    auto pool = std::make_shared<BufferPool>(file, BACKUP_POOL_CAPACITY);
+    auto allocator = PageAllocator::Open(pool, META_PAGE_COUNT);
+    auto limiter = bytes_per_second > 0 ? std::make_unique<RateLimiter>(bytes_per_second) : nullptr;
+    auto buffer = AllocateAligned(BACKUP_BATCH_PAGES * PAGE_SIZE);
+
+    // Copies the given pages in ascending order, and passes every copied page to the visitor.
+    auto copy = [&](std::vector<PageId> page_ids, const std::function<void(PageId, const byte*)>& visitor) {
+      std::sort(page_ids.begin(), page_ids.end());
+
+      for (size_t i = 0; i < page_ids.size(); i += BACKUP_BATCH_PAGES) {
+        std::vector<PageIo> batch;
+        for (auto j = i; j < std::min(i + BACKUP_BATCH_PAGES, page_ids.size()); j++) {
+          batch.push_back({page_ids[j], buffer.get() + (j - i) * PAGE_SIZE});
+        }
+
+        if (limiter) {
+          limiter->Acquire(batch.size() * PAGE_SIZE);
+        }
+        this->file->ReadBatch(batch);
+
+        for (auto& io : batch) {
+          if (!VerifyPage(io.buffer)) {
+            throw std::runtime_error("Cannot back up page " + std::to_string(io.page_id) + ": it is corrupt.");
+          }
+
+          allocator->Reserve(io.page_id);
+          visitor(io.page_id, io.buffer);
+        }
+        file->WriteBatch(batch);
+      }
+    };
+
+    // The nodes of a level determine the pages of the next one, and leaves refer to the first overflow pages.
+    std::vector<PageId> level;
+    if (version.root != INVALID_PAGE_ID) {
+      level.push_back(version.root);
+    }
+
+    std::vector<PageId> extents;
+    std::vector<byte> inflated;
+    while (!level.empty()) {
+      std::vector<PageId> children;
+      copy(std::move(level), [&](PageId, const byte* page) {
+        if (!CowNode::IsLeaf(page)) {
+          for (uint16_t i = 0; i <= CowNode::KeyCount(page); i++) {
+            children.push_back(CowNode::ChildAt(page, i));
+          }
+
+          return;
+        }
+
+        auto leaf = CowNode::Inflate(page, inflated);
+        for (uint16_t i = 0; i < CowNode::KeyCount(leaf); i++) {
+          if (CowNode::IsOverflowAt(leaf, i)) {
+            PageId first;
+            std::memcpy(&first, CowNode::ValueAt(leaf, i).first, sizeof(PageId));
+            extents.push_back(first);
+          }
+        }
+      });
+
+      level = std::move(children);
+    }
+
+    // The first page of an overflow extent determines the size of the extent, and the next extent of the value.
+    while (!extents.empty()) {
+      std::vector<PageId> next_extents;
+      std::vector<PageId> extent_pages;
+      copy(std::move(extents), [&](PageId page_id, const byte* page) {
+        PageId next;
+        uint64_t count;
+        std::memcpy(&next, page + OVERFLOW_NEXT_OFFSET, sizeof(PageId));
+        std::memcpy(&count, page + OVERFLOW_EXTENT_PAGES_OFFSET, sizeof(uint64_t));
+
+        for (auto extent_page = page_id + 1; extent_page < page_id + count; extent_page++) {
+          extent_pages.push_back(extent_page);
+        }
+        if (next != INVALID_PAGE_ID) {
+          next_extents.push_back(next);
+        }
+      });
+
+      copy(std::move(extent_pages), [](PageId, const byte*) {});
+      extents = std::move(next_extents);
+    }
+
+    {
+      auto page = pool->Fetch(MetaPage(version.number));
+      std::unique_lock<std::shared_mutex> latch(page.Latch());
+      EncodeMeta(version, page.MutableData());
+      page.MarkDirty();
+    }
+    pool->FlushAll();
+    pool->Sync();
+  } catch (...) {
+    std::error_code error;
+    std::filesystem::remove(temporary, error);
+    throw;
+  }
+
+  std::filesystem::rename(temporary, path);
+  SyncDirectory(path.parent_path());
+
+  return version;
+}
+
+}
\ No newline at end of file
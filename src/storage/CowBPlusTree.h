@@ -0,0 +1,824 @@
+#ifndef NOID_SRC_STORAGE_COWBPLUSTREE_H_
+#define NOID_SRC_STORAGE_COWBPLUSTREE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "BufferPool.h"
+#include "Codec.h"
+#include "CowNode.h"
+#include "IoBackend.h"
+#include "Page.h"
+#include "PageAllocator.h"
+#include "PageFile.h"
+#include "Shared.h"
+
+namespace noid::storage {
+
+class CowBPlusTree;
+
+/**
+ * @brief Configures a @c CowBPlusTree.
+ */
+struct CowBPlusTreeOptions {
+
+    /**
+     * @brief The amount of pages cached in memory.
+     */
+    size_t pool_capacity = 1024;
+
+    /**
+     * @brief The preferred backend executing page reads and writes.
+     */
+    IoBackendType io_backend = IoBackendType::Synchronous;
+
+    /**
+     * @brief Whether to prefer direct I/O over buffered I/O.
+     */
+    bool direct_io = false;
+
+    /**
+     * @brief The size in bytes above which values are stored in overflow pages instead of inline in the leaves.
+     * Values larger than @c COW_MAX_INLINE_VALUE_SIZE are always stored in overflow pages.
+     */
+    size_t overflow_threshold = 512;
+
+    /**
+     * @brief The codec compressing leaves which do not fit in a page uncompressed, or @c CodecType::None to never
+     * compress leaves.
+     */
+    CodecType leaf_codec = CodecType::None;
+
+    /**
+     * @brief Whether a background thread reclaims the pages of old versions as soon as their last snapshot is
+     * released. Otherwise, they are reclaimed by the next commit.
+     */
+    bool background_reclaim = true;
+
+    /**
+     * @brief The amount of upper tree levels which a background thread reads into the pool after opening, or zero
+     * to read every page on its first access only.
+     */
+    size_t warm_up_levels = 0;
+
+    /**
+     * @brief The time during which a version remains readable using @c CowBPlusTree::SnapshotAsOf after a newer one
+     * was committed, or zero to only retain versions that are pinned by a snapshot. The pages of retained versions
+     * are not reclaimed, so the file grows by the pages rewritten within the window. Versions are retained while the
+     * tree is open only.
+     */
+    std::chrono::milliseconds version_retention = std::chrono::milliseconds(0);
+};
+
+/**
+ * @brief A committed version of a @c CowBPlusTree.
+ */
+struct CowVersion {
+
+    /**
+     * @brief The version number, which increases by one with every commit. Version 0 is the empty tree.
+     */
+    uint64_t number;
+
+    /**
+     * @brief The root page, or @c INVALID_PAGE_ID if the tree is empty.
+     */
+    PageId root;
+
+    /**
+     * @brief The amount of records in the tree.
+     */
+    uint64_t record_count;
+
+    /**
+     * @brief The time at which the version was committed. It never precedes that of an earlier version.
+     */
+    std::chrono::system_clock::time_point timestamp;
+};
+
+/**
+ * @brief A read-only view of a committed version of a @c CowBPlusTree.
+ * @details The pages of the version are not reclaimed while the snapshot exists, so it can be read without
+ * blocking, or being blocked by, writers. A snapshot must not outlive its tree.
+ */
+class CowSnapshot {
+ private:
+    friend class CowBPlusTree;
+
+    /**
+     * The tree this snapshot belongs to, or @c nullptr if this snapshot has been moved from.
+     */
+    CowBPlusTree* tree;
+
+    /**
+     * The pinned version.
+     */
+    CowVersion version;
+
+    /**
+     * @brief Creates a new @c CowSnapshot of an already pinned version.
+     *
+     * @param tree The tree.
+     * @param version The version.
+     */
+    CowSnapshot(CowBPlusTree* tree, CowVersion version);
+
+ public:
+    CowSnapshot()= delete;
+    CowSnapshot(CowSnapshot const&)= delete;
+    CowSnapshot(CowSnapshot &&other) noexcept;
+    ~CowSnapshot();
+
+    CowSnapshot& operator=(CowSnapshot const&)= delete;
+    CowSnapshot& operator=(CowSnapshot &&other)= delete;
+
+    /**
+     * @return The pinned version.
+     */
+    [[nodiscard]] const CowVersion& Version() const;
+
+    /**
+     * @brief Looks up the value associated with the given @p key.
+     *
+     * @param key The search key.
+     * @return The value, or an empty optional if the key does not exist in this version.
+     */
+    [[nodiscard]] std::optional<V> Find(const K& key) const;
+
+    /**
+     * @brief Streams the value associated with the given @p key to @p consumer in chunks, without materializing it.
+     *
+     * @param key The search key.
+     * @param consumer The function to invoke with every consecutive chunk of the value.
+     * @return Whether the key exists in this version.
+     */
+    bool Read(const K& key, const std::function<void(const byte*, size_t)>& consumer) const;
+
+    /**
+     * @brief Invokes @p consumer for every record having a key of at least @p from, in key order, until it returns
+     * @c false.
+     *
+     * @param from The smallest key to visit.
+     * @param consumer The function to invoke with every key and value.
+     */
+    void Scan(const K& from, const std::function<bool(const K&, const V&)>& consumer) const;
+
+    /**
+     * @brief Invokes @p consumer for every key of at least @p from, in key order, until it returns @c false. Values
+     * stored in overflow pages are not read.
+     *
+     * @param from The smallest key to visit.
+     * @param consumer The function to invoke with every key.
+     */
+    void ScanKeys(const K& from, const std::function<bool(const K&)>& consumer) const;
+};
+
+/**
+ * @brief A transaction with snapshot isolation over a @c CowBPlusTree.
+ * @details The transaction reads the version that was committed when it began, and buffers its modifications until
+ * it commits. Any amount of transactions can run concurrently. A commit fails if another transaction committed a
+ * modification of the same key after this one began (first committer wins), and otherwise applies all modifications
+ * as a single new version. A transaction must not outlive its tree.
+ */
+class CowTransaction {
+ private:
+    friend class CowBPlusTree;
+
+    /**
+     * The tree this transaction belongs to.
+     */
+    CowBPlusTree* tree;
+
+    /**
+     * The version being read, or an empty optional once the transaction has ended.
+     */
+    std::optional<CowSnapshot> snapshot;
+
+    /**
+     * The buffered modifications. Removes map to an empty optional.
+     */
+    std::map<K, std::optional<V>> writes;
+
+    /**
+     * @brief Creates a new @c CowTransaction reading the given snapshot.
+     *
+     * @param tree The tree.
+     * @param snapshot The snapshot of the version the transaction reads.
+     */
+    CowTransaction(CowBPlusTree* tree, CowSnapshot&& snapshot);
+
+    /**
+     * @return The snapshot being read.
+     * @throws std::logic_error If the transaction has ended.
+     */
+    const CowSnapshot& Active() const;
+
+ public:
+    CowTransaction()= delete;
+    CowTransaction(CowTransaction const&)= delete;
+    CowTransaction(CowTransaction &&other) noexcept;
+    ~CowTransaction()= default;
+
+    CowTransaction& operator=(CowTransaction const&)= delete;
+    CowTransaction& operator=(CowTransaction &&other)= delete;
+
+    /**
+     * @return The number of the version read by this transaction.
+     * @throws std::logic_error If the transaction has ended.
+     */
+    [[nodiscard]] uint64_t ReadVersion() const;
+
+    /**
+     * @brief Looks up the value associated with the given @p key, including the modifications of this transaction.
+     *
+     * @param key The search key.
+     * @return The value, or an empty optional if no such record exists.
+     * @throws std::logic_error If the transaction has ended.
+     */
+    [[nodiscard]] std::optional<V> Find(const K& key) const;
+
+    /**
+     * @brief Invokes @p consumer for every record having a key of at least @p from, in key order, until it returns
+     * @c false. The modifications of this transaction are included.
+     *
+     * @param from The smallest key to visit.
+     * @param consumer The function to invoke with every key and value.
+     * @throws std::logic_error If the transaction has ended.
+     */
+    void Scan(const K& from, const std::function<bool(const K&, const V&)>& consumer) const;
+
+    /**
+     * @brief Associates @p value with @p key when the transaction commits, overwriting any pre-existing value.
+     *
+     * @param key The key.
+     * @param value The value.
+     * @throws std::logic_error If the transaction has ended.
+     */
+    void Insert(const K& key, const V& value);
+
+    /**
+     * @brief Removes the record having the given @p key when the transaction commits, if it exists.
+     *
+     * @param key The key to remove.
+     * @throws std::logic_error If the transaction has ended.
+     */
+    void Remove(const K& key);
+
+    /**
+     * @brief Durably applies the modifications of this transaction as a new version, unless another transaction
+     * modified one of the same keys and committed after this one began. The transaction ends in either case.
+     *
+     * @return The committed version number, or an empty optional if the transaction conflicted and was aborted.
+     * A transaction without modifications returns the version it read.
+     * @throws std::logic_error If the transaction has ended, or the tree has uncommitted modifications made through
+     * @c CowBPlusTree::Insert or @c CowBPlusTree::Remove.
+     * @throws std::system_error If the modifications cannot be written. The transaction is aborted.
+     */
+    std::optional<uint64_t> Commit();
+
+    /**
+     * @brief Discards the modifications of this transaction and releases its snapshot.
+     */
+    void Abort();
+};
+
+/**
+ * @brief A paged B+tree which never overwrites committed pages (copy-on-write).
+ * @details Modifications are applied to copies of the pages on the path from the modified leaf to the root. These
+ * copies are written to freshly allocated pages, so the previously committed version stays intact. Pages copied
+ * within the current transaction are modified in place, since they are not visible yet.
+ *
+ * @c Commit makes all modifications durable, and then atomically publishes the new root by writing it to one of two
+ * meta pages, which alternate between commits. After a crash, the meta page with the highest valid version is used,
+ * so no write-ahead log is required. Modifications that were not committed are lost.
+ *
+ * Values exceeding the overflow threshold are stored in chains of overflow page extents, so leaves only contain a
+ * reference to them. This keeps the fan-out of the tree high, and allows streaming large values using
+ * @c CowSnapshot::Read.
+ *
+ * Readers pin a committed version using @c Snapshot. Pages that are no longer part of the latest version are
+ * reclaimed once no snapshot of an older version exists. There is a single writer at a time; concurrent calls to
+ * the modifying methods are serialized. Concurrent writers use a @c CowTransaction each instead, which buffers its
+ * modifications and applies them as a whole when it commits.
+ */
+class CowBPlusTree {
+ private:
+    friend class CowSnapshot;
+    friend class CowTransaction;
+
+    /**
+     * @brief The result of inserting a record into a subtree.
+     */
+    struct InsertResult {
+
+        /**
+         * The page containing the (leftmost part of the) subtree root.
+         */
+        PageId page;
+
+        /**
+         * If the subtree root was split, the separator keys and pages of the parts to the right of @c page, in key
+         * order.
+         */
+        std::vector<std::pair<K, PageId>> splits;
+    };
+
+    /**
+     * @brief The result of removing a record from a subtree.
+     */
+    struct RemoveResult {
+
+        /**
+         * The page containing the (leftmost part of the) subtree root, or @c INVALID_PAGE_ID if the subtree became
+         * empty.
+         */
+        PageId page;
+
+        /**
+         * If the subtree root was split, which can happen if a compressed leaf compresses worse after a removal, the
+         * separator keys and pages of the parts to the right of @c page, in key order.
+         */
+        std::vector<std::pair<K, PageId>> splits;
+
+        /**
+         * Whether the subtree root should be merged with a sibling.
+         */
+        bool underfull;
+    };
+
+    /**
+     * The file containing the tree.
+     */
+    std::shared_ptr<PageFile> file;
+
+    /**
+     * The pool caching the pages of @c file.
+     */
+    std::shared_ptr<BufferPool> pool;
+
+    /**
+     * Keeps track of the free pages of @c file.
+     */
+    std::unique_ptr<PageAllocator> allocator;
+
+    /**
+     * The size in bytes above which values are stored in overflow pages.
+     */
+    const size_t overflow_threshold;
+
+    /**
+     * The codec compressing leaves, or @c nullptr if leaves are never compressed.
+     */
+    const Codec* leaf_codec;
+
+    /**
+     * Serializes writers.
+     */
+    std::mutex writer_mutex;
+
+    /**
+     * The time during which superseded versions are retained.
+     */
+    const std::chrono::milliseconds version_retention;
+
+    /**
+     * Protects @c committed, @c readers, @c retained and @c pending_frees.
+     */
+    std::mutex version_mutex;
+
+    /**
+     * The latest committed version.
+     */
+    CowVersion committed;
+
+    /**
+     * The amount of snapshots per pinned version number.
+     */
+    std::map<uint64_t, size_t> readers;
+
+    /**
+     * The superseded versions within the retention window by number. Like pinned versions, their pages are not
+     * reclaimed.
+     */
+    std::map<uint64_t, CowVersion> retained;
+
+    /**
+     * The pages that are no longer part of the tree since the version they are mapped to.
+     */
+    std::map<uint64_t, std::vector<PageId>> pending_frees;
+
+    /**
+     * The root page of the version being written.
+     */
+    PageId root;
+
+    /**
+     * The amount of records in the version being written.
+     */
+    uint64_t record_count;
+
+    /**
+     * Whether the version being written differs from the committed one.
+     */
+    bool modified;
+
+    /**
+     * The pages allocated by the current transaction. These can be modified in place.
+     */
+    std::unordered_set<PageId> transaction_pages;
+
+    /**
+     * The committed pages that are no longer part of the version being written.
+     */
+    std::vector<PageId> transaction_frees;
+
+    /**
+     * The keys modified by the current transaction.
+     */
+    std::set<K> transaction_keys;
+
+    /**
+     * The version which last modified each key, for the keys modified after the oldest pinned version. Commits of
+     * a @c CowTransaction are validated against it. Protected by @c writer_mutex.
+     */
+    std::map<K, uint64_t> key_versions;
+
+    /**
+     * Signals the reclaimer that the oldest pinned version was released, or that it must stop.
+     */
+    std::condition_variable reclaim_needed;
+
+    /**
+     * Whether the reclaimer must reclaim pages, and whether the background threads must stop. Protected by
+     * @c version_mutex.
+     */
+    bool reclaim_pending;
+    bool stopping;
+
+    /**
+     * The thread reclaiming pages in the background, if enabled.
+     */
+    std::thread reclaimer;
+
+    /**
+     * The thread reading the upper tree levels after opening, if enabled.
+     */
+    std::thread warmer;
+
+    /**
+     * @brief Creates a new @c CowBPlusTree using an opened pool and allocator.
+     *
+     * @param file The file containing the tree.
+     * @param pool The pool caching the pages of @p file.
+     * @param allocator Keeps track of the free pages of @p file.
+     * @param overflow_threshold The size in bytes above which values are stored in overflow pages.
+     * @param leaf_codec The codec compressing leaves, or @c nullptr if leaves are never compressed.
+     * @param version_retention The time during which superseded versions are retained.
+     */
+    CowBPlusTree(std::shared_ptr<PageFile> file, std::shared_ptr<BufferPool> pool,
+                 std::unique_ptr<PageAllocator> allocator, size_t overflow_threshold, const Codec* leaf_codec,
+                 std::chrono::milliseconds version_retention);
+
+    /**
+     * @brief Reads both meta pages, and uses the valid one having the highest version as the committed version.
+     */
+    void ReadMeta();
+
+    /**
+     * @brief Reads and decodes the node in the given page.
+     *
+     * @param page_id The page.
+     * @return The node.
+     */
+    CowNode Load(PageId page_id);
+
+    /**
+     * @brief Encodes the given node into a page image, compressing leaves which do not fit in a page otherwise.
+     *
+     * @param node The node to encode.
+     * @param image The page image of @c PAGE_SIZE bytes.
+     * @return Whether the node fits in a page.
+     */
+    bool Encode(const CowNode& node, byte* image) const;
+
+    /**
+     * @brief Writes the given page image to a page of the current transaction.
+     * @details If @p page_id was allocated by the current transaction, it is overwritten. Otherwise a new page is
+     * allocated, and @p page_id is retired.
+     *
+     * @param image The encoded node.
+     * @param page_id The page currently containing the node, or @c INVALID_PAGE_ID for a new node.
+     * @param hint The page close to which a new page should be allocated.
+     * @return The page containing the node.
+     */
+    PageId Place(const byte* image, PageId page_id, PageId hint);
+
+    /**
+     * @brief Writes the given node, splitting it until all parts fit in a page.
+     *
+     * @param node The node to write.
+     * @param page_id The page currently containing the node, or @c INVALID_PAGE_ID for a new node.
+     * @param hint The page close to which new pages should be allocated.
+     * @return The page(s) containing the node.
+     */
+    InsertResult Store(CowNode&& node, PageId page_id, PageId hint);
+
+    /**
+     * @brief Adds new roots on top of the given split root until the tree has a single root.
+     *
+     * @param result The result of storing the current root.
+     * @return The new root page.
+     */
+    PageId Grow(InsertResult&& result);
+
+    /**
+     * @brief Removes the given page from the version being written.
+     * @details Pages of the current transaction are freed immediately, while committed pages are freed once no
+     * snapshot can refer to them anymore.
+     *
+     * @param page_id The page.
+     */
+    void Retire(PageId page_id);
+
+    /**
+     * @brief Converts the given value into its leaf representation, writing it to overflow pages if it exceeds the
+     * overflow threshold.
+     * @details Overflow pages are allocated as extents of contiguous pages, which are chained by the first page of
+     * each extent.
+     *
+     * @param value The value.
+     * @return The value to store in a leaf.
+     */
+    CowValue StoreValue(const V& value);
+
+    /**
+     * @brief Retires the overflow pages of the given leaf value, if any.
+     *
+     * @param value The leaf value.
+     */
+    void RetireValue(const CowValue& value);
+
+    /**
+     * @brief Streams the value stored in the overflow pages referred to by @p reference to @p consumer.
+     *
+     * @param reference The overflow reference stored in a leaf.
+     * @param consumer The function to invoke with every consecutive chunk of the value.
+     */
+    void ReadOverflow(const byte* reference, const std::function<void(const byte*, size_t)>& consumer);
+
+    /**
+     * @brief Materializes the given leaf value, reading it from its overflow pages if needed.
+     */
+    V LoadValue(const CowValue& value);
+
+    /**
+     * @brief Recursively inserts a record into the subtree rooted at @p page_id.
+     */
+    InsertResult InsertInto(PageId page_id, const K& key, const CowValue& value, InsertType& type);
+
+    /**
+     * @brief Recursively removes a record from the subtree rooted at @p page_id.
+     */
+    RemoveResult RemoveFrom(PageId page_id, const K& key, std::optional<CowValue>& removed);
+
+    /**
+     * @brief Looks up a key in the tree rooted at @p root_page, and streams its value to @p consumer.
+     *
+     * @return Whether the key exists.
+     */
+    bool ReadIn(PageId root_page, const K& key, const std::function<void(const byte*, size_t)>& consumer);
+
+    /**
+     * @brief Looks up a key in the tree rooted at @p root_page.
+     */
+    std::optional<V> FindIn(PageId root_page, const K& key);
+
+    /**
+     * @brief Visits the leaf entries of the tree rooted at @p root_page in key order, starting at @p from, until
+     * @p visitor returns @c false.
+     * @details The visitor is invoked with the latched leaf page and the index of the entry within it.
+     */
+    void ScanIn(PageId root_page, const K& from, const std::function<bool(const byte*, uint16_t)>& visitor);
+
+    /**
+     * @brief Releases a snapshot of the given version.
+     *
+     * @param version The version number.
+     */
+    void Unpin(uint64_t version);
+
+    /**
+     * @brief Frees all pending pages that cannot be referred to by a snapshot or a retained version anymore, and
+     * forgets the key versions no transaction can conflict with anymore. Retained versions that expired are dropped
+     * first. The caller must hold @c writer_mutex.
+     */
+    void Reclaim();
+
+    /**
+     * @return The time at which the oldest retained version expires. The caller must hold @c version_mutex, and
+     * @c retained must not be empty.
+     */
+    std::chrono::system_clock::time_point NextExpiry() const;
+
+    /**
+     * @brief Reclaims pages whenever the oldest pinned version is released or the oldest retained version expires,
+     * until stopped.
+     */
+    void RunReclaimer();
+
+    /**
+     * @brief Inserts a record in the current transaction. The caller must hold @c writer_mutex.
+     */
+    InsertType InsertLocked(const K& key, const V& value);
+
+    /**
+     * @brief Removes a record in the current transaction. The caller must hold @c writer_mutex.
+     */
+    std::optional<V> RemoveLocked(const K& key);
+
+    /**
+     * @brief Commits the current transaction. The caller must hold @c writer_mutex.
+     */
+    uint64_t CommitLocked();
+
+    /**
+     * @brief Discards the current transaction. The caller must hold @c writer_mutex.
+     */
+    void RollbackLocked();
+
+    /**
+     * @brief Validates and applies the modifications of a @c CowTransaction.
+     *
+     * @param read_version The version the transaction read.
+     * @param writes The modifications.
+     * @return The committed version number, or an empty optional if the modifications conflict.
+     */
+    std::optional<uint64_t> CommitTransaction(uint64_t read_version, const std::map<K, std::optional<V>>& writes);
+
+ public:
+
+    /**
+     * @brief Opens the tree stored in the file at the given @p path, creating an empty tree if the file does not
+     * exist yet.
+     *
+     * @param path The location of the file.
+     * @param options The options.
+     * @return The opened tree.
+     * @throws std::system_error If the file cannot be opened.
+     * @throws std::runtime_error If the file does not contain a tree.
+     */
+    [[nodiscard]] static std::unique_ptr<CowBPlusTree> Open(const std::filesystem::path& path,
+                                                            const CowBPlusTreeOptions& options = {});
+
+    CowBPlusTree()= delete;
+    CowBPlusTree(CowBPlusTree const&)= delete;
+    CowBPlusTree(CowBPlusTree &&)= delete;
+
+    /**
+     * @brief Discards uncommitted modifications, reclaims all pending pages and flushes the allocator state.
+     */
+    ~CowBPlusTree();
+
+    CowBPlusTree& operator=(CowBPlusTree const&)= delete;
+    CowBPlusTree& operator=(CowBPlusTree &&)= delete;
+
+    /**
+     * @brief Inserts the given key/value pair into the current transaction, overwriting any pre-existing value
+     * having the same key.
+     *
+     * @param key The key.
+     * @param value The value.
+     * @return The type of insert.
+     */
+    InsertType Insert(const K& key, const V& value);
+
+    /**
+     * @brief Removes the record having the given @p key in the current transaction.
+     *
+     * @param key The key to remove.
+     * @return The associated value, or an empty optional if no such record exists.
+     */
+    std::optional<V> Remove(const K& key);
+
+    /**
+     * @brief Looks up the value associated with the given @p key, including uncommitted modifications.
+     *
+     * @param key The search key.
+     * @return The value, or an empty optional if no such record exists.
+     */
+    std::optional<V> Find(const K& key);
+
+    /**
+     * @brief Durably commits the current transaction, and publishes it as the latest version.
+     *
+     * @return The committed version number.
+     * @throws std::system_error If the modifications cannot be written.
+     */
+    uint64_t Commit();
+
+    /**
+     * @brief Discards all uncommitted modifications.
+     */
+    void Rollback();
+
+    /**
+     * @brief Pins the latest committed version.
+     *
+     * @return A snapshot of the latest committed version.
+     */
+    [[nodiscard]] CowSnapshot Snapshot();
+
+    /**
+     * @brief Pins the version that was the latest committed version at the given time.
+     * @details Reading a past version is as fast as reading the latest one: the version is a root like any other,
+     * whose pages are retained for @c CowBPlusTreeOptions::version_retention after it was superseded.
+     *
+     * @param as_of The time.
+     * @return A snapshot of the version.
+     * @throws std::invalid_argument If @p as_of precedes the commit of the oldest retained version.
+     */
+    [[nodiscard]] CowSnapshot SnapshotAsOf(std::chrono::system_clock::time_point as_of);
+
+    /**
+     * @brief Looks up the value associated with the given @p key in the version that was the latest committed
+     * version at the given time.
+     *
+     * @param key The search key.
+     * @param as_of The time.
+     * @return The value, or an empty optional if the key did not exist at that time.
+     * @throws std::invalid_argument If @p as_of precedes the commit of the oldest retained version.
+     */
+    std::optional<V> Find(const K& key, std::chrono::system_clock::time_point as_of);
+
+    /**
+     * @brief Begins a transaction reading the latest committed version.
+     *
+     * @return The transaction.
+     */
+    [[nodiscard]] CowTransaction Begin();
+
+    /**
+     * @return The latest committed version.
+     */
+    CowVersion Committed();
+
+    /**
+     * @return The amount of pages waiting to be reclaimed until older snapshots are released, or retained versions
+     * expire.
+     */
+    size_t PendingPageCount();
+
+    /**
+     * @return The amount of superseded versions that are still retained.
+     */
+    size_t RetainedVersionCount();
+
+    /**
+     * @return The amount of pages in the file.
+     */
+    PageId PageCount();
+
+    /**
+     * @brief Reads the upper levels of the latest committed version into the pool, so the first lookups do not have
+     * to wait for them.
+     * @details The pages of a level are read in parallel batches before descending to the next one. Warming up stops
+     * at the leaves, or before a level would take up more than half of the pool.
+     *
+     * @param levels The amount of levels to read, starting at the root.
+     * @return The amount of pages added to the pool.
+     */
+    size_t WarmUp(size_t levels);
+
+    /**
+     * @brief Writes a copy of the latest committed version to a new file at the given @p path, while writers
+     * continue.
+     * @details The version is pinned while it is copied, so its pages are neither modified nor reclaimed meanwhile.
+     * Only the pages of the version are copied, level by level and in ascending page order, reading them from the
+     * file in large batches so the pool used by readers and writers is left alone. The copy keeps the page ids of the
+     * original, and gets its own allocator state describing just the copied pages. It is written to a temporary file,
+     * which is moved to @p path once it is durable.
+     *
+     * @param path The location of the copy, which can be opened using @c Open.
+     * @param bytes_per_second The maximum rate at which pages are read, or zero to not limit it.
+     * @return The copied version.
+     * @throws std::system_error If a page cannot be read or written.
+     * @throws std::runtime_error If a page of the version is corrupt.
+     */
+    CowVersion Backup(const std::filesystem::path& path, uint64_t bytes_per_second = 0);
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_COWBPLUSTREE_H_
@@ -0,0 +1,278 @@
+#include "CowNode.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace noid::storage {
+
+static const byte LEAF_NODE_TYPE = 1;
+static const byte INTERNAL_NODE_TYPE = 2;
+static const byte COMPRESSED_LEAF_NODE_TYPE = 3;
+
+static const size_t TYPE_OFFSET = PAGE_HEADER_SIZE;
+static const size_t COUNT_OFFSET = PAGE_HEADER_SIZE + 2;
+
+/**
+ * The offsets of the compressed leaf fields. The compressed node follows the node header.
+ */
+static const size_t CODEC_OFFSET = PAGE_HEADER_SIZE + 1;
+static const size_t COMPRESSED_SIZE_OFFSET = PAGE_HEADER_SIZE + 2;
+static const size_t UNCOMPRESSED_SIZE_OFFSET = PAGE_HEADER_SIZE + 4;
+
+/**
+ * The size of a leaf slot: a 16-bit value offset followed by a 16-bit value length.
+ */
+static const size_t SLOT_SIZE = 2 * sizeof(uint16_t);
+
+/**
+ * The value length marking a slot as containing an overflow reference.
+ */
+static const uint16_t OVERFLOW_LENGTH = 0xffff;
+
+static size_t SlotsOffset(uint16_t count) {
+  return COW_NODE_HEADER_END + count * BTREE_KEY_SIZE;
+}
+
+bool CowNode::IsLeaf(const byte *page) {
+  return page[TYPE_OFFSET] == LEAF_NODE_TYPE || page[TYPE_OFFSET] == COMPRESSED_LEAF_NODE_TYPE;
+}
+
+bool CowNode::IsCompressed(const byte *page) {
+  return page[TYPE_OFFSET] == COMPRESSED_LEAF_NODE_TYPE;
+}
+
+const byte* CowNode::Inflate(const byte *page, std::vector<byte> &buffer) {
+  if (!IsCompressed(page)) {
+    return page;
+  }
+
+  uint16_t compressed_size;
+  uint16_t uncompressed_size;
+  std::memcpy(&compressed_size, page + COMPRESSED_SIZE_OFFSET, sizeof(uint16_t));
+  std::memcpy(&uncompressed_size, page + UNCOMPRESSED_SIZE_OFFSET, sizeof(uint16_t));
+  if (compressed_size > PAGE_SIZE - COW_NODE_HEADER_END || uncompressed_size < COW_NODE_HEADER_END) {
+    throw std::runtime_error("Cannot inflate tree node: the compressed leaf is corrupt.");
+  }
+
+  // The node header is part of the compressed data, so only the page header needs to be cleared.
+  buffer.assign(uncompressed_size, 0);
+  GetCodec(static_cast<CodecType>(page[CODEC_OFFSET])).Decompress(
+      page + COW_NODE_HEADER_END, compressed_size, buffer.data() + PAGE_HEADER_SIZE,
+      uncompressed_size - PAGE_HEADER_SIZE);
+
+  return buffer.data();
+}
+
+uint16_t CowNode::KeyCount(const byte *page) {
+  uint16_t count;
+  std::memcpy(&count, page + COUNT_OFFSET, sizeof(uint16_t));
+
+  return count;
+}
+
+K CowNode::KeyAt(const byte *page, uint16_t index) {
+  K key;
+  std::memcpy(key.data(), page + COW_NODE_HEADER_END + index * BTREE_KEY_SIZE, BTREE_KEY_SIZE);
+
+  return key;
+}
+
+uint16_t CowNode::LowerBound(const byte *page, const K &key) {
+  uint16_t low = 0;
+  uint16_t high = KeyCount(page);
+
+  while (low < high) {
+    auto middle = static_cast<uint16_t>(low + (high - low) / 2);
+    if (std::memcmp(page + COW_NODE_HEADER_END + middle * BTREE_KEY_SIZE, key.data(), BTREE_KEY_SIZE) < 0) {
+      low = static_cast<uint16_t>(middle + 1);
+    } else {
+      high = middle;
+    }
+  }
+
+  return low;
+}
+
+PageId CowNode::ChildAt(const byte *page, uint16_t index) {
+  PageId child;
+  std::memcpy(&child, page + SlotsOffset(KeyCount(page)) + index * sizeof(PageId), sizeof(PageId));
+
+  return child;
+}
+
+std::pair<uint16_t, PageId> CowNode::FindChild(const byte *page, const K &key) {
+  // Keys equal to a separator belong to its right subtree.
+  auto index = LowerBound(page, key);
+  if (index < KeyCount(page) && KeyAt(page, index) == key) {
+    index++;
+  }
+
+  return {index, ChildAt(page, index)};
+}
+
+std::pair<const byte*, size_t> CowNode::ValueAt(const byte *page, uint16_t index) {
+  uint16_t slot[2];
+  std::memcpy(slot, page + SlotsOffset(KeyCount(page)) + index * SLOT_SIZE, SLOT_SIZE);
+
+  return {page + slot[0], slot[1] == OVERFLOW_LENGTH ? COW_OVERFLOW_REFERENCE_SIZE : slot[1]};
+}
+
+bool CowNode::IsOverflowAt(const byte *page, uint16_t index) {
+  uint16_t length;
+  std::memcpy(&length, page + SlotsOffset(KeyCount(page)) + index * SLOT_SIZE + sizeof(uint16_t), sizeof(uint16_t));
+
+  return length == OVERFLOW_LENGTH;
+}
+
+CowNode CowNode::Decode(const byte *page) {
+  std::vector<byte> buffer;
+  page = Inflate(page, buffer);
+
+  if (page[TYPE_OFFSET] != LEAF_NODE_TYPE && page[TYPE_OFFSET] != INTERNAL_NODE_TYPE) {
+    throw std::runtime_error("Cannot decode tree node: the page does not contain a node.");
+  }
+
+  CowNode node;
+  node.leaf = IsLeaf(page);
+
+  auto count = KeyCount(page);
+  node.keys.resize(count);
+  for (uint16_t i = 0; i < count; i++) {
+    node.keys[i] = KeyAt(page, i);
+  }
+
+  if (node.leaf) {
+    node.values.reserve(count);
+    for (uint16_t i = 0; i < count; i++) {
+      const auto [data, size] = ValueAt(page, i);
+      node.values.push_back({V(data, data + size), IsOverflowAt(page, i)});
+    }
+  } else {
+    node.children.resize(count + 1);
+    std::memcpy(node.children.data(), page + SlotsOffset(count), (count + 1) * sizeof(PageId));
+  }
+
+  return node;
+}
+
+size_t CowNode::EncodedSize() const {
+  if (!this->leaf) {
+    return SlotsOffset(static_cast<uint16_t>(this->keys.size())) + this->children.size() * sizeof(PageId);
+  }
+
+  auto size = SlotsOffset(static_cast<uint16_t>(this->keys.size())) + this->keys.size() * SLOT_SIZE;
+  for (auto& value : this->values) {
+    size += value.data.size();
+  }
+
+  return size;
+}
+
+bool CowNode::Fits() const {
+  return this->EncodedSize() <= PAGE_SIZE;
+}
+
+void CowNode::Encode(byte *page) const {
+  auto count = static_cast<uint16_t>(this->keys.size());
+
+  std::memset(page + PAGE_HEADER_SIZE, 0, PAGE_SIZE - PAGE_HEADER_SIZE);
+  page[TYPE_OFFSET] = this->leaf ? LEAF_NODE_TYPE : INTERNAL_NODE_TYPE;
+  std::memcpy(page + COUNT_OFFSET, &count, sizeof(uint16_t));
+
+  for (uint16_t i = 0; i < count; i++) {
+    std::memcpy(page + COW_NODE_HEADER_END + i * BTREE_KEY_SIZE, this->keys[i].data(), BTREE_KEY_SIZE);
+  }
+
+  if (!this->leaf) {
+    std::memcpy(page + SlotsOffset(count), this->children.data(), this->children.size() * sizeof(PageId));
+    return;
+  }
+
+  auto slots = page + SlotsOffset(count);
+  auto offset = SlotsOffset(count) + count * SLOT_SIZE;
+  for (uint16_t i = 0; i < count; i++) {
+    auto& value = this->values[i];
+    uint16_t slot[2] = {static_cast<uint16_t>(offset),
+                        value.overflow ? OVERFLOW_LENGTH : static_cast<uint16_t>(value.data.size())};
+    std::memcpy(slots + i * SLOT_SIZE, slot, SLOT_SIZE);
+    std::copy(value.data.begin(), value.data.end(), page + offset);
+
+    offset += value.data.size();
+  }
+}
+
+bool CowNode::EncodeCompressed(const Codec &codec, byte *page) const {
+  auto size = this->EncodedSize();
+  if (!this->leaf || size > COW_MAX_COMPRESSED_LEAF_SIZE) {
+    return false;
+  }
+
+  std::vector<byte> uncompressed(std::max<size_t>(size, PAGE_SIZE));
+  this->Encode(uncompressed.data());
+
+  auto compressed_size = codec.Compress(uncompressed.data() + PAGE_HEADER_SIZE, size - PAGE_HEADER_SIZE,
+                                        page + COW_NODE_HEADER_END, PAGE_SIZE - COW_NODE_HEADER_END);
+  if (compressed_size == 0) {
+    return false;
+  }
+
+  auto compressed_size16 = static_cast<uint16_t>(compressed_size);
+  auto uncompressed_size16 = static_cast<uint16_t>(size);
+  std::memset(page + PAGE_HEADER_SIZE, 0, COW_NODE_HEADER_END - PAGE_HEADER_SIZE);
+  std::memset(page + COW_NODE_HEADER_END + compressed_size, 0, PAGE_SIZE - COW_NODE_HEADER_END - compressed_size);
+  page[TYPE_OFFSET] = COMPRESSED_LEAF_NODE_TYPE;
+  page[CODEC_OFFSET] = static_cast<byte>(codec.Type());
+  std::memcpy(page + COMPRESSED_SIZE_OFFSET, &compressed_size16, sizeof(uint16_t));
+  std::memcpy(page + UNCOMPRESSED_SIZE_OFFSET, &uncompressed_size16, sizeof(uint16_t));
+
+  return true;
+}
+
+std::pair<K, CowNode> CowNode::Split() {
+  CowNode right;
+  right.leaf = this->leaf;
+
+  if (!this->leaf) {
+    auto middle = this->keys.size() / 2;
+    auto separator = this->keys[middle];
+
+    right.keys.assign(this->keys.begin() + static_cast<int64_t>(middle) + 1, this->keys.end());
+    right.children.assign(this->children.begin() + static_cast<int64_t>(middle) + 1, this->children.end());
+    this->keys.resize(middle);
+    this->children.resize(middle + 1);
+
+    return {separator, std::move(right)};
+  }
+
+  // Keep adding records to the left half until it contains half of the bytes, but leave at least one for the right.
+  auto half = (this->EncodedSize() - COW_NODE_HEADER_END) / 2;
+  size_t left_bytes = 0;
+  size_t middle = 0;
+  while (middle + 1 < this->keys.size() && left_bytes < half) {
+    left_bytes += BTREE_KEY_SIZE + SLOT_SIZE + this->values[middle].data.size();
+    middle++;
+  }
+
+  right.keys.assign(this->keys.begin() + static_cast<int64_t>(middle), this->keys.end());
+  right.values.assign(std::make_move_iterator(this->values.begin() + static_cast<int64_t>(middle)),
+                      std::make_move_iterator(this->values.end()));
+  this->keys.resize(middle);
+  this->values.resize(middle);
+
+  return {right.keys.front(), std::move(right)};
+}
+
+void CowNode::Merge(const K &separator, CowNode &&right) {
+  if (!this->leaf) {
+    this->keys.push_back(separator);
+    this->children.insert(this->children.end(), right.children.begin(), right.children.end());
+  } else {
+    this->values.insert(this->values.end(), std::make_move_iterator(right.values.begin()),
+                        std::make_move_iterator(right.values.end()));
+  }
+
+  this->keys.insert(this->keys.end(), right.keys.begin(), right.keys.end());
+}
+
+}
\ No newline at end of file
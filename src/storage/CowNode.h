@@ -0,0 +1,210 @@
+#ifndef NOID_SRC_STORAGE_COWNODE_H_
+#define NOID_SRC_STORAGE_COWNODE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "Codec.h"
+#include "Page.h"
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief The offset of the first key in a node page, following the @c PageHeader and the node header.
+ */
+const size_t COW_NODE_HEADER_END = PAGE_HEADER_SIZE + 8;
+
+/**
+ * @brief The maximum size in bytes of a value stored inline in a @c CowBPlusTree leaf. This guarantees that
+ * splitting a full leaf in two yields leaves which both fit in a page. Larger values are stored in overflow pages.
+ */
+const size_t COW_MAX_INLINE_VALUE_SIZE = 1024;
+
+/**
+ * @brief The maximum uncompressed size in bytes of a compressed leaf.
+ */
+const size_t COW_MAX_COMPRESSED_LEAF_SIZE = 4 * PAGE_SIZE;
+
+/**
+ * @brief The size in bytes of a reference to a value stored in overflow pages: the first overflow page id followed
+ * by the value length.
+ */
+const size_t COW_OVERFLOW_REFERENCE_SIZE = sizeof(PageId) + sizeof(uint64_t);
+
+/**
+ * @brief A value stored in a @c CowNode leaf.
+ */
+struct CowValue {
+
+    /**
+     * @brief The value itself, or a reference to the overflow pages containing it.
+     */
+    V data;
+
+    /**
+     * @brief Whether @c data is a reference to overflow pages.
+     */
+    bool overflow = false;
+};
+
+/**
+ * @brief The decoded contents of a node page of a @c CowBPlusTree.
+ * @details A node page starts with the @c PageHeader, followed by the node type, the amount of keys and the keys
+ * themselves. Internal nodes then contain one more child page id than they have keys. The keys of the subtree of
+ * child @c i are less than key @c i, and the keys of the subtree of child @c i+1 are at least key @c i. Leaf nodes
+ * contain a slot per key holding the offset and length of its value, followed by the values. Values stored in
+ * overflow pages are replaced by a reference, which is marked using a special length.
+ *
+ * Leaves which do not fit in a page can be stored compressed if their compressed form does. The page then contains
+ * the codec type, the compressed size and the uncompressed size, followed by the compressed node. Its uncompressed
+ * form, which has the same layout as an uncompressed page but can be larger, is obtained using @c Inflate.
+ *
+ * Pages can be searched without decoding them using the static methods.
+ */
+struct CowNode {
+
+    /**
+     * @brief Whether this node is a leaf.
+     */
+    bool leaf = true;
+
+    /**
+     * @brief The keys, in ascending order.
+     */
+    std::vector<K> keys;
+
+    /**
+     * @brief The values of a leaf, which correspond to the keys.
+     */
+    std::vector<CowValue> values;
+
+    /**
+     * @brief The child page ids of an internal node.
+     */
+    std::vector<PageId> children;
+
+    /**
+     * @brief Decodes the node stored in the given page.
+     *
+     * @param page The page contents.
+     * @return The node.
+     * @throws std::runtime_error If the page does not contain a node.
+     */
+    static CowNode Decode(const byte* page);
+
+    /**
+     * @return Whether the given page contains a leaf node. This includes compressed leaves.
+     */
+    static bool IsLeaf(const byte* page);
+
+    /**
+     * @return Whether the given page contains a compressed leaf.
+     */
+    static bool IsCompressed(const byte* page);
+
+    /**
+     * @brief Obtains the uncompressed form of the node stored in the given page, on which the other static methods
+     * can operate.
+     *
+     * @param page The page contents.
+     * @param buffer The buffer to decompress into, if the page contains a compressed leaf.
+     * @return @p page itself, or the data of @p buffer if the page contains a compressed leaf.
+     * @throws std::runtime_error If the compressed leaf is corrupt.
+     */
+    static const byte* Inflate(const byte* page, std::vector<byte>& buffer);
+
+    /**
+     * @return The amount of keys in the node stored in the given page.
+     */
+    static uint16_t KeyCount(const byte* page);
+
+    /**
+     * @return The key at @p index in the node stored in the given page.
+     */
+    static K KeyAt(const byte* page, uint16_t index);
+
+    /**
+     * @brief Determines which child of the internal node stored in the given page covers @p key.
+     *
+     * @param page The page contents.
+     * @param key The search key.
+     * @return The child index and page id.
+     */
+    static std::pair<uint16_t, PageId> FindChild(const byte* page, const K& key);
+
+    /**
+     * @return The child page id at @p index in the internal node stored in the given page.
+     */
+    static PageId ChildAt(const byte* page, uint16_t index);
+
+    /**
+     * @brief Finds the index of the first key that is at least @p key in the node stored in the given page.
+     *
+     * @param page The page contents.
+     * @param key The search key.
+     * @return The index, which equals the key count if all keys are less than @p key.
+     */
+    static uint16_t LowerBound(const byte* page, const K& key);
+
+    /**
+     * @return The value at @p index in the leaf stored in the given page, and its size. For values stored in overflow
+     * pages, this is the reference to them.
+     */
+    static std::pair<const byte*, size_t> ValueAt(const byte* page, uint16_t index);
+
+    /**
+     * @return Whether the value at @p index in the leaf stored in the given page is stored in overflow pages.
+     */
+    static bool IsOverflowAt(const byte* page, uint16_t index);
+
+    /**
+     * @return The size in bytes this node requires when encoded.
+     */
+    [[nodiscard]] size_t EncodedSize() const;
+
+    /**
+     * @return Whether this node fits in a single page.
+     */
+    [[nodiscard]] bool Fits() const;
+
+    /**
+     * @brief Encodes this node into the given page, leaving the @c PageHeader untouched.
+     *
+     * @param page The page contents.
+     */
+    void Encode(byte* page) const;
+
+    /**
+     * @brief Encodes this leaf into the given page in compressed form, leaving the @c PageHeader untouched.
+     *
+     * @param codec The codec to compress the leaf with.
+     * @param page The page contents.
+     * @return Whether the compressed leaf fits in the page. If not, the page contents are undefined.
+     */
+    bool EncodeCompressed(const Codec& codec, byte* page) const;
+
+    /**
+     * @brief Moves the upper part of this node into a new right sibling, so both fit in a page.
+     * @details Leaves are split by size, so both halves contain about as many bytes. Internal nodes are split at
+     * their middle key, which is moved up.
+     *
+     * @return The separator key to insert into the parent, and the right sibling.
+     */
+    std::pair<K, CowNode> Split();
+
+    /**
+     * @brief Appends all entries of the given right sibling to this node.
+     *
+     * @param separator The key separating both nodes in their parent. Only used for internal nodes.
+     * @param right The right sibling.
+     */
+    void Merge(const K& separator, CowNode&& right);
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_COWNODE_H_
@@ -0,0 +1,118 @@
+#include "Crc32c.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NOID_HAVE_SSE42_CRC32 1
+#include <nmmintrin.h>
+#endif
+
+namespace noid::storage {
+
+/**
+ * The reflected CRC32C polynomial.
+ */
+static const uint32_t CRC32C_POLYNOMIAL = 0x82f63b78;
+
+using Crc32cTables = std::array<std::array<uint32_t, 256>, 8>;
+
+/**
+ * @brief Computes the slice-by-8 lookup tables. Table @c k maps a byte to its contribution to the checksum when it is
+ * followed by @c k more bytes.
+ */
+static Crc32cTables MakeTables() {
+  Crc32cTables tables{};
+
+  for (uint32_t i = 0; i < 256; i++) {
+    auto crc = i;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (CRC32C_POLYNOMIAL & (0 - (crc & 1)));
+    }
+
+    tables[0][i] = crc;
+  }
+
+  for (uint32_t i = 0; i < 256; i++) {
+    for (size_t k = 1; k < 8; k++) {
+      tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xff];
+    }
+  }
+
+  return tables;
+}
+
+uint32_t Crc32cSoftware(const void *data, size_t size, uint32_t crc) {
+  static const auto tables = MakeTables();
+
+  auto p = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+
+  while (size >= 8) {
+    uint32_t low;
+    uint32_t high;
+    std::memcpy(&low, p, sizeof(uint32_t));
+    std::memcpy(&high, p + sizeof(uint32_t), sizeof(uint32_t));
+    low ^= crc;
+
+    // This assumes a little-endian host, like the rest of the on-disk formats.
+    crc = tables[7][low & 0xff] ^ tables[6][(low >> 8) & 0xff] ^ tables[5][(low >> 16) & 0xff] ^ tables[4][low >> 24] ^
+        tables[3][high & 0xff] ^ tables[2][(high >> 8) & 0xff] ^ tables[1][(high >> 16) & 0xff] ^ tables[0][high >> 24];
+
+    p += 8;
+    size -= 8;
+  }
+
+  while (size-- > 0) {
+    crc = (crc >> 8) ^ tables[0][(crc ^ *p++) & 0xff];
+  }
+
+  return ~crc;
+}
+
+#ifdef NOID_HAVE_SSE42_CRC32
+
+__attribute__((target("sse4.2")))
+static uint32_t Crc32cHardware(const void *data, size_t size, uint32_t crc) {
+  auto p = static_cast<const uint8_t*>(data);
+  uint64_t crc64 = ~crc;
+
+  while (size >= 8) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(uint64_t));
+    crc64 = _mm_crc32_u64(crc64, value);
+
+    p += 8;
+    size -= 8;
+  }
+
+  auto crc32 = static_cast<uint32_t>(crc64);
+  while (size-- > 0) {
+    crc32 = _mm_crc32_u8(crc32, *p++);
+  }
+
+  return ~crc32;
+}
+
+bool Crc32cHardwareSupported() {
+  static const bool supported = __builtin_cpu_supports("sse4.2");
+  return supported;
+}
+
+uint32_t Crc32c(const void *data, size_t size, uint32_t crc) {
+  return Crc32cHardwareSupported() ? Crc32cHardware(data, size, crc) : Crc32cSoftware(data, size, crc);
+}
+
+#else
+
+bool Crc32cHardwareSupported() {
+  return false;
+}
+
+uint32_t Crc32c(const void *data, size_t size, uint32_t crc) {
+  return Crc32cSoftware(data, size, crc);
+}
+
+#endif
+
+}
\ No newline at end of file
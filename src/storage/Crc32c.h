@@ -0,0 +1,39 @@
+#ifndef NOID_SRC_STORAGE_CRC32C_H_
+#define NOID_SRC_STORAGE_CRC32C_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace noid::storage {
+
+/**
+ * @brief Computes the CRC32C (Castagnoli) checksum of the given data.
+ * @details Uses the SSE4.2 @c crc32 instruction if the processor supports it, and a slice-by-8 table
+ * implementation otherwise. The checksum of data spanning multiple buffers is computed by passing the checksum of the
+ * preceding buffers as @p crc.
+ *
+ * @param data The data.
+ * @param size The size of the data in bytes.
+ * @param crc The checksum of the preceding data, or zero.
+ * @return The checksum.
+ */
+uint32_t Crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+/**
+ * @brief Computes the CRC32C checksum of the given data using the slice-by-8 table implementation.
+ *
+ * @param data The data.
+ * @param size The size of the data in bytes.
+ * @param crc The checksum of the preceding data, or zero.
+ * @return The checksum.
+ */
+uint32_t Crc32cSoftware(const void* data, size_t size, uint32_t crc = 0);
+
+/**
+ * @return Whether @c Crc32c uses the hardware implementation on this processor.
+ */
+bool Crc32cHardwareSupported();
+
+}
+
+#endif //NOID_SRC_STORAGE_CRC32C_H_
@@ -0,0 +1,76 @@
+#ifndef NOID_SRC_STORAGE_IOBACKEND_H_
+#define NOID_SRC_STORAGE_IOBACKEND_H_
+
+#include <vector>
+
+#include "Page.h"
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief Describes the available implementations of @c IoBackend.
+ */
+enum class IoBackendType {
+
+    /**
+     * Pages are read and written one at a time using @c pread and @c pwrite.
+     */
+    Synchronous,
+
+    /**
+     * Batches of pages are submitted through a single @c io_uring submission, and are processed concurrently by the
+     * kernel.
+     */
+    IoUring,
+};
+
+/**
+ * @brief A single page read or write.
+ */
+struct PageIo {
+
+    /**
+     * @brief The page to read or write.
+     */
+    PageId page_id;
+
+    /**
+     * @brief The buffer of @c PAGE_SIZE bytes to read into or write from.
+     */
+    byte* buffer;
+};
+
+/**
+ * @brief Interface for classes which execute page reads and writes on a file descriptor.
+ */
+class IoBackend {
+ public:
+    virtual ~IoBackend()= default;
+
+    /**
+     * @return The type of this backend.
+     */
+    [[nodiscard]] virtual IoBackendType Type() const = 0;
+
+    /**
+     * @brief Reads all given pages, and returns when all reads have completed.
+     * @details Reading a page beyond the end of the file yields a page containing only zeroes.
+     *
+     * @param batch The pages to read.
+     * @throws std::system_error If any page cannot be read.
+     */
+    virtual void Read(const std::vector<PageIo>& batch) = 0;
+
+    /**
+     * @brief Writes all given pages, and returns when all writes have completed.
+     *
+     * @param batch The pages to write.
+     * @throws std::system_error If any page cannot be written.
+     */
+    virtual void Write(const std::vector<PageIo>& batch) = 0;
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_IOBACKEND_H_
@@ -0,0 +1,328 @@
+#include "LsmStore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <shared_mutex>
+#include <stdexcept>
+#include <utility>
+
+#include "Crc32c.h"
+#include "SequentialFile.h"
+
+namespace noid::storage {
+
+/**
+ * Identifies a catalog file, which lists the trees of a store.
+ */
+static const byte CATALOG_MAGIC[8] = {'n', 'o', 'i', 'd', 'c', 't', 'l', 'g'};
+
+static const uint32_t CATALOG_VERSION = 1;
+
+/**
+ * The catalog consists of the magic, the version, the amount of trees and the id, name length and name per tree,
+ * followed by a CRC32C checksum of all preceding bytes.
+ */
+static const size_t CATALOG_HEADER_SIZE = sizeof(CATALOG_MAGIC) + sizeof(uint32_t) + sizeof(uint32_t);
+static const size_t CATALOG_ENTRY_HEADER_SIZE = sizeof(uint32_t) + sizeof(uint32_t);
+
+static std::filesystem::path CatalogPath(const std::filesystem::path& directory) {
+  return directory / "CATALOG";
+}
+
+static std::filesystem::path TreeDirectory(const std::filesystem::path& directory, uint32_t id) {
+  return directory / "trees" / std::to_string(id);
+}
+
+[[noreturn]] static void ThrowCorrupt(const std::filesystem::path& directory) {
+  throw std::runtime_error("The catalog of LSM store " + directory.string() + " is corrupt.");
+}
+
+/**
+ * @return The ids of the trees listed in the catalog of the given store by name.
+ */
+static std::map<std::string, uint32_t> ReadCatalog(const std::filesystem::path& directory) {
+  std::map<std::string, uint32_t> ids;
+  if (!std::filesystem::exists(CatalogPath(directory))) {
+    return ids;
+  }
+
+  auto reader = SequentialReader::Open(CatalogPath(directory));
+  std::vector<byte> catalog(reader->Size());
+  reader->Read(catalog.data(), catalog.size());
+
+  uint32_t version = 0;
+  uint32_t count = 0;
+  uint32_t checksum = 0;
+  if (catalog.size() >= CATALOG_HEADER_SIZE + sizeof(uint32_t)) {
+    std::memcpy(&version, catalog.data() + sizeof(CATALOG_MAGIC), sizeof(uint32_t));
+    std::memcpy(&count, catalog.data() + sizeof(CATALOG_MAGIC) + sizeof(uint32_t), sizeof(uint32_t));
+    std::memcpy(&checksum, catalog.data() + catalog.size() - sizeof(uint32_t), sizeof(uint32_t));
+  }
+
+  if (catalog.size() < CATALOG_HEADER_SIZE + sizeof(uint32_t)
+      || std::memcmp(catalog.data(), CATALOG_MAGIC, sizeof(CATALOG_MAGIC)) != 0 || version != CATALOG_VERSION
+      || Crc32c(catalog.data(), catalog.size() - sizeof(uint32_t)) != checksum) {
+    ThrowCorrupt(directory);
+  }
+
+  auto end = catalog.size() - sizeof(uint32_t);
+  auto position = CATALOG_HEADER_SIZE;
+  for (uint32_t i = 0; i < count; i++) {
+    if (end - position < CATALOG_ENTRY_HEADER_SIZE) {
+      ThrowCorrupt(directory);
+    }
+
+    uint32_t id;
+    uint32_t length;
+    std::memcpy(&id, catalog.data() + position, sizeof(uint32_t));
+    std::memcpy(&length, catalog.data() + position + sizeof(uint32_t), sizeof(uint32_t));
+    position += CATALOG_ENTRY_HEADER_SIZE;
+
+    if (end - position < length || id == 0) {
+      ThrowCorrupt(directory);
+    }
+
+    ids.emplace(std::string(reinterpret_cast<const char*>(catalog.data() + position), length), id);
+    position += length;
+  }
+
+  if (position != end) {
+    ThrowCorrupt(directory);
+  }
+
+  return ids;
+}
+
+/**
+ * @brief Atomically replaces the catalog of the given store by one listing the given trees.
+ */
+static void WriteCatalog(const std::filesystem::path& directory, const std::map<std::string, uint32_t>& ids) {
+  std::vector<byte> catalog(CATALOG_MAGIC, CATALOG_MAGIC + sizeof(CATALOG_MAGIC));
+  auto append = [&catalog](const auto& value) {
+    auto data = reinterpret_cast<const byte*>(&value);
+    catalog.insert(catalog.end(), data, data + sizeof(value));
+  };
+
+  append(CATALOG_VERSION);
+  append(static_cast<uint32_t>(ids.size()));
+  for (auto& [name, id] : ids) {
+    append(id);
+    append(static_cast<uint32_t>(name.size()));
+    catalog.insert(catalog.end(), name.begin(), name.end());
+  }
+  append(Crc32c(catalog.data(), catalog.size()));
+
+  auto path = CatalogPath(directory);
+  auto temporary_path = path;
+  temporary_path += ".tmp";
+
+  auto writer = SequentialWriter::Create(temporary_path);
+  writer->Append(catalog.data(), catalog.size());
+  writer->Close();
+
+  std::filesystem::rename(temporary_path, path);
+  SyncDirectory(directory);
+}
+
+LsmStore::LsmStore(std::filesystem::path directory, const LsmStoreOptions &options,
+                   std::shared_ptr<WriteAheadLog> log)
+  : directory(std::move(directory)), options(options), log(std::move(log)), opened(false), stopping(false) {}
+
+LsmStore::~LsmStore() {
+  {
+    std::lock_guard<std::mutex> lock(this->flusher_mutex);
+    this->stopping = true;
+  }
+  this->flusher_changed.notify_all();
+
+  if (this->flusher.joinable()) {
+    this->flusher.join();
+  }
+
+  // The background threads of a tree can call into the store, so all of them are stopped before any tree is gone.
+  for (auto& [name, tree] : this->trees) {
+    tree->Stop();
+  }
+  this->trees.clear();
+}
+
+std::unique_ptr<LsmStore> LsmStore::Open(const std::filesystem::path &directory,
+                                         const std::map<std::string, LsmTreeOptions> &trees,
+                                         const LsmStoreOptions &options) {
+  if (trees.empty()) {
+    throw std::invalid_argument("Expect an LSM store to contain at least one tree.");
+  }
+
+  std::filesystem::create_directories(directory);
+
+  // The log cannot be checkpointed without knowing the records every tree still requires.
+  auto ids = ReadCatalog(directory);
+  uint32_t next_id = 1;
+  for (auto& [name, id] : ids) {
+    if (trees.count(name) == 0) {
+      throw std::invalid_argument("Cannot open LSM store " + directory.string() + " without its tree " + name + ".");
+    }
+    next_id = std::max(next_id, id + 1);
+  }
+
+  bool created = false;
+  for (auto& [name, tree_options] : trees) {
+    if (ids.count(name) == 0) {
+      // A directory left behind by a tree whose creation was not recorded does not contain any of its data.
+      std::filesystem::remove_all(TreeDirectory(directory, next_id));
+      ids.emplace(name, next_id++);
+      created = true;
+    }
+  }
+
+  if (created) {
+    std::filesystem::create_directories(directory / "trees");
+    WriteCatalog(directory, ids);
+  }
+
+  auto store = std::unique_ptr<LsmStore>(new LsmStore(
+      directory, options, WriteAheadLog::Open(directory / "wal", options.log_segment_size)));
+
+  for (auto& [name, tree_options] : trees) {
+    // The store flushes the shared log itself.
+    auto attached_options = tree_options;
+    attached_options.log_flush_interval = std::chrono::milliseconds(0);
+
+    store->trees.emplace(name, LsmTree::Open(TreeDirectory(directory, ids[name]), attached_options, store->log,
+                                             ids[name], store.get()));
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(store->checkpoint_mutex);
+    store->opened = true;
+  }
+  store->Checkpoint();
+
+  for (auto& [name, tree] : store->trees) {
+    tree->Start();
+  }
+
+  if (options.log_flush_interval.count() > 0) {
+    store->flusher = std::thread(&LsmStore::RunFlusher, store.get());
+  }
+
+  return store;
+}
+
+LsmTree &LsmStore::Tree(const std::string &name) {
+  auto tree = this->trees.find(name);
+  if (tree == this->trees.end()) {
+    throw std::invalid_argument("LSM store " + this->directory.string() + " does not contain a tree " + name + ".");
+  }
+
+  return *tree->second;
+}
+
+void LsmStore::Write(const std::map<std::string, WriteBatch> &batches) {
+  this->Write(batches, this->options.sync_writes ? Durability::Sync : Durability::Buffered);
+}
+
+void LsmStore::Write(const std::map<std::string, WriteBatch> &batches, Durability durability) {
+  std::vector<std::pair<LsmTree*, LsmTree::PreparedBatch>> parts;
+  for (auto& [name, batch] : batches) {
+    auto& tree = this->Tree(name);
+    if (batch.Count() > 0) {
+      parts.emplace_back(&tree, tree.Prepare(batch));
+    }
+  }
+
+  if (parts.empty()) {
+    return;
+  }
+
+  // Trees are locked in the order of their ids, so concurrent writes cannot deadlock.
+  std::sort(parts.begin(), parts.end(), [](const auto& a, const auto& b) {
+    return a.first->family < b.first->family;
+  });
+
+  V record;
+  if (durability != Durability::Memory) {
+    record = LsmTree::EncodeGroup(parts);
+  }
+
+  for (auto& part : parts) {
+    part.first->Throttle();
+  }
+
+  Lsn lsn = INVALID_LSN;
+  std::vector<LsmTree*> full;
+  {
+    std::vector<std::unique_lock<std::shared_mutex>> locks;
+    for (auto& part : parts) {
+      locks.emplace_back(part.first->mutex);
+    }
+
+    if (durability != Durability::Memory) {
+      lsn = this->log->Append(record.data(), record.size());
+    }
+
+    for (auto& [tree, batch] : parts) {
+      // Unlogged modifications do not advance the LSN up to which the memtable covers the log.
+      if (tree->ApplyLocked(batch, durability == Durability::Memory ? tree->memtable_last_lsn : lsn)) {
+        full.push_back(tree);
+      }
+    }
+  }
+
+  if (durability == Durability::Sync) {
+    for (auto& part : parts) {
+      part.first->synchronous_writes++;
+    }
+    this->FlushLog(lsn);
+  }
+
+  for (auto* tree : full) {
+    tree->Flush();
+  }
+}
+
+void LsmStore::Sync() {
+  this->FlushLog(this->log->LastLsn());
+}
+
+void LsmStore::FlushLog(Lsn lsn) {
+  // The log can contain records of every tree, so the values all of them refer to must be durable first.
+  for (auto& [name, tree] : this->trees) {
+    tree->values->Sync();
+  }
+
+  this->log->Flush(lsn);
+}
+
+void LsmStore::Checkpoint() {
+  std::lock_guard<std::mutex> lock(this->checkpoint_mutex);
+  if (!this->opened) {
+    return;
+  }
+
+  // Records appended from now on are not covered by the trees queried below, so they are retained.
+  auto lsn = this->log->LastLsn() + 1;
+  for (auto& [name, tree] : this->trees) {
+    lsn = std::min(lsn, tree->RequiredLsn());
+  }
+
+  this->log->Checkpoint(lsn);
+}
+
+void LsmStore::RunFlusher() {
+  std::unique_lock<std::mutex> lock(this->flusher_mutex);
+  while (!this->flusher_changed.wait_for(lock, this->options.log_flush_interval, [this] {
+    return this->stopping;
+  })) {
+    lock.unlock();
+    try {
+      this->Sync();
+    } catch (...) {
+      // The log is flushed again after the next interval, or by the next synchronous modification.
+    }
+    lock.lock();
+  }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,199 @@
+#ifndef NOID_SRC_STORAGE_LSMSTORE_H_
+#define NOID_SRC_STORAGE_LSMSTORE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LsmTree.h"
+#include "WriteAheadLog.h"
+#include "WriteBatch.h"
+
+namespace noid::storage {
+
+/**
+ * @brief Configures an @c LsmStore. The trees of the store are configured by their own @c LsmTreeOptions, except for
+ * the log options, which are taken from here.
+ */
+struct LsmStoreOptions {
+
+    /**
+     * @brief The size in bytes of the write-ahead log segments.
+     */
+    uint64_t log_segment_size = WAL_DEFAULT_SEGMENT_SIZE;
+
+    /**
+     * @brief Whether cross-tree writes that do not specify a @c Durability are @c Durability::Sync, rather than
+     * @c Durability::Buffered.
+     */
+    bool sync_writes = true;
+
+    /**
+     * @brief The interval at which a background thread flushes the log, which bounds the time until
+     * @c Durability::Buffered modifications are durable. Zero disables the thread.
+     */
+    std::chrono::milliseconds log_flush_interval = std::chrono::milliseconds(100);
+};
+
+/**
+ * @brief A set of named @c LsmTree instances sharing a single write-ahead log.
+ * @details Every tree has its own directory, memtable, runs, value log and background threads, and therefore its
+ * own options such as the memtable order. Only the log is shared: all trees append their records to it, prefixed by
+ * the id of the tree, so that writes spanning multiple trees are logged as a single record and recovered atomically.
+ *
+ * The log is checkpointed up to the oldest record that a tree still requires, which is the first record that was
+ * not flushed to one of its runs yet. Every tree records the first LSN it requires in its manifest, since it can be
+ * older than the checkpoint of the log. A tree without any unflushed modifications does not hold the checkpoint back.
+ *
+ * The ids of the trees are recorded in a catalog, so a name always refers to the same log records. All trees of the
+ * catalog must be opened together, because the log cannot be checkpointed without knowing which records they still
+ * require.
+ *
+ * All methods can be called concurrently.
+ */
+class LsmStore {
+ private:
+
+    /**
+     * The directory containing the catalog, the log and the trees.
+     */
+    const std::filesystem::path directory;
+
+    /**
+     * The options.
+     */
+    const LsmStoreOptions options;
+
+    /**
+     * The write-ahead log shared by all trees. It is declared before @c trees, so it outlives them.
+     */
+    std::shared_ptr<WriteAheadLog> log;
+
+    /**
+     * The trees by name. The map is not modified once the store has been opened.
+     */
+    std::map<std::string, std::unique_ptr<LsmTree>> trees;
+
+    /**
+     * Serializes checkpoints, and protects @c opened.
+     */
+    std::mutex checkpoint_mutex;
+
+    /**
+     * Whether all trees have been opened, so the checkpoint can take the records they require into account.
+     */
+    bool opened;
+
+    /**
+     * Protects @c stopping.
+     */
+    std::mutex flusher_mutex;
+
+    /**
+     * Signals that the flusher must stop.
+     */
+    std::condition_variable flusher_changed;
+
+    /**
+     * Whether the flusher must stop.
+     */
+    bool stopping;
+
+    /**
+     * The thread flushing the log, if @c LsmStoreOptions::log_flush_interval is positive.
+     */
+    std::thread flusher;
+
+    /**
+     * @brief Creates a new @c LsmStore without any trees.
+     *
+     * @param directory The directory containing the catalog, the log and the trees.
+     * @param options The options.
+     * @param log The opened write-ahead log.
+     */
+    LsmStore(std::filesystem::path directory, const LsmStoreOptions& options, std::shared_ptr<WriteAheadLog> log);
+
+    /**
+     * @brief Makes the log durable up to the given @p lsn, after the values that the records of all trees refer to.
+     */
+    void FlushLog(Lsn lsn);
+
+    /**
+     * @brief Checkpoints the log up to the first record that one of the trees still requires.
+     */
+    void Checkpoint();
+
+    /**
+     * @brief Flushes the log every @c LsmStoreOptions::log_flush_interval until stopped.
+     */
+    void RunFlusher();
+
+    friend class LsmTree;
+
+ public:
+
+    /**
+     * @brief Opens the store in the given @p directory, creating it and any tree that does not exist yet.
+     *
+     * @param directory The directory.
+     * @param trees The options of every tree by name.
+     * @param options The options of the store.
+     * @return The opened store.
+     * @throws std::invalid_argument If @p trees is empty, or does not contain a tree of the store.
+     * @throws std::system_error If the directory, the catalog, the log or a tree cannot be opened.
+     * @throws std::runtime_error If the catalog, the log or a tree is corrupt.
+     */
+    [[nodiscard]] static std::unique_ptr<LsmStore> Open(const std::filesystem::path& directory,
+                                                        const std::map<std::string, LsmTreeOptions>& trees,
+                                                        const LsmStoreOptions& options = {});
+
+    LsmStore()= delete;
+    LsmStore(LsmStore const&)= delete;
+    LsmStore(LsmStore &&)= delete;
+    ~LsmStore();
+
+    LsmStore& operator=(LsmStore const&)= delete;
+    LsmStore& operator=(LsmStore &&)= delete;
+
+    /**
+     * @brief Looks up a tree of the store.
+     *
+     * @param name The name of the tree.
+     * @return The tree, which remains valid until the store is destroyed.
+     * @throws std::invalid_argument If the store does not contain a tree having the given @p name.
+     */
+    LsmTree& Tree(const std::string& name);
+
+    /**
+     * @brief Applies the given batches to the trees having their names atomically. Readers of every tree observe
+     * either none or all of its operations, and after a crash either none or all batches are recovered.
+     *
+     * @param batches The batches by tree name.
+     * @throws std::invalid_argument If the store does not contain a tree having one of the names.
+     * @throws std::system_error If the batches cannot be logged, or a memtable cannot be flushed.
+     */
+    void Write(const std::map<std::string, WriteBatch>& batches);
+
+    /**
+     * @brief Applies the given batches atomically like @c Write, with the given @p durability.
+     */
+    void Write(const std::map<std::string, WriteBatch>& batches, Durability durability);
+
+    /**
+     * @brief Makes all modifications of all trees durable.
+     *
+     * @throws std::system_error If the log cannot be written.
+     */
+    void Sync();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_LSMSTORE_H_
@@ -0,0 +1,1517 @@
+#include "LsmTree.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "Crc32c.h"
+#include "LsmStore.h"
+#include "SequentialFile.h"
+
+namespace noid::storage {
+
+/**
+ * The types of log records.
+ */
+static const byte LOG_INSERT = 0;
+static const byte LOG_REMOVE = 1;
+static const byte LOG_BATCH = 2;
+static const byte LOG_SEPARATED = 3;
+static const byte LOG_FAMILY = 4;
+static const byte LOG_FAMILY_BATCH = 5;
+
+/**
+ * The size of the header of a batch record: its type and the amount of operations. Every operation consists of its
+ * type, key, value length and value.
+ */
+static const size_t BATCH_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t);
+static const size_t BATCH_OPERATION_HEADER_SIZE = sizeof(uint8_t) + BTREE_KEY_SIZE + sizeof(uint32_t);
+
+/**
+ * The size of the header of a record of a tree in a store: its type and the id of the tree, or the amount of trees if
+ * the record spans multiple trees. Every part of the latter consists of the id of a tree, the part size and a batch
+ * record.
+ */
+static const size_t FAMILY_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t);
+static const size_t FAMILY_PART_HEADER_SIZE = sizeof(uint32_t) + sizeof(uint32_t);
+
+/**
+ * The prefixes of memtable values.
+ */
+static const byte MEMTABLE_VALUE = 0;
+static const byte MEMTABLE_TOMBSTONE = 1;
+static const byte MEMTABLE_SEPARATED = 2;
+
+static const char* RUN_EXTENSION = ".run";
+
+/**
+ * Identifies a manifest file, which lists the sorted runs of each level.
+ */
+static const byte MANIFEST_MAGIC[8] = {'n', 'o', 'i', 'd', 'm', 'f', 's', 't'};
+
+static const uint32_t MANIFEST_VERSION = 1;
+
+/**
+ * The manifest consists of the magic, the version, the next run number, the first log LSN that might not be contained
+ * in the runs, the amount of runs and a level and number per run, followed by a CRC32C checksum of all preceding
+ * bytes.
+ */
+static const size_t MANIFEST_HEADER_SIZE = sizeof(MANIFEST_MAGIC) + sizeof(uint32_t) + sizeof(uint64_t)
+    + sizeof(uint64_t) + sizeof(uint32_t);
+static const size_t MANIFEST_ENTRY_SIZE = sizeof(uint8_t) + sizeof(uint64_t);
+
+/**
+ * The amount of compaction bytes after which the rate limiter is consulted.
+ */
+static const uint64_t COMPACTION_RATE_CHUNK = 64 * 1024;
+
+/**
+ * The time a compaction thread waits after a failed compaction before trying again.
+ */
+static const std::chrono::seconds COMPACTION_RETRY_DELAY(1);
+
+/**
+ * The delay of writes while level 0 contains at least @c level0_slowdown_trigger runs.
+ */
+static const std::chrono::milliseconds SLOWDOWN_DELAY(1);
+
+/**
+ * The amount of replayed modifications whose keys determine the key ranges of the replay threads.
+ */
+static const size_t REPLAY_SAMPLE_SIZE = 4096;
+
+/**
+ * The amount of replayed modifications handed to a replay thread at once.
+ */
+static const size_t REPLAY_CHUNK_SIZE = 1024;
+
+/**
+ * @brief The modifications of a key range replayed from the log, and the memtable records they result in.
+ */
+struct ReplayPartition {
+
+    /**
+     * Protects @c queue and @c closed.
+     */
+    std::mutex mutex;
+
+    /**
+     * Signals that modifications were queued, or that the partition was closed.
+     */
+    std::condition_variable changed;
+
+    /**
+     * The modifications that were not applied yet, in log order.
+     */
+    std::vector<std::pair<K, LsmEntry>> queue;
+
+    /**
+     * Whether all modifications have been queued.
+     */
+    bool closed = false;
+
+    /**
+     * The memtable records, and the amount of bytes applied to them.
+     */
+    std::map<K, V> records;
+    size_t bytes = 0;
+};
+
+static std::filesystem::path RunDirectory(const std::filesystem::path& directory) {
+  return directory / "runs";
+}
+
+static std::filesystem::path RunPath(const std::filesystem::path& directory, uint64_t number) {
+  std::ostringstream name;
+  name << std::setw(16) << std::setfill('0') << number << RUN_EXTENSION;
+
+  return RunDirectory(directory) / name.str();
+}
+
+static std::filesystem::path ManifestPath(const std::filesystem::path& directory) {
+  return directory / "MANIFEST";
+}
+
+/**
+ * @return The run number encoded in the given run path.
+ */
+static uint64_t RunNumber(const std::filesystem::path& path) {
+  return std::stoull(path.stem().string());
+}
+
+[[noreturn]] static void ThrowTruncated(Lsn lsn) {
+  throw std::runtime_error("Cannot replay LSM tree log record " + std::to_string(lsn) + ": it is truncated.");
+}
+
+/**
+ * @brief Decodes the operations of the batch record having the given @p lsn.
+ */
+static std::vector<std::pair<K, LsmEntry>> DecodeBatch(const byte* data, size_t size, Lsn lsn) {
+  if (size < BATCH_HEADER_SIZE) {
+    ThrowTruncated(lsn);
+  }
+
+  uint32_t count;
+  std::memcpy(&count, data + sizeof(uint8_t), sizeof(uint32_t));
+
+  std::vector<std::pair<K, LsmEntry>> operations(count);
+  auto position = BATCH_HEADER_SIZE;
+  for (auto& [key, entry] : operations) {
+    if (size - position < BATCH_OPERATION_HEADER_SIZE) {
+      ThrowTruncated(lsn);
+    }
+
+    uint32_t length;
+    entry.tombstone = data[position] == LOG_REMOVE;
+    entry.separated = data[position] == LOG_SEPARATED;
+    std::memcpy(key.data(), data + position + sizeof(uint8_t), BTREE_KEY_SIZE);
+    std::memcpy(&length, data + position + sizeof(uint8_t) + BTREE_KEY_SIZE, sizeof(uint32_t));
+    position += BATCH_OPERATION_HEADER_SIZE;
+
+    if (size - position < length) {
+      ThrowTruncated(lsn);
+    }
+
+    entry.value.assign(data + position, data + position + length);
+    position += length;
+  }
+
+  return operations;
+}
+
+/**
+ * @return The type of the log record or batch operation describing the given entry.
+ */
+static byte LogType(const LsmEntry& entry) {
+  return entry.tombstone ? LOG_REMOVE : entry.separated ? LOG_SEPARATED : LOG_INSERT;
+}
+
+/**
+ * @brief Narrows the given log record down to the part belonging to the tree having the given @p family. A tree that
+ * owns its log, whose family is zero, owns all records.
+ *
+ * @return Whether the record contains a part belonging to the tree.
+ */
+static bool Unframe(uint32_t family, const byte*& data, size_t& size, Lsn lsn) {
+  if (family == 0) {
+    return true;
+  } else if (size < FAMILY_HEADER_SIZE) {
+    ThrowTruncated(lsn);
+  } else if (data[0] != LOG_FAMILY && data[0] != LOG_FAMILY_BATCH) {
+    throw std::runtime_error("Cannot replay LSM tree log record " + std::to_string(lsn)
+                                 + ": it does not belong to a tree of a store.");
+  }
+
+  uint32_t count;
+  std::memcpy(&count, data + sizeof(uint8_t), sizeof(uint32_t));
+  if (data[0] == LOG_FAMILY) {
+    data += FAMILY_HEADER_SIZE;
+    size -= FAMILY_HEADER_SIZE;
+
+    return count == family;
+  }
+
+  auto position = FAMILY_HEADER_SIZE;
+  for (uint32_t i = 0; i < count; i++) {
+    if (size - position < FAMILY_PART_HEADER_SIZE) {
+      ThrowTruncated(lsn);
+    }
+
+    uint32_t part_family;
+    uint32_t part_size;
+    std::memcpy(&part_family, data + position, sizeof(uint32_t));
+    std::memcpy(&part_size, data + position + sizeof(uint32_t), sizeof(uint32_t));
+    position += FAMILY_PART_HEADER_SIZE;
+
+    if (size - position < part_size) {
+      ThrowTruncated(lsn);
+    } else if (part_family == family) {
+      data += position;
+      size = part_size;
+      return true;
+    }
+
+    position += part_size;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Appends a batch record containing the given operations to @p record.
+ */
+static void AppendBatch(const std::vector<const std::pair<K, LsmEntry>*>& operations, V& record) {
+  auto size = BATCH_HEADER_SIZE;
+  for (auto* operation : operations) {
+    size += BATCH_OPERATION_HEADER_SIZE + operation->second.value.size();
+  }
+  record.reserve(record.size() + size);
+
+  record.push_back(LOG_BATCH);
+  auto count = static_cast<uint32_t>(operations.size());
+  record.insert(record.end(), reinterpret_cast<const byte*>(&count), reinterpret_cast<const byte*>(&count + 1));
+  for (auto* operation : operations) {
+    auto& [key, entry] = *operation;
+    auto length = static_cast<uint32_t>(entry.value.size());
+
+    record.push_back(LogType(entry));
+    record.insert(record.end(), key.begin(), key.end());
+    record.insert(record.end(), reinterpret_cast<const byte*>(&length), reinterpret_cast<const byte*>(&length + 1));
+    record.insert(record.end(), entry.value.begin(), entry.value.end());
+  }
+}
+
+/**
+ * @brief Removes the given runs from @p level.
+ */
+static void EraseRuns(std::vector<std::shared_ptr<SortedRun>>& level,
+                      const std::vector<std::shared_ptr<SortedRun>>& runs) {
+  level.erase(std::remove_if(level.begin(), level.end(), [&runs](const std::shared_ptr<SortedRun>& run) {
+    return std::find(runs.begin(), runs.end(), run) != runs.end();
+  }), level.end());
+}
+
+/**
+ * @brief Converts the given memtable value into an entry.
+ */
+static LsmEntry ToEntry(const V& value) {
+  return {value[0] == MEMTABLE_TOMBSTONE, V(value.begin() + 1, value.end()), value[0] == MEMTABLE_SEPARATED};
+}
+
+/**
+ * @brief Converts the given entry into a memtable value.
+ */
+static V ToMemtableValue(const LsmEntry& entry) {
+  V value;
+  value.reserve(1 + entry.value.size());
+  value.push_back(entry.tombstone ? MEMTABLE_TOMBSTONE : entry.separated ? MEMTABLE_SEPARATED : MEMTABLE_VALUE);
+  value.insert(value.end(), entry.value.begin(), entry.value.end());
+
+  return value;
+}
+
+/**
+ * @brief Applies the modifications queued in the given partition until it is closed.
+ */
+static void ApplyPartition(ReplayPartition& partition) {
+  std::vector<std::pair<K, LsmEntry>> modifications;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(partition.mutex);
+      partition.changed.wait(lock, [&partition] { return !partition.queue.empty() || partition.closed; });
+      if (partition.queue.empty()) {
+        return;
+      }
+
+      std::swap(modifications, partition.queue);
+    }
+
+    for (auto& [key, entry] : modifications) {
+      auto value = ToMemtableValue(entry);
+      partition.bytes += BTREE_KEY_SIZE + value.size();
+      partition.records.insert_or_assign(key, std::move(value));
+    }
+    modifications.clear();
+  }
+}
+
+/**
+ * @return Whether the given entry is a separated value stored at the given location.
+ */
+static bool PointsTo(const std::optional<LsmEntry>& entry, const ValuePointer& pointer) {
+  if (!entry || !entry->separated) {
+    return false;
+  }
+
+  auto location = ValuePointer::Decode(entry->value);
+  return location.segment == pointer.segment && location.offset == pointer.offset;
+}
+
+LsmTree::LsmTree(std::filesystem::path directory, const LsmTreeOptions &options, std::shared_ptr<WriteAheadLog> log,
+                 std::unique_ptr<ValueLog> values, uint32_t family, LsmStore *store)
+  : directory(std::move(directory)), options(options), log(std::move(log)), family(family), store(store),
+    values(std::move(values)), memtable(std::make_shared<BPlusTree>(options.memtable_order)), memtable_bytes(0),
+    memtable_last_lsn(INVALID_LSN), frozen(nullptr), frozen_last_lsn(INVALID_LSN), log_lsn(INVALID_LSN),
+    flushed_memtables(0), next_run_number(1), limiter(options.compaction_bytes_per_second), compacting(), cursors(),
+    stopping(false), stalled_writes(0), stall_time_ns(0), compactions(0), failed_compactions(0),
+    compaction_bytes_read(0), compaction_bytes_written(0), synchronous_writes(0), value_log_gc_segments(0),
+    value_log_gc_failures(0), value_log_gc_bytes_scanned(0), value_log_gc_bytes_live(0),
+    value_log_gc_bytes_relocated(0), value_log_gc_time_ns(0) {}
+
+LsmTree::~LsmTree() {
+  this->Stop();
+}
+
+void LsmTree::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(this->compaction_mutex);
+    this->stopping = true;
+  }
+  this->compaction_changed.notify_all();
+
+  for (auto& compactor : this->compactors) {
+    compactor.join();
+  }
+  this->compactors.clear();
+
+  if (this->collector.joinable()) {
+    this->collector.join();
+  }
+
+  if (this->flusher.joinable()) {
+    this->flusher.join();
+  }
+}
+
+void LsmTree::Recover() {
+  std::filesystem::create_directories(RunDirectory(this->directory));
+
+  std::set<uint64_t> live;
+  if (std::filesystem::exists(ManifestPath(this->directory))) {
+    auto reader = SequentialReader::Open(ManifestPath(this->directory));
+    std::vector<byte> manifest(reader->Size());
+    reader->Read(manifest.data(), manifest.size());
+
+    uint32_t version = 0;
+    uint64_t next_number = 0;
+    uint32_t count = 0;
+    uint32_t checksum = 0;
+    auto position = manifest.data() + sizeof(MANIFEST_MAGIC);
+    if (manifest.size() >= MANIFEST_HEADER_SIZE + sizeof(uint32_t)) {
+      std::memcpy(&version, position, sizeof(uint32_t));
+      std::memcpy(&next_number, position += sizeof(uint32_t), sizeof(uint64_t));
+      std::memcpy(&this->log_lsn, position += sizeof(uint64_t), sizeof(uint64_t));
+      std::memcpy(&count, position += sizeof(uint64_t), sizeof(uint32_t));
+      std::memcpy(&checksum, manifest.data() + manifest.size() - sizeof(uint32_t), sizeof(uint32_t));
+    }
+
+    if (manifest.size() < MANIFEST_HEADER_SIZE + sizeof(uint32_t)
+        || std::memcmp(manifest.data(), MANIFEST_MAGIC, sizeof(MANIFEST_MAGIC)) != 0 || version != MANIFEST_VERSION
+        || manifest.size() != MANIFEST_HEADER_SIZE + count * MANIFEST_ENTRY_SIZE + sizeof(uint32_t)
+        || Crc32c(manifest.data(), manifest.size() - sizeof(uint32_t)) != checksum) {
+      throw std::runtime_error("The manifest of LSM tree " + this->directory.string() + " is corrupt.");
+    }
+
+    position = manifest.data() + MANIFEST_HEADER_SIZE;
+    for (uint32_t i = 0; i < count; i++, position += MANIFEST_ENTRY_SIZE) {
+      uint64_t number;
+      std::memcpy(&number, position + sizeof(uint8_t), sizeof(uint64_t));
+      if (*position >= LSM_LEVEL_COUNT) {
+        throw std::runtime_error("The manifest of LSM tree " + this->directory.string() + " is corrupt.");
+      }
+
+      this->levels[*position].push_back(SortedRun::Open(RunPath(this->directory, number)));
+      live.insert(number);
+    }
+    this->next_run_number = next_number;
+  }
+
+  // Runs that were not finished or not installed before a crash, and runs that were compacted.
+  for (auto& file : std::filesystem::directory_iterator(RunDirectory(this->directory))) {
+    if (file.path().extension() != RUN_EXTENSION || live.count(RunNumber(file.path())) == 0) {
+      std::filesystem::remove(file.path());
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> lock(this->mutex);
+
+  std::vector<ReplayPartition> partitions(std::max<size_t>(this->options.recovery_threads, 1));
+  std::vector<std::thread> workers;
+  for (auto& partition : partitions) {
+    workers.emplace_back(ApplyPartition, std::ref(partition));
+  }
+
+  std::vector<std::pair<K, LsmEntry>> sample;
+  std::vector<K> boundaries;
+  std::vector<std::vector<std::pair<K, LsmEntry>>> chunks(partitions.size());
+
+  auto hand_over = [&partitions, &chunks](size_t index) {
+    {
+      std::lock_guard<std::mutex> partition_lock(partitions[index].mutex);
+      auto& queue = partitions[index].queue;
+      queue.insert(queue.end(), std::make_move_iterator(chunks[index].begin()),
+                   std::make_move_iterator(chunks[index].end()));
+    }
+    partitions[index].changed.notify_one();
+    chunks[index].clear();
+  };
+
+  auto route = [&boundaries, &chunks, &hand_over](const K& key, LsmEntry&& entry) {
+    auto index = static_cast<size_t>(std::upper_bound(boundaries.begin(), boundaries.end(), key)
+                                         - boundaries.begin());
+    chunks[index].emplace_back(key, std::move(entry));
+    if (chunks[index].size() >= REPLAY_CHUNK_SIZE) {
+      hand_over(index);
+    }
+  };
+
+  // Modifications are sampled until the key ranges are known, and routed directly afterwards.
+  bool routing = false;
+  auto start_routing = [&partitions, &sample, &boundaries, &route, &routing]() {
+    std::vector<K> keys;
+    keys.reserve(sample.size());
+    for (auto& modification : sample) {
+      keys.push_back(modification.first);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    for (size_t i = 1; i < partitions.size() && !keys.empty(); i++) {
+      boundaries.push_back(keys[i * keys.size() / partitions.size()]);
+    }
+
+    routing = true;
+    for (auto& [key, entry] : sample) {
+      route(key, std::move(entry));
+    }
+    sample.clear();
+  };
+
+  auto add = [&sample, &route, &routing, &start_routing](const K& key, LsmEntry&& entry) {
+    if (routing) {
+      route(key, std::move(entry));
+    } else {
+      sample.emplace_back(key, std::move(entry));
+      if (sample.size() >= REPLAY_SAMPLE_SIZE) {
+        start_routing();
+      }
+    }
+  };
+
+  auto finish = [&partitions, &workers]() {
+    for (auto& partition : partitions) {
+      {
+        std::lock_guard<std::mutex> partition_lock(partition.mutex);
+        partition.closed = true;
+      }
+      partition.changed.notify_one();
+    }
+
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  };
+
+  // The log of a store can contain records that are older than the runs of this tree, and records of other trees.
+  Lsn last_lsn = INVALID_LSN;
+  try {
+    auto from = std::max(this->log->CheckpointLsn(), this->log_lsn);
+    this->log->Replay(from, [this, &add, &last_lsn](Lsn lsn, const byte* data, size_t size) {
+      last_lsn = lsn;
+      if (!Unframe(this->family, data, size, lsn)) {
+        return;
+      }
+
+      if (size > 0 && data[0] == LOG_BATCH) {
+        for (auto& [key, entry] : DecodeBatch(data, size, lsn)) {
+          add(key, std::move(entry));
+        }
+
+        return;
+      }
+
+      if (size < 1 + BTREE_KEY_SIZE) {
+        ThrowTruncated(lsn);
+      }
+
+      K key;
+      std::memcpy(key.data(), data + 1, BTREE_KEY_SIZE);
+      add(key, {data[0] == LOG_REMOVE, V(data + 1 + BTREE_KEY_SIZE, data + size), data[0] == LOG_SEPARATED});
+    });
+
+    if (!routing) {
+      start_routing();
+    }
+    for (size_t i = 0; i < chunks.size(); i++) {
+      hand_over(i);
+    }
+  } catch (...) {
+    finish();
+    throw;
+  }
+  finish();
+
+  // The key ranges are disjoint and ordered, so the partitions together hold the records in key order.
+  size_t record_count = 0;
+  for (auto& partition : partitions) {
+    record_count += partition.records.size();
+  }
+
+  std::vector<std::pair<K, V>> records;
+  records.reserve(record_count);
+  for (auto& partition : partitions) {
+    for (auto& record : partition.records) {
+      records.emplace_back(record.first, std::move(record.second));
+    }
+    this->memtable_bytes += partition.bytes;
+  }
+
+  this->memtable->Load(std::move(records));
+  this->memtable_last_lsn = last_lsn;
+}
+
+void LsmTree::WriteManifest(const Levels &next, Lsn next_log_lsn) {
+  uint32_t count = 0;
+  for (auto& level : next) {
+    count += static_cast<uint32_t>(level.size());
+  }
+
+  std::vector<byte> manifest(MANIFEST_MAGIC, MANIFEST_MAGIC + sizeof(MANIFEST_MAGIC));
+  auto append = [&manifest](const auto& value) {
+    auto data = reinterpret_cast<const byte*>(&value);
+    manifest.insert(manifest.end(), data, data + sizeof(value));
+  };
+
+  append(MANIFEST_VERSION);
+  append(this->next_run_number.load());
+  append(next_log_lsn);
+  append(count);
+  for (uint8_t level = 0; level < LSM_LEVEL_COUNT; level++) {
+    for (auto& run : next[level]) {
+      append(level);
+      append(RunNumber(run->Path()));
+    }
+  }
+  append(Crc32c(manifest.data(), manifest.size()));
+
+  auto path = ManifestPath(this->directory);
+  auto temporary_path = path;
+  temporary_path += ".tmp";
+
+  auto writer = SequentialWriter::Create(temporary_path);
+  writer->Append(manifest.data(), manifest.size());
+  writer->Close();
+
+  std::filesystem::rename(temporary_path, path);
+  SyncDirectory(this->directory);
+}
+
+uint64_t LsmTree::LevelTarget(size_t level) const {
+  auto target = this->options.level1_size;
+  for (size_t i = 1; i < level; i++) {
+    target *= this->options.level_size_multiplier;
+  }
+
+  return target;
+}
+
+std::optional<LsmTree::Compaction> LsmTree::PickCompaction(const std::unique_lock<std::mutex> &compaction_lock) {
+  // The compaction state is modified below, which the shared lock on the levels does not protect.
+  assert(compaction_lock.owns_lock() && compaction_lock.mutex() == &this->compaction_mutex);
+  std::shared_lock<std::shared_mutex> lock(this->mutex);
+
+  // Compact the level exceeding its maximum the most, which is not involved in a compaction yet.
+  // Only a level scored at or above 1.0 qualifies, so nothing is picked when all of them are within their maximum.
+  size_t best = 0;
+  double best_score = 0.0;
+  for (size_t level = 0; level + 1 < LSM_LEVEL_COUNT; level++) {
+    if (this->compacting[level] || this->compacting[level + 1]) {
+      continue;
+    }
+
+    double score;
+    if (level == 0) {
+      score = static_cast<double>(this->levels[0].size())
+          / static_cast<double>(std::max<size_t>(this->options.level0_compaction_trigger, 1));
+    } else {
+      uint64_t size = 0;
+      for (auto& run : this->levels[level]) {
+        size += run->FileSize();
+      }
+      score = static_cast<double>(size) / static_cast<double>(this->LevelTarget(level));
+    }
+
+    if (score >= best_score) {
+      best = level;
+      best_score = score;
+    }
+  }
+
+  auto& source = this->levels[best];
+  if (best_score < 1.0 || source.empty()) {
+    return std::nullopt;
+  }
+
+  Compaction compaction{best, {}, {}, true};
+  if (best == 0) {
+    // Runs in level 0 overlap, so all of them are compacted together.
+    compaction.inputs = source;
+  } else {
+    auto run = std::find_if(source.begin(), source.end(), [this, best](const std::shared_ptr<SortedRun>& r) {
+      return this->cursors[best] < r->SmallestKey();
+    });
+    compaction.inputs.push_back(run == source.end() ? source.front() : *run);
+    this->cursors[best] = compaction.inputs.front()->LargestKey();
+  }
+
+  auto smallest = compaction.inputs.front()->SmallestKey();
+  auto largest = compaction.inputs.front()->LargestKey();
+  for (auto& input : compaction.inputs) {
+    smallest = std::min(smallest, input->SmallestKey());
+    largest = std::max(largest, input->LargestKey());
+  }
+
+  for (auto& run : this->levels[best + 1]) {
+    if (run->Overlaps(smallest, largest)) {
+      compaction.targets.push_back(run);
+    }
+  }
+
+  // The targets can extend beyond the inputs, and their tombstones may only be dropped if no deeper run overlaps them.
+  for (auto& target : compaction.targets) {
+    smallest = std::min(smallest, target->SmallestKey());
+    largest = std::max(largest, target->LargestKey());
+  }
+
+  for (auto level = best + 2; level < LSM_LEVEL_COUNT && compaction.bottom; level++) {
+    for (auto& run : this->levels[level]) {
+      compaction.bottom = compaction.bottom && !run->Overlaps(smallest, largest);
+    }
+  }
+
+  this->compacting[best] = true;
+  this->compacting[best + 1] = true;
+
+  return compaction;
+}
+
+void LsmTree::RunCompaction(const Compaction &compaction) {
+  std::vector<std::shared_ptr<SortedRun>> outputs;
+
+  if (compaction.inputs.size() == 1 && compaction.targets.empty()) {
+    // Nothing to merge with, so the run moves down as is.
+    outputs.push_back(compaction.inputs.front());
+  } else {
+    try {
+      std::vector<std::shared_ptr<SortedRun>> runs(compaction.inputs);
+      runs.insert(runs.end(), compaction.targets.begin(), compaction.targets.end());
+
+      std::vector<std::unique_ptr<SortedRunIterator>> iterators;
+      for (auto& run : runs) {
+        iterators.push_back(std::make_unique<SortedRunIterator>(*run, K{}));
+      }
+
+      // Iterators are merged by key. Of equal keys, the one of the newest run comes first.
+      auto later = [&iterators](size_t a, size_t b) {
+        auto& key_a = iterators[a]->Key();
+        auto& key_b = iterators[b]->Key();
+
+        return key_b < key_a || (key_a == key_b && b < a);
+      };
+      std::priority_queue<size_t, std::vector<size_t>, decltype(later)> heap(later);
+      for (size_t i = 0; i < iterators.size(); i++) {
+        if (iterators[i]->Valid()) {
+          heap.push(i);
+        }
+      }
+
+      std::unique_ptr<SortedRunBuilder> builder;
+      std::filesystem::path path;
+      auto finish = [&]() {
+        builder->Finish();
+        builder.reset();
+        outputs.push_back(SortedRun::Open(path));
+      };
+
+      uint64_t unlimited_bytes = 0;
+      auto account = [&](std::atomic<uint64_t>& counter, const LsmEntry& entry) {
+        auto bytes = BTREE_KEY_SIZE + 1 + sizeof(uint32_t) + entry.value.size();
+        counter += bytes;
+        if ((unlimited_bytes += bytes) >= COMPACTION_RATE_CHUNK) {
+          this->limiter.Acquire(unlimited_bytes);
+          unlimited_bytes = 0;
+        }
+      };
+
+      while (!heap.empty()) {
+        auto newest = heap.top();
+        heap.pop();
+
+        K key = iterators[newest]->Key();
+        LsmEntry entry = iterators[newest]->Entry();
+        account(this->compaction_bytes_read, entry);
+
+        iterators[newest]->Next();
+        if (iterators[newest]->Valid()) {
+          heap.push(newest);
+        }
+
+        // Skip the older versions of the key.
+        while (!heap.empty() && iterators[heap.top()]->Key() == key) {
+          auto older = heap.top();
+          heap.pop();
+          account(this->compaction_bytes_read, iterators[older]->Entry());
+
+          iterators[older]->Next();
+          if (iterators[older]->Valid()) {
+            heap.push(older);
+          }
+        }
+
+        if (entry.tombstone && compaction.bottom) {
+          continue;
+        }
+
+        if (!builder) {
+          path = RunPath(this->directory, this->next_run_number++);
+          builder = SortedRunBuilder::Create(path, this->options.bloom_bits_per_key);
+        }
+
+        builder->Add(key, entry);
+        account(this->compaction_bytes_written, entry);
+
+        if (builder->Size() >= this->options.run_size) {
+          finish();
+        }
+      }
+
+      if (builder) {
+        finish();
+      }
+    } catch (...) {
+      for (auto& output : outputs) {
+        output->MarkObsolete();
+      }
+
+      throw;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> manifest_lock(this->manifest_mutex);
+
+    auto next = this->levels;
+    EraseRuns(next[compaction.level], compaction.inputs);
+    EraseRuns(next[compaction.level + 1], compaction.targets);
+    next[compaction.level + 1].insert(next[compaction.level + 1].end(), outputs.begin(), outputs.end());
+    std::sort(next[compaction.level + 1].begin(), next[compaction.level + 1].end(),
+              [](const std::shared_ptr<SortedRun>& a, const std::shared_ptr<SortedRun>& b) {
+      return a->SmallestKey() < b->SmallestKey();
+    });
+
+    try {
+      this->WriteManifest(next, this->log_lsn);
+    } catch (...) {
+      for (auto& output : outputs) {
+        if (std::find(compaction.inputs.begin(), compaction.inputs.end(), output) == compaction.inputs.end()) {
+          output->MarkObsolete();
+        }
+      }
+
+      throw;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(this->mutex);
+    this->levels = std::move(next);
+  }
+
+  // The files are removed once the last reader releases them.
+  for (auto& runs : {compaction.inputs, compaction.targets}) {
+    for (auto& run : runs) {
+      if (std::find(outputs.begin(), outputs.end(), run) == outputs.end()) {
+        run->MarkObsolete();
+      }
+    }
+  }
+
+  this->compactions++;
+}
+
+void LsmTree::RunCompactions() {
+  std::unique_lock<std::mutex> lock(this->compaction_mutex);
+
+  while (!this->stopping) {
+    auto compaction = this->PickCompaction(lock);
+    if (!compaction) {
+      this->compaction_changed.wait(lock);
+      continue;
+    }
+
+    lock.unlock();
+    bool failed = false;
+    try {
+      this->RunCompaction(*compaction);
+    } catch (...) {
+      // The runs are left as they were, so the compaction is picked again later.
+      this->failed_compactions++;
+      failed = true;
+    }
+    lock.lock();
+
+    this->compacting[compaction->level] = false;
+    this->compacting[compaction->level + 1] = false;
+    this->compaction_changed.notify_all();
+
+    if (failed) {
+      this->compaction_changed.wait_for(lock, COMPACTION_RETRY_DELAY, [this] { return this->stopping; });
+    }
+  }
+}
+
+size_t LsmTree::Level0RunCount() {
+  std::shared_lock<std::shared_mutex> lock(this->mutex);
+  return this->levels[0].size();
+}
+
+void LsmTree::Throttle() {
+  if (this->compactors.empty()) {
+    return;
+  }
+
+  // Writes must not wait for a level 0 compaction which is never triggered.
+  auto stop_trigger = std::max(this->options.level0_stop_trigger, this->options.level0_compaction_trigger);
+  auto count = this->Level0RunCount();
+  if (count < this->options.level0_slowdown_trigger && count < stop_trigger) {
+    return;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::unique_lock<std::mutex> lock(this->compaction_mutex);
+    while (!this->stopping && this->Level0RunCount() >= stop_trigger) {
+      this->compaction_changed.wait(lock);
+    }
+  }
+
+  if (this->Level0RunCount() >= this->options.level0_slowdown_trigger) {
+    std::this_thread::sleep_for(SLOWDOWN_DELAY);
+  }
+
+  this->stalled_writes++;
+  this->stall_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+bool LsmTree::ApplyLocked(const K &key, const LsmEntry &entry, Lsn lsn) {
+  auto value = ToMemtableValue(entry);
+
+  this->memtable->Insert(key, value);
+  this->memtable_bytes += BTREE_KEY_SIZE + value.size();
+  this->memtable_last_lsn = lsn;
+
+  return this->memtable_bytes >= this->options.memtable_size;
+}
+
+LsmEntry LsmTree::Separate(const K &key, const LsmEntry &entry) {
+  if (entry.tombstone || entry.separated || this->options.value_separation_threshold == 0
+      || entry.value.size() < this->options.value_separation_threshold) {
+    return entry;
+  }
+
+  return {false, this->values->Append(key, entry.value).Encode(), true};
+}
+
+std::optional<V> LsmTree::Resolve(const K &key, LsmEntry &&entry) {
+  if (entry.tombstone) {
+    return std::nullopt;
+  } else if (entry.separated) {
+    return this->values->Read(key, ValuePointer::Decode(entry.value));
+  }
+
+  return std::move(entry.value);
+}
+
+void LsmTree::FlushLog(Lsn lsn) {
+  if (this->store) {
+    this->store->FlushLog(lsn);
+    return;
+  }
+
+  this->values->Sync();
+  this->log->Flush(lsn);
+}
+
+void LsmTree::CheckpointLog(Lsn lsn) {
+  if (this->store) {
+    this->store->Checkpoint();
+  } else {
+    this->log->Checkpoint(lsn);
+  }
+}
+
+Lsn LsmTree::RequiredLsn() {
+  std::shared_lock<std::shared_mutex> lock(this->mutex);
+  return this->memtable_bytes == 0 && !this->frozen ? std::numeric_limits<Lsn>::max() : this->log_lsn;
+}
+
+V LsmTree::NewRecord(size_t capacity) const {
+  V record;
+  if (this->store) {
+    record.reserve(FAMILY_HEADER_SIZE + capacity);
+    record.push_back(LOG_FAMILY);
+    record.insert(record.end(), reinterpret_cast<const byte*>(&this->family),
+                  reinterpret_cast<const byte*>(&this->family + 1));
+  } else {
+    record.reserve(capacity);
+  }
+
+  return record;
+}
+
+V LsmTree::EncodeGroup(const std::vector<std::pair<LsmTree*, PreparedBatch>>& parts) {
+  V record;
+  record.push_back(LOG_FAMILY_BATCH);
+  auto count = static_cast<uint32_t>(parts.size());
+  record.insert(record.end(), reinterpret_cast<const byte*>(&count), reinterpret_cast<const byte*>(&count + 1));
+
+  for (auto& [tree, batch] : parts) {
+    record.insert(record.end(), reinterpret_cast<const byte*>(&tree->family),
+                  reinterpret_cast<const byte*>(&tree->family + 1));
+
+    // The size of the part is known once it has been encoded.
+    auto position = record.size();
+    record.resize(position + sizeof(uint32_t));
+    AppendBatch(batch.operations, record);
+
+    auto size = static_cast<uint32_t>(record.size() - position - sizeof(uint32_t));
+    std::memcpy(record.data() + position, &size, sizeof(uint32_t));
+  }
+
+  return record;
+}
+
+Durability LsmTree::DefaultDurability() const {
+  return this->options.sync_writes ? Durability::Sync : Durability::Buffered;
+}
+
+void LsmTree::Apply(const K &key, const LsmEntry &original, Durability durability) {
+  auto entry = this->Separate(key, original);
+
+  V record;
+  if (durability != Durability::Memory) {
+    record = this->NewRecord(1 + BTREE_KEY_SIZE + entry.value.size());
+    record.push_back(LogType(entry));
+    record.insert(record.end(), key.begin(), key.end());
+    record.insert(record.end(), entry.value.begin(), entry.value.end());
+  }
+
+  this->Throttle();
+
+  Lsn lsn;
+  bool full;
+  {
+    std::unique_lock<std::shared_mutex> lock(this->mutex);
+
+    // Unlogged modifications do not advance the LSN up to which the memtable covers the log.
+    lsn = durability == Durability::Memory ? this->memtable_last_lsn : this->log->Append(record.data(), record.size());
+    full = this->ApplyLocked(key, entry, lsn);
+  }
+
+  if (durability == Durability::Sync) {
+    this->synchronous_writes++;
+    this->FlushLog(lsn);
+  }
+
+  if (full) {
+    this->Flush();
+  }
+}
+
+std::unique_ptr<LsmTree> LsmTree::Open(const std::filesystem::path &directory, const LsmTreeOptions &options,
+                                       std::shared_ptr<WriteAheadLog> log, uint32_t family, LsmStore *store) {
+  std::filesystem::create_directories(directory);
+
+  auto values = ValueLog::Open(directory / "values", options.value_log_segment_size);
+  auto tree = std::unique_ptr<LsmTree>(new LsmTree(directory, options, std::move(log), std::move(values), family,
+                                                   store));
+  tree->Recover();
+
+  if (tree->memtable_bytes >= options.memtable_size) {
+    tree->Flush();
+  }
+
+  return tree;
+}
+
+std::unique_ptr<LsmTree> LsmTree::Open(const std::filesystem::path &directory, const LsmTreeOptions &options) {
+  std::filesystem::create_directories(directory);
+
+  auto tree = LsmTree::Open(directory, options, WriteAheadLog::Open(directory / "wal", options.log_segment_size), 0,
+                            nullptr);
+  tree->Start();
+
+  return tree;
+}
+
+void LsmTree::Start() {
+  for (size_t i = 0; i < this->options.compaction_threads; i++) {
+    this->compactors.emplace_back(&LsmTree::RunCompactions, this);
+  }
+
+  if (this->options.value_log_gc_interval.count() > 0) {
+    this->collector = std::thread(&LsmTree::RunCollector, this);
+  }
+
+  if (this->options.log_flush_interval.count() > 0) {
+    this->flusher = std::thread(&LsmTree::RunFlusher, this);
+  }
+}
+
+void LsmTree::Write(const WriteBatch &batch) {
+  this->Write(batch, this->DefaultDurability());
+}
+
+void LsmTree::Write(const WriteBatch &batch, Durability durability) {
+  if (batch.Count() == 0) {
+    return;
+  }
+
+  auto prepared = this->Prepare(batch);
+
+  V record;
+  if (durability != Durability::Memory) {
+    record = this->NewRecord(0);
+    AppendBatch(prepared.operations, record);
+  }
+
+  this->Throttle();
+
+  // Readers hold the lock as well, so they observe either none or all of the operations.
+  Lsn lsn;
+  bool full;
+  {
+    std::unique_lock<std::shared_mutex> lock(this->mutex);
+    lsn = durability == Durability::Memory ? this->memtable_last_lsn : this->log->Append(record.data(), record.size());
+    full = this->ApplyLocked(prepared, lsn);
+  }
+
+  if (durability == Durability::Sync) {
+    this->synchronous_writes++;
+    this->FlushLog(lsn);
+  }
+
+  if (full) {
+    this->Flush();
+  }
+}
+
+LsmTree::PreparedBatch LsmTree::Prepare(const WriteBatch &batch) {
+  // Operations are applied in key order, so those modifying the same memtable leaf follow each other. The sort is
+  // stable, so only the last operation added for every key needs to be applied.
+  PreparedBatch prepared;
+  auto& operations = prepared.operations;
+  operations.reserve(batch.Count());
+  for (auto& operation : batch.Operations()) {
+    operations.push_back(&operation);
+  }
+
+  std::stable_sort(operations.begin(), operations.end(), [](const auto* a, const auto* b) {
+    return a->first < b->first;
+  });
+  operations.erase(operations.begin(), std::unique(operations.rbegin(), operations.rend(), [](auto* a, auto* b) {
+    return a->first == b->first;
+  }).base());
+
+  // The reserved capacity keeps the pointers to separated operations valid.
+  prepared.separated.reserve(operations.size());
+  for (auto& operation : operations) {
+    auto entry = this->Separate(operation->first, operation->second);
+    if (entry.separated) {
+      operation = &prepared.separated.emplace_back(operation->first, std::move(entry));
+    }
+  }
+
+  return prepared;
+}
+
+bool LsmTree::ApplyLocked(const PreparedBatch &batch, Lsn lsn) {
+  bool full = false;
+  for (auto* operation : batch.operations) {
+    full = this->ApplyLocked(operation->first, operation->second, lsn) || full;
+  }
+
+  return full;
+}
+
+void LsmTree::Insert(const K &key, const V &value) {
+  this->Apply(key, {false, value}, this->DefaultDurability());
+}
+
+void LsmTree::Insert(const K &key, const V &value, Durability durability) {
+  this->Apply(key, {false, value}, durability);
+}
+
+void LsmTree::Remove(const K &key) {
+  this->Apply(key, {true, {}}, this->DefaultDurability());
+}
+
+void LsmTree::Remove(const K &key, Durability durability) {
+  this->Apply(key, {true, {}}, durability);
+}
+
+std::optional<LsmEntry> LsmTree::FindInMemtablesLocked(const K &key) {
+  for (auto& table : {this->memtable, this->frozen}) {
+    if (!table) {
+      continue;
+    }
+
+    if (auto value = table->Find(key)) {
+      return ToEntry(*value);
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::optional<LsmEntry> LsmTree::FindEntry(const K &key) {
+  std::vector<std::shared_ptr<SortedRun>> candidates;
+  {
+    std::shared_lock<std::shared_mutex> lock(this->mutex);
+
+    if (auto entry = this->FindInMemtablesLocked(key)) {
+      return entry;
+    }
+
+    // Runs in level 0 can overlap, but deeper levels contain at most a single run covering the key.
+    candidates = this->levels[0];
+    for (size_t level = 1; level < LSM_LEVEL_COUNT; level++) {
+      auto& runs = this->levels[level];
+      auto run = std::upper_bound(runs.begin(), runs.end(), key, [](const K& k, const std::shared_ptr<SortedRun>& r) {
+        return k < r->SmallestKey();
+      });
+
+      if (run != runs.begin() && !((*--run)->LargestKey() < key)) {
+        candidates.push_back(*run);
+      }
+    }
+  }
+
+  for (auto& run : candidates) {
+    if (auto entry = run->Find(key)) {
+      return entry;
+    }
+  }
+
+  return std::nullopt;
+}
+
+std::optional<V> LsmTree::Find(const K &key) {
+  // The garbage collector cannot remove the segment a pointer refers to before its value has been read, and the
+  // value is read without holding the memtable lock.
+  std::shared_lock<std::shared_mutex> lock(this->collection_mutex);
+
+  auto entry = this->FindEntry(key);
+  return entry ? this->Resolve(key, std::move(*entry)) : std::nullopt;
+}
+
+void LsmTree::Flush() {
+  std::lock_guard<std::mutex> flush_lock(this->flush_mutex);
+
+  std::shared_ptr<BPlusTree> table;
+  Lsn last_lsn;
+  {
+    std::unique_lock<std::shared_mutex> lock(this->mutex);
+
+    // A memtable that failed to flush before is flushed first.
+    if (!this->frozen) {
+      if (this->memtable_bytes == 0) {
+        return;
+      }
+
+      this->frozen = std::move(this->memtable);
+      this->frozen_last_lsn = this->memtable_last_lsn;
+      this->memtable = std::make_shared<BPlusTree>(this->options.memtable_order);
+      this->memtable_bytes = 0;
+    }
+
+    table = this->frozen;
+    last_lsn = this->frozen_last_lsn;
+  }
+
+  // The log records are checkpointed once the run is installed, so the values they refer to must be durable first.
+  this->values->Sync();
+
+  auto path = RunPath(this->directory, this->next_run_number++);
+  auto builder = SortedRunBuilder::Create(path, this->options.bloom_bits_per_key);
+  table->Scan([&builder](const K& key, const V& value) {
+    builder->Add(key, ToEntry(value));
+    return true;
+  });
+  builder->Finish();
+
+  std::shared_ptr<SortedRun> run = SortedRun::Open(path);
+  Lsn next_log_lsn;
+  {
+    std::lock_guard<std::mutex> manifest_lock(this->manifest_mutex);
+
+    auto next = this->levels;
+    next[0].insert(next[0].begin(), run);
+    next_log_lsn = std::max(this->log_lsn, last_lsn + 1);
+    try {
+      this->WriteManifest(next, next_log_lsn);
+    } catch (...) {
+      run->MarkObsolete();
+      throw;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(this->mutex);
+    this->levels = std::move(next);
+    this->frozen.reset();
+    this->log_lsn = next_log_lsn;
+    this->flushed_memtables++;
+  }
+
+  // The records of the frozen memtable are durable in the run now.
+  this->CheckpointLog(next_log_lsn);
+
+  // Acquiring the mutex ensures a compaction thread either sees the new run or is waiting for this notification.
+  {
+    std::lock_guard<std::mutex> lock(this->compaction_mutex);
+  }
+  this->compaction_changed.notify_all();
+}
+
+void LsmTree::Compact() {
+  std::unique_lock<std::mutex> lock(this->compaction_mutex);
+
+  while (true) {
+    auto compaction = this->PickCompaction(lock);
+    if (!compaction) {
+      if (std::find(this->compacting.begin(), this->compacting.end(), true) == this->compacting.end()) {
+        return;
+      }
+
+      // A background compaction might be in the way.
+      this->compaction_changed.wait(lock);
+      continue;
+    }
+
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      this->RunCompaction(*compaction);
+    } catch (...) {
+      this->failed_compactions++;
+      error = std::current_exception();
+    }
+    lock.lock();
+
+    this->compacting[compaction->level] = false;
+    this->compacting[compaction->level + 1] = false;
+    this->compaction_changed.notify_all();
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+void LsmTree::Sync() {
+  this->FlushLog(this->log->LastLsn());
+}
+
+bool LsmTree::Relocate(const K &key, const ValuePointer &pointer, const V &value) {
+  while (true) {
+    uint64_t flushed;
+    {
+      std::shared_lock<std::shared_mutex> lock(this->mutex);
+      flushed = this->flushed_memtables;
+    }
+
+    if (!PointsTo(this->FindEntry(key), pointer)) {
+      return false;
+    }
+
+    LsmEntry entry{false, this->values->Append(key, value).Encode(), true};
+    auto record = this->NewRecord(1 + BTREE_KEY_SIZE + entry.value.size());
+    record.push_back(LOG_SEPARATED);
+    record.insert(record.end(), key.begin(), key.end());
+    record.insert(record.end(), entry.value.begin(), entry.value.end());
+
+    Lsn lsn;
+    bool full;
+    {
+      std::unique_lock<std::shared_mutex> lock(this->mutex);
+
+      // A newer version is either still in the memtables, or was flushed since the lookup. In the latter case the
+      // lookup is repeated, and the appended value becomes garbage.
+      auto current = this->FindInMemtablesLocked(key);
+      if (current && !PointsTo(current, pointer)) {
+        return false;
+      } else if (!current && flushed != this->flushed_memtables) {
+        continue;
+      }
+
+      lsn = this->log->Append(record.data(), record.size());
+      full = this->ApplyLocked(key, entry, lsn);
+    }
+
+    if (full) {
+      this->Flush();
+    }
+
+    return true;
+  }
+}
+
+size_t LsmTree::CollectGarbage() {
+  std::lock_guard<std::mutex> gc_lock(this->gc_mutex);
+
+  size_t removed = 0;
+  while (auto segment = this->values->OldestSealedSegment()) {
+    {
+      std::lock_guard<std::mutex> lock(this->compaction_mutex);
+      if (this->stopping) {
+        break;
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    // The first scan only determines which values are live, so a segment that is mostly live is not rewritten.
+    std::vector<uint64_t> live;
+    uint64_t scanned_bytes = 0;
+    uint64_t live_bytes = 0;
+    this->values->Scan(*segment, [this, &live, &scanned_bytes, &live_bytes](const K& key, const ValuePointer& pointer,
+                                                                           const V&) {
+      scanned_bytes += pointer.length;
+      if (PointsTo(this->FindEntry(key), pointer)) {
+        live.push_back(pointer.offset);
+        live_bytes += pointer.length;
+      }
+
+      return true;
+    });
+    this->value_log_gc_bytes_scanned += scanned_bytes;
+    this->value_log_gc_bytes_live += live_bytes;
+
+    auto garbage_bytes = static_cast<double>(scanned_bytes - live_bytes);
+    if (garbage_bytes < this->options.value_log_gc_garbage_ratio * static_cast<double>(scanned_bytes)) {
+      this->value_log_gc_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start).count();
+      break;
+    }
+
+    if (!live.empty()) {
+      size_t next = 0;
+      this->values->Scan(*segment, [this, &live, &next](const K& key, const ValuePointer& pointer, const V& value) {
+        if (pointer.offset == live[next]) {
+          if (this->Relocate(key, pointer, value)) {
+            this->value_log_gc_bytes_relocated += pointer.length;
+          }
+          next++;
+        }
+
+        return next < live.size();
+      });
+
+      // The relocations must survive a crash once the segment is gone.
+      this->FlushLog(this->log->LastLsn());
+    }
+
+    {
+      std::unique_lock<std::shared_mutex> lock(this->collection_mutex);
+      this->values->Remove(*segment);
+    }
+
+    removed++;
+    this->value_log_gc_segments++;
+    this->value_log_gc_time_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+
+  return removed;
+}
+
+void LsmTree::RunFlusher() {
+  std::unique_lock<std::mutex> lock(this->compaction_mutex);
+  while (!this->compaction_changed.wait_for(lock, this->options.log_flush_interval, [this] {
+    return this->stopping;
+  })) {
+    lock.unlock();
+    try {
+      this->Sync();
+    } catch (...) {
+      // The log is flushed again after the next interval, or by the next synchronous modification.
+    }
+    lock.lock();
+  }
+}
+
+void LsmTree::RunCollector() {
+  std::unique_lock<std::mutex> lock(this->compaction_mutex);
+  while (!this->compaction_changed.wait_for(lock, this->options.value_log_gc_interval, [this] {
+    return this->stopping;
+  })) {
+    lock.unlock();
+    try {
+      this->CollectGarbage();
+    } catch (...) {
+      // The segment is collected again after the next interval.
+      this->value_log_gc_failures++;
+    }
+    lock.lock();
+  }
+}
+
+size_t LsmTree::RunCount() {
+  std::shared_lock<std::shared_mutex> lock(this->mutex);
+
+  size_t count = 0;
+  for (auto& level : this->levels) {
+    count += level.size();
+  }
+
+  return count;
+}
+
+size_t LsmTree::RunCount(size_t level) {
+  std::shared_lock<std::shared_mutex> lock(this->mutex);
+  return level < LSM_LEVEL_COUNT ? this->levels[level].size() : 0;
+}
+
+LsmTreeMetrics LsmTree::Metrics() {
+  // Without any live bytes, the space amplification is infinite.
+  uint64_t scanned = this->value_log_gc_bytes_scanned;
+  uint64_t live = this->value_log_gc_bytes_live;
+
+  uint64_t pending = 0;
+  {
+    std::shared_lock<std::shared_mutex> lock(this->mutex);
+
+    for (size_t level = 0; level + 1 < LSM_LEVEL_COUNT; level++) {
+      uint64_t size = 0;
+      for (auto& run : this->levels[level]) {
+        size += run->FileSize();
+      }
+
+      // All runs in level 0 are compacted together, while deeper levels are compacted down to their maximum.
+      if (level == 0) {
+        pending += this->levels[0].size() >= this->options.level0_compaction_trigger ? size : 0;
+      } else {
+        pending += size > this->LevelTarget(level) ? size - this->LevelTarget(level) : 0;
+      }
+    }
+  }
+
+  return {
+      pending,
+      this->stalled_writes,
+      std::chrono::nanoseconds(this->stall_time_ns),
+      this->compactions,
+      this->failed_compactions,
+      this->compaction_bytes_read,
+      this->compaction_bytes_written,
+      this->synchronous_writes,
+      this->log->FlushCount(),
+      this->values->Size(),
+      scanned == 0 ? 1.0 : static_cast<double>(scanned) / static_cast<double>(live),
+      this->value_log_gc_segments,
+      this->value_log_gc_failures,
+      scanned,
+      this->value_log_gc_bytes_relocated,
+      std::chrono::nanoseconds(this->value_log_gc_time_ns),
+  };
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,818 @@
+#ifndef NOID_SRC_STORAGE_LSMTREE_H_
+#define NOID_SRC_STORAGE_LSMTREE_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+#include "BPlusTree.h"
+#include "Page.h"
+#include "RateLimiter.h"
+#include "Shared.h"
+#include "SortedRun.h"
+#include "ValueLog.h"
+#include "WriteAheadLog.h"
+#include "WriteBatch.h"
+
+namespace noid::storage {
+
+/**
+ * @brief The amount of levels of an @c LsmTree.
+ */
+const size_t LSM_LEVEL_COUNT = 7;
+
+class LsmStore;
+
+/**
+ * @brief The guarantee that a modification of an @c LsmTree offers once it returns.
+ */
+enum class Durability {
+
+    /**
+     * The modification is applied to the memtable without being logged. It survives a crash only if the memtable has
+     * been flushed to a run before.
+     */
+    Memory,
+
+    /**
+     * The modification is logged in memory. It becomes durable when the log is flushed by a synchronous
+     * modification, by @c LsmTree::Sync, or every @c LsmTreeOptions::log_flush_interval.
+     */
+    Buffered,
+
+    /**
+     * The modification is durable once it returns. Concurrent synchronous modifications share the synchronization of
+     * the log (group commit).
+     */
+    Sync,
+};
+
+/**
+ * @brief Configures an @c LsmTree.
+ */
+struct LsmTreeOptions {
+
+    /**
+     * @brief The approximate size in bytes of the keys and values in the memtable after which it is flushed to a
+     * sorted run.
+     */
+    size_t memtable_size = 4 * 1024 * 1024;
+
+    /**
+     * @brief The order of the @c BPlusTree used as memtable.
+     */
+    uint8_t memtable_order = 64;
+
+    /**
+     * @brief The amount of Bloom filter bits per key of the sorted runs, or zero to omit their filters. Filters let
+     * lookups of absent keys skip runs without reading them.
+     */
+    uint8_t bloom_bits_per_key = SORTED_RUN_DEFAULT_BLOOM_BITS_PER_KEY;
+
+    /**
+     * @brief The size in bytes of the write-ahead log segments.
+     */
+    uint64_t log_segment_size = WAL_DEFAULT_SEGMENT_SIZE;
+
+    /**
+     * @brief Whether modifications that do not specify a @c Durability are @c Durability::Sync, rather than
+     * @c Durability::Buffered.
+     */
+    bool sync_writes = true;
+
+    /**
+     * @brief The interval at which a background thread flushes the log, which bounds the time until
+     * @c Durability::Buffered modifications are durable. Zero disables the thread.
+     */
+    std::chrono::milliseconds log_flush_interval = std::chrono::milliseconds(100);
+
+    /**
+     * @brief The amount of background threads executing compactions. If zero, runs are only compacted by
+     * @c LsmTree::Compact, and writes are never throttled.
+     */
+    size_t compaction_threads = 1;
+
+    /**
+     * @brief The amount of threads applying the log records replayed when the tree is opened. Each thread applies
+     * the records of its own key range, so the records of every key are applied in log order.
+     */
+    size_t recovery_threads = 4;
+
+    /**
+     * @brief The amount of runs in level 0 at which they are compacted into level 1.
+     */
+    size_t level0_compaction_trigger = 4;
+
+    /**
+     * @brief The amount of runs in level 0 at which every write is delayed by a millisecond.
+     */
+    size_t level0_slowdown_trigger = 8;
+
+    /**
+     * @brief The amount of runs in level 0 at which writes wait until a compaction has reduced it.
+     */
+    size_t level0_stop_trigger = 12;
+
+    /**
+     * @brief The size in bytes of level 1 at which it is compacted into level 2.
+     */
+    uint64_t level1_size = 64 * 1024 * 1024;
+
+    /**
+     * @brief The factor by which the maximum size of each level exceeds that of the level before it.
+     */
+    uint32_t level_size_multiplier = 10;
+
+    /**
+     * @brief The size in bytes after which a compaction starts writing a new run.
+     */
+    uint64_t run_size = 8 * 1024 * 1024;
+
+    /**
+     * @brief The maximum amount of bytes read and written by compactions per second, or zero for unlimited
+     * throughput.
+     */
+    uint64_t compaction_bytes_per_second = 0;
+
+    /**
+     * @brief The size in bytes from which values are stored in a separate @c ValueLog, while the memtable and the
+     * sorted runs only hold a pointer to them. Zero disables value separation.
+     */
+    size_t value_separation_threshold = 0;
+
+    /**
+     * @brief The size in bytes of the value log segments.
+     */
+    uint64_t value_log_segment_size = VALUE_LOG_DEFAULT_SEGMENT_SIZE;
+
+    /**
+     * @brief The minimum fraction of the value bytes in the oldest sealed value log segment that must be garbage
+     * before the garbage collector relocates its live values and removes it.
+     */
+    double value_log_gc_garbage_ratio = 0.5;
+
+    /**
+     * @brief The interval at which a background thread collects value log garbage, or zero to only collect it in
+     * @c LsmTree::CollectGarbage.
+     */
+    std::chrono::milliseconds value_log_gc_interval = std::chrono::seconds(10);
+};
+
+/**
+ * @brief A point-in-time copy of the metrics collected by an @c LsmTree.
+ */
+struct LsmTreeMetrics {
+
+    /**
+     * @brief An estimate of the amount of bytes that must be compacted until no level exceeds its maximum size.
+     */
+    uint64_t pending_compaction_bytes;
+
+    /**
+     * @brief The amount of writes that were delayed or stopped because level 0 contained too many runs.
+     */
+    uint64_t stalled_writes;
+
+    /**
+     * @brief The total time writes were delayed or stopped.
+     */
+    std::chrono::nanoseconds stall_time;
+
+    /**
+     * @brief The amount of completed compactions.
+     */
+    uint64_t compactions;
+
+    /**
+     * @brief The amount of compactions that failed with an error.
+     */
+    uint64_t failed_compactions;
+
+    /**
+     * @brief The total amount of record bytes read and written by compactions.
+     */
+    uint64_t compaction_bytes_read;
+    uint64_t compaction_bytes_written;
+
+    /**
+     * @brief The amount of @c Durability::Sync modifications, and the amount of times the log was written and
+     * synchronized. Group commit lets the latter stay below the former.
+     */
+    uint64_t synchronous_writes;
+    uint64_t log_flushes;
+
+    /**
+     * @brief The total size in bytes of the value log segments.
+     */
+    uint64_t value_log_bytes;
+
+    /**
+     * @brief The ratio of value log bytes to live value bytes, estimated from the segments scanned by the garbage
+     * collector so far. It is one before the first scan.
+     */
+    double value_log_space_amplification;
+
+    /**
+     * @brief The amount of value log segments removed by the garbage collector.
+     */
+    uint64_t value_log_gc_segments;
+
+    /**
+     * @brief The amount of garbage collections that failed with an error.
+     */
+    uint64_t value_log_gc_failures;
+
+    /**
+     * @brief The total amount of value bytes scanned and relocated by the garbage collector, and the time it spent
+     * doing so. Dividing the scanned bytes by the time yields its throughput.
+     */
+    uint64_t value_log_gc_bytes_scanned;
+    uint64_t value_log_gc_bytes_relocated;
+    std::chrono::nanoseconds value_log_gc_time;
+};
+
+/**
+ * @brief A log-structured merge tree, which turns random writes into sequential ones.
+ * @details Modifications are appended to a write-ahead log and applied to an in-memory @c BPlusTree, the memtable.
+ * When the memtable exceeds @c LsmTreeOptions::memtable_size, it is frozen and written to an immutable
+ * @c SortedRun, after which the log records it contains are checkpointed. Removes are recorded as tombstones, which
+ * shadow older values of the same key.
+ *
+ * Flushed runs enter level 0, where their key ranges can overlap. Background threads compact them into the deeper
+ * levels, each of which contains runs with disjoint key ranges and may hold @c level_size_multiplier times as many
+ * bytes as the level before it. A compaction merges a run, or all level 0 runs, with the overlapping runs of the next
+ * level and keeps only the newest version of every key. Tombstones are dropped once no deeper level can contain the
+ * key. The set of runs per level is recorded in a manifest file which is replaced atomically, so a crash during a
+ * flush or compaction leaves the previous set intact.
+ *
+ * Lookups consult the memtable, the frozen memtable being flushed, the runs in level 0 from newest to oldest and then
+ * the single run per deeper level that covers the key. The first layer containing the key determines the result.
+ * Runs whose Bloom filter excludes the key are skipped without I/O.
+ *
+ * Values of at least @c LsmTreeOptions::value_separation_threshold bytes are appended to a @c ValueLog before the
+ * modification is logged, and all layers store a @c ValuePointer instead. Memtable rebalancing, flushes and
+ * compactions then move small entries only, at the cost of an extra read per lookup of a separated value. The value
+ * log is synchronized before the records or runs referring to it become durable.
+ *
+ * Overwritten and removed separated values become garbage in the value log. The garbage collector scans the oldest
+ * sealed segment and looks up the key of every entry: an entry is live if the newest version of its key still points
+ * to it. Once enough of the segment is garbage, the live values are appended to the value log again and logged as
+ * modifications of their keys, unless a newer modification overtook them, after which the segment is removed.
+ *
+ * A tree either owns its log, or shares it with the other trees of an @c LsmStore. In the latter case its records are
+ * prefixed by the id of the tree, and records of other trees are skipped during recovery.
+ *
+ * All methods can be called concurrently.
+ */
+class LsmTree {
+ private:
+
+    /**
+     * The runs per level. Level 0 is ordered from newest to oldest run, deeper levels by key.
+     */
+    using Levels = std::array<std::vector<std::shared_ptr<SortedRun>>, LSM_LEVEL_COUNT>;
+
+    /**
+     * @brief A compaction of runs into the next level.
+     */
+    struct Compaction {
+
+        /**
+         * The level containing @c inputs.
+         */
+        size_t level;
+
+        /**
+         * The runs to compact, from newest to oldest.
+         */
+        std::vector<std::shared_ptr<SortedRun>> inputs;
+
+        /**
+         * The runs of the next level that overlap @c inputs.
+         */
+        std::vector<std::shared_ptr<SortedRun>> targets;
+
+        /**
+         * Whether no level below the next one overlaps the inputs, so tombstones can be dropped.
+         */
+        bool bottom;
+    };
+
+    /**
+     * The directory containing the log and the sorted runs.
+     */
+    const std::filesystem::path directory;
+
+    /**
+     * The options.
+     */
+    const LsmTreeOptions options;
+
+    /**
+     * The write-ahead log of the memtable, which is shared by all trees of the store the tree belongs to.
+     */
+    std::shared_ptr<WriteAheadLog> log;
+
+    /**
+     * The id of the tree within its store, which prefixes its log records, or zero if the tree owns its log.
+     */
+    const uint32_t family;
+
+    /**
+     * The store the tree belongs to, or @c nullptr if the tree owns its log.
+     */
+    LsmStore* const store;
+
+    /**
+     * The log containing the separated values. It is destroyed before @c log, so the values that the last log
+     * records refer to are synchronized first.
+     */
+    std::unique_ptr<ValueLog> values;
+
+    /**
+     * Protects the memtables, @c levels and @c flushed_memtables.
+     */
+    std::shared_mutex mutex;
+
+    /**
+     * Held shared by lookups from finding a value pointer until reading its value, and exclusively by the garbage
+     * collector while it removes a value log segment.
+     */
+    std::shared_mutex collection_mutex;
+
+    /**
+     * Serializes garbage collections.
+     */
+    std::mutex gc_mutex;
+
+    /**
+     * Serializes modifications of @c levels and writes of the manifest.
+     */
+    std::mutex manifest_mutex;
+
+    /**
+     * Serializes flushes.
+     */
+    std::mutex flush_mutex;
+
+    /**
+     * The memtable receiving modifications. Values are prefixed by a byte marking tombstones and separated values.
+     */
+    std::shared_ptr<BPlusTree> memtable;
+
+    /**
+     * The approximate size in bytes of the keys and values in @c memtable.
+     */
+    size_t memtable_bytes;
+
+    /**
+     * The LSN of the last log record applied to @c memtable.
+     */
+    Lsn memtable_last_lsn;
+
+    /**
+     * The memtable being flushed, or @c nullptr. If a flush fails, it is retried by the next flush.
+     */
+    std::shared_ptr<BPlusTree> frozen;
+
+    /**
+     * The LSN of the last log record applied to @c frozen.
+     */
+    Lsn frozen_last_lsn;
+
+    /**
+     * The first LSN of the log records that might not be contained in the runs yet. It is recorded in the manifest,
+     * because the log of a store is only checkpointed up to the oldest such LSN of all its trees.
+     */
+    Lsn log_lsn;
+
+    /**
+     * The amount of memtables that were written to a run, which tells a relocation whether the version it verified
+     * might have been overtaken by one that was flushed in the meantime.
+     */
+    uint64_t flushed_memtables;
+
+    /**
+     * The sorted runs per level.
+     */
+    Levels levels;
+
+    /**
+     * The number of the next sorted run.
+     */
+    std::atomic<uint64_t> next_run_number;
+
+    /**
+     * Limits the throughput of compactions.
+     */
+    RateLimiter limiter;
+
+    /**
+     * Protects @c compacting, @c cursors and @c stopping, and is used to signal the end of a compaction.
+     */
+    std::mutex compaction_mutex;
+
+    /**
+     * Signals that a compaction ended, or that runs were added to level 0.
+     */
+    std::condition_variable compaction_changed;
+
+    /**
+     * Whether a compaction reads from or writes to a level.
+     */
+    std::array<bool, LSM_LEVEL_COUNT> compacting;
+
+    /**
+     * The largest key of the last run compacted out of each level. The next compaction picks the run after it, so
+     * all key ranges are compacted in turn.
+     */
+    std::array<K, LSM_LEVEL_COUNT> cursors;
+
+    /**
+     * Whether the compaction threads must stop.
+     */
+    bool stopping;
+
+    /**
+     * The compaction threads.
+     */
+    std::vector<std::thread> compactors;
+
+    /**
+     * The thread collecting value log garbage, if @c LsmTreeOptions::value_log_gc_interval is positive.
+     */
+    std::thread collector;
+
+    /**
+     * The thread flushing the log, if @c LsmTreeOptions::log_flush_interval is positive.
+     */
+    std::thread flusher;
+
+    /**
+     * The counters backing the @c LsmTreeMetrics.
+     */
+    std::atomic<uint64_t> stalled_writes;
+    std::atomic<int64_t> stall_time_ns;
+    std::atomic<uint64_t> compactions;
+    std::atomic<uint64_t> failed_compactions;
+    std::atomic<uint64_t> compaction_bytes_read;
+    std::atomic<uint64_t> compaction_bytes_written;
+    std::atomic<uint64_t> synchronous_writes;
+    std::atomic<uint64_t> value_log_gc_segments;
+    std::atomic<uint64_t> value_log_gc_failures;
+    std::atomic<uint64_t> value_log_gc_bytes_scanned;
+    std::atomic<uint64_t> value_log_gc_bytes_live;
+    std::atomic<uint64_t> value_log_gc_bytes_relocated;
+    std::atomic<int64_t> value_log_gc_time_ns;
+
+    /**
+     * @brief Creates a new @c LsmTree.
+     *
+     * @param directory The directory containing the log and the sorted runs.
+     * @param options The options.
+     * @param log The opened write-ahead log.
+     * @param values The opened value log.
+     * @param family The id of the tree within its store, or zero if the tree owns its log.
+     * @param store The store the tree belongs to, or @c nullptr if the tree owns its log.
+     */
+    LsmTree(std::filesystem::path directory, const LsmTreeOptions& options, std::shared_ptr<WriteAheadLog> log,
+            std::unique_ptr<ValueLog> values, uint32_t family, LsmStore* store);
+
+    /**
+     * @brief Opens the tree stored in the given @p directory without starting its background threads.
+     *
+     * @param directory The directory.
+     * @param options The options.
+     * @param log The opened write-ahead log.
+     * @param family The id of the tree within its store, or zero if the tree owns its log.
+     * @param store The store the tree belongs to, or @c nullptr if the tree owns its log.
+     * @return The opened tree.
+     */
+    static std::unique_ptr<LsmTree> Open(const std::filesystem::path& directory, const LsmTreeOptions& options,
+                                         std::shared_ptr<WriteAheadLog> log, uint32_t family, LsmStore* store);
+
+    /**
+     * @brief Starts the compaction threads, the garbage collector and the log flusher, as far as they are enabled.
+     */
+    void Start();
+
+    /**
+     * @brief Stops and joins all background threads.
+     */
+    void Stop();
+
+    /**
+     * @brief Opens the sorted runs listed in the manifest, removes all others, and replays the log records that were
+     * not flushed yet.
+     * @details The key ranges of the replay threads are the quantiles of the keys of the first records. The reading
+     * thread routes every modification to the thread owning its key, and the memtable is built bottom-up once all
+     * threads are done.
+     */
+    void Recover();
+
+    /**
+     * @brief Atomically replaces the manifest by one listing the given runs and the given log LSN. The caller must
+     * hold @c manifest_mutex.
+     */
+    void WriteManifest(const Levels& next, Lsn next_log_lsn);
+
+    /**
+     * @return The maximum size in bytes of the given level.
+     */
+    [[nodiscard]] uint64_t LevelTarget(size_t level) const;
+
+    /**
+     * @brief Selects the next compaction and marks its levels as compacting.
+     *
+     * @param compaction_lock The lock on @c compaction_mutex, which the caller must hold.
+     * @return The compaction, or an empty optional if no level that is not being compacted exceeds its maximum.
+     */
+    std::optional<Compaction> PickCompaction(const std::unique_lock<std::mutex> &compaction_lock);
+
+    /**
+     * @brief Executes the given compaction and installs its output.
+     */
+    void RunCompaction(const Compaction& compaction);
+
+    /**
+     * @brief Executes compactions until stopped.
+     */
+    void RunCompactions();
+
+    /**
+     * @brief Delays or stops the calling writer while level 0 contains too many runs.
+     */
+    void Throttle();
+
+    /**
+     * @return The amount of runs in level 0.
+     */
+    size_t Level0RunCount();
+
+    /**
+     * @brief Moves the value of the given entry to the value log if it reaches the separation threshold.
+     *
+     * @param key The key.
+     * @param entry The value or tombstone.
+     * @return The entry to log and apply.
+     */
+    LsmEntry Separate(const K& key, const LsmEntry& entry);
+
+    /**
+     * @brief Reads the value of the given entry, fetching separated values from the value log.
+     *
+     * @return The value, or an empty optional if the entry is a tombstone.
+     */
+    std::optional<V> Resolve(const K& key, LsmEntry&& entry);
+
+    /**
+     * @brief Makes the log durable up to the given @p lsn, after the values its records refer to.
+     */
+    void FlushLog(Lsn lsn);
+
+    /**
+     * @brief Recycles the log records that are contained in the runs. The log of a store is only checkpointed up to
+     * the oldest record that one of its trees still requires.
+     *
+     * @param lsn The first LSN this tree still requires.
+     */
+    void CheckpointLog(Lsn lsn);
+
+    /**
+     * @return The first LSN this tree requires for recovery, or the maximum LSN if its memtables are empty.
+     */
+    Lsn RequiredLsn();
+
+    /**
+     * @return An empty log record, prefixed by the id of the tree if it belongs to a store.
+     */
+    [[nodiscard]] V NewRecord(size_t capacity) const;
+
+    /**
+     * @brief Looks up the entry of the given @p key in the memtables. The caller must hold @c mutex.
+     *
+     * @return The entry, or an empty optional if the memtables do not contain the key.
+     */
+    std::optional<LsmEntry> FindInMemtablesLocked(const K& key);
+
+    /**
+     * @brief Looks up the newest entry of the given @p key, without reading separated values.
+     *
+     * @return The entry, or an empty optional if the key was never written.
+     */
+    std::optional<LsmEntry> FindEntry(const K& key);
+
+    /**
+     * @brief Appends a live value to the value log again, and points its key to the new location unless a newer
+     * modification overtook the version being relocated.
+     *
+     * @param key The key.
+     * @param pointer The current location of the value.
+     * @param value The value.
+     * @return Whether the value was live and has been relocated.
+     */
+    bool Relocate(const K& key, const ValuePointer& pointer, const V& value);
+
+    /**
+     * @brief Collects value log garbage every @c LsmTreeOptions::value_log_gc_interval until stopped.
+     */
+    void RunCollector();
+
+    /**
+     * @brief Flushes the log every @c LsmTreeOptions::log_flush_interval until stopped.
+     */
+    void RunFlusher();
+
+    /**
+     * @return The durability of modifications that do not specify one.
+     */
+    [[nodiscard]] Durability DefaultDurability() const;
+
+    /**
+     * @brief Logs and applies a modification.
+     *
+     * @param key The key.
+     * @param entry The new value or tombstone.
+     * @param durability The guarantee the modification offers once this method returns.
+     */
+    void Apply(const K& key, const LsmEntry& entry, Durability durability);
+
+    /**
+     * @brief Applies a modification to the memtable. The caller must hold @c mutex exclusively.
+     *
+     * @return Whether the memtable should be flushed.
+     */
+    bool ApplyLocked(const K& key, const LsmEntry& entry, Lsn lsn);
+
+    /**
+     * @brief A batch prepared for logging and applying.
+     */
+    struct PreparedBatch {
+
+        /**
+         * The last operation per key, in key order.
+         */
+        std::vector<const std::pair<K, LsmEntry>*> operations;
+
+        /**
+         * The operations whose values were moved to the value log, which @c operations point to instead.
+         */
+        std::vector<std::pair<K, LsmEntry>> separated;
+    };
+
+    /**
+     * @brief Sorts the operations of the given batch and moves large values to the value log.
+     */
+    PreparedBatch Prepare(const WriteBatch& batch);
+
+    /**
+     * @brief Applies the operations of a prepared batch to the memtable. The caller must hold @c mutex exclusively.
+     *
+     * @return Whether the memtable should be flushed.
+     */
+    bool ApplyLocked(const PreparedBatch& batch, Lsn lsn);
+
+    /**
+     * @brief Encodes a single log record containing the given batches of trees of the same store.
+     */
+    static V EncodeGroup(const std::vector<std::pair<LsmTree*, PreparedBatch>>& parts);
+
+    friend class LsmStore;
+
+ public:
+
+    /**
+     * @brief Opens the tree stored in the given @p directory, creating it if it does not exist yet.
+     *
+     * @param directory The directory.
+     * @param options The options.
+     * @return The opened tree.
+     * @throws std::system_error If the directory, the log or a sorted run cannot be opened.
+     * @throws std::runtime_error If the log or a sorted run is corrupt.
+     */
+    [[nodiscard]] static std::unique_ptr<LsmTree> Open(const std::filesystem::path& directory,
+                                                       const LsmTreeOptions& options = {});
+
+    LsmTree()= delete;
+    LsmTree(LsmTree const&)= delete;
+    LsmTree(LsmTree &&)= delete;
+    ~LsmTree();
+
+    LsmTree& operator=(LsmTree const&)= delete;
+    LsmTree& operator=(LsmTree &&)= delete;
+
+    /**
+     * @brief Associates @p value with @p key, overwriting any pre-existing value. The previous value is not read.
+     *
+     * @param key The key.
+     * @param value The value.
+     * @throws std::system_error If the modification cannot be logged, or the memtable cannot be flushed.
+     */
+    void Insert(const K& key, const V& value);
+
+    /**
+     * @brief Associates @p value with @p key like @c Insert, with the given @p durability.
+     */
+    void Insert(const K& key, const V& value, Durability durability);
+
+    /**
+     * @brief Removes the given @p key by writing a tombstone. It is not checked whether the key exists.
+     *
+     * @param key The key to remove.
+     * @throws std::system_error If the modification cannot be logged, or the memtable cannot be flushed.
+     */
+    void Remove(const K& key);
+
+    /**
+     * @brief Removes the given @p key like @c Remove, with the given @p durability.
+     */
+    void Remove(const K& key, Durability durability);
+
+    /**
+     * @brief Applies all operations of the given @p batch atomically. Readers observe either none or all of them,
+     * and after a crash either none or all of them are recovered.
+     * @details The batch is logged as a single record. Its operations are applied in key order, which also limits
+     * the memtable work to the last operation per key.
+     *
+     * @param batch The operations to apply.
+     * @throws std::system_error If the batch cannot be logged, or the memtable cannot be flushed.
+     */
+    void Write(const WriteBatch& batch);
+
+    /**
+     * @brief Applies all operations of the given @p batch atomically like @c Write, with the given @p durability.
+     * A @c Durability::Memory batch is not logged, so after a crash none of its operations might be recovered.
+     */
+    void Write(const WriteBatch& batch, Durability durability);
+
+    /**
+     * @brief Looks up the value associated with the given @p key.
+     *
+     * @param key The search key.
+     * @return The value, or an empty optional if the key does not exist.
+     * @throws std::runtime_error If a sorted run or the value log is corrupt.
+     */
+    std::optional<V> Find(const K& key);
+
+    /**
+     * @brief Writes the memtable to a new sorted run, even if it has not reached its maximum size.
+     *
+     * @throws std::system_error If the sorted run cannot be written.
+     */
+    void Flush();
+
+    /**
+     * @brief Executes compactions on the calling thread until no level exceeds its maximum size, waiting for
+     * background compactions where they are in the way.
+     *
+     * @throws std::system_error If a run cannot be read or written.
+     * @throws std::runtime_error If a run is corrupt.
+     */
+    void Compact();
+
+    /**
+     * @brief Makes all modifications durable.
+     *
+     * @throws std::system_error If the log cannot be written.
+     */
+    void Sync();
+
+    /**
+     * @brief Removes the oldest sealed value log segments for as long as at least
+     * @c LsmTreeOptions::value_log_gc_garbage_ratio of their value bytes are garbage, relocating their live values
+     * first.
+     *
+     * @return The amount of removed segments.
+     * @throws std::system_error If the value log or the log cannot be read or written.
+     * @throws std::runtime_error If a value log segment or a sorted run is corrupt.
+     */
+    size_t CollectGarbage();
+
+    /**
+     * @return The amount of sorted runs in all levels.
+     */
+    size_t RunCount();
+
+    /**
+     * @return The amount of sorted runs in the given level.
+     */
+    size_t RunCount(size_t level);
+
+    /**
+     * @return A copy of the current metrics.
+     */
+    LsmTreeMetrics Metrics();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_LSMTREE_H_
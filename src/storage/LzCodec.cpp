@@ -0,0 +1,192 @@
+#include "LzCodec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace noid::storage {
+
+static const size_t MIN_MATCH = 4;
+static const size_t MAX_OFFSET = 0xffff;
+static const size_t HASH_BITS = 13;
+static const uint32_t NO_POSITION = UINT32_MAX;
+
+static uint32_t Load32(const byte* data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(uint32_t));
+
+  return value;
+}
+
+static uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+/**
+ * @brief Writes compressed data, keeping track of whether it still fits in the destination.
+ */
+class LzWriter {
+ private:
+    byte* destination;
+    size_t capacity;
+    size_t size = 0;
+
+ public:
+    LzWriter(byte* destination, size_t capacity) : destination(destination), capacity(capacity) {}
+
+    [[nodiscard]] size_t Size() const {
+      return this->size;
+    }
+
+    bool Put(byte value) {
+      if (this->size == this->capacity) {
+        return false;
+      }
+
+      this->destination[this->size++] = value;
+      return true;
+    }
+
+    bool PutLength(size_t length) {
+      for (; length >= 255; length -= 255) {
+        if (!this->Put(255)) {
+          return false;
+        }
+      }
+
+      return this->Put(static_cast<byte>(length));
+    }
+
+    bool Put(const byte* data, size_t length) {
+      if (this->capacity - this->size < length) {
+        return false;
+      }
+
+      std::copy(data, data + length, this->destination + this->size);
+      this->size += length;
+      return true;
+    }
+
+    /**
+     * @brief Writes a sequence of literals, optionally followed by a match.
+     */
+    bool PutSequence(const byte* literals, size_t literal_length, size_t offset, size_t match_length) {
+      auto extra_match = match_length > 0 ? match_length - MIN_MATCH : 0;
+      auto token = static_cast<byte>((std::min<size_t>(literal_length, 15) << 4) | std::min<size_t>(extra_match, 15));
+
+      return this->Put(token)
+          && (literal_length < 15 || this->PutLength(literal_length - 15))
+          && this->Put(literals, literal_length)
+          && (match_length == 0 || (this->Put(static_cast<byte>(offset)) && this->Put(static_cast<byte>(offset >> 8))
+              && (extra_match < 15 || this->PutLength(extra_match - 15))));
+    }
+};
+
+CodecType LzCodec::Type() const {
+  return CodecType::Lz;
+}
+
+size_t LzCodec::Compress(const byte *source, size_t size, byte *destination, size_t capacity) const {
+  std::vector<uint32_t> table(size_t{1} << HASH_BITS, NO_POSITION);
+  LzWriter writer(destination, capacity);
+
+  size_t anchor = 0;
+  size_t position = 0;
+  while (position + MIN_MATCH <= size) {
+    auto sequence = Load32(source + position);
+    auto& entry = table[Hash(sequence)];
+    auto candidate = entry;
+    entry = static_cast<uint32_t>(position);
+
+    if (candidate == NO_POSITION || position - candidate > MAX_OFFSET || Load32(source + candidate) != sequence) {
+      position++;
+      continue;
+    }
+
+    auto length = MIN_MATCH;
+    while (position + length < size && source[candidate + length] == source[position + length]) {
+      length++;
+    }
+
+    if (!writer.PutSequence(source + anchor, position - anchor, position - candidate, length)) {
+      return 0;
+    }
+
+    position += length;
+    anchor = position;
+  }
+
+  if (!writer.PutSequence(source + anchor, size - anchor, 0, 0)) {
+    return 0;
+  }
+
+  return writer.Size();
+}
+
+void LzCodec::Decompress(const byte *source, size_t size, byte *destination, size_t decompressed_size) const {
+  auto corrupt = [] {
+    return std::runtime_error("Cannot decompress data: it is corrupt.");
+  };
+
+  size_t input = 0;
+  size_t output = 0;
+  auto read_length = [&](size_t length) {
+    if (length < 15) {
+      return length;
+    }
+
+    byte extension;
+    do {
+      if (input == size) {
+        throw corrupt();
+      }
+
+      extension = source[input++];
+      length += extension;
+    } while (extension == 255);
+
+    return length;
+  };
+
+  while (input < size) {
+    auto token = source[input++];
+
+    auto literal_length = read_length(token >> 4);
+    if (size - input < literal_length || decompressed_size - output < literal_length) {
+      throw corrupt();
+    }
+
+    std::copy(source + input, source + input + literal_length, destination + output);
+    input += literal_length;
+    output += literal_length;
+
+    if (input == size) {
+      break;
+    }
+
+    if (size - input < 2) {
+      throw corrupt();
+    }
+
+    size_t offset = source[input] | (source[input + 1] << 8);
+    input += 2;
+
+    auto match_length = read_length(token & 0x0f) + MIN_MATCH;
+    if (offset == 0 || offset > output || decompressed_size - output < match_length) {
+      throw corrupt();
+    }
+
+    // Matches may overlap their own output, so they are copied byte by byte.
+    for (size_t i = 0; i < match_length; i++, output++) {
+      destination[output] = destination[output - offset];
+    }
+  }
+
+  if (output != decompressed_size) {
+    throw corrupt();
+  }
+}
+
+}
\ No newline at end of file
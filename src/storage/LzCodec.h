@@ -0,0 +1,35 @@
+#ifndef NOID_SRC_STORAGE_LZCODEC_H_
+#define NOID_SRC_STORAGE_LZCODEC_H_
+
+#include <cstddef>
+
+#include "Codec.h"
+
+namespace noid::storage {
+
+/**
+ * @brief A fast LZ77 codec, using a block format similar to LZ4.
+ * @details The compressed data is a sequence of literal runs, each followed by a back-reference of at least four
+ * bytes into the preceding 64 KiB of decompressed data. Every sequence starts with a token byte containing the
+ * literal length in its high nibble and the match length minus four in its low nibble. A nibble of 15 is followed by
+ * extension bytes, which are added to it until a byte less than 255 is encountered. Then follow the literals, the
+ * 16-bit little endian match offset and the match length extension bytes. The last sequence only contains literals.
+ *
+ * Matches are found using a single-entry hash table of four byte prefixes, trading compression ratio for speed.
+ */
+class LzCodec : public Codec {
+ public:
+
+    /**
+     * @return @c CodecType::Lz
+     */
+    [[nodiscard]] CodecType Type() const override;
+
+    size_t Compress(const byte* source, size_t size, byte* destination, size_t capacity) const override;
+
+    void Decompress(const byte* source, size_t size, byte* destination, size_t decompressed_size) const override;
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_LZCODEC_H_
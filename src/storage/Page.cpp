@@ -0,0 +1,35 @@
+#include "Page.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#include "Crc32c.h"
+
+namespace noid::storage {
+
+static const size_t CHECKSUM_OFFSET = offsetof(PageHeader, checksum);
+static const size_t CHECKSUM_END = CHECKSUM_OFFSET + sizeof(uint32_t);
+
+uint32_t ComputePageChecksum(const byte *page) {
+  auto crc = Crc32c(page, CHECKSUM_OFFSET);
+  return Crc32c(page + CHECKSUM_END, PAGE_SIZE - CHECKSUM_END, crc);
+}
+
+void SealPage(byte *page) {
+  auto checksum = ComputePageChecksum(page);
+  std::memcpy(page + CHECKSUM_OFFSET, &checksum, sizeof(uint32_t));
+}
+
+bool VerifyPage(const byte *page) {
+  uint32_t checksum;
+  std::memcpy(&checksum, page + CHECKSUM_OFFSET, sizeof(uint32_t));
+
+  if (checksum == ComputePageChecksum(page)) {
+    return true;
+  }
+
+  return std::all_of(page, page + PAGE_SIZE, [](byte b) { return b == 0; });
+}
+
+}
\ No newline at end of file
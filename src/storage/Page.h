@@ -0,0 +1,89 @@
+#ifndef NOID_SRC_STORAGE_PAGE_H_
+#define NOID_SRC_STORAGE_PAGE_H_
+
+#include <cstdint>
+#include <limits>
+
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief Alias for the page number within a @c PageFile.
+ */
+using PageId = uint64_t;
+
+/**
+ * @brief Alias for a log sequence number, which uniquely identifies a record in the @c WriteAheadLog.
+ */
+using Lsn = uint64_t;
+
+/**
+ * @brief The size in bytes of a single page.
+ */
+const uint32_t PAGE_SIZE = 4096;
+
+/**
+ * @brief Sentinel value for a page id that does not point to a page.
+ */
+const PageId INVALID_PAGE_ID = std::numeric_limits<PageId>::max();
+
+/**
+ * @brief Sentinel value for a log sequence number that does not point to a log record. The first record in a
+ * @c WriteAheadLog always has an LSN of 1.
+ */
+const Lsn INVALID_LSN = 0;
+
+/**
+ * @brief The header every page starts with.
+ */
+struct PageHeader {
+
+    /**
+     * @brief The LSN of the log record describing the latest modification of the page.
+     */
+    Lsn lsn;
+
+    /**
+     * @brief The CRC32C checksum of all other bytes of the page, which is set when the page is written.
+     */
+    uint32_t checksum;
+
+    /**
+     * @brief Reserved for future use.
+     */
+    uint32_t reserved;
+};
+
+/**
+ * @brief The size in bytes of the @c PageHeader. Page contents start at this offset.
+ */
+const uint32_t PAGE_HEADER_SIZE = sizeof(PageHeader);
+
+/**
+ * @brief Computes the checksum of the given page, skipping the checksum stored in its @c PageHeader.
+ *
+ * @param page The page contents, which must contain @c PAGE_SIZE bytes.
+ * @return The checksum.
+ */
+uint32_t ComputePageChecksum(const byte* page);
+
+/**
+ * @brief Stores the checksum of the given page in its @c PageHeader. This must be done before the page is written.
+ *
+ * @param page The page contents, which must contain @c PAGE_SIZE bytes.
+ */
+void SealPage(byte* page);
+
+/**
+ * @brief Verifies the checksum stored in the @c PageHeader of the given page.
+ * @details A page containing only zeroes is valid, since it has never been written.
+ *
+ * @param page The page contents, which must contain @c PAGE_SIZE bytes.
+ * @return Whether the page is intact.
+ */
+bool VerifyPage(const byte* page);
+
+}
+
+#endif //NOID_SRC_STORAGE_PAGE_H_
@@ -0,0 +1,319 @@
+#include "PageAllocator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace noid::storage {
+
+/**
+ * Identifies page 0 as the first bitmap page of an allocator.
+ */
+static const uint64_t ALLOCATOR_MAGIC = 0x6e6f6964616c6c63;
+
+/**
+ * The offsets of the magic and the page count in page 0.
+ */
+static const size_t MAGIC_OFFSET = PAGE_HEADER_SIZE;
+static const size_t PAGE_COUNT_OFFSET = MAGIC_OFFSET + sizeof(uint64_t);
+
+/**
+ * The offset of the bitmap in every bitmap page. The preceding bytes are only used in page 0.
+ */
+static const size_t BITMAP_OFFSET = PAGE_COUNT_OFFSET + sizeof(uint64_t);
+
+/**
+ * The amount of pages described by a single bitmap page, including the bitmap page itself.
+ */
+static const PageId PAGES_PER_GROUP = (PAGE_SIZE - BITMAP_OFFSET) * 8;
+
+static bool IsBitmapPage(PageId page_id) {
+  return page_id % PAGES_PER_GROUP == 0;
+}
+
+PageAllocator::PageAllocator(std::shared_ptr<BufferPool> pool, PageId reserved_pages)
+  : pool(std::move(pool)), reserved_pages(reserved_pages), page_count(0), next_group(0) {}
+
+void PageAllocator::Load() {
+  uint64_t magic;
+  {
+    auto page = this->pool->Fetch(0);
+    std::shared_lock<std::shared_mutex> latch(page.Latch());
+    std::memcpy(&magic, page.Data() + MAGIC_OFFSET, sizeof(uint64_t));
+    std::memcpy(&this->page_count, page.Data() + PAGE_COUNT_OFFSET, sizeof(PageId));
+  }
+
+  if (magic == 0) {
+    auto page = this->pool->Fetch(0);
+    std::unique_lock<std::shared_mutex> latch(page.Latch());
+
+    // Page 0 and the reserved pages are allocated from the start.
+    this->page_count = 1 + this->reserved_pages;
+    for (PageId id = 0; id < this->page_count; id++) {
+      page.MutableData()[BITMAP_OFFSET + id / 8] |= static_cast<byte>(1 << (id % 8));
+    }
+
+    std::memcpy(page.MutableData() + MAGIC_OFFSET, &ALLOCATOR_MAGIC, sizeof(uint64_t));
+    std::memcpy(page.MutableData() + PAGE_COUNT_OFFSET, &this->page_count, sizeof(PageId));
+    page.MarkDirty();
+
+    this->loaded_groups.push_back(true);
+    this->next_group = 1;
+    return;
+  } else if (magic != ALLOCATOR_MAGIC) {
+    throw std::runtime_error("Cannot open page allocator: page 0 does not contain an allocator bitmap.");
+  }
+
+  // The bitmaps are read on demand, so opening a large file does not require reading all of them.
+  this->loaded_groups.resize((this->page_count + PAGES_PER_GROUP - 1) / PAGES_PER_GROUP);
+}
+
+void PageAllocator::LoadGroup(PageId page_id) {
+  auto index = page_id / PAGES_PER_GROUP;
+  if (index >= this->loaded_groups.size() || this->loaded_groups[index]) {
+    return;
+  }
+
+  auto group = index * PAGES_PER_GROUP;
+  auto page = this->pool->Fetch(group);
+  std::shared_lock<std::shared_mutex> latch(page.Latch());
+
+  auto end = std::min(this->page_count, group + PAGES_PER_GROUP);
+  for (auto id = group; id < end; id++) {
+    auto bit = id - group;
+    if ((page.Data()[BITMAP_OFFSET + bit / 8] & (1 << (bit % 8))) == 0) {
+      this->free_pages.insert(id);
+    }
+  }
+
+  this->loaded_groups[index] = true;
+}
+
+bool PageAllocator::LoadNextGroup() {
+  while (this->next_group < this->loaded_groups.size() && this->loaded_groups[this->next_group]) {
+    this->next_group++;
+  }
+
+  if (this->next_group == this->loaded_groups.size()) {
+    return false;
+  }
+
+  this->LoadGroup(this->next_group * PAGES_PER_GROUP);
+  return true;
+}
+
+void PageAllocator::SetAllocated(PageId page_id, bool allocated) {
+  auto group = page_id - page_id % PAGES_PER_GROUP;
+  auto bit = page_id - group;
+
+  auto page = this->pool->Fetch(group);
+  std::unique_lock<std::shared_mutex> latch(page.Latch());
+
+  auto& bits = page.MutableData()[BITMAP_OFFSET + bit / 8];
+  if (allocated) {
+    bits |= static_cast<byte>(1 << (bit % 8));
+  } else {
+    bits &= static_cast<byte>(~(1 << (bit % 8)));
+  }
+
+  page.MarkDirty();
+}
+
+void PageAllocator::WritePageCount() {
+  auto page = this->pool->Fetch(0);
+  std::unique_lock<std::shared_mutex> latch(page.Latch());
+
+  std::memcpy(page.MutableData() + PAGE_COUNT_OFFSET, &this->page_count, sizeof(PageId));
+  page.MarkDirty();
+}
+
+void PageAllocator::Grow(PageId count) {
+  auto end = this->page_count + count;
+
+  for (auto id = this->page_count; id < end; id++) {
+    if (IsBitmapPage(id)) {
+      // A new group starts here. Its pages beyond the end of the file are free, so only the bitmap page itself
+      // must be marked allocated.
+      auto page = this->pool->Fetch(id);
+      std::unique_lock<std::shared_mutex> latch(page.Latch());
+
+      std::memset(page.MutableData(), 0, PAGE_SIZE);
+      page.MutableData()[BITMAP_OFFSET] = 1;
+      page.MarkDirty();
+      this->loaded_groups.push_back(true);
+    } else {
+      this->free_pages.insert(id);
+    }
+  }
+
+  this->page_count = end;
+  this->WritePageCount();
+}
+
+std::unique_ptr<PageAllocator> PageAllocator::Open(std::shared_ptr<BufferPool> pool, PageId reserved_pages) {
+  if (reserved_pages + 1 >= PAGES_PER_GROUP) {
+    throw std::invalid_argument("Expect the reserved pages to fit in the first bitmap group.");
+  }
+
+  auto allocator = std::unique_ptr<PageAllocator>(new PageAllocator(std::move(pool), reserved_pages));
+  allocator->Load();
+
+  return allocator;
+}
+
+PageId PageAllocator::Allocate(PageId hint) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  if (hint != INVALID_PAGE_ID) {
+    this->LoadGroup(hint);
+  }
+
+  while (this->free_pages.empty()) {
+    if (!this->LoadNextGroup()) {
+      this->Grow(PAGE_ALLOCATOR_EXTENT_SIZE);
+    }
+  }
+
+  auto candidate = this->free_pages.begin();
+  if (hint != INVALID_PAGE_ID) {
+    // Choose the closest free page on either side of the hint.
+    candidate = this->free_pages.lower_bound(hint);
+    if (candidate == this->free_pages.end()) {
+      candidate = std::prev(candidate);
+    } else if (candidate != this->free_pages.begin() && *candidate - hint > hint - *std::prev(candidate)) {
+      candidate = std::prev(candidate);
+    }
+  }
+
+  auto page_id = *candidate;
+  this->free_pages.erase(candidate);
+  this->SetAllocated(page_id, true);
+
+  return page_id;
+}
+
+PageId PageAllocator::AllocateExtent(PageId count, PageId hint) {
+  if (count == 0 || count >= PAGES_PER_GROUP) {
+    throw std::invalid_argument("Expect an extent of at least one page, which fits in a bitmap group.");
+  }
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  if (hint != INVALID_PAGE_ID) {
+    this->LoadGroup(hint);
+  }
+
+  // Find the first run of enough free pages at or after the hint, wrapping around to the start of the file. Growing
+  // the file always creates such a run, unless a new bitmap page splits it.
+  auto start = hint == INVALID_PAGE_ID ? this->free_pages.begin() : this->free_pages.lower_bound(hint);
+  auto first = INVALID_PAGE_ID;
+
+  while (first == INVALID_PAGE_ID) {
+    for (auto pass = 0; pass < 2 && first == INVALID_PAGE_ID; pass++) {
+      auto begin = pass == 0 ? start : this->free_pages.begin();
+      auto end = pass == 0 ? this->free_pages.end() : start;
+
+      PageId run = 0;
+      for (auto it = begin; it != end; it++) {
+        run = run > 0 && *it == *std::prev(it) + 1 ? run + 1 : 1;
+        if (run == count) {
+          first = *it - count + 1;
+          break;
+        }
+      }
+    }
+
+    if (first == INVALID_PAGE_ID) {
+      if (!this->LoadNextGroup()) {
+        this->Grow(std::max(count, PAGE_ALLOCATOR_EXTENT_SIZE));
+      }
+      start = this->free_pages.begin();
+    }
+  }
+
+  for (auto id = first; id < first + count; id++) {
+    this->free_pages.erase(id);
+    this->SetAllocated(id, true);
+  }
+
+  return first;
+}
+
+void PageAllocator::Free(PageId page_id) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  if (page_id >= this->page_count || page_id <= this->reserved_pages || IsBitmapPage(page_id)) {
+    throw std::logic_error("Cannot free page " + std::to_string(page_id) + ": it is not managed by the allocator.");
+  }
+
+  this->LoadGroup(page_id);
+  if (this->free_pages.count(page_id) > 0) {
+    throw std::logic_error("Cannot free page " + std::to_string(page_id) + ": it is free already.");
+  }
+
+  this->pool->Discard(page_id);
+  this->SetAllocated(page_id, false);
+  this->free_pages.insert(page_id);
+}
+
+void PageAllocator::Reserve(PageId page_id) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  if (page_id <= this->reserved_pages || IsBitmapPage(page_id)) {
+    throw std::logic_error("Cannot reserve page " + std::to_string(page_id) + ": it is not managed by the allocator.");
+  } else if (page_id >= this->page_count) {
+    this->Grow(page_id + 1 - this->page_count);
+  }
+
+  this->LoadGroup(page_id);
+  if (this->free_pages.erase(page_id) == 0) {
+    throw std::logic_error("Cannot reserve page " + std::to_string(page_id) + ": it is allocated already.");
+  }
+
+  this->SetAllocated(page_id, true);
+}
+
+PageId PageAllocator::Truncate() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+
+  // A trailing bitmap page can be released as well, since all pages of its group follow it.
+  auto new_count = this->page_count;
+  while (new_count > 1 + this->reserved_pages) {
+    auto last = new_count - 1;
+    this->LoadGroup(last);
+    if (this->free_pages.count(last) == 0 && !IsBitmapPage(last)) {
+      break;
+    }
+
+    new_count--;
+  }
+
+  if (new_count == this->page_count) {
+    return new_count;
+  }
+
+  this->free_pages.erase(this->free_pages.lower_bound(new_count), this->free_pages.end());
+  this->loaded_groups.resize((new_count + PAGES_PER_GROUP - 1) / PAGES_PER_GROUP);
+  this->next_group = std::min(this->next_group, this->loaded_groups.size());
+  this->page_count = new_count;
+  this->WritePageCount();
+  this->pool->Truncate(new_count);
+
+  return new_count;
+}
+
+PageId PageAllocator::PageCount() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->page_count;
+}
+
+PageId PageAllocator::FreePageCount() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  while (this->LoadNextGroup()) {}
+
+  return this->free_pages.size();
+}
+
+}
\ No newline at end of file
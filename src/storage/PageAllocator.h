@@ -0,0 +1,207 @@
+#ifndef NOID_SRC_STORAGE_PAGEALLOCATOR_H_
+#define NOID_SRC_STORAGE_PAGEALLOCATOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "BufferPool.h"
+#include "Page.h"
+
+namespace noid::storage {
+
+/**
+ * @brief The amount of pages by which a @c PageAllocator grows its file when no free page is left.
+ */
+const PageId PAGE_ALLOCATOR_EXTENT_SIZE = 32;
+
+/**
+ * @brief Keeps track of the free and allocated pages in a @c PageFile, so freed pages are reused instead of
+ * growing the file.
+ * @details The allocation state of every page is stored in a bitmap. The file is divided into groups of pages, of
+ * which the first page contains the bitmap of the group. The bitmap page of the first group, page 0, also contains
+ * the amount of pages managed by the allocator. A set of all free pages is kept in memory, so allocations do not need
+ * to scan the bitmaps.
+ *
+ * Opening an allocator only reads page 0. The bitmap of a group is read when one of its pages is freed or used as an
+ * allocation hint, and the remaining groups are read one at a time when the groups read so far have no free page
+ * left. The file only grows once all groups have been read.
+ *
+ * Allocations can be given a hint, in which case the free page closest to it is returned. Pages that are allocated
+ * together, like a node and its split sibling, therefore end up close to each other on disk. When no free page is
+ * left, the file grows by an extent of @c PAGE_ALLOCATOR_EXTENT_SIZE pages at once. Trailing free pages can be
+ * released using @c Truncate.
+ *
+ * Bitmap pages are modified through the @c BufferPool and are not logged, so they become durable when the pool is
+ * flushed. Pages allocated after the last flush leak if the process crashes, but a page is never handed out twice
+ * if callers free pages only after the structures referencing them have been flushed.
+ */
+class PageAllocator {
+ private:
+
+    /**
+     * The pool containing the managed pages.
+     */
+    const std::shared_ptr<BufferPool> pool;
+
+    /**
+     * The amount of pages following page 0 that are reserved for fixed-location metadata of the caller.
+     */
+    const PageId reserved_pages;
+
+    /**
+     * Protects all allocator state.
+     */
+    std::mutex mutex;
+
+    /**
+     * The amount of pages managed by this allocator, both free and allocated.
+     */
+    PageId page_count;
+
+    /**
+     * The ids of all free pages in the groups read so far, in ascending order.
+     */
+    std::set<PageId> free_pages;
+
+    /**
+     * Whether the bitmap of every group has been read, by group index.
+     */
+    std::vector<bool> loaded_groups;
+
+    /**
+     * The index of the first group of which the bitmap may not have been read yet.
+     */
+    size_t next_group;
+
+    /**
+     * @brief Creates a new @c PageAllocator.
+     *
+     * @param pool The pool containing the managed pages.
+     * @param reserved_pages The amount of reserved pages following page 0.
+     */
+    PageAllocator(std::shared_ptr<BufferPool> pool, PageId reserved_pages);
+
+    /**
+     * @brief Initializes a new allocator, or reads the page count of an existing one.
+     *
+     * @throws std::runtime_error If page 0 does not belong to an allocator.
+     */
+    void Load();
+
+    /**
+     * @brief Reads the bitmap of the group containing the given page, unless it has been read already.
+     *
+     * @param page_id A page in the group.
+     */
+    void LoadGroup(PageId page_id);
+
+    /**
+     * @brief Reads the bitmap of the first group which has not been read yet.
+     *
+     * @return Whether such a group existed.
+     */
+    bool LoadNextGroup();
+
+    /**
+     * @brief Marks the given page as allocated or free in its bitmap.
+     *
+     * @param page_id The page.
+     * @param allocated Whether the page is allocated.
+     */
+    void SetAllocated(PageId page_id, bool allocated);
+
+    /**
+     * @brief Stores the current page count in page 0.
+     */
+    void WritePageCount();
+
+    /**
+     * @brief Adds the given amount of pages to the end of the file, initializing bitmap pages where required.
+     *
+     * @param count The amount of pages to add.
+     */
+    void Grow(PageId count);
+
+ public:
+
+    /**
+     * @brief Opens the allocator of the file cached by the given @p pool, initializing it if the file is empty.
+     *
+     * @param pool The pool containing the managed pages.
+     * @param reserved_pages The amount of pages following page 0 that are never allocated, so the caller can store
+     * its own metadata at a fixed location. This is only used when initializing a new allocator.
+     * @return The allocator.
+     * @throws std::invalid_argument If @p reserved_pages does not fit in the first bitmap group.
+     * @throws std::runtime_error If the file does not contain an allocator.
+     */
+    [[nodiscard]] static std::unique_ptr<PageAllocator> Open(std::shared_ptr<BufferPool> pool,
+                                                             PageId reserved_pages = 0);
+
+    PageAllocator()= delete;
+    PageAllocator(PageAllocator const&)= delete;
+    PageAllocator(PageAllocator &&)= delete;
+    ~PageAllocator()= default;
+
+    PageAllocator& operator=(PageAllocator const&)= delete;
+    PageAllocator& operator=(PageAllocator &&)= delete;
+
+    /**
+     * @brief Allocates a single page.
+     *
+     * @param hint A page close to which the new page should be allocated, or @c INVALID_PAGE_ID.
+     * @return The id of the allocated page.
+     */
+    PageId Allocate(PageId hint = INVALID_PAGE_ID);
+
+    /**
+     * @brief Allocates @p count contiguous pages.
+     *
+     * @param count The amount of pages.
+     * @param hint A page close to which the pages should be allocated, or @c INVALID_PAGE_ID.
+     * @return The id of the first allocated page.
+     * @throws std::invalid_argument If @p count is zero, or exceeds the size of a bitmap group.
+     */
+    PageId AllocateExtent(PageId count, PageId hint = INVALID_PAGE_ID);
+
+    /**
+     * @brief Returns the given page to the allocator. Its cached contents are discarded without being written.
+     *
+     * @param page_id The page to free.
+     * @throws std::logic_error If the page is not allocated, or cannot be freed.
+     */
+    void Free(PageId page_id);
+
+    /**
+     * @brief Marks the given free page as allocated, growing the file if the page lies beyond its end.
+     * @details This rebuilds the allocation state of a file of which the pages are written at known locations, like
+     * a copy of another file.
+     *
+     * @param page_id The page to allocate.
+     * @throws std::logic_error If the page is allocated already, or is not managed by the allocator.
+     */
+    void Reserve(PageId page_id);
+
+    /**
+     * @brief Releases all free pages at the end of the file, shrinking it.
+     *
+     * @return The amount of pages remaining.
+     */
+    PageId Truncate();
+
+    /**
+     * @return The amount of pages managed by this allocator, both free and allocated.
+     */
+    PageId PageCount();
+
+    /**
+     * @return The amount of free pages. This reads the bitmaps of all groups.
+     */
+    PageId FreePageCount();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_PAGEALLOCATOR_H_
@@ -0,0 +1,147 @@
+#include "PageFile.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AlignedBuffer.h"
+#include "SyncIoBackend.h"
+#include "UringIoBackend.h"
+
+namespace noid::storage {
+
+PageFile::PageFile(int fd, IoBackendType backend_type, bool direct_io) : fd(fd), direct_io(direct_io) {
+  if (backend_type == IoBackendType::IoUring) {
+    try {
+      this->backend = UringIoBackend::Create(fd);
+    } catch (std::system_error&) {
+      // Fall back to the synchronous backend below.
+    }
+  }
+
+  if (!this->backend) {
+    this->backend = std::make_unique<SyncIoBackend>(fd);
+  }
+}
+
+void PageFile::Transfer(const std::vector<PageIo> &batch, bool write) {
+  std::vector<size_t> unaligned;
+  if (this->direct_io) {
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (!IsAligned(batch[i].buffer)) {
+        unaligned.push_back(i);
+      }
+    }
+  }
+
+  if (unaligned.empty()) {
+    if (write) {
+      this->backend->Write(batch);
+    } else {
+      this->backend->Read(batch);
+    }
+
+    return;
+  }
+
+  auto staging = AllocateAligned(unaligned.size() * PAGE_SIZE);
+  auto staged = batch;
+  for (size_t i = 0; i < unaligned.size(); i++) {
+    staged[unaligned[i]].buffer = staging.get() + i * PAGE_SIZE;
+    if (write) {
+      std::memcpy(staged[unaligned[i]].buffer, batch[unaligned[i]].buffer, PAGE_SIZE);
+    }
+  }
+
+  if (write) {
+    this->backend->Write(staged);
+  } else {
+    this->backend->Read(staged);
+    for (auto index : unaligned) {
+      std::memcpy(batch[index].buffer, staged[index].buffer, PAGE_SIZE);
+    }
+  }
+}
+
+std::unique_ptr<PageFile> PageFile::Open(const std::filesystem::path &path, IoBackendType backend_type,
+                                         bool direct_io) {
+  const auto flags = O_RDWR | O_CREAT | O_CLOEXEC;
+
+  auto fd = -1;
+  if (direct_io) {
+    fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+
+    // File systems which do not support direct I/O, like tmpfs, reject it using EINVAL.
+    if (fd < 0 && errno != EINVAL) {
+      throw std::system_error(errno, std::generic_category(), "Cannot open page file " + path.string());
+    }
+  }
+
+  auto opened_direct = fd >= 0;
+  if (!opened_direct) {
+    fd = ::open(path.c_str(), flags, 0644);
+  }
+
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot open page file " + path.string());
+  }
+
+  return std::unique_ptr<PageFile>(new PageFile(fd, backend_type, opened_direct));
+}
+
+PageFile::~PageFile() {
+  // The backend might still refer to the file descriptor.
+  this->backend.reset();
+  ::close(this->fd);
+}
+
+PageId PageFile::PageCount() {
+  struct stat st{};
+  if (::fstat(this->fd, &st) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot determine page file size");
+  }
+
+  return (static_cast<PageId>(st.st_size) + PAGE_SIZE - 1) / PAGE_SIZE;
+}
+
+void PageFile::Read(PageId page_id, byte *buffer) {
+  this->Transfer({{page_id, buffer}}, false);
+}
+
+void PageFile::Write(PageId page_id, const byte *buffer) {
+  this->Transfer({{page_id, const_cast<byte*>(buffer)}}, true);
+}
+
+void PageFile::ReadBatch(const std::vector<PageIo> &batch) {
+  this->Transfer(batch, false);
+}
+
+void PageFile::WriteBatch(const std::vector<PageIo> &batch) {
+  this->Transfer(batch, true);
+}
+
+IoBackendType PageFile::BackendType() const {
+  return this->backend->Type();
+}
+
+bool PageFile::DirectIo() const {
+  return this->direct_io;
+}
+
+void PageFile::Truncate(PageId page_count) {
+  if (::ftruncate(this->fd, static_cast<off_t>(page_count * PAGE_SIZE)) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot truncate page file");
+  }
+}
+
+void PageFile::Sync() {
+  if (::fdatasync(this->fd) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot synchronize page file");
+  }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,154 @@
+#ifndef NOID_SRC_STORAGE_PAGEFILE_H_
+#define NOID_SRC_STORAGE_PAGEFILE_H_
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "IoBackend.h"
+#include "Page.h"
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief A file which is read and written in units of @c PAGE_SIZE bytes.
+ * @details Reads and writes are positional, so a single @c PageFile can be shared between threads. They are
+ * executed by an @c IoBackend, which determines whether the pages of a batch are processed one by one, or
+ * concurrently. Buffers should be aligned to @c PAGE_SIZE, which avoids intermediate copies when using direct I/O.
+ */
+class PageFile {
+ private:
+
+    /**
+     * The file descriptor of the opened file.
+     */
+    int fd;
+
+    /**
+     * Whether the file was opened using @c O_DIRECT.
+     */
+    const bool direct_io;
+
+    /**
+     * The backend executing the page reads and writes.
+     */
+    std::unique_ptr<IoBackend> backend;
+
+    /**
+     * @brief Creates a new @c PageFile wrapping the given file descriptor, which is closed on destruction.
+     *
+     * @param fd The file descriptor.
+     * @param backend_type The preferred backend type.
+     * @param direct_io Whether the file descriptor was opened using @c O_DIRECT.
+     */
+    PageFile(int fd, IoBackendType backend_type, bool direct_io);
+
+    /**
+     * @brief Reads or writes the given pages using the backend.
+     * @details Using direct I/O, pages in buffers that are not aligned to @c PAGE_SIZE are transferred through
+     * aligned intermediate buffers.
+     *
+     * @param batch The pages to read or write.
+     * @param write Whether to write (@c true) or read (@c false) the pages.
+     */
+    void Transfer(const std::vector<PageIo>& batch, bool write);
+
+ public:
+
+    /**
+     * @brief Opens the page file at the given @p path, creating it if it does not exist yet.
+     * @details If the @c IoBackendType::IoUring backend is requested but cannot be set up, for example because the
+     * kernel does not support it, the file falls back to the @c IoBackendType::Synchronous backend.
+     *
+     * Direct I/O bypasses the operating system page cache, so pages cached by a @c BufferPool are not cached twice.
+     * If the file system does not support it, the file falls back to buffered I/O.
+     *
+     * @param path The location of the file.
+     * @param backend_type The preferred backend type.
+     * @param direct_io Whether to prefer direct I/O (@c O_DIRECT) over buffered I/O.
+     * @return The opened page file.
+     * @throws std::system_error If the file cannot be opened.
+     */
+    [[nodiscard]] static std::unique_ptr<PageFile> Open(const std::filesystem::path& path,
+                                                        IoBackendType backend_type = IoBackendType::Synchronous,
+                                                        bool direct_io = false);
+
+    PageFile()= delete;
+    PageFile(PageFile const&)= delete;
+    PageFile(PageFile &&)= delete;
+    ~PageFile();
+
+    PageFile& operator=(PageFile const&)= delete;
+    PageFile& operator=(PageFile &&)= delete;
+
+    /**
+     * @return The amount of pages in this file, including a possibly partially written last page.
+     * @throws std::system_error If the file size cannot be determined.
+     */
+    PageId PageCount();
+
+    /**
+     * @brief Reads the page with the given @p page_id into @p buffer.
+     * @details Reading a page beyond the end of the file yields a page containing only zeroes.
+     *
+     * @param page_id The page to read.
+     * @param buffer The destination, which must be able to contain at least @c PAGE_SIZE bytes.
+     * @throws std::system_error If the page cannot be read.
+     */
+    void Read(PageId page_id, byte* buffer);
+
+    /**
+     * @brief Writes @c PAGE_SIZE bytes from @p buffer to the page with the given @p page_id.
+     *
+     * @param page_id The page to write.
+     * @param buffer The source, which must contain at least @c PAGE_SIZE bytes.
+     * @throws std::system_error If the page cannot be written.
+     */
+    void Write(PageId page_id, const byte* buffer);
+
+    /**
+     * @brief Reads all given pages in a single batch.
+     *
+     * @param batch The pages to read.
+     * @throws std::system_error If any page cannot be read.
+     */
+    void ReadBatch(const std::vector<PageIo>& batch);
+
+    /**
+     * @brief Writes all given pages in a single batch.
+     *
+     * @param batch The pages to write.
+     * @throws std::system_error If any page cannot be written.
+     */
+    void WriteBatch(const std::vector<PageIo>& batch);
+
+    /**
+     * @return The type of the backend executing the page reads and writes.
+     */
+    [[nodiscard]] IoBackendType BackendType() const;
+
+    /**
+     * @return Whether pages are transferred using direct I/O, bypassing the operating system page cache.
+     */
+    [[nodiscard]] bool DirectIo() const;
+
+    /**
+     * @brief Truncates or extends the file to the given amount of pages.
+     *
+     * @param page_count The new amount of pages.
+     * @throws std::system_error If the file cannot be truncated.
+     */
+    void Truncate(PageId page_count);
+
+    /**
+     * @brief Flushes all written pages to stable storage.
+     *
+     * @throws std::system_error If the file cannot be synchronized.
+     */
+    void Sync();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_PAGEFILE_H_
@@ -0,0 +1,50 @@
+#include "RateLimiter.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace noid::storage {
+
+RateLimiter::RateLimiter(uint64_t bytes_per_second)
+  : bytes_per_second(bytes_per_second), available(0), last_refill(std::chrono::steady_clock::now()) {}
+
+void RateLimiter::Acquire(uint64_t bytes) {
+  std::chrono::duration<double> wait(0);
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->bytes_per_second == 0) {
+      return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - this->last_refill;
+    auto rate = static_cast<double>(this->bytes_per_second);
+    auto burst = rate / 10;
+
+    this->available = std::min(burst, this->available + elapsed.count() * rate);
+    this->last_refill = now;
+    this->available -= static_cast<double>(bytes);
+
+    if (this->available < 0) {
+      wait = std::chrono::duration<double>(-this->available / rate);
+    }
+  }
+
+  if (wait.count() > 0) {
+    std::this_thread::sleep_for(wait);
+  }
+}
+
+void RateLimiter::SetBytesPerSecond(uint64_t rate) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->bytes_per_second = rate;
+  this->available = 0;
+  this->last_refill = std::chrono::steady_clock::now();
+}
+
+uint64_t RateLimiter::BytesPerSecond() {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->bytes_per_second;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef NOID_SRC_STORAGE_RATELIMITER_H_
+#define NOID_SRC_STORAGE_RATELIMITER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace noid::storage {
+
+/**
+ * @brief Limits the throughput of background I/O to a configurable amount of bytes per second.
+ * @details The limiter is a token bucket which allows bursts of up to a tenth of a second worth of bytes. Callers
+ * requesting more bytes than are available go into debt, and sleep until that debt is paid off. This serves
+ * concurrent callers in the order they requested their bytes.
+ */
+class RateLimiter {
+ private:
+
+    /**
+     * The maximum throughput, or zero if the throughput is unlimited.
+     */
+    uint64_t bytes_per_second;
+
+    /**
+     * The amount of bytes that may be acquired without waiting. Negative if callers are in debt.
+     */
+    double available;
+
+    /**
+     * The moment @c available was last refilled.
+     */
+    std::chrono::steady_clock::time_point last_refill;
+
+    /**
+     * Protects the bucket state.
+     */
+    std::mutex mutex;
+
+ public:
+
+    /**
+     * @brief Creates a new @c RateLimiter.
+     *
+     * @param bytes_per_second The maximum throughput, or zero for unlimited throughput.
+     */
+    explicit RateLimiter(uint64_t bytes_per_second);
+    RateLimiter()= delete;
+    RateLimiter(RateLimiter const&)= delete;
+    RateLimiter(RateLimiter &&)= delete;
+    ~RateLimiter()= default;
+
+    RateLimiter& operator=(RateLimiter const&)= delete;
+    RateLimiter& operator=(RateLimiter &&)= delete;
+
+    /**
+     * @brief Blocks until the given amount of bytes may be processed without exceeding the maximum throughput.
+     *
+     * @param bytes The amount of bytes to process.
+     */
+    void Acquire(uint64_t bytes);
+
+    /**
+     * @brief Changes the maximum throughput. Callers that are already waiting are not affected.
+     *
+     * @param rate The new maximum throughput, or zero for unlimited throughput.
+     */
+    void SetBytesPerSecond(uint64_t rate);
+
+    /**
+     * @return The maximum throughput, or zero if the throughput is unlimited.
+     */
+    uint64_t BytesPerSecond();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_RATELIMITER_H_
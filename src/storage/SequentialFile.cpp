@@ -0,0 +1,170 @@
+#include "SequentialFile.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace noid::storage {
+
+SequentialWriter::SequentialWriter(int fd, size_t buffer_size) : fd(fd), offset(0) {
+  this->buffer.reserve(buffer_size);
+}
+
+void SequentialWriter::FlushBuffer() {
+  size_t done = 0;
+  while (done < this->buffer.size()) {
+    auto result = ::write(this->fd, this->buffer.data() + done, this->buffer.size() - done);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::system_error(errno, std::generic_category(), "Cannot write file");
+    }
+
+    done += static_cast<size_t>(result);
+  }
+
+  this->buffer.clear();
+}
+
+std::unique_ptr<SequentialWriter> SequentialWriter::Create(const std::filesystem::path &path, size_t buffer_size) {
+  auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot create file " + path.string());
+  }
+
+  return std::unique_ptr<SequentialWriter>(new SequentialWriter(fd, buffer_size));
+}
+
+SequentialWriter::~SequentialWriter() {
+  if (this->fd >= 0) {
+    ::close(this->fd);
+  }
+}
+
+void SequentialWriter::Append(const byte *data, size_t size) {
+  while (size > 0) {
+    auto count = std::min(size, this->buffer.capacity() - this->buffer.size());
+    this->buffer.insert(this->buffer.end(), data, data + count);
+    this->offset += count;
+
+    data += count;
+    size -= count;
+
+    if (this->buffer.size() == this->buffer.capacity()) {
+      this->FlushBuffer();
+    }
+  }
+}
+
+uint64_t SequentialWriter::Offset() const {
+  return this->offset;
+}
+
+void SequentialWriter::Close() {
+  if (this->fd < 0) {
+    return;
+  }
+
+  this->FlushBuffer();
+  if (::fsync(this->fd) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot synchronize file");
+  }
+
+  ::close(this->fd);
+  this->fd = -1;
+}
+
+SequentialReader::SequentialReader(int fd, uint64_t size, size_t buffer_size)
+  : fd(fd), buffer(buffer_size), position(0), limit(0), file_offset(0), size(size) {}
+
+std::unique_ptr<SequentialReader> SequentialReader::Open(const std::filesystem::path &path, size_t buffer_size) {
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot open file " + path.string());
+  }
+
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    auto error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::generic_category(), "Cannot determine size of file " + path.string());
+  }
+
+  // Let the kernel read ahead aggressively, since the file is read from start to end.
+  ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  return std::unique_ptr<SequentialReader>(new SequentialReader(fd, static_cast<uint64_t>(st.st_size), buffer_size));
+}
+
+SequentialReader::~SequentialReader() {
+  ::close(this->fd);
+}
+
+uint64_t SequentialReader::Size() const {
+  return this->size;
+}
+
+uint64_t SequentialReader::Offset() const {
+  return this->file_offset - (this->limit - this->position);
+}
+
+void SequentialReader::Seek(uint64_t offset) {
+  this->file_offset = offset;
+  this->position = 0;
+  this->limit = 0;
+}
+
+bool SequentialReader::Read(byte *destination, size_t count) {
+  while (count > 0) {
+    if (this->position == this->limit) {
+      auto result = ::pread(this->fd, this->buffer.data(), this->buffer.size(), static_cast<off_t>(this->file_offset));
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+
+        throw std::system_error(errno, std::generic_category(), "Cannot read file");
+      } else if (result == 0) {
+        return false;
+      }
+
+      this->position = 0;
+      this->limit = static_cast<size_t>(result);
+      this->file_offset += static_cast<uint64_t>(result);
+    }
+
+    auto available = std::min(count, this->limit - this->position);
+    std::memcpy(destination, this->buffer.data() + this->position, available);
+
+    this->position += available;
+    destination += available;
+    count -= available;
+  }
+
+  return true;
+}
+
+void SyncDirectory(const std::filesystem::path &directory) {
+  auto fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot open directory " + directory.string());
+  }
+
+  auto result = ::fsync(fd);
+  auto error = errno;
+  ::close(fd);
+
+  if (result != 0) {
+    throw std::system_error(error, std::generic_category(), "Cannot synchronize directory " + directory.string());
+  }
+}
+
+}
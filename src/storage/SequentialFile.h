@@ -0,0 +1,222 @@
+#ifndef NOID_SRC_STORAGE_SEQUENTIALFILE_H_
+#define NOID_SRC_STORAGE_SEQUENTIALFILE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief The default size in bytes of the buffers used for sequential I/O.
+ */
+const size_t SEQUENTIAL_BUFFER_SIZE = 1024 * 1024;
+
+/**
+ * @brief Writes a file from start to end through a large buffer, so that the file is written using few large writes.
+ */
+class SequentialWriter {
+ private:
+
+    /**
+     * The file descriptor, or -1 if the file has been closed.
+     */
+    int fd;
+
+    /**
+     * The bytes that have not been written to the file yet.
+     */
+    std::vector<byte> buffer;
+
+    /**
+     * The amount of bytes appended so far.
+     */
+    uint64_t offset;
+
+    /**
+     * @brief Creates a new @c SequentialWriter wrapping the given file descriptor.
+     *
+     * @param fd The file descriptor.
+     * @param buffer_size The size of the write buffer.
+     */
+    SequentialWriter(int fd, size_t buffer_size);
+
+    /**
+     * @brief Writes the buffered bytes to the file.
+     */
+    void FlushBuffer();
+
+ public:
+
+    /**
+     * @brief Creates the file at the given @p path, truncating it if it already exists.
+     *
+     * @param path The file location.
+     * @param buffer_size The size of the write buffer.
+     * @return The writer.
+     * @throws std::system_error If the file cannot be created.
+     */
+    [[nodiscard]] static std::unique_ptr<SequentialWriter> Create(const std::filesystem::path& path,
+                                                                  size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
+
+    SequentialWriter()= delete;
+    SequentialWriter(SequentialWriter const&)= delete;
+    SequentialWriter(SequentialWriter &&)= delete;
+    ~SequentialWriter();
+
+    SequentialWriter& operator=(SequentialWriter const&)= delete;
+    SequentialWriter& operator=(SequentialWriter &&)= delete;
+
+    /**
+     * @brief Appends the given bytes to the file.
+     *
+     * @param data The bytes to append.
+     * @param size The amount of bytes to append.
+     * @throws std::system_error If the bytes cannot be written.
+     */
+    void Append(const byte* data, size_t size);
+
+    /**
+     * @brief Appends the raw representation of the given value to the file.
+     *
+     * @tparam T The value type, which must be trivially copyable.
+     * @param value The value to append.
+     */
+    template<typename T>
+    void AppendValue(const T& value) {
+      this->Append(reinterpret_cast<const byte*>(&value), sizeof(T));
+    }
+
+    /**
+     * @return The amount of bytes appended so far.
+     */
+    [[nodiscard]] uint64_t Offset() const;
+
+    /**
+     * @brief Writes all buffered bytes, synchronizes the file and closes it.
+     *
+     * @throws std::system_error If the file cannot be written or synchronized.
+     */
+    void Close();
+};
+
+/**
+ * @brief Reads a file through a large buffer, so that the file is read using few large reads.
+ */
+class SequentialReader {
+ private:
+
+    /**
+     * The file descriptor.
+     */
+    int fd;
+
+    /**
+     * The bytes read from the file, but not yet consumed.
+     */
+    std::vector<byte> buffer;
+
+    /**
+     * The position of the next unconsumed byte in @c buffer.
+     */
+    size_t position;
+
+    /**
+     * The amount of valid bytes in @c buffer.
+     */
+    size_t limit;
+
+    /**
+     * The file offset of the first byte following the buffered bytes.
+     */
+    uint64_t file_offset;
+
+    /**
+     * The size of the file.
+     */
+    uint64_t size;
+
+    /**
+     * @brief Creates a new @c SequentialReader wrapping the given file descriptor.
+     *
+     * @param fd The file descriptor.
+     * @param size The size of the file.
+     * @param buffer_size The size of the read buffer.
+     */
+    SequentialReader(int fd, uint64_t size, size_t buffer_size);
+
+ public:
+
+    /**
+     * @brief Opens the file at the given @p path.
+     *
+     * @param path The file location.
+     * @param buffer_size The size of the read buffer.
+     * @return The reader.
+     * @throws std::system_error If the file cannot be opened.
+     */
+    [[nodiscard]] static std::unique_ptr<SequentialReader> Open(const std::filesystem::path& path,
+                                                                size_t buffer_size = SEQUENTIAL_BUFFER_SIZE);
+
+    SequentialReader()= delete;
+    SequentialReader(SequentialReader const&)= delete;
+    SequentialReader(SequentialReader &&)= delete;
+    ~SequentialReader();
+
+    SequentialReader& operator=(SequentialReader const&)= delete;
+    SequentialReader& operator=(SequentialReader &&)= delete;
+
+    /**
+     * @return The size of the file in bytes.
+     */
+    [[nodiscard]] uint64_t Size() const;
+
+    /**
+     * @return The file offset of the next byte to be read.
+     */
+    [[nodiscard]] uint64_t Offset() const;
+
+    /**
+     * @brief Continues reading at the given file offset.
+     *
+     * @param offset The file offset of the next byte to read.
+     */
+    void Seek(uint64_t offset);
+
+    /**
+     * @brief Reads exactly @p count bytes into @p destination.
+     *
+     * @param destination The buffer to read into.
+     * @param count The amount of bytes to read.
+     * @return Whether the bytes could be read. If not, the end of the file has been reached.
+     * @throws std::system_error If the file cannot be read.
+     */
+    bool Read(byte* destination, size_t count);
+
+    /**
+     * @brief Reads the raw representation of a value.
+     *
+     * @tparam T The value type, which must be trivially copyable.
+     * @param value The value to read into.
+     * @return Whether the value could be read. If not, the end of the file has been reached.
+     */
+    template<typename T>
+    bool ReadValue(T& value) {
+      return this->Read(reinterpret_cast<byte*>(&value), sizeof(T));
+    }
+};
+
+/**
+ * @brief Makes the creation, removal and renaming of entries in the given directory durable.
+ *
+ * @param directory The directory.
+ * @throws std::system_error If the directory cannot be opened or synchronized.
+ */
+void SyncDirectory(const std::filesystem::path& directory);
+
+}
+
+#endif //NOID_SRC_STORAGE_SEQUENTIALFILE_H_
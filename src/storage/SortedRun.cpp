@@ -0,0 +1,424 @@
+#include "SortedRun.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Crc32c.h"
+
+namespace noid::storage {
+
+/**
+ * Identifies a sorted run file. It is stored at the very end of the file, so a truncated run is detected as well.
+ */
+static const byte RUN_MAGIC[8] = {'n', 'o', 'i', 'd', 'r', 'u', 'n', '1'};
+
+static const uint32_t RUN_VERSION = 2;
+
+/**
+ * The size of a record header: the key, the flags and the value length.
+ */
+static const size_t RECORD_HEADER_SIZE = BTREE_KEY_SIZE + sizeof(uint8_t) + sizeof(uint32_t);
+
+/**
+ * The record flags.
+ */
+static const byte RECORD_TOMBSTONE = 1;
+static const byte RECORD_SEPARATED = 2;
+
+/**
+ * The size of an index entry: the first key, the offset, the size and the checksum of a block.
+ */
+static const size_t INDEX_ENTRY_SIZE = BTREE_KEY_SIZE + sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint32_t);
+
+/**
+ * The footer consists of the filter offset, the index offset, the block count, the record count, the smallest and
+ * largest key, the filter checksum, the index checksum, the format version and the magic. The filter ends where the
+ * index starts.
+ */
+static const size_t FOOTER_SIZE = 4 * sizeof(uint64_t) + 2 * BTREE_KEY_SIZE + 3 * sizeof(uint32_t)
+    + sizeof(RUN_MAGIC);
+
+static std::filesystem::path TemporaryPath(const std::filesystem::path& path) {
+  auto temporary_path = path;
+  temporary_path += ".tmp";
+
+  return temporary_path;
+}
+
+template<typename T>
+static void Put(std::vector<byte>& buffer, const T& value) {
+  auto data = reinterpret_cast<const byte*>(&value);
+  buffer.insert(buffer.end(), data, data + sizeof(T));
+}
+
+template<typename T>
+static T Get(const byte* data) {
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+
+  return value;
+}
+
+/**
+ * @brief Decodes the record at @p position in the given block, and advances @p position past it.
+ */
+static void DecodeRecord(const std::vector<byte>& block, size_t& position, K& key, LsmEntry& entry) {
+  if (block.size() - position < RECORD_HEADER_SIZE) {
+    throw std::runtime_error("Cannot decode sorted run record: the block is truncated.");
+  }
+
+  std::memcpy(key.data(), block.data() + position, BTREE_KEY_SIZE);
+  entry.tombstone = (block[position + BTREE_KEY_SIZE] & RECORD_TOMBSTONE) != 0;
+  entry.separated = (block[position + BTREE_KEY_SIZE] & RECORD_SEPARATED) != 0;
+  auto size = Get<uint32_t>(block.data() + position + BTREE_KEY_SIZE + sizeof(uint8_t));
+  position += RECORD_HEADER_SIZE;
+
+  if (block.size() - position < size) {
+    throw std::runtime_error("Cannot decode sorted run record: the block is truncated.");
+  }
+
+  entry.value.assign(block.begin() + static_cast<int64_t>(position),
+                     block.begin() + static_cast<int64_t>(position + size));
+  position += size;
+}
+
+/**
+ * @brief Reads exactly @p size bytes at the given file offset.
+ */
+static void ReadFully(int fd, byte* destination, size_t size, uint64_t offset, const std::filesystem::path& path) {
+  size_t done = 0;
+  while (done < size) {
+    auto result = ::pread(fd, destination + done, size - done, static_cast<off_t>(offset + done));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::system_error(errno, std::generic_category(), "Cannot read sorted run " + path.string());
+    } else if (result == 0) {
+      throw std::runtime_error("Sorted run " + path.string() + " is truncated.");
+    }
+
+    done += static_cast<size_t>(result);
+  }
+}
+
+SortedRunBuilder::SortedRunBuilder(std::filesystem::path path, std::unique_ptr<SequentialWriter> writer,
+                                   uint8_t bits_per_key)
+  : path(std::move(path)), writer(std::move(writer)), block_key(), largest_key(), record_count(0),
+    bits_per_key(bits_per_key) {}
+
+std::unique_ptr<SortedRunBuilder> SortedRunBuilder::Create(const std::filesystem::path &path, uint8_t bits_per_key) {
+  return std::unique_ptr<SortedRunBuilder>(
+      new SortedRunBuilder(path, SequentialWriter::Create(TemporaryPath(path)), bits_per_key));
+}
+
+SortedRunBuilder::~SortedRunBuilder() {
+  if (this->writer) {
+    // The run was abandoned.
+    this->writer.reset();
+
+    std::error_code error;
+    std::filesystem::remove(TemporaryPath(this->path), error);
+  }
+}
+
+void SortedRunBuilder::CloseBlock() {
+  auto offset = this->writer->Offset();
+  auto size = static_cast<uint32_t>(this->block.size());
+  auto checksum = Crc32c(this->block.data(), this->block.size());
+  this->writer->Append(this->block.data(), this->block.size());
+
+  this->index.insert(this->index.end(), this->block_key.begin(), this->block_key.end());
+  Put(this->index, offset);
+  Put(this->index, size);
+  Put(this->index, checksum);
+
+  this->block.clear();
+}
+
+void SortedRunBuilder::Add(const K &key, const LsmEntry &entry) {
+  if (this->smallest_key && key <= this->largest_key) {
+    throw std::logic_error("Expect the keys of a sorted run to be added in ascending order.");
+  }
+
+  if (this->block.empty()) {
+    this->block_key = key;
+  }
+
+  this->block.insert(this->block.end(), key.begin(), key.end());
+  this->block.push_back((entry.tombstone ? RECORD_TOMBSTONE : 0) | (entry.separated ? RECORD_SEPARATED : 0));
+  Put(this->block, static_cast<uint32_t>(entry.value.size()));
+  this->block.insert(this->block.end(), entry.value.begin(), entry.value.end());
+
+  if (!this->smallest_key) {
+    this->smallest_key = key;
+  }
+  this->largest_key = key;
+  this->record_count++;
+
+  if (this->bits_per_key > 0) {
+    this->hashes.push_back(BloomFilter::Hash(key));
+  }
+
+  if (this->block.size() >= SORTED_RUN_BLOCK_SIZE) {
+    this->CloseBlock();
+  }
+}
+
+uint64_t SortedRunBuilder::RecordCount() const {
+  return this->record_count;
+}
+
+uint64_t SortedRunBuilder::Size() const {
+  return this->writer->Offset() + this->block.size();
+}
+
+void SortedRunBuilder::Finish() {
+  if (!this->block.empty()) {
+    this->CloseBlock();
+  }
+
+  std::vector<byte> filter;
+  BloomFilter::Build(this->hashes, this->bits_per_key).Encode(filter);
+  uint64_t filter_offset = this->writer->Offset();
+  auto filter_checksum = Crc32c(filter.data(), filter.size());
+  this->writer->Append(filter.data(), filter.size());
+
+  auto smallest = this->smallest_key.value_or(K{});
+  uint64_t index_offset = this->writer->Offset();
+  uint64_t block_count = this->index.size() / INDEX_ENTRY_SIZE;
+  auto index_checksum = Crc32c(this->index.data(), this->index.size());
+
+  this->writer->Append(this->index.data(), this->index.size());
+  this->writer->AppendValue(filter_offset);
+  this->writer->AppendValue(index_offset);
+  this->writer->AppendValue(block_count);
+  this->writer->AppendValue(this->record_count);
+  this->writer->Append(smallest.data(), BTREE_KEY_SIZE);
+  this->writer->Append(this->largest_key.data(), BTREE_KEY_SIZE);
+  this->writer->AppendValue(filter_checksum);
+  this->writer->AppendValue(index_checksum);
+  this->writer->AppendValue(RUN_VERSION);
+  this->writer->Append(RUN_MAGIC, sizeof(RUN_MAGIC));
+  this->writer->Close();
+  this->writer.reset();
+
+  std::filesystem::rename(TemporaryPath(this->path), this->path);
+  SyncDirectory(this->path.parent_path());
+}
+
+SortedRun::SortedRun(std::filesystem::path path, int fd)
+  : path(std::move(path)), fd(fd), record_count(0), file_size(0), smallest_key(), largest_key(), obsolete(false) {}
+
+std::unique_ptr<SortedRun> SortedRun::Open(const std::filesystem::path &path) {
+  auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot open sorted run " + path.string());
+  }
+
+  auto run = std::unique_ptr<SortedRun>(new SortedRun(path, fd));
+  run->Load();
+
+  return run;
+}
+
+SortedRun::~SortedRun() {
+  ::close(this->fd);
+
+  if (this->obsolete) {
+    std::error_code error;
+    std::filesystem::remove(this->path, error);
+  }
+}
+
+void SortedRun::Load() {
+  struct stat status{};
+  if (::fstat(this->fd, &status) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot determine the size of " + this->path.string());
+  }
+
+  this->file_size = static_cast<uint64_t>(status.st_size);
+  if (this->file_size < FOOTER_SIZE) {
+    throw std::runtime_error(this->path.string() + " is not a sorted run.");
+  }
+
+  byte footer[FOOTER_SIZE];
+  ReadFully(this->fd, footer, FOOTER_SIZE, this->file_size - FOOTER_SIZE, this->path);
+
+  auto position = footer;
+  auto filter_offset = Get<uint64_t>(position);
+  auto index_offset = Get<uint64_t>(position += sizeof(uint64_t));
+  auto block_count = Get<uint64_t>(position += sizeof(uint64_t));
+  this->record_count = Get<uint64_t>(position += sizeof(uint64_t));
+  std::memcpy(this->smallest_key.data(), position += sizeof(uint64_t), BTREE_KEY_SIZE);
+  std::memcpy(this->largest_key.data(), position += BTREE_KEY_SIZE, BTREE_KEY_SIZE);
+  auto filter_checksum = Get<uint32_t>(position += BTREE_KEY_SIZE);
+  auto index_checksum = Get<uint32_t>(position += sizeof(uint32_t));
+  auto version = Get<uint32_t>(position += sizeof(uint32_t));
+
+  if (std::memcmp(footer + FOOTER_SIZE - sizeof(RUN_MAGIC), RUN_MAGIC, sizeof(RUN_MAGIC)) != 0
+      || version != RUN_VERSION || filter_offset > index_offset
+      || index_offset + block_count * INDEX_ENTRY_SIZE != this->file_size - FOOTER_SIZE) {
+    throw std::runtime_error(this->path.string() + " is not a sorted run.");
+  }
+
+  std::vector<byte> filter(index_offset - filter_offset);
+  ReadFully(this->fd, filter.data(), filter.size(), filter_offset, this->path);
+  if (Crc32c(filter.data(), filter.size()) != filter_checksum) {
+    throw std::runtime_error("The Bloom filter of sorted run " + this->path.string() + " is corrupt.");
+  }
+  this->filter = BloomFilter::Decode(filter.data(), filter.size());
+
+  std::vector<byte> index(block_count * INDEX_ENTRY_SIZE);
+  ReadFully(this->fd, index.data(), index.size(), index_offset, this->path);
+  if (Crc32c(index.data(), index.size()) != index_checksum) {
+    throw std::runtime_error("The index of sorted run " + this->path.string() + " is corrupt.");
+  }
+
+  this->blocks.resize(block_count);
+  for (size_t i = 0; i < block_count; i++) {
+    auto entry = index.data() + i * INDEX_ENTRY_SIZE;
+    auto& block = this->blocks[i];
+
+    std::memcpy(block.first_key.data(), entry, BTREE_KEY_SIZE);
+    block.offset = Get<uint64_t>(entry + BTREE_KEY_SIZE);
+    block.size = Get<uint32_t>(entry + BTREE_KEY_SIZE + sizeof(uint64_t));
+    block.checksum = Get<uint32_t>(entry + BTREE_KEY_SIZE + sizeof(uint64_t) + sizeof(uint32_t));
+  }
+}
+
+std::vector<byte> SortedRun::ReadBlock(size_t index) const {
+  auto& block = this->blocks[index];
+  std::vector<byte> data(block.size);
+  ReadFully(this->fd, data.data(), data.size(), block.offset, this->path);
+
+  if (Crc32c(data.data(), data.size()) != block.checksum) {
+    throw std::runtime_error("Block " + std::to_string(index) + " of sorted run " + this->path.string()
+                                 + " is corrupt.");
+  }
+
+  return data;
+}
+
+std::optional<LsmEntry> SortedRun::Find(const K &key) const {
+  if (this->blocks.empty() || key < this->smallest_key || this->largest_key < key
+      || !this->filter.MayContain(key)) {
+    return std::nullopt;
+  }
+
+  // The last block starting at or before the key is the only one that can contain it.
+  auto block = std::upper_bound(this->blocks.begin(), this->blocks.end(), key, [](const K& k, const Block& b) {
+    return k < b.first_key;
+  }) - 1;
+  auto data = this->ReadBlock(static_cast<size_t>(block - this->blocks.begin()));
+
+  size_t position = 0;
+  K record_key;
+  LsmEntry entry;
+  while (position < data.size()) {
+    DecodeRecord(data, position, record_key, entry);
+    if (record_key == key) {
+      return entry;
+    } else if (key < record_key) {
+      break;
+    }
+  }
+
+  return std::nullopt;
+}
+
+void SortedRun::Scan(const K &from, const std::function<bool(const K &, const LsmEntry &)> &consumer) const {
+  for (SortedRunIterator iterator(*this, from); iterator.Valid(); iterator.Next()) {
+    if (!consumer(iterator.Key(), iterator.Entry())) {
+      return;
+    }
+  }
+}
+
+const std::filesystem::path &SortedRun::Path() const {
+  return this->path;
+}
+
+uint64_t SortedRun::RecordCount() const {
+  return this->record_count;
+}
+
+uint64_t SortedRun::FileSize() const {
+  return this->file_size;
+}
+
+size_t SortedRun::FilterSize() const {
+  return this->filter.Size();
+}
+
+const K &SortedRun::SmallestKey() const {
+  return this->smallest_key;
+}
+
+const K &SortedRun::LargestKey() const {
+  return this->largest_key;
+}
+
+bool SortedRun::Overlaps(const K &smallest, const K &largest) const {
+  return !this->blocks.empty() && !(largest < this->smallest_key) && !(this->largest_key < smallest);
+}
+
+void SortedRun::MarkObsolete() {
+  this->obsolete = true;
+}
+
+SortedRunIterator::SortedRunIterator(const SortedRun &run, const K &from)
+  : run(run), block_index(0), position(0), key(), valid(false) {
+  if (run.blocks.empty() || run.largest_key < from) {
+    return;
+  }
+
+  // The last block starting at or before the key is the first one that can contain it.
+  auto first = std::upper_bound(run.blocks.begin(), run.blocks.end(), from, [](const K& k, const SortedRun::Block& b) {
+    return k < b.first_key;
+  }) - run.blocks.begin();
+  this->block_index = static_cast<size_t>(std::max<int64_t>(first - 1, 0));
+  this->block = run.ReadBlock(this->block_index);
+
+  do {
+    this->Next();
+  } while (this->valid && this->key < from);
+}
+
+bool SortedRunIterator::Valid() const {
+  return this->valid;
+}
+
+const K &SortedRunIterator::Key() const {
+  return this->key;
+}
+
+const LsmEntry &SortedRunIterator::Entry() const {
+  return this->entry;
+}
+
+void SortedRunIterator::Next() {
+  while (this->position == this->block.size()) {
+    if (this->block_index + 1 >= this->run.blocks.size()) {
+      this->valid = false;
+      return;
+    }
+
+    this->block = this->run.ReadBlock(++this->block_index);
+    this->position = 0;
+  }
+
+  DecodeRecord(this->block, this->position, this->key, this->entry);
+  this->valid = true;
+}
+
+}
\ No newline at end of file
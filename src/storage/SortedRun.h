@@ -0,0 +1,430 @@
+#ifndef NOID_SRC_STORAGE_SORTEDRUN_H_
+#define NOID_SRC_STORAGE_SORTEDRUN_H_
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "BloomFilter.h"
+#include "SequentialFile.h"
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief The size in bytes after which a block of a sorted run is closed.
+ */
+const size_t SORTED_RUN_BLOCK_SIZE = 4096;
+
+/**
+ * @brief The default amount of Bloom filter bits per key of a sorted run.
+ */
+const uint8_t SORTED_RUN_DEFAULT_BLOOM_BITS_PER_KEY = 10;
+
+/**
+ * @brief A value or tombstone stored in a layer of an @c LsmTree.
+ */
+struct LsmEntry {
+
+    /**
+     * @brief Whether the key has been removed.
+     */
+    bool tombstone = false;
+
+    /**
+     * @brief The value, which is empty for tombstones.
+     */
+    V value;
+
+    /**
+     * @brief Whether the value is stored in a @c ValueLog, in which case @c value holds an encoded @c ValuePointer.
+     */
+    bool separated = false;
+};
+
+/**
+ * @brief Writes a new sorted run file.
+ * @details Records are written in blocks of about @c SORTED_RUN_BLOCK_SIZE bytes. Each record consists of its key,
+ * a byte of flags marking tombstones and separated values, the length of its value and the value itself. The blocks
+ * are followed by a @c BloomFilter of all keys, a sparse index holding the first key, offset, size and CRC32C checksum
+ * of every block, and a footer.
+ *
+ * The run is written to a temporary file, which is renamed to its final location by @c Finish. A run that was not
+ * finished never becomes visible.
+ */
+class SortedRunBuilder {
+ private:
+
+    /**
+     * The final location of the run.
+     */
+    const std::filesystem::path path;
+
+    /**
+     * The temporary file being written.
+     */
+    std::unique_ptr<SequentialWriter> writer;
+
+    /**
+     * The records of the current block.
+     */
+    std::vector<byte> block;
+
+    /**
+     * The first key of the current block.
+     */
+    K block_key;
+
+    /**
+     * The encoded index entries of all closed blocks.
+     */
+    std::vector<byte> index;
+
+    /**
+     * The smallest and largest key added so far.
+     */
+    std::optional<K> smallest_key;
+    K largest_key;
+
+    /**
+     * The amount of records added so far.
+     */
+    uint64_t record_count;
+
+    /**
+     * The amount of Bloom filter bits per key.
+     */
+    const uint8_t bits_per_key;
+
+    /**
+     * The Bloom filter hashes of the keys added so far.
+     */
+    std::vector<uint64_t> hashes;
+
+    /**
+     * @brief Creates a new @c SortedRunBuilder.
+     *
+     * @param path The final location of the run.
+     * @param writer The temporary file.
+     * @param bits_per_key The amount of Bloom filter bits per key.
+     */
+    SortedRunBuilder(std::filesystem::path path, std::unique_ptr<SequentialWriter> writer, uint8_t bits_per_key);
+
+    /**
+     * @brief Writes the current block and adds it to the index.
+     */
+    void CloseBlock();
+
+ public:
+
+    /**
+     * @brief Starts writing a new sorted run, which will be stored at the given @p path.
+     *
+     * @param path The final location of the run.
+     * @param bits_per_key The amount of Bloom filter bits per key, or zero to omit the filter.
+     * @return The builder.
+     * @throws std::system_error If the temporary file cannot be created.
+     */
+    [[nodiscard]] static std::unique_ptr<SortedRunBuilder> Create(const std::filesystem::path& path,
+        uint8_t bits_per_key = SORTED_RUN_DEFAULT_BLOOM_BITS_PER_KEY);
+
+    SortedRunBuilder()= delete;
+    SortedRunBuilder(SortedRunBuilder const&)= delete;
+    SortedRunBuilder(SortedRunBuilder &&)= delete;
+    ~SortedRunBuilder();
+
+    SortedRunBuilder& operator=(SortedRunBuilder const&)= delete;
+    SortedRunBuilder& operator=(SortedRunBuilder &&)= delete;
+
+    /**
+     * @brief Appends a record to the run.
+     *
+     * @param key The key, which must exceed all keys added before.
+     * @param entry The value or tombstone.
+     * @throws std::logic_error If @p key does not exceed the previous key.
+     * @throws std::system_error If the record cannot be written.
+     */
+    void Add(const K& key, const LsmEntry& entry);
+
+    /**
+     * @return The amount of records added so far.
+     */
+    [[nodiscard]] uint64_t RecordCount() const;
+
+    /**
+     * @return The approximate size in bytes of the run so far, excluding its filter, index and footer.
+     */
+    [[nodiscard]] uint64_t Size() const;
+
+    /**
+     * @brief Writes the Bloom filter, the index and the footer, makes the run durable and moves it to its final
+     * location.
+     *
+     * @throws std::system_error If the run cannot be written.
+     */
+    void Finish();
+};
+
+class SortedRunIterator;
+
+/**
+ * @brief An immutable file containing records in key order, written by a @c SortedRunBuilder.
+ * @details The Bloom filter and the sparse index are kept in memory. A point lookup for an absent key is usually
+ * answered by the filter alone, and otherwise reads a single block. Lookups and scans can be executed concurrently.
+ *
+ * A run that is no longer needed can be marked obsolete, after which its file is removed as soon as the last reference
+ * to it is released. Readers which still use the run can therefore finish without copying it.
+ */
+class SortedRun {
+    friend class SortedRunIterator;
+
+ private:
+
+    /**
+     * @brief The location of a block in the run.
+     */
+    struct Block {
+
+        /**
+         * The first key in the block.
+         */
+        K first_key;
+
+        /**
+         * The file offset of the block.
+         */
+        uint64_t offset;
+
+        /**
+         * The size of the block in bytes.
+         */
+        uint32_t size;
+
+        /**
+         * The CRC32C checksum of the block.
+         */
+        uint32_t checksum;
+    };
+
+    /**
+     * The location of the run.
+     */
+    const std::filesystem::path path;
+
+    /**
+     * The file descriptor of the run.
+     */
+    int fd;
+
+    /**
+     * The sparse index.
+     */
+    std::vector<Block> blocks;
+
+    /**
+     * The filter of all keys in the run.
+     */
+    BloomFilter filter;
+
+    /**
+     * The amount of records in the run.
+     */
+    uint64_t record_count;
+
+    /**
+     * The size of the run file in bytes.
+     */
+    uint64_t file_size;
+
+    /**
+     * The smallest and largest key in the run.
+     */
+    K smallest_key;
+    K largest_key;
+
+    /**
+     * Whether the file must be removed when the run is destroyed.
+     */
+    std::atomic<bool> obsolete;
+
+    /**
+     * @brief Creates a new @c SortedRun reading the given file.
+     */
+    SortedRun(std::filesystem::path path, int fd);
+
+    /**
+     * @brief Reads the footer and the index.
+     */
+    void Load();
+
+    /**
+     * @brief Reads and verifies the block at @p index.
+     */
+    std::vector<byte> ReadBlock(size_t index) const;
+
+ public:
+
+    /**
+     * @brief Opens the sorted run at the given @p path.
+     *
+     * @param path The location of the run.
+     * @return The opened run.
+     * @throws std::system_error If the file cannot be opened or read.
+     * @throws std::runtime_error If the file does not contain a sorted run, or its filter or index is corrupt.
+     */
+    [[nodiscard]] static std::unique_ptr<SortedRun> Open(const std::filesystem::path& path);
+
+    SortedRun()= delete;
+    SortedRun(SortedRun const&)= delete;
+    SortedRun(SortedRun &&)= delete;
+    ~SortedRun();
+
+    SortedRun& operator=(SortedRun const&)= delete;
+    SortedRun& operator=(SortedRun &&)= delete;
+
+    /**
+     * @brief Looks up the record having the given @p key.
+     *
+     * @param key The search key.
+     * @return The value or tombstone, or an empty optional if the run does not contain the key.
+     * @throws std::runtime_error If the block containing the key is corrupt.
+     */
+    [[nodiscard]] std::optional<LsmEntry> Find(const K& key) const;
+
+    /**
+     * @brief Invokes @p consumer for every record having a key of at least @p from, in key order, until it returns
+     * @c false.
+     *
+     * @param from The smallest key to visit.
+     * @param consumer The function to invoke with every key and entry.
+     * @throws std::runtime_error If a block is corrupt.
+     */
+    void Scan(const K& from, const std::function<bool(const K&, const LsmEntry&)>& consumer) const;
+
+    /**
+     * @return The location of the run.
+     */
+    [[nodiscard]] const std::filesystem::path& Path() const;
+
+    /**
+     * @return The amount of records in the run.
+     */
+    [[nodiscard]] uint64_t RecordCount() const;
+
+    /**
+     * @return The size of the run file in bytes.
+     */
+    [[nodiscard]] uint64_t FileSize() const;
+
+    /**
+     * @return The size in bytes of the in-memory Bloom filter.
+     */
+    [[nodiscard]] size_t FilterSize() const;
+
+    /**
+     * @return The smallest key in the run.
+     */
+    [[nodiscard]] const K& SmallestKey() const;
+
+    /**
+     * @return The largest key in the run.
+     */
+    [[nodiscard]] const K& LargestKey() const;
+
+    /**
+     * @return Whether the key ranges of this run and the given one overlap.
+     */
+    [[nodiscard]] bool Overlaps(const K& smallest, const K& largest) const;
+
+    /**
+     * @brief Removes the file of this run when it is destroyed.
+     */
+    void MarkObsolete();
+};
+
+/**
+ * @brief A cursor over the records of a @c SortedRun in key order.
+ * @details The run must outlive the iterator. Blocks are read one at a time and verified when they are entered.
+ */
+class SortedRunIterator {
+ private:
+
+    /**
+     * The run being iterated.
+     */
+    const SortedRun& run;
+
+    /**
+     * The index of the current block.
+     */
+    size_t block_index;
+
+    /**
+     * The contents of the current block.
+     */
+    std::vector<byte> block;
+
+    /**
+     * The offset of the next record in @c block.
+     */
+    size_t position;
+
+    /**
+     * The current record.
+     */
+    K key;
+    LsmEntry entry;
+
+    /**
+     * Whether the iterator is positioned at a record.
+     */
+    bool valid;
+
+ public:
+
+    /**
+     * @brief Creates a new @c SortedRunIterator positioned at the first record having a key of at least @p from.
+     *
+     * @param run The run to iterate.
+     * @param from The smallest key to visit.
+     * @throws std::runtime_error If a block is corrupt.
+     */
+    SortedRunIterator(const SortedRun& run, const K& from);
+    SortedRunIterator()= delete;
+    SortedRunIterator(SortedRunIterator const&)= delete;
+    SortedRunIterator(SortedRunIterator &&)= delete;
+    ~SortedRunIterator()= default;
+
+    SortedRunIterator& operator=(SortedRunIterator const&)= delete;
+    SortedRunIterator& operator=(SortedRunIterator &&)= delete;
+
+    /**
+     * @return Whether the iterator is positioned at a record. If not, all records have been visited.
+     */
+    [[nodiscard]] bool Valid() const;
+
+    /**
+     * @return The key of the current record.
+     */
+    [[nodiscard]] const K& Key() const;
+
+    /**
+     * @return The value or tombstone of the current record.
+     */
+    [[nodiscard]] const LsmEntry& Entry() const;
+
+    /**
+     * @brief Moves to the next record.
+     *
+     * @throws std::runtime_error If the next block is corrupt.
+     */
+    void Next();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_SORTEDRUN_H_
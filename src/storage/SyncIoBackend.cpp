@@ -0,0 +1,65 @@
+#include "SyncIoBackend.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <unistd.h>
+
+namespace noid::storage {
+
+void ReadPageFully(int fd, off_t offset, byte *buffer) {
+  size_t done = 0;
+  while (done < PAGE_SIZE) {
+    auto result = ::pread(fd, buffer + done, PAGE_SIZE - done, offset + static_cast<off_t>(done));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::system_error(errno, std::generic_category(), "Cannot read page");
+    } else if (result == 0) {
+      // Reading beyond the end of the file.
+      std::memset(buffer + done, 0, PAGE_SIZE - done);
+      return;
+    }
+
+    done += static_cast<size_t>(result);
+  }
+}
+
+void WritePageFully(int fd, off_t offset, const byte *buffer) {
+  size_t done = 0;
+  while (done < PAGE_SIZE) {
+    auto result = ::pwrite(fd, buffer + done, PAGE_SIZE - done, offset + static_cast<off_t>(done));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::system_error(errno, std::generic_category(), "Cannot write page");
+    }
+
+    done += static_cast<size_t>(result);
+  }
+}
+
+SyncIoBackend::SyncIoBackend(int fd) : fd(fd) {}
+
+IoBackendType SyncIoBackend::Type() const {
+  return IoBackendType::Synchronous;
+}
+
+void SyncIoBackend::Read(const std::vector<PageIo> &batch) {
+  for (auto& io : batch) {
+    ReadPageFully(this->fd, static_cast<off_t>(io.page_id * PAGE_SIZE), io.buffer);
+  }
+}
+
+void SyncIoBackend::Write(const std::vector<PageIo> &batch) {
+  for (auto& io : batch) {
+    WritePageFully(this->fd, static_cast<off_t>(io.page_id * PAGE_SIZE), io.buffer);
+  }
+}
+
+}
\ No newline at end of file
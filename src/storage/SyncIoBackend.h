@@ -0,0 +1,76 @@
+#ifndef NOID_SRC_STORAGE_SYNCIOBACKEND_H_
+#define NOID_SRC_STORAGE_SYNCIOBACKEND_H_
+
+#include <vector>
+
+#include <sys/types.h>
+
+#include "IoBackend.h"
+
+namespace noid::storage {
+
+/**
+ * @brief Executes page reads and writes one at a time using @c pread and @c pwrite.
+ */
+class SyncIoBackend : public IoBackend {
+ private:
+
+    /**
+     * The file descriptor to read from and write to. It is owned by the caller.
+     */
+    int fd;
+
+ public:
+
+    /**
+     * @brief Creates a new @c SyncIoBackend.
+     *
+     * @param fd The file descriptor to read from and write to. It is not closed by this backend.
+     */
+    explicit SyncIoBackend(int fd);
+    ~SyncIoBackend() override = default;
+
+    /**
+     * @return @c IoBackendType::Synchronous
+     */
+    [[nodiscard]] IoBackendType Type() const override;
+
+    /**
+     * @brief Reads the given pages one by one.
+     *
+     * @param batch The pages to read.
+     */
+    void Read(const std::vector<PageIo>& batch) override;
+
+    /**
+     * @brief Writes the given pages one by one.
+     *
+     * @param batch The pages to write.
+     */
+    void Write(const std::vector<PageIo>& batch) override;
+};
+
+/**
+ * @brief Reads @c PAGE_SIZE bytes at the given file offset using @c pread, zero-filling anything beyond the end of
+ * the file.
+ *
+ * @param fd The file descriptor.
+ * @param offset The file offset.
+ * @param buffer The destination.
+ * @throws std::system_error If the read fails.
+ */
+void ReadPageFully(int fd, off_t offset, byte* buffer);
+
+/**
+ * @brief Writes @c PAGE_SIZE bytes at the given file offset using @c pwrite.
+ *
+ * @param fd The file descriptor.
+ * @param offset The file offset.
+ * @param buffer The source.
+ * @throws std::system_error If the write fails.
+ */
+void WritePageFully(int fd, off_t offset, const byte* buffer);
+
+}
+
+#endif //NOID_SRC_STORAGE_SYNCIOBACKEND_H_
@@ -0,0 +1,256 @@
+#include "UringIoBackend.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include "AlignedBuffer.h"
+#include "SyncIoBackend.h"
+
+#if __has_include(<linux/io_uring.h>)
+#define NOID_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace noid::storage {
+
+#ifdef NOID_HAVE_IO_URING
+
+struct UringIoBackend::Ring {
+    int fd = -1;
+    unsigned entries = 0;
+
+    void* sq_ring = MAP_FAILED;
+    size_t sq_ring_size = 0;
+    void* cq_ring = MAP_FAILED;
+    size_t cq_ring_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    ~Ring() {
+      if (this->sqes != MAP_FAILED) {
+        ::munmap(this->sqes, this->sqes_size);
+      }
+      if (this->cq_ring != MAP_FAILED && this->cq_ring != this->sq_ring) {
+        ::munmap(this->cq_ring, this->cq_ring_size);
+      }
+      if (this->sq_ring != MAP_FAILED) {
+        ::munmap(this->sq_ring, this->sq_ring_size);
+      }
+      if (this->fd >= 0) {
+        ::close(this->fd);
+      }
+    }
+};
+
+static void *MapRing(int fd, size_t size, off_t offset) {
+  auto address = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+  if (address == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(), "Cannot map io_uring queue");
+  }
+
+  return address;
+}
+
+UringIoBackend::UringIoBackend(int fd, std::unique_ptr<Ring> ring) : fd(fd), ring(std::move(ring)), broken(false) {}
+
+void UringIoBackend::Abandon(unsigned submitted_tail, unsigned in_flight, const std::function<unsigned()> &reap) {
+  auto& r = *this->ring;
+
+  // The kernel only consumes entries during io_uring_enter, so the entries it did not consume can be withdrawn.
+  __atomic_store_n(r.sq_tail, submitted_tail, __ATOMIC_RELEASE);
+
+  // The entries in flight still refer to the buffers of the caller, which may be released once this returns.
+  while (in_flight > 0) {
+    auto result = ::syscall(__NR_io_uring_enter, r.fd, 0, in_flight, IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (result < 0 && errno != EINTR) {
+      // Their completions would be mistaken for those of a later batch.
+      this->broken = true;
+      return;
+    }
+
+    in_flight -= std::min(in_flight, reap());
+  }
+}
+
+void UringIoBackend::Submit(const std::vector<PageIo> &batch, bool write) {
+  std::lock_guard<std::mutex> lock(this->mutex);
+  auto& r = *this->ring;
+
+  if (this->broken) {
+    throw std::system_error(EIO, std::generic_category(), "Cannot submit to io_uring, since earlier entries are lost");
+  }
+
+  // Reap every completion of a round before reporting the first error, to leave the queues consistent.
+  int error = 0;
+  std::vector<size_t> short_transfers;
+  auto reap = [&r, &error, &short_transfers]() {
+    unsigned reaped = 0;
+    auto head = *r.cq_head;
+    auto cq_tail = __atomic_load_n(r.cq_tail, __ATOMIC_ACQUIRE);
+    while (head != cq_tail) {
+      auto cqe = &r.cqes[head & *r.cq_mask];
+
+      if (cqe->res < 0) {
+        error = error ? error : -cqe->res;
+      } else if (static_cast<uint32_t>(cqe->res) < PAGE_SIZE) {
+        short_transfers.push_back(cqe->user_data);
+      }
+
+      head++;
+      reaped++;
+    }
+    __atomic_store_n(r.cq_head, head, __ATOMIC_RELEASE);
+
+    return reaped;
+  };
+
+  for (size_t start = 0; start < batch.size(); start += r.entries) {
+    auto count = static_cast<unsigned>(std::min<size_t>(r.entries, batch.size() - start));
+
+    // This is the only producer, so the tail can be read without synchronization.
+    auto tail = *r.sq_tail;
+    for (unsigned i = 0; i < count; i++) {
+      auto& io = batch[start + i];
+      auto index = (tail + i) & *r.sq_mask;
+      auto sqe = &r.sqes[index];
+
+      std::memset(sqe, 0, sizeof(io_uring_sqe));
+      sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe->fd = this->fd;
+      sqe->off = io.page_id * PAGE_SIZE;
+      sqe->addr = reinterpret_cast<uint64_t>(io.buffer);
+      sqe->len = PAGE_SIZE;
+      sqe->user_data = start + i;
+
+      r.sq_array[index] = index;
+    }
+
+    // Publish the entries before the kernel can observe the new tail.
+    __atomic_store_n(r.sq_tail, tail + count, __ATOMIC_RELEASE);
+
+    unsigned to_submit = count;
+    unsigned completed = 0;
+    while (completed < count) {
+      auto result = ::syscall(__NR_io_uring_enter, r.fd, to_submit, count - completed, IORING_ENTER_GETEVENTS,
+                              nullptr, 0);
+      if (result < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+
+        auto submit_error = errno;
+        this->Abandon(tail + count - to_submit, count - to_submit - completed, reap);
+        throw std::system_error(submit_error, std::generic_category(), "Cannot submit to io_uring");
+      }
+      to_submit -= static_cast<unsigned>(result);
+      completed += reap();
+    }
+  }
+
+  if (error) {
+    throw std::system_error(error, std::generic_category(), write ? "Cannot write page" : "Cannot read page");
+  }
+
+  // Short transfers are rare, for example when reading beyond the end of the file. Redo them synchronously, which
+  // also zero-fills reads beyond the end of the file.
+  for (auto index : short_transfers) {
+    auto& io = batch[index];
+    auto offset = static_cast<off_t>(io.page_id * PAGE_SIZE);
+
+    if (write) {
+      WritePageFully(this->fd, offset, io.buffer);
+    } else {
+      ReadPageFully(this->fd, offset, io.buffer);
+    }
+  }
+}
+
+std::unique_ptr<UringIoBackend> UringIoBackend::Create(int fd, unsigned int queue_depth) {
+  io_uring_params params{};
+  auto ring = std::make_unique<Ring>();
+
+  ring->fd = static_cast<int>(::syscall(__NR_io_uring_setup, queue_depth, &params));
+  if (ring->fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot set up io_uring");
+  }
+
+  ring->entries = params.sq_entries;
+  ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  // Recent kernels map both rings using a single mapping.
+  auto single_mapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mapping) {
+    ring->sq_ring_size = ring->cq_ring_size = std::max(ring->sq_ring_size, ring->cq_ring_size);
+  }
+
+  ring->sq_ring = MapRing(ring->fd, ring->sq_ring_size, IORING_OFF_SQ_RING);
+  ring->cq_ring = single_mapping ? ring->sq_ring : MapRing(ring->fd, ring->cq_ring_size, IORING_OFF_CQ_RING);
+  ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  ring->sqes = static_cast<io_uring_sqe*>(MapRing(ring->fd, ring->sqes_size, IORING_OFF_SQES));
+
+  auto sq = static_cast<byte*>(ring->sq_ring);
+  auto cq = static_cast<byte*>(ring->cq_ring);
+  ring->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring->sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  ring->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring->cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  auto backend = std::unique_ptr<UringIoBackend>(new UringIoBackend(fd, std::move(ring)));
+
+  // Kernels before 5.6 set up a ring, but do not support IORING_OP_READ. Probe for it, so the caller can fall back.
+  auto probe = AllocateAligned(PAGE_SIZE);
+  backend->Read({{0, probe.get()}});
+
+  return backend;
+}
+
+UringIoBackend::~UringIoBackend()= default;
+
+#else
+
+struct UringIoBackend::Ring {};
+
+UringIoBackend::UringIoBackend(int fd, std::unique_ptr<Ring> ring) : fd(fd), ring(std::move(ring)), broken(false) {}
+
+void UringIoBackend::Submit(const std::vector<PageIo> &, bool) {
+  throw std::system_error(ENOSYS, std::generic_category(), "io_uring is not supported on this platform");
+}
+
+std::unique_ptr<UringIoBackend> UringIoBackend::Create(int, unsigned int) {
+  throw std::system_error(ENOSYS, std::generic_category(), "io_uring is not supported on this platform");
+}
+
+UringIoBackend::~UringIoBackend()= default;
+
+#endif
+
+IoBackendType UringIoBackend::Type() const {
+  return IoBackendType::IoUring;
+}
+
+void UringIoBackend::Read(const std::vector<PageIo> &batch) {
+  this->Submit(batch, false);
+}
+
+void UringIoBackend::Write(const std::vector<PageIo> &batch) {
+  this->Submit(batch, true);
+}
+
+}
\ No newline at end of file
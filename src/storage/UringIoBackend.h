@@ -0,0 +1,123 @@
+#ifndef NOID_SRC_STORAGE_URINGIOBACKEND_H_
+#define NOID_SRC_STORAGE_URINGIOBACKEND_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "IoBackend.h"
+
+namespace noid::storage {
+
+/**
+ * @brief The default amount of submission queue entries of an @c UringIoBackend.
+ */
+const unsigned URING_DEFAULT_QUEUE_DEPTH = 64;
+
+/**
+ * @brief Executes batches of page reads and writes through an @c io_uring instance.
+ * @details All pages of a batch are placed in the submission queue and submitted to the kernel using a single system
+ * call, which also waits for their completions. This keeps up to the queue depth of reads or writes in flight
+ * concurrently. Batches exceeding the queue depth are processed in multiple rounds. Concurrent callers are
+ * serialized.
+ */
+class UringIoBackend : public IoBackend {
+ private:
+
+    /**
+     * @brief The memory-mapped submission and completion queues.
+     */
+    struct Ring;
+
+    /**
+     * The file descriptor to read from and write to. It is owned by the caller.
+     */
+    int fd;
+
+    /**
+     * The queues shared with the kernel.
+     */
+    std::unique_ptr<Ring> ring;
+
+    /**
+     * Serializes access to @c ring.
+     */
+    std::mutex mutex;
+
+    /**
+     * Whether entries of a failed batch may still be in flight, in which case no more batches are accepted.
+     */
+    bool broken;
+
+    /**
+     * @brief Creates a new @c UringIoBackend using the given, already set up, @p ring.
+     *
+     * @param fd The file descriptor to read from and write to.
+     * @param ring The queues.
+     */
+    UringIoBackend(int fd, std::unique_ptr<Ring> ring);
+
+    /**
+     * @brief Submits the given pages to the kernel and waits until all of them have been processed.
+     *
+     * @param batch The pages to read or write.
+     * @param write Whether to write (@c true) or read (@c false) the pages.
+     */
+    void Submit(const std::vector<PageIo>& batch, bool write);
+
+    /**
+     * @brief Withdraws the entries of a failed submission the kernel did not consume, and waits for the completion
+     * of those in flight.
+     * @details If the completions cannot be awaited, this backend is marked as broken.
+     *
+     * @param submitted_tail The submission queue tail following the last entry the kernel consumed.
+     * @param in_flight The amount of consumed entries that have not completed yet.
+     * @param reap Reaps the available completions and returns their amount.
+     */
+    void Abandon(unsigned submitted_tail, unsigned in_flight, const std::function<unsigned()>& reap);
+
+ public:
+
+    /**
+     * @brief Sets up a new @c io_uring instance for the given file descriptor.
+     *
+     * @param fd The file descriptor to read from and write to. It is not closed by this backend.
+     * @param queue_depth The amount of submission queue entries, which the kernel rounds up to a power of two.
+     * @return The backend.
+     * @throws std::system_error If @c io_uring is not supported by the kernel or not permitted for this process.
+     */
+    [[nodiscard]] static std::unique_ptr<UringIoBackend> Create(int fd,
+                                                                unsigned queue_depth = URING_DEFAULT_QUEUE_DEPTH);
+
+    UringIoBackend()= delete;
+    UringIoBackend(UringIoBackend const&)= delete;
+    UringIoBackend(UringIoBackend &&)= delete;
+    ~UringIoBackend() override;
+
+    UringIoBackend& operator=(UringIoBackend const&)= delete;
+    UringIoBackend& operator=(UringIoBackend &&)= delete;
+
+    /**
+     * @return @c IoBackendType::IoUring
+     */
+    [[nodiscard]] IoBackendType Type() const override;
+
+    /**
+     * @brief Reads the given pages concurrently.
+     *
+     * @param batch The pages to read.
+     */
+    void Read(const std::vector<PageIo>& batch) override;
+
+    /**
+     * @brief Writes the given pages concurrently.
+     *
+     * @param batch The pages to write.
+     */
+    void Write(const std::vector<PageIo>& batch) override;
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_URINGIOBACKEND_H_
@@ -0,0 +1,336 @@
+#include "ValueLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Crc32c.h"
+#include "SequentialFile.h"
+
+namespace noid::storage {
+
+static const char* SEGMENT_EXTENSION = ".vlog";
+
+/**
+ * The size of an entry header: the checksum, the key and the value length. The checksum covers the remainder of the
+ * entry.
+ */
+static const size_t ENTRY_HEADER_SIZE = sizeof(uint32_t) + BTREE_KEY_SIZE + sizeof(uint32_t);
+
+static std::filesystem::path SegmentPath(const std::filesystem::path& directory, uint64_t number) {
+  std::ostringstream name;
+  name << std::setw(16) << std::setfill('0') << number << SEGMENT_EXTENSION;
+
+  return directory / name.str();
+}
+
+static void WriteFully(int fd, const byte* data, size_t size, uint64_t offset, const std::filesystem::path& path) {
+  size_t done = 0;
+  while (done < size) {
+    auto result = ::pwrite(fd, data + done, size - done, static_cast<off_t>(offset + done));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::system_error(errno, std::generic_category(), "Cannot write to value log segment " + path.string());
+    }
+
+    done += static_cast<size_t>(result);
+  }
+}
+
+static void ReadFully(int fd, byte* destination, size_t size, uint64_t offset, const std::filesystem::path& path) {
+  size_t done = 0;
+  while (done < size) {
+    auto result = ::pread(fd, destination + done, size - done, static_cast<off_t>(offset + done));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::system_error(errno, std::generic_category(), "Cannot read value log segment " + path.string());
+    } else if (result == 0) {
+      throw std::runtime_error("Value log segment " + path.string() + " is truncated.");
+    }
+
+    done += static_cast<size_t>(result);
+  }
+}
+
+static void SyncSegment(int fd, const std::filesystem::path& path) {
+  if (::fdatasync(fd) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot synchronize value log segment " + path.string());
+  }
+}
+
+ValuePointer ValuePointer::Decode(const V &data) {
+  if (data.size() != VALUE_POINTER_SIZE) {
+    throw std::runtime_error("Cannot decode value pointer: expect " + std::to_string(VALUE_POINTER_SIZE)
+                                 + " bytes, got " + std::to_string(data.size()) + ".");
+  }
+
+  ValuePointer pointer{};
+  std::memcpy(&pointer.segment, data.data(), sizeof(uint64_t));
+  std::memcpy(&pointer.offset, data.data() + sizeof(uint64_t), sizeof(uint64_t));
+  std::memcpy(&pointer.length, data.data() + 2 * sizeof(uint64_t), sizeof(uint32_t));
+
+  return pointer;
+}
+
+V ValuePointer::Encode() const {
+  V data(VALUE_POINTER_SIZE);
+  std::memcpy(data.data(), &this->segment, sizeof(uint64_t));
+  std::memcpy(data.data() + sizeof(uint64_t), &this->offset, sizeof(uint64_t));
+  std::memcpy(data.data() + 2 * sizeof(uint64_t), &this->length, sizeof(uint32_t));
+
+  return data;
+}
+
+ValueLog::Segment::Segment(std::filesystem::path path, bool create) : path(std::move(path)) {
+  this->fd = ::open(this->path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0), 0644);
+  if (this->fd < 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot open value log segment " + this->path.string());
+  }
+}
+
+ValueLog::Segment::~Segment() {
+  ::close(this->fd);
+}
+
+ValueLog::ValueLog(std::filesystem::path directory, uint64_t segment_size)
+  : directory(std::move(directory)), segment_size(segment_size), head(nullptr), head_number(1), head_size(0),
+    synced_size(0), size(0) {}
+
+std::unique_ptr<ValueLog> ValueLog::Open(const std::filesystem::path &directory, uint64_t segment_size) {
+  if (segment_size == 0) {
+    throw std::invalid_argument("Expect the value log segment size to be positive.");
+  }
+
+  std::filesystem::create_directories(directory);
+
+  auto log = std::unique_ptr<ValueLog>(new ValueLog(directory, segment_size));
+  for (auto& file : std::filesystem::directory_iterator(directory)) {
+    if (file.path().extension() != SEGMENT_EXTENSION) {
+      continue;
+    }
+
+    auto number = static_cast<uint64_t>(std::stoull(file.path().stem().string()));
+    log->segments[number] = std::make_shared<Segment>(file.path(), false);
+    log->head_number = std::max(log->head_number, number + 1);
+    log->size += std::filesystem::file_size(file.path());
+  }
+
+  return log;
+}
+
+ValueLog::~ValueLog() {
+  try {
+    this->Sync();
+  } catch (...) {
+    // Values that could not be synchronized are lost if the system crashes, just like unsynchronized ones.
+  }
+}
+
+std::shared_ptr<ValueLog::Segment> ValueLog::Find(uint64_t number) {
+  std::shared_lock<std::shared_mutex> lock(this->mutex);
+
+  auto segment = this->segments.find(number);
+  return segment == this->segments.end() ? nullptr : segment->second;
+}
+
+ValuePointer ValueLog::Append(const K &key, const V &value) {
+  if (value.size() > std::numeric_limits<uint32_t>::max() - ENTRY_HEADER_SIZE) {
+    throw std::invalid_argument("Cannot append a value of " + std::to_string(value.size()) + " bytes to a value log.");
+  }
+
+  auto length = static_cast<uint32_t>(value.size());
+  std::vector<byte> entry(ENTRY_HEADER_SIZE + value.size());
+  std::memcpy(entry.data() + sizeof(uint32_t), key.data(), BTREE_KEY_SIZE);
+  std::memcpy(entry.data() + sizeof(uint32_t) + BTREE_KEY_SIZE, &length, sizeof(uint32_t));
+  std::copy(value.begin(), value.end(), entry.begin() + ENTRY_HEADER_SIZE);
+
+  auto checksum = Crc32c(entry.data() + sizeof(uint32_t), entry.size() - sizeof(uint32_t));
+  std::memcpy(entry.data(), &checksum, sizeof(uint32_t));
+
+  std::lock_guard<std::mutex> lock(this->append_mutex);
+
+  if (this->head && this->head_size >= this->segment_size) {
+    // A full segment is never written again, so it is synchronized once.
+    if (this->synced_size < this->head_size) {
+      SyncSegment(this->head->fd, this->head->path);
+    }
+
+    this->head.reset();
+    this->head_number++;
+  }
+
+  if (!this->head) {
+    auto segment = std::make_shared<Segment>(SegmentPath(this->directory, this->head_number), true);
+    SyncDirectory(this->directory);
+    {
+      std::unique_lock<std::shared_mutex> segments_lock(this->mutex);
+      this->segments[this->head_number] = segment;
+    }
+
+    this->head = std::move(segment);
+    this->head_size = 0;
+    this->synced_size = 0;
+  }
+
+  WriteFully(this->head->fd, entry.data(), entry.size(), this->head_size, this->head->path);
+
+  ValuePointer pointer{this->head_number, this->head_size, length};
+  this->head_size += entry.size();
+  this->size += entry.size();
+
+  return pointer;
+}
+
+V ValueLog::Read(const K &key, const ValuePointer &pointer) {
+  auto segment = this->Find(pointer.segment);
+  if (!segment) {
+    throw std::runtime_error("Cannot read value: value log segment " + std::to_string(pointer.segment)
+                                 + " does not exist.");
+  }
+
+  std::vector<byte> entry(ENTRY_HEADER_SIZE + pointer.length);
+  ReadFully(segment->fd, entry.data(), entry.size(), pointer.offset, segment->path);
+
+  uint32_t checksum;
+  uint32_t length;
+  std::memcpy(&checksum, entry.data(), sizeof(uint32_t));
+  std::memcpy(&length, entry.data() + sizeof(uint32_t) + BTREE_KEY_SIZE, sizeof(uint32_t));
+
+  if (length != pointer.length || checksum != Crc32c(entry.data() + sizeof(uint32_t), entry.size() - sizeof(uint32_t))
+      || std::memcmp(entry.data() + sizeof(uint32_t), key.data(), BTREE_KEY_SIZE) != 0) {
+    throw std::runtime_error("Cannot read value: the entry at offset " + std::to_string(pointer.offset)
+                                 + " of value log segment " + segment->path.string() + " is corrupt.");
+  }
+
+  return {entry.begin() + ENTRY_HEADER_SIZE, entry.end()};
+}
+
+void ValueLog::Sync() {
+  std::lock_guard<std::mutex> sync_lock(this->sync_mutex);
+
+  // A synchronization that completed while waiting for the lock might have covered all values appended before.
+  std::shared_ptr<Segment> segment;
+  uint64_t size;
+  {
+    std::lock_guard<std::mutex> lock(this->append_mutex);
+    if (!this->head || this->synced_size >= this->head_size) {
+      return;
+    }
+
+    segment = this->head;
+    size = this->head_size;
+  }
+
+  // Appends continue while the segment is being synchronized.
+  SyncSegment(segment->fd, segment->path);
+
+  std::lock_guard<std::mutex> lock(this->append_mutex);
+  if (segment == this->head) {
+    this->synced_size = std::max(this->synced_size, size);
+  }
+}
+
+std::optional<uint64_t> ValueLog::OldestSealedSegment() {
+  std::lock_guard<std::mutex> lock(this->append_mutex);
+  std::shared_lock<std::shared_mutex> segments_lock(this->mutex);
+
+  // The head segment has the highest number, and only exists once a value has been appended to it.
+  if (this->segments.empty() || this->segments.begin()->first >= this->head_number) {
+    return std::nullopt;
+  }
+
+  return this->segments.begin()->first;
+}
+
+void ValueLog::Scan(uint64_t segment_number,
+                    const std::function<bool(const K&, const ValuePointer&, const V&)>& consumer) {
+  auto segment = this->Find(segment_number);
+  if (!segment) {
+    throw std::runtime_error("Cannot scan value log segment " + std::to_string(segment_number)
+                                 + ": it does not exist.");
+  }
+
+  auto reader = SequentialReader::Open(segment->path);
+  std::vector<byte> entry(ENTRY_HEADER_SIZE);
+  while (true) {
+    auto offset = reader->Offset();
+    if (!reader->Read(entry.data(), ENTRY_HEADER_SIZE)) {
+      return;
+    }
+
+    uint32_t checksum;
+    uint32_t length;
+    std::memcpy(&checksum, entry.data(), sizeof(uint32_t));
+    std::memcpy(&length, entry.data() + sizeof(uint32_t) + BTREE_KEY_SIZE, sizeof(uint32_t));
+    if (length > reader->Size() - reader->Offset()) {
+      return;
+    }
+
+    entry.resize(ENTRY_HEADER_SIZE + length);
+    reader->Read(entry.data() + ENTRY_HEADER_SIZE, length);
+    if (checksum != Crc32c(entry.data() + sizeof(uint32_t), entry.size() - sizeof(uint32_t))) {
+      throw std::runtime_error("Cannot scan value log segment " + segment->path.string() + ": the entry at offset "
+                                   + std::to_string(offset) + " is corrupt.");
+    }
+
+    K key;
+    std::memcpy(key.data(), entry.data() + sizeof(uint32_t), BTREE_KEY_SIZE);
+    if (!consumer(key, {segment_number, offset, length}, V(entry.begin() + ENTRY_HEADER_SIZE, entry.end()))) {
+      return;
+    }
+    entry.resize(ENTRY_HEADER_SIZE);
+  }
+}
+
+void ValueLog::Remove(uint64_t segment_number) {
+  std::shared_ptr<Segment> segment;
+  {
+    std::lock_guard<std::mutex> lock(this->append_mutex);
+    std::unique_lock<std::shared_mutex> segments_lock(this->mutex);
+
+    auto position = this->segments.find(segment_number);
+    if (position == this->segments.end() || segment_number >= this->head_number) {
+      throw std::logic_error("Cannot remove value log segment " + std::to_string(segment_number)
+                                 + ": it does not exist or is not sealed.");
+    }
+
+    segment = std::move(position->second);
+    this->segments.erase(position);
+  }
+
+  // Readers that found the segment before it was erased keep its file descriptor open.
+  auto removed_size = std::filesystem::file_size(segment->path);
+  if (::unlink(segment->path.c_str()) != 0) {
+    throw std::system_error(errno, std::generic_category(), "Cannot remove value log segment "
+        + segment->path.string());
+  }
+  SyncDirectory(this->directory);
+  this->size -= removed_size;
+}
+
+size_t ValueLog::SegmentCount() {
+  std::shared_lock<std::shared_mutex> lock(this->mutex);
+  return this->segments.size();
+}
+
+uint64_t ValueLog::Size() {
+  return this->size;
+}
+
+}
\ No newline at end of file
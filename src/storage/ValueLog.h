@@ -0,0 +1,268 @@
+#ifndef NOID_SRC_STORAGE_VALUELOG_H_
+#define NOID_SRC_STORAGE_VALUELOG_H_
+
+#include <cstdint>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <optional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief The default size in bytes after which the @c ValueLog starts a new segment.
+ */
+const uint64_t VALUE_LOG_DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+/**
+ * @brief The size in bytes of an encoded @c ValuePointer.
+ */
+const size_t VALUE_POINTER_SIZE = sizeof(uint64_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+/**
+ * @brief The location of a value in a @c ValueLog.
+ */
+struct ValuePointer {
+
+    /**
+     * @brief The number of the segment containing the value.
+     */
+    uint64_t segment;
+
+    /**
+     * @brief The offset of the entry containing the value within its segment.
+     */
+    uint64_t offset;
+
+    /**
+     * @brief The size of the value in bytes.
+     */
+    uint32_t length;
+
+    /**
+     * @brief Decodes a pointer encoded by @c Encode.
+     *
+     * @param data The encoded pointer.
+     * @return The pointer.
+     * @throws std::runtime_error If @p data does not have the size of an encoded pointer.
+     */
+    static ValuePointer Decode(const V& data);
+
+    /**
+     * @return The encoded pointer, which consists of @c VALUE_POINTER_SIZE bytes.
+     */
+    [[nodiscard]] V Encode() const;
+};
+
+/**
+ * @brief An append-only log of values, stored as a sequence of segment files within a directory.
+ * @details Storing large values outside of an index keeps the index small: its entries only hold a @c ValuePointer,
+ * so they can be moved cheaply, and more of them fit in memory. Every entry consists of a CRC32C checksum, the key the
+ * value belongs to, the value length and the value itself.
+ *
+ * Entries are written to the operating system as soon as they are appended, but only become durable after @c Sync.
+ * Opening the log always starts a new segment, so a segment that was being written during a crash is never appended
+ * to again.
+ *
+ * Segments other than the one being appended to are sealed. The owner of the log reclaims the space of values it no
+ * longer refers to by scanning a sealed segment, appending the values that are still referenced again, and then
+ * removing the segment.
+ *
+ * All methods can be called concurrently.
+ */
+class ValueLog {
+ private:
+
+    /**
+     * @brief An opened segment file.
+     */
+    struct Segment {
+
+        /**
+         * The location of the segment.
+         */
+        std::filesystem::path path;
+
+        /**
+         * The file descriptor of the segment.
+         */
+        int fd;
+
+        /**
+         * @brief Opens the segment at the given @p path, creating it if requested.
+         */
+        Segment(std::filesystem::path path, bool create);
+        Segment()= delete;
+        Segment(Segment const&)= delete;
+        Segment(Segment &&)= delete;
+        ~Segment();
+
+        Segment& operator=(Segment const&)= delete;
+        Segment& operator=(Segment &&)= delete;
+    };
+
+    /**
+     * The directory containing the segments.
+     */
+    const std::filesystem::path directory;
+
+    /**
+     * The size in bytes after which a new segment is started.
+     */
+    const uint64_t segment_size;
+
+    /**
+     * Protects @c segments.
+     */
+    std::shared_mutex mutex;
+
+    /**
+     * The opened segments by number.
+     */
+    std::map<uint64_t, std::shared_ptr<Segment>> segments;
+
+    /**
+     * Serializes appends, and protects the head state.
+     */
+    std::mutex append_mutex;
+
+    /**
+     * Serializes synchronizations, so that callers waiting for one in progress can rely on it instead of starting
+     * another.
+     */
+    std::mutex sync_mutex;
+
+    /**
+     * The segment being appended to, or @c nullptr if it has not been created yet.
+     */
+    std::shared_ptr<Segment> head;
+
+    /**
+     * The number of the segment being appended to.
+     */
+    uint64_t head_number;
+
+    /**
+     * The size in bytes of the head segment, and the amount of those bytes that are durable.
+     */
+    uint64_t head_size;
+    uint64_t synced_size;
+
+    /**
+     * The total size in bytes of all segments.
+     */
+    std::atomic<uint64_t> size;
+
+    /**
+     * @brief Creates a new @c ValueLog.
+     *
+     * @param directory The directory containing the segments.
+     * @param segment_size The size in bytes after which a new segment is started.
+     */
+    ValueLog(std::filesystem::path directory, uint64_t segment_size);
+
+    /**
+     * @return The segment having the given number, or @c nullptr if it does not exist.
+     */
+    std::shared_ptr<Segment> Find(uint64_t number);
+
+ public:
+
+    /**
+     * @brief Opens the value log in the given @p directory, creating it if it does not exist yet.
+     *
+     * @param directory The directory containing the segments.
+     * @param segment_size The size in bytes after which a new segment is started.
+     * @return The opened log.
+     * @throws std::invalid_argument If @p segment_size is zero.
+     * @throws std::system_error If the directory or a segment cannot be opened.
+     */
+    [[nodiscard]] static std::unique_ptr<ValueLog> Open(const std::filesystem::path& directory,
+                                                        uint64_t segment_size = VALUE_LOG_DEFAULT_SEGMENT_SIZE);
+
+    ValueLog()= delete;
+    ValueLog(ValueLog const&)= delete;
+    ValueLog(ValueLog &&)= delete;
+
+    /**
+     * @brief Makes all appended values durable, if possible.
+     */
+    ~ValueLog();
+
+    ValueLog& operator=(ValueLog const&)= delete;
+    ValueLog& operator=(ValueLog &&)= delete;
+
+    /**
+     * @brief Appends the given value to the log.
+     *
+     * @param key The key the value belongs to.
+     * @param value The value.
+     * @return The location of the value.
+     * @throws std::invalid_argument If the value does not fit in a single entry.
+     * @throws std::system_error If the value cannot be written.
+     */
+    ValuePointer Append(const K& key, const V& value);
+
+    /**
+     * @brief Reads the value at the given location.
+     *
+     * @param key The key the value belongs to.
+     * @param pointer The location of the value.
+     * @return The value.
+     * @throws std::system_error If the value cannot be read.
+     * @throws std::runtime_error If the segment does not exist, or the entry is corrupt or belongs to another key.
+     */
+    V Read(const K& key, const ValuePointer& pointer);
+
+    /**
+     * @brief Makes all appended values durable. Concurrent callers share a synchronization where possible.
+     *
+     * @throws std::system_error If the head segment cannot be synchronized.
+     */
+    void Sync();
+
+    /**
+     * @return The number of the oldest sealed segment, or an empty optional if no segment is sealed.
+     */
+    std::optional<uint64_t> OldestSealedSegment();
+
+    /**
+     * @brief Passes the entries of the given segment to @p consumer in the order they were appended, until it
+     * returns @c false. A truncated entry at the end of the segment, left behind by a crash, ends the scan.
+     *
+     * @param segment The number of the segment.
+     * @param consumer The consumer of the key, location and value of every entry.
+     * @throws std::system_error If the segment cannot be read.
+     * @throws std::runtime_error If the segment does not exist or contains a corrupt entry.
+     */
+    void Scan(uint64_t segment, const std::function<bool(const K&, const ValuePointer&, const V&)>& consumer);
+
+    /**
+     * @brief Deletes the given sealed segment. Reads of values it contains fail afterwards.
+     *
+     * @param segment The number of the segment.
+     * @throws std::logic_error If the segment does not exist or is not sealed.
+     * @throws std::system_error If the segment cannot be deleted.
+     */
+    void Remove(uint64_t segment);
+
+    /**
+     * @return The amount of segments.
+     */
+    size_t SegmentCount();
+
+    /**
+     * @return The total size in bytes of all segments.
+     */
+    uint64_t Size();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_VALUELOG_H_
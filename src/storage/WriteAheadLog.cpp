@@ -0,0 +1,469 @@
+#include "WriteAheadLog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Crc32c.h"
+#include "SequentialFile.h"
+
+namespace noid::storage {
+
+/**
+ * The size of the header preceding every record: a 32-bit record size, a 32-bit CRC32C checksum and a 64-bit LSN.
+ * The checksum covers the record size, the LSN and the record contents.
+ */
+static const size_t RECORD_HEADER_SIZE = sizeof(uint32_t) + sizeof(uint32_t) + sizeof(Lsn);
+static const size_t RECORD_CHECKSUM_OFFSET = sizeof(uint32_t);
+static const size_t RECORD_LSN_OFFSET = RECORD_CHECKSUM_OFFSET + sizeof(uint32_t);
+
+/**
+ * @brief Computes the checksum of a record.
+ *
+ * @param header The record header.
+ * @param data The record contents.
+ * @param size The size of the record contents.
+ * @return The checksum.
+ */
+static uint32_t RecordChecksum(const byte* header, const byte* data, size_t size) {
+  auto crc = Crc32c(header, RECORD_CHECKSUM_OFFSET);
+  crc = Crc32c(header + RECORD_LSN_OFFSET, sizeof(Lsn), crc);
+
+  return Crc32c(data, size, crc);
+}
+
+static const char* SEGMENT_EXTENSION = ".wal";
+static const char* CHECKPOINT_FILE_NAME = "CHECKPOINT";
+
+static void ThrowSystemError(const std::string& what) {
+  throw std::system_error(errno, std::generic_category(), what);
+}
+
+static void WriteFully(int fd, const byte* data, size_t size, uint64_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    auto result = ::pwrite(fd, data + done, size - done, static_cast<off_t>(offset + done));
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      ThrowSystemError("Cannot write to write-ahead log");
+    }
+
+    done += static_cast<size_t>(result);
+  }
+}
+
+/**
+ * @brief Determines the block size direct writes to the given file must be aligned to.
+ *
+ * @param fd The file descriptor.
+ * @return The preferred I/O block size of the file system, or @c PAGE_SIZE if it is not a sensible alignment.
+ */
+static size_t DirectIoBlockSize(int fd) {
+  struct stat st{};
+  if (::fstat(fd, &st) != 0) {
+    ThrowSystemError("Cannot determine write-ahead log block size");
+  }
+
+  auto block_size = static_cast<size_t>(st.st_blksize);
+  if (block_size < 512 || block_size > PAGE_SIZE || (block_size & (block_size - 1)) != 0) {
+    return PAGE_SIZE;
+  }
+
+  return block_size;
+}
+
+static std::filesystem::path SegmentPath(const std::filesystem::path& directory, Lsn first_lsn) {
+  std::stringstream name;
+  name << std::hex << std::setw(16) << std::setfill('0') << first_lsn << SEGMENT_EXTENSION;
+
+  return directory / name.str();
+}
+
+/**
+ * @brief Reads all intact records from the given segment file, stopping at the first torn, corrupt or out-of-sequence
+ * record.
+ *
+ * @param path The segment file.
+ * @param first_lsn The LSN of the first record in the segment.
+ * @param consumer The function to invoke with the LSN, contents and size of each record.
+ * @return The LSN following the last intact record and the size in bytes of all intact records.
+ */
+static std::pair<Lsn, uint64_t> ReadSegment(const std::filesystem::path& path, Lsn first_lsn,
+                                            const std::function<void(Lsn, const byte*, size_t)>& consumer) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    ThrowSystemError("Cannot open write-ahead log segment " + path.string());
+  }
+
+  auto expected_lsn = first_lsn;
+  uint64_t valid_bytes = 0;
+  byte header[RECORD_HEADER_SIZE];
+  std::vector<byte> payload;
+
+  while (in.read(reinterpret_cast<char*>(header), RECORD_HEADER_SIZE)) {
+    uint32_t size;
+    uint32_t checksum;
+    Lsn lsn;
+    std::memcpy(&size, header, sizeof(uint32_t));
+    std::memcpy(&checksum, header + RECORD_CHECKSUM_OFFSET, sizeof(uint32_t));
+    std::memcpy(&lsn, header + RECORD_LSN_OFFSET, sizeof(Lsn));
+
+    if (lsn != expected_lsn) {
+      break;
+    }
+
+    payload.resize(size);
+    if (!in.read(reinterpret_cast<char*>(payload.data()), size)) {
+      break;
+    }
+
+    if (checksum != RecordChecksum(header, payload.data(), payload.size())) {
+      break;
+    }
+
+    consumer(lsn, payload.data(), payload.size());
+
+    expected_lsn++;
+    valid_bytes += RECORD_HEADER_SIZE + size;
+  }
+
+  return {expected_lsn, valid_bytes};
+}
+
+WriteAheadLog::WriteAheadLog(std::filesystem::path directory, uint64_t segment_size, bool direct_io)
+  : directory(std::move(directory)), segment_size(segment_size), direct_io(direct_io), buffer_first_lsn(1),
+    next_lsn(1), flushed_lsn(0), checkpoint_lsn(INVALID_LSN), flush_count(0), segment_fd(-1), segment_bytes(0),
+    segment_block_size(0), write_buffer_size(0) {}
+
+void WriteAheadLog::OpenSegment(const std::filesystem::path &path, int flags) {
+  if (this->segment_fd >= 0) {
+    ::close(this->segment_fd);
+    this->segment_fd = -1;
+  }
+
+  flags |= O_WRONLY | O_CLOEXEC;
+  if (this->direct_io) {
+    this->segment_fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+
+    // File systems which do not support direct I/O, like tmpfs, reject it using EINVAL.
+    if (this->segment_fd < 0 && errno != EINVAL) {
+      ThrowSystemError("Cannot open write-ahead log segment " + path.string());
+    }
+  }
+
+  this->segment_block_size = 0;
+  if (this->segment_fd >= 0) {
+    this->segment_block_size = DirectIoBlockSize(this->segment_fd);
+  } else {
+    this->segment_fd = ::open(path.c_str(), flags, 0644);
+  }
+
+  if (this->segment_fd < 0) {
+    ThrowSystemError("Cannot open write-ahead log segment " + path.string());
+  }
+
+  this->tail.clear();
+}
+
+void WriteAheadLog::WriteSegment(const byte *data, size_t size) {
+  if (this->segment_block_size == 0) {
+    WriteFully(this->segment_fd, data, size, this->segment_bytes);
+    return;
+  }
+
+  // Direct writes must start and end at a block boundary, so rewrite the partially written last block, and pad the
+  // new last block with zeroes. Recovery stops reading at the padding, since it does not contain a valid LSN.
+  auto block_size = this->segment_block_size;
+  auto unpadded_size = this->tail.size() + size;
+  auto padded_size = (unpadded_size + block_size - 1) / block_size * block_size;
+
+  if (padded_size > this->write_buffer_size) {
+    this->write_buffer = AllocateAligned(padded_size, block_size);
+    this->write_buffer_size = padded_size;
+  }
+
+  auto staging = this->write_buffer.get();
+  std::copy(this->tail.begin(), this->tail.end(), staging);
+  std::memcpy(staging + this->tail.size(), data, size);
+  std::memset(staging + unpadded_size, 0, padded_size - unpadded_size);
+
+  WriteFully(this->segment_fd, staging, padded_size, this->segment_bytes - this->tail.size());
+}
+
+void WriteAheadLog::AdvanceSegment(size_t size) {
+  if (this->segment_block_size > 0) {
+    // The staging buffer still holds the written blocks, the last of which becomes the new partial block.
+    auto unpadded_size = this->tail.size() + size;
+    auto tail_size = unpadded_size % this->segment_block_size;
+    auto staging = this->write_buffer.get();
+    this->tail.assign(staging + unpadded_size - tail_size, staging + unpadded_size);
+  }
+
+  this->segment_bytes += size;
+}
+
+void WriteAheadLog::Recover() {
+  std::filesystem::create_directories(this->directory);
+
+  std::ifstream checkpoint(this->directory / CHECKPOINT_FILE_NAME, std::ios::binary);
+  Lsn lsn = INVALID_LSN;
+  if (checkpoint && checkpoint.read(reinterpret_cast<char*>(&lsn), sizeof(Lsn))) {
+    this->checkpoint_lsn = lsn;
+  }
+
+  for (auto& entry : std::filesystem::directory_iterator(this->directory)) {
+    if (entry.is_regular_file() && entry.path().extension() == SEGMENT_EXTENSION) {
+      auto first_lsn = static_cast<Lsn>(std::stoull(entry.path().stem().string(), nullptr, 16));
+      this->segments.push_back({first_lsn, entry.path()});
+    }
+  }
+  std::sort(this->segments.begin(), this->segments.end(), [](const Segment& lhs, const Segment& rhs) {
+    return lhs.first_lsn < rhs.first_lsn;
+  });
+
+  if (this->segments.empty()) {
+    this->next_lsn = std::max<Lsn>(1, this->checkpoint_lsn);
+  } else {
+    auto& last = this->segments.back();
+    const auto [end_lsn, valid_bytes] = ReadSegment(last.path, last.first_lsn, [](Lsn, const byte*, size_t) {});
+
+    this->OpenSegment(last.path, 0);
+
+    // Discard a torn record or block padding that might have been left behind by the last flush.
+    if (::ftruncate(this->segment_fd, static_cast<off_t>(valid_bytes)) != 0) {
+      ThrowSystemError("Cannot truncate write-ahead log segment " + last.path.string());
+    }
+
+    this->segment_bytes = valid_bytes;
+
+    if (this->segment_block_size > 0) {
+      this->tail.resize(valid_bytes % this->segment_block_size);
+
+      std::ifstream in(last.path, std::ios::binary);
+      in.seekg(static_cast<std::streamoff>(valid_bytes - this->tail.size()));
+      if (!in.read(reinterpret_cast<char*>(this->tail.data()), static_cast<std::streamsize>(this->tail.size()))) {
+        ThrowSystemError("Cannot read write-ahead log segment " + last.path.string());
+      }
+    }
+    this->next_lsn = end_lsn;
+  }
+
+  this->buffer_first_lsn = this->next_lsn;
+  this->flushed_lsn = this->next_lsn - 1;
+}
+
+void WriteAheadLog::StartSegment(Lsn first_lsn) {
+  auto path = SegmentPath(this->directory, first_lsn);
+  this->OpenSegment(path, O_CREAT | O_TRUNC);
+
+  SyncDirectory(this->directory);
+
+  this->segments.push_back({first_lsn, path});
+  this->segment_bytes = 0;
+}
+
+void WriteAheadLog::WriteCheckpointFile(Lsn lsn) {
+  auto path = this->directory / CHECKPOINT_FILE_NAME;
+  auto temporary_path = path;
+  temporary_path += ".tmp";
+
+  auto fd = ::open(temporary_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    ThrowSystemError("Cannot create checkpoint file " + temporary_path.string());
+  }
+
+  try {
+    WriteFully(fd, reinterpret_cast<const byte*>(&lsn), sizeof(Lsn), 0);
+    if (::fdatasync(fd) != 0) {
+      ThrowSystemError("Cannot synchronize checkpoint file " + temporary_path.string());
+    }
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+  ::close(fd);
+
+  // Renaming is atomic, so a crash leaves either the previous or the new checkpoint behind.
+  std::filesystem::rename(temporary_path, path);
+  SyncDirectory(this->directory);
+}
+
+std::unique_ptr<WriteAheadLog> WriteAheadLog::Open(const std::filesystem::path &directory, uint64_t segment_size,
+                                                   bool direct_io) {
+  auto log = std::unique_ptr<WriteAheadLog>(new WriteAheadLog(directory, segment_size, direct_io));
+  log->Recover();
+
+  return log;
+}
+
+WriteAheadLog::~WriteAheadLog() {
+  try {
+    this->Flush(this->LastLsn());
+  } catch (...) {
+    // Records that could not be flushed are lost, just like they would be after a crash.
+  }
+
+  if (this->segment_fd >= 0) {
+    ::close(this->segment_fd);
+  }
+}
+
+Lsn WriteAheadLog::Append(const byte *data, size_t size) {
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument("Cannot append a record of " + std::to_string(size) + " bytes to a write-ahead log.");
+  }
+
+  std::lock_guard<std::mutex> lock(this->append_mutex);
+
+  auto lsn = this->next_lsn++;
+  auto record_size = static_cast<uint32_t>(size);
+  auto offset = this->buffer.size();
+
+  this->buffer.resize(offset + RECORD_HEADER_SIZE + size);
+  auto header = &this->buffer[offset];
+  std::memcpy(header, &record_size, sizeof(uint32_t));
+  std::memcpy(header + RECORD_LSN_OFFSET, &lsn, sizeof(Lsn));
+  if (size > 0) {
+    std::memcpy(header + RECORD_HEADER_SIZE, data, size);
+  }
+
+  auto checksum = RecordChecksum(header, header + RECORD_HEADER_SIZE, size);
+  std::memcpy(header + RECORD_CHECKSUM_OFFSET, &checksum, sizeof(uint32_t));
+
+  return lsn;
+}
+
+void WriteAheadLog::Flush(Lsn lsn) {
+  if (this->flushed_lsn >= lsn) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> flush_lock(this->flush_mutex);
+
+  // Another thread might have flushed our records while we were waiting.
+  if (this->flushed_lsn >= lsn) {
+    return;
+  }
+
+  std::vector<byte> pending;
+  Lsn first_lsn;
+  Lsn last_lsn;
+  {
+    std::lock_guard<std::mutex> append_lock(this->append_mutex);
+    pending.swap(this->buffer);
+    first_lsn = this->buffer_first_lsn;
+    last_lsn = this->next_lsn - 1;
+    this->buffer_first_lsn = this->next_lsn;
+  }
+
+  if (pending.empty()) {
+    return;
+  }
+
+  try {
+    if (this->segment_fd < 0 || this->segment_bytes >= this->segment_size) {
+      this->StartSegment(first_lsn);
+    }
+
+    this->WriteSegment(pending.data(), pending.size());
+    if (::fdatasync(this->segment_fd) != 0) {
+      ThrowSystemError("Cannot synchronize write-ahead log");
+    }
+  } catch (...) {
+    // The records are put back in front of the ones appended meanwhile, so the next flush rewrites them at the same
+    // offset instead of leaving a gap in the LSNs, at which recovery would stop.
+    std::lock_guard<std::mutex> append_lock(this->append_mutex);
+    pending.insert(pending.end(), this->buffer.begin(), this->buffer.end());
+    this->buffer.swap(pending);
+    this->buffer_first_lsn = first_lsn;
+    throw;
+  }
+
+  this->AdvanceSegment(pending.size());
+  this->flushed_lsn = last_lsn;
+  this->flush_count++;
+}
+
+void WriteAheadLog::Checkpoint(Lsn lsn) {
+  std::lock_guard<std::mutex> flush_lock(this->flush_mutex);
+  if (lsn <= this->checkpoint_lsn) {
+    return;
+  }
+
+  this->WriteCheckpointFile(lsn);
+  this->checkpoint_lsn = lsn;
+
+  // A segment can be recycled if its successor starts at or before the checkpoint. The last segment is never
+  // recycled since it is being appended to.
+  size_t recyclable = 0;
+  while (recyclable + 1 < this->segments.size() && this->segments[recyclable + 1].first_lsn <= lsn) {
+    std::filesystem::remove(this->segments[recyclable].path);
+    recyclable++;
+  }
+
+  this->segments.erase(this->segments.begin(), this->segments.begin() + static_cast<int64_t>(recyclable));
+}
+
+void WriteAheadLog::Replay(Lsn from, const std::function<void(Lsn, const byte *, size_t)> &consumer) {
+  std::lock_guard<std::mutex> flush_lock(this->flush_mutex);
+
+  for (size_t i = 0; i < this->segments.size(); i++) {
+    if (i + 1 < this->segments.size() && this->segments[i + 1].first_lsn <= from) {
+      continue;
+    }
+
+    auto end_lsn = ReadSegment(this->segments[i].path, this->segments[i].first_lsn,
+                               [&](Lsn lsn, const byte* data, size_t size) {
+      if (lsn >= from) {
+        consumer(lsn, data, size);
+      }
+    }).first;
+
+    // Only the last segment can end in a torn record. Anywhere else, records are missing.
+    if (i + 1 < this->segments.size() && end_lsn != this->segments[i + 1].first_lsn) {
+      throw std::runtime_error("Write-ahead log segment " + this->segments[i].path.string() + " is corrupt.");
+    }
+  }
+}
+
+Lsn WriteAheadLog::LastLsn() {
+  std::lock_guard<std::mutex> lock(this->append_mutex);
+  return this->next_lsn - 1;
+}
+
+Lsn WriteAheadLog::FlushedLsn() {
+  return this->flushed_lsn;
+}
+
+Lsn WriteAheadLog::CheckpointLsn() {
+  return this->checkpoint_lsn;
+}
+
+uint64_t WriteAheadLog::FlushCount() {
+  return this->flush_count;
+}
+
+size_t WriteAheadLog::SegmentCount() {
+  std::lock_guard<std::mutex> flush_lock(this->flush_mutex);
+  return this->segments.size();
+}
+
+bool WriteAheadLog::DirectIo() {
+  std::lock_guard<std::mutex> flush_lock(this->flush_mutex);
+  return this->segment_block_size > 0;
+}
+
+}
\ No newline at end of file
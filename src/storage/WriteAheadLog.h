@@ -0,0 +1,301 @@
+#ifndef NOID_SRC_STORAGE_WRITEAHEADLOG_H_
+#define NOID_SRC_STORAGE_WRITEAHEADLOG_H_
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "AlignedBuffer.h"
+#include "Page.h"
+#include "Shared.h"
+
+namespace noid::storage {
+
+/**
+ * @brief The default size in bytes after which the @c WriteAheadLog starts a new segment.
+ */
+const uint64_t WAL_DEFAULT_SEGMENT_SIZE = 64 * 1024 * 1024;
+
+/**
+ * @brief An append-only log of opaque records, stored as a sequence of segment files within a directory.
+ * @details Every record is identified by a log sequence number (LSN), which increases by one for every appended
+ * record. Appended records are buffered in memory until they are flushed. Flushing is serialized, so concurrent
+ * callers of @c Flush share a single write and synchronization of the log (group commit).
+ *
+ * Segments can be written using direct I/O. Every flush then writes whole file system blocks, padding the last one
+ * with zeroes, which is rewritten including the following records by the next flush.
+ *
+ * Once the changes described by all records before a given LSN have been persisted elsewhere, @c Checkpoint records
+ * that LSN and recycles the segments which only contain records preceding it. This keeps the log from growing
+ * without bound.
+ */
+class WriteAheadLog {
+ private:
+
+    /**
+     * @brief Describes a single segment file.
+     */
+    struct Segment {
+
+        /**
+         * The LSN of the first record in this segment.
+         */
+        Lsn first_lsn;
+
+        /**
+         * The location of the segment file.
+         */
+        std::filesystem::path path;
+    };
+
+    /**
+     * The directory containing the segment files.
+     */
+    const std::filesystem::path directory;
+
+    /**
+     * The size in bytes after which a new segment is started.
+     */
+    const uint64_t segment_size;
+
+    /**
+     * Whether to prefer direct I/O (@c O_DIRECT) when writing segments.
+     */
+    const bool direct_io;
+
+    /**
+     * Protects the append buffer and @c next_lsn.
+     */
+    std::mutex append_mutex;
+
+    /**
+     * Serializes flushes, checkpoints and replays, and protects the segments and the current segment file.
+     */
+    std::mutex flush_mutex;
+
+    /**
+     * The records which have been appended, but not yet written to the current segment.
+     */
+    std::vector<byte> buffer;
+
+    /**
+     * The LSN of the first record in @c buffer.
+     */
+    Lsn buffer_first_lsn;
+
+    /**
+     * The LSN that will be assigned to the next appended record.
+     */
+    Lsn next_lsn;
+
+    /**
+     * The LSN of the last record that was written to stable storage.
+     */
+    std::atomic<Lsn> flushed_lsn;
+
+    /**
+     * The LSN of the latest checkpoint. All records preceding it may have been recycled.
+     */
+    std::atomic<Lsn> checkpoint_lsn;
+
+    /**
+     * The amount of times buffered records were written and synchronized.
+     */
+    std::atomic<uint64_t> flush_count;
+
+    /**
+     * All segments, ordered by their first LSN. The last segment is the one being appended to.
+     */
+    std::vector<Segment> segments;
+
+    /**
+     * The file descriptor of the last segment, or -1 if no segment has been created yet.
+     */
+    int segment_fd;
+
+    /**
+     * The size in bytes of the last segment.
+     */
+    uint64_t segment_bytes;
+
+    /**
+     * The block size of the last segment if it was opened using direct I/O, or zero otherwise.
+     */
+    size_t segment_block_size;
+
+    /**
+     * The contents of the last, partially written block of the last segment. Only used for direct I/O.
+     */
+    std::vector<byte> tail;
+
+    /**
+     * The aligned buffer direct writes are staged in.
+     */
+    AlignedBuffer write_buffer;
+
+    /**
+     * The size in bytes of @c write_buffer.
+     */
+    size_t write_buffer_size;
+
+    /**
+     * @brief Creates a new @c WriteAheadLog in the given @p directory.
+     *
+     * @param directory The directory containing the segment files.
+     * @param segment_size The size in bytes after which a new segment is started.
+     * @param direct_io Whether to prefer direct I/O when writing segments.
+     */
+    WriteAheadLog(std::filesystem::path directory, uint64_t segment_size, bool direct_io);
+
+    /**
+     * @brief Opens the given segment file for writing, and makes it the last segment.
+     * @details Direct I/O is used if it is preferred and supported by the file system.
+     *
+     * @param path The segment file.
+     * @param flags Additional flags to open the file with.
+     */
+    void OpenSegment(const std::filesystem::path& path, int flags);
+
+    /**
+     * @brief Writes the given records to the end of the last segment.
+     * @details The segment is not advanced until @c AdvanceSegment is called, so a failed write can be retried at
+     * the same offset.
+     *
+     * @param data The records.
+     * @param size The size in bytes of the records.
+     */
+    void WriteSegment(const byte* data, size_t size);
+
+    /**
+     * @brief Advances the end of the last segment past the records written by the preceding @c WriteSegment, once
+     * they are durable.
+     *
+     * @param size The size in bytes of the records.
+     */
+    void AdvanceSegment(size_t size);
+
+    /**
+     * @brief Reads the existing segments and the latest checkpoint, and discards a possibly torn last record.
+     */
+    void Recover();
+
+    /**
+     * @brief Closes the current segment, and creates a new one starting at the given @p first_lsn.
+     *
+     * @param first_lsn The LSN of the first record to be written to the new segment.
+     */
+    void StartSegment(Lsn first_lsn);
+
+    /**
+     * @brief Durably records the given LSN as the latest checkpoint.
+     *
+     * @param lsn The checkpoint LSN.
+     */
+    void WriteCheckpointFile(Lsn lsn);
+
+ public:
+
+    /**
+     * @brief Opens the log in the given @p directory, creating the directory if it does not exist.
+     *
+     * @param directory The directory containing the segment files.
+     * @param segment_size The size in bytes after which a new segment is started.
+     * @param direct_io Whether to prefer direct I/O (@c O_DIRECT) when writing segments. If the file system does not
+     * support it, segments are written using buffered I/O.
+     * @return The opened log.
+     * @throws std::system_error If the log cannot be opened.
+     */
+    [[nodiscard]] static std::unique_ptr<WriteAheadLog> Open(const std::filesystem::path& directory,
+                                                             uint64_t segment_size = WAL_DEFAULT_SEGMENT_SIZE,
+                                                             bool direct_io = false);
+
+    WriteAheadLog()= delete;
+    WriteAheadLog(WriteAheadLog const&)= delete;
+    WriteAheadLog(WriteAheadLog &&)= delete;
+    ~WriteAheadLog();
+
+    WriteAheadLog& operator=(WriteAheadLog const&)= delete;
+    WriteAheadLog& operator=(WriteAheadLog &&)= delete;
+
+    /**
+     * @brief Appends a copy of the given record to the log buffer.
+     * @details The record is not durable until @c Flush has been called with at least the returned LSN.
+     *
+     * @param data The record contents.
+     * @param size The size of the record in bytes.
+     * @return The LSN assigned to the record.
+     * @throws std::invalid_argument If the record is 4 GiB or larger.
+     */
+    Lsn Append(const byte* data, size_t size);
+
+    /**
+     * @brief Writes all buffered records up to and including @p lsn to stable storage.
+     * @details If the records have been flushed already, this method returns immediately. If the records cannot
+     * be written, they remain buffered, so a later flush can still write them.
+     *
+     * @param lsn The LSN up to which the log must be durable.
+     * @throws std::system_error If the log cannot be written.
+     */
+    void Flush(Lsn lsn);
+
+    /**
+     * @brief Records @p lsn as the latest checkpoint and recycles all segments containing only preceding records.
+     * @details The caller guarantees that the changes described by all records preceding @p lsn are durable
+     * elsewhere. Checkpoints never move backwards; a checkpoint preceding the current one is ignored.
+     *
+     * @param lsn The first LSN that is still required for recovery.
+     * @throws std::system_error If the checkpoint cannot be recorded.
+     */
+    void Checkpoint(Lsn lsn);
+
+    /**
+     * @brief Invokes @p consumer for every durable record having an LSN of at least @p from, in LSN order.
+     * @details The checksum of every record is verified. Replay stops at a corrupt record in the last segment, which
+     * is indistinguishable from a torn write.
+     *
+     * @param from The LSN of the first record to replay.
+     * @param consumer The function to invoke with the LSN, contents and size of each record.
+     * @throws std::system_error If the log cannot be read.
+     * @throws std::runtime_error If a segment other than the last one contains a corrupt record.
+     */
+    void Replay(Lsn from, const std::function<void(Lsn, const byte*, size_t)>& consumer);
+
+    /**
+     * @return The LSN of the last appended record, or @c INVALID_LSN if no records were appended yet.
+     */
+    Lsn LastLsn();
+
+    /**
+     * @return The LSN of the last record that is durable.
+     */
+    Lsn FlushedLsn();
+
+    /**
+     * @return The LSN of the latest checkpoint, which is where recovery should start replaying.
+     */
+    Lsn CheckpointLsn();
+
+    /**
+     * @return The amount of times buffered records were written and synchronized. Since concurrent flushes share a
+     * synchronization, this can be less than the amount of @c Flush calls.
+     */
+    uint64_t FlushCount();
+
+    /**
+     * @return The amount of segment files currently in use.
+     */
+    size_t SegmentCount();
+
+    /**
+     * @return Whether the last segment is written using direct I/O.
+     */
+    bool DirectIo();
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_WRITEAHEADLOG_H_
@@ -0,0 +1,34 @@
+#include "WriteBatch.h"
+
+namespace noid::storage {
+
+WriteBatch::WriteBatch() : size(0) {}
+
+void WriteBatch::Insert(const K &key, const V &value) {
+  this->operations.emplace_back(key, LsmEntry{false, value});
+  this->size += BTREE_KEY_SIZE + value.size();
+}
+
+void WriteBatch::Remove(const K &key) {
+  this->operations.emplace_back(key, LsmEntry{true, {}});
+  this->size += BTREE_KEY_SIZE;
+}
+
+void WriteBatch::Clear() {
+  this->operations.clear();
+  this->size = 0;
+}
+
+const std::vector<std::pair<K, LsmEntry>> &WriteBatch::Operations() const {
+  return this->operations;
+}
+
+size_t WriteBatch::Count() const {
+  return this->operations.size();
+}
+
+size_t WriteBatch::Size() const {
+  return this->size;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef NOID_SRC_STORAGE_WRITEBATCH_H_
+#define NOID_SRC_STORAGE_WRITEBATCH_H_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "Shared.h"
+#include "SortedRun.h"
+
+namespace noid::storage {
+
+/**
+ * @brief A group of inserts and removes which is applied atomically by @c LsmTree::Write.
+ * @details Operations are buffered in the order they are added. If a key is modified more than once, the last
+ * operation wins.
+ */
+class WriteBatch {
+ private:
+
+    /**
+     * The buffered operations, in the order they were added.
+     */
+    std::vector<std::pair<K, LsmEntry>> operations;
+
+    /**
+     * The total size in bytes of the keys and values of @c operations.
+     */
+    size_t size;
+
+ public:
+
+    WriteBatch();
+
+    /**
+     * @brief Adds an insert of @p value at @p key, overwriting any pre-existing value.
+     *
+     * @param key The key.
+     * @param value The value.
+     */
+    void Insert(const K& key, const V& value);
+
+    /**
+     * @brief Adds a remove of @p key.
+     *
+     * @param key The key to remove.
+     */
+    void Remove(const K& key);
+
+    /**
+     * @brief Removes all operations.
+     */
+    void Clear();
+
+    /**
+     * @return The operations, in the order they were added.
+     */
+    [[nodiscard]] const std::vector<std::pair<K, LsmEntry>>& Operations() const;
+
+    /**
+     * @return The amount of operations.
+     */
+    [[nodiscard]] size_t Count() const;
+
+    /**
+     * @return The total size in bytes of the keys and values of all operations.
+     */
+    [[nodiscard]] size_t Size() const;
+};
+
+}
+
+#endif //NOID_SRC_STORAGE_WRITEBATCH_H_